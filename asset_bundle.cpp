@@ -0,0 +1,153 @@
+#include "asset_bundle.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+#ifdef RGBENCH_ASSETS
+// Байты набора, их пишет rgbench_pack_assets при сборке
+alignas(ASSET_ALIGNMENT) const unsigned char EMBEDDED_ASSETS[] = {
+#include "assets.inc"
+};
+#endif
+
+} // namespace
+
+AssetBundle::~AssetBundle() {
+    if (mapping_) {
+        munmap(mapping_, mappingSize_);
+    }
+}
+
+bool AssetBundle::openEmbedded(std::string& error) {
+#ifdef RGBENCH_ASSETS
+    source_ = "встроенный";
+    return parse(EMBEDDED_ASSETS, sizeof(EMBEDDED_ASSETS), error);
+#else
+    error = "no embedded asset bundle in this build, use --assets";
+    return false;
+#endif
+}
+
+bool AssetBundle::openFile(const std::string& path, std::string& error) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        error = "cannot read " + path;
+        close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // Отображение держит файл и без дескриптора
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "mmap " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    mapping_ = mapping;
+    mappingSize_ = static_cast<size_t>(info.st_size);
+    source_ = path;
+    return parse(static_cast<const uint8_t*>(mapping), mappingSize_, error);
+}
+
+bool AssetBundle::parse(const uint8_t* data, size_t size, std::string& error) {
+    AssetHeader header;
+    if (size < sizeof(header)) {
+        error = "asset bundle is truncated";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, ASSET_MAGIC, sizeof(ASSET_MAGIC)) != 0) {
+        error = "not an asset bundle";
+        return false;
+    }
+    size_t tableEnd = sizeof(header) + static_cast<size_t>(header.entryCount) * sizeof(AssetEntry);
+    if (tableEnd > size) {
+        error = "asset bundle table is truncated";
+        return false;
+    }
+    // Границы записей проверяются один раз, find() им уже доверяет
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        AssetEntry entry;
+        std::memcpy(&entry, data + sizeof(header) + i * sizeof(AssetEntry), sizeof(entry));
+        if (entry.name[ASSET_NAME_SIZE - 1] != '\0' || entry.offset > size || entry.size > size - entry.offset) {
+            error = "asset bundle entry " + std::to_string(i) + " is corrupted";
+            return false;
+        }
+    }
+    data_ = data;
+    size_ = size;
+    return true;
+}
+
+std::string_view AssetBundle::find(std::string_view name) const {
+    if (!data_) {
+        return {};
+    }
+    AssetHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        AssetEntry entry;
+        std::memcpy(&entry, data_ + sizeof(header) + i * sizeof(AssetEntry), sizeof(entry));
+        if (name == entry.name) {
+            return std::string_view(reinterpret_cast<const char*>(data_) + entry.offset, entry.size);
+        }
+    }
+    return {};
+}
+
+bool AssetBundle::image(std::string_view name, AssetImage& out) const {
+    std::string_view data = find(name);
+    AssetImageHeader header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    size_t pixelsSize = static_cast<size_t>(header.width) * header.height * header.channels;
+    if (header.width == 0 || header.height == 0 || header.channels == 0 || data.size() - sizeof(header) < pixelsSize) {
+        return false;
+    }
+    out.width = static_cast<int>(header.width);
+    out.height = static_cast<int>(header.height);
+    out.channels = static_cast<int>(header.channels);
+    out.pixels = reinterpret_cast<const uint8_t*>(data.data()) + sizeof(header);
+    return true;
+}
+
+std::vector<uint8_t> packAssetBundle(const std::vector<std::pair<std::string, std::vector<uint8_t>>>& entries) {
+    auto align = [](size_t offset) { return (offset + ASSET_ALIGNMENT - 1) / ASSET_ALIGNMENT * ASSET_ALIGNMENT; };
+
+    AssetHeader header = {};
+    std::memcpy(header.magic, ASSET_MAGIC, sizeof(ASSET_MAGIC));
+    header.entryCount = static_cast<uint32_t>(entries.size());
+
+    std::vector<AssetEntry> table(entries.size());
+    size_t offset = align(sizeof(header) + table.size() * sizeof(AssetEntry));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        std::memset(&table[i], 0, sizeof(AssetEntry));
+        std::strncpy(table[i].name, entries[i].first.c_str(), ASSET_NAME_SIZE - 1);
+        table[i].offset = static_cast<uint32_t>(offset);
+        table[i].size = static_cast<uint32_t>(entries[i].second.size());
+        offset = align(offset + entries[i].second.size());
+    }
+
+    std::vector<uint8_t> blob(offset, 0);
+    std::memcpy(blob.data(), &header, sizeof(header));
+    if (!table.empty()) {
+        std::memcpy(blob.data() + sizeof(header), table.data(), table.size() * sizeof(AssetEntry));
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        std::copy(entries[i].second.begin(), entries[i].second.end(), blob.begin() + table[i].offset);
+    }
+    return blob;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Набор ресурсов: исходники шейдеров GL, атлас глифов с метриками и иконка в
+// одном блоке. Собирается утилитой rgbench_pack_assets при сборке и
+// встраивается в исполняемый файл; файл набора (--assets) отображается в
+// память через mmap. При запуске не ищутся файлы и не работает FreeType.
+// Формат: заголовок, таблица записей, данные записей с выравниванием 16 байт
+// от начала блока. Числа в порядке байт машины сборки
+constexpr char ASSET_MAGIC[8] = {'R', 'G', 'B', 'P', 'A', 'K', '0', '1'};
+constexpr size_t ASSET_ALIGNMENT = 16;
+constexpr size_t ASSET_NAME_SIZE = 48;
+
+struct AssetHeader {
+    char magic[8];
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct AssetEntry {
+    char name[ASSET_NAME_SIZE]; // С нулем в конце
+    uint32_t offset;            // От начала блока
+    uint32_t size;
+};
+
+// Записи атласа и иконки: заголовок, за ним строки пикселей без выравнивания
+struct AssetImageHeader {
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels; // 1 - маска R8, 4 - RGBA
+    uint32_t reserved;
+};
+
+// Запись font/glyphs: по глифу на код ASCII
+constexpr int ASSET_GLYPH_COUNT = 128;
+struct AssetGlyph {
+    int32_t width, height;
+    int32_t bearingX, bearingY;
+    uint32_t advance;        // В 1/64 пикселя, как у FreeType
+    uint32_t atlasX, atlasY; // Левый верхний угол маски в атласе
+    uint32_t loaded;         // 0 - FreeType не смог растеризовать
+};
+
+struct AssetImage {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    const uint8_t* pixels = nullptr;
+};
+
+class AssetBundle {
+public:
+    AssetBundle() = default;
+    ~AssetBundle();
+
+    AssetBundle(const AssetBundle&) = delete;
+    AssetBundle& operator=(const AssetBundle&) = delete;
+
+    // Набор, встроенный при сборке
+    bool openEmbedded(std::string& error);
+    // Файл набора только для чтения через mmap, страницы подгружаются при обращении
+    bool openFile(const std::string& path, std::string& error);
+
+    // Пусто, если записи нет
+    [[nodiscard]] std::string_view find(std::string_view name) const;
+    // Изображение с проверкой размера; пиксели указывают в набор
+    bool image(std::string_view name, AssetImage& out) const;
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] const std::string& source() const { return source_; }
+
+private:
+    bool parse(const uint8_t* data, size_t size, std::string& error);
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::string source_;
+    void* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+};
+
+// Блок набора из записей по порядку, для утилиты сборки
+std::vector<uint8_t> packAssetBundle(const std::vector<std::pair<std::string, std::vector<uint8_t>>>& entries);
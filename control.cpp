@@ -0,0 +1,348 @@
+#include "control.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <map>
+
+namespace {
+
+constexpr int POLL_INTERVAL_MS = 200;
+constexpr size_t MAX_LINE_SIZE = 64 * 1024;
+constexpr auto REQUEST_TIMEOUT = std::chrono::seconds(10);
+
+std::string runtimeDirectory() {
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    return runtime && *runtime ? runtime : "/tmp";
+}
+
+bool makeAddress(const std::string& path, sockaddr_un& address, std::string& error) {
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = "socket path is too long";
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+JsonValue errorResponse(const JsonValue& id, int code, const std::string& message) {
+    JsonValue error = JsonValue::object();
+    error.set("code", code).set("message", message);
+    JsonValue response = JsonValue::object();
+    response.set("jsonrpc", "2.0").set("error", error).set("id", id);
+    return response;
+}
+
+// Первый сокет rgbench-*.sock в каталоге по умолчанию
+std::string findControlPath() {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(runtimeDirectory(), ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("rgbench-", 0) == 0 && entry.path().extension() == ".sock") {
+            return entry.path().string();
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+std::string defaultControlPath() {
+    return runtimeDirectory() + "/rgbench-" + std::to_string(getpid()) + ".sock";
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+bool ControlServer::start(const std::string& path, std::string& error) {
+    sockaddr_un address;
+    if (!makeAddress(path, address, error)) {
+        return false;
+    }
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    // Сокет от упавшего процесса мешает bind
+    unlink(path.c_str());
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listenFd_, 8) < 0 ||
+        pipe2(wakeFds_, O_CLOEXEC | O_NONBLOCK) < 0) {
+        error = std::strerror(errno);
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    path_ = path;
+    stop_ = false;
+    thread_ = std::thread(&ControlServer::serveLoop, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (listenFd_ < 0) {
+        return;
+    }
+    stop_ = true;
+    thread_.join();
+    close(listenFd_);
+    listenFd_ = -1;
+    for (int& fd : wakeFds_) {
+        close(fd);
+        fd = -1;
+    }
+    unlink(path_.c_str());
+}
+
+void ControlServer::processPending(const Handler& handler) {
+    std::deque<std::shared_ptr<Request>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return;
+        }
+        pending.swap(queue_);
+    }
+    for (auto& request : pending) {
+        JsonValue result = handler(request->method, request->params, request->error);
+        std::lock_guard<std::mutex> lock(mutex_);
+        request->result = std::move(result);
+        request->done = true;
+    }
+    // Канал неблокирующий: если он полон, фоновый поток и так проснется
+    char wake = 1;
+    ssize_t written = write(wakeFds_[1], &wake, 1);
+    (void)written;
+}
+
+void ControlServer::serveLoop() {
+    std::map<int, std::string> clients; // Дескриптор -> недочитанный ввод
+
+    while (!stop_) {
+        std::vector<pollfd> fds;
+        fds.push_back({listenFd_, POLLIN, 0});
+        fds.push_back({wakeFds_[0], POLLIN, 0});
+        for (const auto& client : clients) {
+            fds.push_back({client.first, POLLIN, 0});
+        }
+        int ready = poll(fds.data(), fds.size(), POLL_INTERVAL_MS);
+        // Таймауты проверяются и без событий
+        finishRequests();
+        if (ready <= 0) {
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(wakeFds_[0], drain, sizeof(drain)) > 0) {
+            }
+            finishRequests();
+        }
+        if (fds[0].revents & POLLIN) {
+            int clientFd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (clientFd >= 0) {
+                clients[clientFd];
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!fds[i].revents) {
+                continue;
+            }
+            int clientFd = fds[i].fd;
+            std::string& buffer = clients[clientFd];
+            char chunk[4096];
+            ssize_t n = recv(clientFd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                dropClient(clientFd);
+                close(clientFd);
+                clients.erase(clientFd);
+                continue;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+
+            size_t newline;
+            while ((newline = buffer.find('\n')) != std::string::npos) {
+                std::string line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (!line.empty()) {
+                    handleLine(clientFd, line);
+                }
+            }
+            if (buffer.size() > MAX_LINE_SIZE) {
+                sendAll(clientFd, errorResponse(JsonValue(), RPC_INVALID_REQUEST, "request too long").dump() + "\n");
+                dropClient(clientFd);
+                close(clientFd);
+                clients.erase(clientFd);
+            }
+        }
+    }
+
+    for (const auto& client : clients) {
+        close(client.first);
+    }
+}
+
+void ControlServer::handleLine(int clientFd, const std::string& line) {
+    JsonValue message;
+    std::string parseError;
+    if (!parseJson(line, message, parseError)) {
+        sendAll(clientFd, errorResponse(JsonValue(), RPC_PARSE_ERROR, parseError).dump() + "\n");
+        return;
+    }
+    const JsonValue& id = message["id"];
+    if (!message.isObject() || !message["method"].isString()) {
+        sendAll(clientFd, errorResponse(id, RPC_INVALID_REQUEST, "method is required").dump() + "\n");
+        return;
+    }
+
+    auto request = std::make_shared<Request>();
+    request->method = message["method"].asString();
+    request->params = message["params"];
+    request->clientFd = clientFd;
+    request->id = id;
+    // Запрос без id - уведомление, ответ не нужен
+    request->notification = !message.has("id");
+    request->deadline = std::chrono::steady_clock::now() + REQUEST_TIMEOUT;
+    inFlight_.push_back(request);
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(request));
+}
+
+void ControlServer::finishRequests() {
+    if (inFlight_.empty()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    // Запрос и выполнен ли он: done меняет поток рендеринга, читаем под замком
+    std::vector<std::pair<std::shared_ptr<Request>, bool>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t kept = 0;
+        for (auto& request : inFlight_) {
+            if (!request->done && now < request->deadline) {
+                inFlight_[kept++] = std::move(request);
+                continue;
+            }
+            bool done = request->done;
+            if (!done) {
+                // Еще в очереди - убираем, чтобы команда не выполнилась после
+                // ответа об ошибке; уже взятую поток рендеринга доделает
+                auto queued = std::find(queue_.begin(), queue_.end(), request);
+                if (queued != queue_.end()) {
+                    queue_.erase(queued);
+                }
+            }
+            finished.emplace_back(std::move(request), done);
+        }
+        inFlight_.resize(kept);
+    }
+
+    for (const auto& [request, done] : finished) {
+        if (request->notification || request->clientFd < 0) {
+            continue;
+        }
+        JsonValue response;
+        if (!done) {
+            response = errorResponse(request->id, RPC_INTERNAL_ERROR, "render thread did not respond");
+        } else if (request->error.code != 0) {
+            response = errorResponse(request->id, request->error.code, request->error.message);
+        } else {
+            response = JsonValue::object();
+            response.set("jsonrpc", "2.0").set("result", request->result).set("id", request->id);
+        }
+        sendAll(request->clientFd, response.dump() + "\n");
+    }
+}
+
+void ControlServer::dropClient(int clientFd) {
+    // Команды отключившегося клиента выполняются, но дескриптор может
+    // достаться новому соединению - ответ не отправляем
+    for (auto& request : inFlight_) {
+        if (request->clientFd == clientFd) {
+            request->clientFd = -1;
+        }
+    }
+}
+
+int sendControlRequest(const std::string& path, const std::string& method, const std::string& params) {
+    std::string socketPath = path.empty() ? findControlPath() : path;
+    if (socketPath.empty()) {
+        std::cerr << "Не найден управляющий сокет, укажите --control <путь>" << std::endl;
+        return 1;
+    }
+
+    JsonValue request = JsonValue::object();
+    request.set("jsonrpc", "2.0").set("method", method).set("id", 1);
+    if (!params.empty()) {
+        JsonValue parsed;
+        std::string error;
+        if (!parseJson(params, parsed, error)) {
+            std::cerr << "Invalid params: " << error << std::endl;
+            return 1;
+        }
+        request.set("params", parsed);
+    }
+
+    sockaddr_un address;
+    std::string error;
+    if (!makeAddress(socketPath, address, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Failed to connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+    sendAll(fd, request.dump() + "\n");
+
+    std::string response;
+    char chunk[4096];
+    while (response.find('\n') == std::string::npos) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            break;
+        }
+        response.append(chunk, static_cast<size_t>(n));
+    }
+    close(fd);
+
+    response = response.substr(0, response.find('\n'));
+    std::cout << response << std::endl;
+    JsonValue parsed;
+    return parseJson(response, parsed, error) && !parsed.has("error") ? 0 : 1;
+}
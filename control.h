@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json.h"
+
+// Коды ошибок JSON-RPC 2.0
+constexpr int RPC_PARSE_ERROR = -32700;
+constexpr int RPC_INVALID_REQUEST = -32600;
+constexpr int RPC_METHOD_NOT_FOUND = -32601;
+constexpr int RPC_INVALID_PARAMS = -32602;
+constexpr int RPC_INTERNAL_ERROR = -32603;
+
+// Ошибка, которую обработчик команды возвращает клиенту
+struct RpcError {
+    int code = 0;
+    std::string message;
+};
+
+// Управление запущенным тестом через Unix-сокет: JSON-RPC 2.0, один запрос
+// на строку. Сокет обслуживает фоновый поток, а сами команды выполняются в
+// потоке рендеринга (processPending), потому что им нужен GL контекст. Фоновый
+// поток не ждет выполнения: ответ он отправляет, когда поток рендеринга
+// разбудит его через канал, поэтому медленная команда не задерживает других
+// клиентов
+class ControlServer {
+public:
+    // Обработчик: result для успешного ответа или заполненный error
+    using Handler = std::function<JsonValue(const std::string& method, const JsonValue& params, RpcError& error)>;
+
+    ~ControlServer();
+
+    bool start(const std::string& path, std::string& error);
+    void stop();
+
+    // Выполняет накопившиеся команды, вызывается раз за кадр
+    void processPending(const Handler& handler);
+
+    [[nodiscard]] bool isRunning() const { return listenFd_ >= 0; }
+    [[nodiscard]] const std::string& path() const { return path_; }
+
+private:
+    struct Request {
+        std::string method;
+        JsonValue params;
+        JsonValue result;
+        RpcError error;
+        bool done = false;
+        // Дальше - только для фонового потока
+        int clientFd = -1; // -1 - клиент отключился, ответ не нужен
+        JsonValue id;
+        bool notification = false;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void serveLoop();
+    void handleLine(int clientFd, const std::string& line);
+    // Отправляет готовые ответы и ошибки по таймауту
+    void finishRequests();
+    void dropClient(int clientFd);
+
+    std::string path_;
+    int listenFd_ = -1;
+    int wakeFds_[2] = {-1, -1}; // Канал: поток рендеринга будит фоновый поток
+    std::atomic<bool> stop_ {false};
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::deque<std::shared_ptr<Request>> queue_;
+    // Принятые, но еще без ответа; только фоновый поток
+    std::vector<std::shared_ptr<Request>> inFlight_;
+};
+
+// Путь сокета по умолчанию: $XDG_RUNTIME_DIR/rgbench-<pid>.sock или /tmp
+[[nodiscard]] std::string defaultControlPath();
+
+// Подкоманда ctl: отправляет один запрос и печатает ответ
+int sendControlRequest(const std::string& path, const std::string& method, const std::string& params);
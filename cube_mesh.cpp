@@ -0,0 +1,451 @@
+#include "cube_mesh.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+const std::array<float, CUBE_VERTEX_COUNT * CUBE_VERTEX_FLOATS> CUBE_VERTICES = {
+    // позиции          // цвета
+    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 1.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  1.0f, 1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f
+};
+
+CubeLayout cubeLayout(int size) {
+    CubeLayout layout;
+    layout.size = size;
+    layout.cubieSize = 0.9f / size;
+    layout.totalSize = layout.cubieSize + 0.03f / size;
+    layout.center = (size - 1) * 0.5f;
+    return layout;
+}
+
+unsigned visibleCubeFaces(int size, int x, int y, int z) {
+    int last = size - 1;
+    unsigned mask = 0;
+    if (z == 0) mask |= 1u << FACE_NEG_Z;
+    if (z == last) mask |= 1u << FACE_POS_Z;
+    if (x == 0) mask |= 1u << FACE_NEG_X;
+    if (x == last) mask |= 1u << FACE_POS_X;
+    if (y == 0) mask |= 1u << FACE_NEG_Y;
+    if (y == last) mask |= 1u << FACE_POS_Y;
+    return mask;
+}
+
+CubeCullStats cubeCullStats(int size) {
+    uint64_t n = static_cast<uint64_t>(size);
+    uint64_t inner = size > 2 ? n - 2 : 0;
+    CubeCullStats stats;
+    stats.cubies = n * n * n;
+    stats.visibleCubies = stats.cubies - inner * inner * inner;
+    stats.faces = stats.cubies * CUBE_FACE_COUNT;
+    stats.visibleFaces = n * n * CUBE_FACE_COUNT;
+    return stats;
+}
+
+namespace {
+
+// float -> half float, без субнормальных чисел (координаты кубика в них не попадают)
+uint16_t toHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if (exponent <= 0) {
+        return sign;
+    }
+    if (exponent >= 31) {
+        return sign | 0x7C00;
+    }
+    uint16_t half = static_cast<uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+    if (mantissa & 0x1000) {
+        half++;  // Округление, перенос в порядок дает верный результат
+    }
+    return half;
+}
+
+uint8_t toUnorm8(float value) {
+    return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Уникальные углы грани и индексы ее треугольников в порядке CUBE_VERTICES
+struct FaceCorners {
+    int vertex[CUBE_FACE_CORNERS];   // Номер вершины в CUBE_VERTICES
+    uint32_t index[CUBE_FACE_VERTICES];
+};
+
+FaceCorners faceCorners(int face) {
+    FaceCorners corners {};
+    int count = 0;
+    for (int i = 0; i < CUBE_FACE_VERTICES; i++) {
+        int v = face * CUBE_FACE_VERTICES + i;
+        const float* position = &CUBE_VERTICES[v * CUBE_VERTEX_FLOATS];
+        int found = -1;
+        for (int c = 0; c < count; c++) {
+            if (std::equal(position, position + 3, &CUBE_VERTICES[corners.vertex[c] * CUBE_VERTEX_FLOATS])) {
+                found = c;
+                break;
+            }
+        }
+        if (found < 0) {
+            found = count;
+            corners.vertex[count++] = v;
+        }
+        corners.index[i] = static_cast<uint32_t>(found);
+    }
+    return corners;
+}
+
+void appendVertex(CubeMesh& mesh, int v, float scale, const glm::vec3& offset) {
+    const float* source = &CUBE_VERTICES[v * CUBE_VERTEX_FLOATS];
+    float position[3] = {source[0] * scale + offset.x, source[1] * scale + offset.y, source[2] * scale + offset.z};
+    if (mesh.format == VertexFormat::Packed) {
+        uint16_t halves[4] = {toHalf(position[0]), toHalf(position[1]), toHalf(position[2]), toHalf(1.0f)};
+        uint8_t color[4] = {toUnorm8(source[3]), toUnorm8(source[4]), toUnorm8(source[5]), 255};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(halves);
+        mesh.vertices.insert(mesh.vertices.end(), bytes, bytes + sizeof(halves));
+        mesh.vertices.insert(mesh.vertices.end(), color, color + sizeof(color));
+    } else {
+        float vertex[CUBE_VERTEX_FLOATS] = {position[0], position[1], position[2], source[3], source[4], source[5]};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(vertex);
+        mesh.vertices.insert(mesh.vertices.end(), bytes, bytes + sizeof(vertex));
+    }
+    mesh.vertexCount++;
+}
+
+// Добавляет видимые грани одного кубика
+void appendCubie(CubeMesh& mesh, std::vector<uint32_t>& indices, unsigned faces, float scale, const glm::vec3& offset) {
+    for (int face = 0; face < CUBE_FACE_COUNT; face++) {
+        if (!(faces & (1u << face))) {
+            continue;
+        }
+        if (mesh.format == VertexFormat::Float) {
+            for (int i = 0; i < CUBE_FACE_VERTICES; i++) {
+                appendVertex(mesh, face * CUBE_FACE_VERTICES + i, scale, offset);
+            }
+            continue;
+        }
+        FaceCorners corners = faceCorners(face);
+        uint32_t base = static_cast<uint32_t>(mesh.vertexCount);
+        for (int c = 0; c < CUBE_FACE_CORNERS; c++) {
+            appendVertex(mesh, corners.vertex[c], scale, offset);
+        }
+        for (uint32_t index : corners.index) {
+            indices.push_back(base + index);
+        }
+    }
+}
+
+// Индексы в 16 бит, если хватает, иначе в 32
+void packIndices(CubeMesh& mesh, const std::vector<uint32_t>& indices) {
+    mesh.indexCount = indices.size();
+    if (indices.empty()) {
+        return;
+    }
+    if (mesh.vertexCount <= 0x10000) {
+        mesh.indexSize = 2;
+        mesh.indices.resize(indices.size() * 2);
+        for (size_t i = 0; i < indices.size(); i++) {
+            uint16_t index = static_cast<uint16_t>(indices[i]);
+            std::memcpy(&mesh.indices[i * 2], &index, 2);
+        }
+    } else {
+        mesh.indexSize = 4;
+        mesh.indices.resize(indices.size() * 4);
+        std::memcpy(mesh.indices.data(), indices.data(), mesh.indices.size());
+    }
+}
+
+} // namespace
+
+int vertexStride(VertexFormat format) {
+    return format == VertexFormat::Packed ? 12 : CUBE_VERTEX_FLOATS * static_cast<int>(sizeof(float));
+}
+
+CubeMesh buildUnitCubeMesh(VertexFormat format) {
+    CubeMesh mesh;
+    mesh.format = format;
+    std::vector<uint32_t> indices;
+    appendCubie(mesh, indices, ALL_CUBE_FACES, 1.0f, glm::vec3(0.0f));
+    packIndices(mesh, indices);
+    return mesh;
+}
+
+CubeMesh bakeCubeMesh(const CubeLayout& layout, bool cull, VertexFormat format) {
+    CubeCullStats stats = cubeCullStats(layout.size);
+    uint64_t faces = cull ? stats.visibleFaces : stats.faces;
+    bool indexed = format != VertexFormat::Float;
+
+    CubeMesh mesh;
+    mesh.format = format;
+    mesh.vertices.reserve(faces * (indexed ? CUBE_FACE_CORNERS : CUBE_FACE_VERTICES) * vertexStride(format));
+    std::vector<uint32_t> indices;
+    if (indexed) {
+        indices.reserve(faces * CUBE_FACE_VERTICES);
+    }
+    for (int x = 0; x < layout.size; x++) {
+        for (int y = 0; y < layout.size; y++) {
+            for (int z = 0; z < layout.size; z++) {
+                unsigned mask = cull ? visibleCubeFaces(layout.size, x, y, z) : ALL_CUBE_FACES;
+                if (mask != 0) {
+                    appendCubie(mesh, indices, mask, layout.cubieSize, layout.offset(x, y, z));
+                }
+            }
+        }
+    }
+    packIndices(mesh, indices);
+    return mesh;
+}
+
+std::vector<glm::vec3> cubieOffsets(const CubeLayout& layout, bool cull) {
+    std::vector<glm::vec3> offsets;
+    CubeCullStats stats = cubeCullStats(layout.size);
+    offsets.reserve(cull ? stats.visibleCubies : stats.cubies);
+    for (int x = 0; x < layout.size; x++) {
+        for (int y = 0; y < layout.size; y++) {
+            for (int z = 0; z < layout.size; z++) {
+                if (!cull || visibleCubeFaces(layout.size, x, y, z) != 0) {
+                    offsets.push_back(layout.offset(x, y, z));
+                }
+            }
+        }
+    }
+    return offsets;
+}
+
+#if defined(__SSE2__) && defined(__GNUC__)
+namespace {
+
+// Ветка AVX собирается под target("avx") без -mavx на весь файл и
+// выбирается по CPUID при первом вызове
+__attribute__((target("avx"))) void writeCubieTransformsAvx(__m128 s0, __m128 s1, __m128 s2, __m128 c0, __m128 c1,
+                                                             __m128 c2, __m128 c3, const glm::vec3* offsets,
+                                                             size_t count, float* out) {
+    __m256 s01 = _mm256_set_m128(s1, s0);
+    for (size_t i = 0; i < count; i++, out += CUBIE_TRANSFORM_FLOATS) {
+        __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(offsets[i].x)), _mm_mul_ps(c1, _mm_set1_ps(offsets[i].y))),
+                              _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(offsets[i].z)), c3));
+        _mm256_stream_ps(out, s01);
+        _mm256_stream_ps(out + 8, _mm256_set_m128(t, s2));
+    }
+    _mm_sfence();
+}
+
+bool cpuHasAvx() {
+    static const bool avx = __builtin_cpu_supports("avx");
+    return avx;
+}
+
+} // namespace
+#endif
+
+void writeCubieTransforms(const glm::mat4& rotation, float cubieSize, const glm::vec3* offsets, size_t count, float* out) {
+    const float* r = &rotation[0][0];
+#if defined(__SSE2__)
+    __m128 c0 = _mm_loadu_ps(r);
+    __m128 c1 = _mm_loadu_ps(r + 4);
+    __m128 c2 = _mm_loadu_ps(r + 8);
+    __m128 c3 = _mm_loadu_ps(r + 12);
+    __m128 scale = _mm_set1_ps(cubieSize);
+    __m128 s0 = _mm_mul_ps(c0, scale);
+    __m128 s1 = _mm_mul_ps(c1, scale);
+    __m128 s2 = _mm_mul_ps(c2, scale);
+
+#if defined(__GNUC__)
+    if ((reinterpret_cast<uintptr_t>(out) & 31) == 0 && cpuHasAvx()) {
+        writeCubieTransformsAvx(s0, s1, s2, c0, c1, c2, c3, offsets, count, out);
+        return;
+    }
+#endif
+
+    bool aligned = (reinterpret_cast<uintptr_t>(out) & 15) == 0;
+    for (size_t i = 0; i < count; i++, out += CUBIE_TRANSFORM_FLOATS) {
+        __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(offsets[i].x)), _mm_mul_ps(c1, _mm_set1_ps(offsets[i].y))),
+                              _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(offsets[i].z)), c3));
+        if (aligned) {
+            _mm_stream_ps(out, s0);
+            _mm_stream_ps(out + 4, s1);
+            _mm_stream_ps(out + 8, s2);
+            _mm_stream_ps(out + 12, t);
+        } else {
+            _mm_storeu_ps(out, s0);
+            _mm_storeu_ps(out + 4, s1);
+            _mm_storeu_ps(out + 8, s2);
+            _mm_storeu_ps(out + 12, t);
+        }
+    }
+    if (aligned) {
+        _mm_sfence();
+    }
+#else
+    for (size_t i = 0; i < count; i++, out += CUBIE_TRANSFORM_FLOATS) {
+        for (int row = 0; row < 4; row++) {
+            out[row] = r[row] * cubieSize;
+            out[4 + row] = r[4 + row] * cubieSize;
+            out[8 + row] = r[8 + row] * cubieSize;
+            out[12 + row] = r[row] * offsets[i].x + r[4 + row] * offsets[i].y + r[8 + row] * offsets[i].z + r[12 + row];
+        }
+    }
+#endif
+}
+
+bool VertexCacheModel::access(uint32_t index) {
+    // Пока кэш не полон, записи лежат в [0, count_): flush() сбрасывает и next_
+    if (std::find(entries_.begin(), entries_.begin() + count_, index) != entries_.begin() + count_) {
+        return true;
+    }
+    entries_[next_] = index;
+    next_ = next_ + 1 == entries_.size() ? 0 : next_ + 1;
+    count_ = std::min(count_ + 1, entries_.size());
+    return false;
+}
+
+namespace {
+
+// Индексы baked, которые прогоняются через модель: дальше доля не меняется,
+// а N=100 дает 36 млн индексов
+constexpr uint64_t MAX_MODELED_INDICES = 1u << 22;
+
+// Модель кэша по потоку индексов кадра. cube - вызов на кубик, с отсечением
+// видимые грани идут отдельными диапазонами glMultiDrawElements; instanced и
+// threaded - единичный кубик на экземпляр; baked - один поток на весь кубик
+double modelCacheHitRate(int size, bool cull, Workload workload) {
+    std::array<FaceCorners, CUBE_FACE_COUNT> corners;
+    for (int face = 0; face < CUBE_FACE_COUNT; face++) {
+        corners[face] = faceCorners(face);
+    }
+    VertexCacheModel cache;
+    uint64_t hits = 0;
+    uint64_t indices = 0;
+    // Грани с номером base первой вершины, base растет как в appendCubie
+    auto drawFaces = [&](unsigned mask, uint32_t base, bool flushFaces) {
+        for (int face = 0; face < CUBE_FACE_COUNT; face++) {
+            if (!(mask & (1u << face))) {
+                continue;
+            }
+            if (flushFaces) {
+                cache.flush();
+            }
+            for (uint32_t index : corners[face].index) {
+                hits += cache.access(base + index);
+                indices++;
+            }
+            base += CUBE_FACE_CORNERS;
+        }
+        return base;
+    };
+
+    if (workload == Workload::Baked) {
+        uint32_t base = 0;
+        for (int x = 0; x < size && indices < MAX_MODELED_INDICES; x++) {
+            for (int y = 0; y < size; y++) {
+                for (int z = 0; z < size; z++) {
+                    base = drawFaces(cull ? visibleCubeFaces(size, x, y, z) : ALL_CUBE_FACES, base, false);
+                }
+            }
+        }
+    } else if (workload == Workload::Cube) {
+        // Поток вызова зависит только от маски граней
+        std::array<uint64_t, ALL_CUBE_FACES + 1> draws {};
+        for (int x = 0; x < size; x++) {
+            for (int y = 0; y < size; y++) {
+                for (int z = 0; z < size; z++) {
+                    draws[cull ? visibleCubeFaces(size, x, y, z) : ALL_CUBE_FACES]++;
+                }
+            }
+        }
+        for (unsigned mask = 1; mask <= ALL_CUBE_FACES; mask++) {
+            if (draws[mask] == 0) {
+                continue;
+            }
+            uint64_t drawHits = hits, drawIndices = indices;
+            cache.flush();
+            drawFaces(mask, 0, mask != ALL_CUBE_FACES);
+            hits = drawHits + (hits - drawHits) * draws[mask];
+            indices = drawIndices + (indices - drawIndices) * draws[mask];
+        }
+    } else {
+        drawFaces(ALL_CUBE_FACES, 0, false);
+    }
+    return indices > 0 ? static_cast<double>(hits) / indices : 0.0;
+}
+
+} // namespace
+
+CubeGeometryStats cubeGeometryStats(int size, bool cull, Workload workload, VertexFormat format) {
+    CubeCullStats cullStats = cubeCullStats(size);
+    bool baked = workload == Workload::Baked;
+    // Инстансный путь отсекает грани в шейдере, вершины все равно обрабатываются,
+    // threaded отсекает только внутренние кубики
+    uint64_t faces = cull ? cullStats.visibleFaces : cullStats.faces;
+    if (workload == Workload::Instanced) {
+        faces = cullStats.faces;
+    } else if (workload == Workload::Threaded) {
+        faces = (cull ? cullStats.visibleCubies : cullStats.cubies) * CUBE_FACE_COUNT;
+    }
+    uint64_t stride = static_cast<uint64_t>(vertexStride(format));
+
+    CubeGeometryStats stats;
+    if (workload == Workload::Cube) {
+        stats.draws = cull ? cullStats.visibleCubies : cullStats.cubies;
+    } else {
+        stats.draws = 1;
+    }
+    if (format == VertexFormat::Float) {
+        stats.shadedVertices = faces * CUBE_FACE_VERTICES;
+    } else {
+        stats.cacheHitRate = modelCacheHitRate(size, cull, workload);
+        stats.indices = faces * CUBE_FACE_VERTICES;
+        stats.shadedVertices = static_cast<uint64_t>(stats.indices * (1.0 - stats.cacheHitRate) + 0.5);
+        uint64_t meshVertices = baked ? faces * CUBE_FACE_CORNERS : CUBE_FACE_COUNT * CUBE_FACE_CORNERS;
+        stats.indexBytes = stats.indices * (meshVertices <= 0x10000 ? 2 : 4);
+    }
+    stats.vertexBytes = stats.shadedVertices * stride;
+    if (workload == Workload::Threaded) {
+        // Матрица кубика читается из буфера инстансов один раз на кубик
+        stats.vertexBytes += faces / CUBE_FACE_COUNT * CUBIE_TRANSFORM_FLOATS * sizeof(float);
+    }
+    return stats;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "options.h"
+
+// Геометрия кубика Рубика
+
+constexpr int CUBE_VERTEX_COUNT = 36;
+constexpr int CUBE_VERTEX_FLOATS = 6;  // Позиция и цвет
+
+// Грани в порядке CUBE_VERTICES
+enum CubeFace { FACE_NEG_Z, FACE_POS_Z, FACE_NEG_X, FACE_POS_X, FACE_NEG_Y, FACE_POS_Y, CUBE_FACE_COUNT };
+constexpr int CUBE_FACE_VERTICES = 6;   // Без индексов: два треугольника
+constexpr int CUBE_FACE_CORNERS = 4;    // С индексами: уникальные вершины грани
+constexpr unsigned ALL_CUBE_FACES = (1u << CUBE_FACE_COUNT) - 1;
+
+// Единичный куб с центром в нуле, по 6 вершин на грань, обход против часовой
+// стрелки снаружи (для GL_CULL_FACE)
+extern const std::array<float, CUBE_VERTEX_COUNT * CUBE_VERTEX_FLOATS> CUBE_VERTICES;
+
+// Размещение кубиков N x N x N: весь кубик занимает одинаковый объем при любом N
+struct CubeLayout {
+    int size = 3;
+    float cubieSize = 0.3f;
+    float totalSize = 0.31f;  // Шаг между центрами кубиков
+    float center = 1.0f;
+
+    [[nodiscard]] glm::vec3 offset(int x, int y, int z) const {
+        return glm::vec3(x - center, y - center, z - center) * totalSize;
+    }
+};
+
+[[nodiscard]] CubeLayout cubeLayout(int size);
+
+// Маска граней кубика (x, y, z), смотрящих наружу кубика Рубика.
+// Грани, прижатые к соседу, не видны; 0 - внутренний кубик
+[[nodiscard]] unsigned visibleCubeFaces(int size, int x, int y, int z);
+
+// Сколько кубиков и граней отсекается для кубика N x N x N
+struct CubeCullStats {
+    uint64_t cubies = 0;
+    uint64_t visibleCubies = 0;
+    uint64_t faces = 0;
+    uint64_t visibleFaces = 0;
+};
+
+[[nodiscard]] CubeCullStats cubeCullStats(int size);
+
+// Геометрия, готовая к загрузке в GL буферы
+struct CubeMesh {
+    VertexFormat format = VertexFormat::Float;
+    std::vector<uint8_t> vertices;
+    size_t vertexCount = 0;
+    std::vector<uint8_t> indices;  // Пусто для VertexFormat::Float
+    size_t indexCount = 0;
+    int indexSize = 0;             // 2 или 4 байта
+
+    [[nodiscard]] bool indexed() const { return indexCount > 0; }
+};
+
+// Размер вершины в байтах
+[[nodiscard]] int vertexStride(VertexFormat format);
+
+// Единичный куб для отрисовки по кубику. Грань f занимает 6 вершин (float)
+// или 6 индексов, начиная с f * 6
+[[nodiscard]] CubeMesh buildUnitCubeMesh(VertexFormat format);
+
+// Все кубики заранее преобразованы в координаты кубика Рубика: один буфер и
+// один вызов отрисовки с общей матрицей вращения. cull - без внутренних
+// кубиков и граней
+[[nodiscard]] CubeMesh bakeCubeMesh(const CubeLayout& layout, bool cull, VertexFormat format);
+
+// Центры кубиков в порядке x, y, z; cull - только наружные кубики
+[[nodiscard]] std::vector<glm::vec3> cubieOffsets(const CubeLayout& layout, bool cull);
+
+constexpr int CUBIE_TRANSFORM_FLOATS = 16;
+constexpr size_t TRANSFORM_CHUNK = 4096;  // Кубиков в одном задании пула потоков
+
+// Матрицы model кубиков: rotation * translate(offset) * scale(cubieSize), по
+// столбцами, как их читает шейдер. Первые три столбца общие для всех кубиков,
+// считается только смещение. Выровненный out пишется потоково мимо кэша -
+// так быстрее для отображенного GL буфера
+void writeCubieTransforms(const glm::mat4& rotation, float cubieSize, const glm::vec3* offsets, size_t count, float* out);
+
+// Модель кэша вершин после трансформации: FIFO, размер типичный для
+// современных GPU. Настоящие драйверы устроены иначе, замер - PipelineStats
+constexpr size_t VERTEX_CACHE_SIZE = 32;
+
+class VertexCacheModel {
+public:
+    explicit VertexCacheModel(size_t size = VERTEX_CACHE_SIZE) : entries_(size) {}
+
+    // true - вершина уже в кэше, шейдер не запускается
+    bool access(uint32_t index);
+    // Граница вызова отрисовки или экземпляра: кэш ее не переживает
+    void flush() {
+        next_ = 0;
+        count_ = 0;
+    }
+
+private:
+    std::vector<uint32_t> entries_;  // Кольцо, next_ - самая старая запись
+    size_t next_ = 0;
+    size_t count_ = 0;
+};
+
+// Оценка нагрузки на выборку вершин за кадр. Попадания в кэш - модель FIFO
+// по потоку индексов, который уходит в отрисовку, с учетом границ вызовов
+struct CubeGeometryStats {
+    uint64_t draws = 0;
+    uint64_t indices = 0;          // 0 без индексов
+    uint64_t shadedVertices = 0;   // Запуски вершинного шейдера
+    uint64_t vertexBytes = 0;      // Прочитано вершин: промахи кэша * размер вершины
+    uint64_t indexBytes = 0;
+    double cacheHitRate = 0.0;     // Оценка модели, 0 без индексов
+};
+
+[[nodiscard]] CubeGeometryStats cubeGeometryStats(int size, bool cull, Workload workload, VertexFormat format);
@@ -0,0 +1,677 @@
+#include "fleet.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "json.h"
+
+namespace {
+
+constexpr int CLOCK_SYNC_ROUNDS = 5;
+constexpr int CLOCK_SYNC_TIMEOUT_MS = 2000;
+constexpr double RESULT_GRACE_SEC = 60.0;
+constexpr double OUTLIER_Z = 3.5;
+
+double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool sendMessage(int fd, const JsonValue& message) {
+    return sendAll(fd, message.dump() + "\n");
+}
+
+// Достает из buffer готовую строку, false - строки еще нет
+bool takeLine(std::string& buffer, std::string& line) {
+    size_t newline = buffer.find('\n');
+    if (newline == std::string::npos) {
+        return false;
+    }
+    line = buffer.substr(0, newline);
+    buffer.erase(0, newline + 1);
+    return true;
+}
+
+// Дочитывает данные из сокета в buffer. false - соединение закрыто
+bool receiveInto(int fd, std::string& buffer) {
+    char chunk[4096];
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+        return n < 0 && (errno == EINTR || errno == EAGAIN);
+    }
+    buffer.append(chunk, static_cast<size_t>(n));
+    return true;
+}
+
+// 1 - строка прочитана, 0 - таймаут, -1 - соединение закрыто
+int readLineFrom(int fd, std::string& buffer, std::string& line, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!takeLine(buffer, line)) {
+        int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        if (remaining <= 0) {
+            return 0;
+        }
+        pollfd pfd {fd, POLLIN, 0};
+        if (poll(&pfd, 1, remaining) <= 0) {
+            continue;
+        }
+        if (!receiveInto(fd, buffer)) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+JsonValue scenarioToJson(const FleetScenario& scenario) {
+    JsonValue json = JsonValue::object();
+    json.set("workload", scenario.workload)
+        .set("cube_size", scenario.cubeSize)
+        .set("warmup", scenario.warmupSec)
+        .set("duration", scenario.durationSec);
+    return json;
+}
+
+// Состояние подключенного агента на стороне координатора
+struct AgentState {
+    int fd = -1;
+    std::string buffer;
+    std::string address;
+    std::string node;
+    std::string gpu;
+    std::string driver;
+    std::string cpu;
+    bool hello = false;
+    double offsetMs = 0.0;      // Часы агента минус часы координатора
+    double rttMs = 0.0;
+    bool done = false;
+    bool failed = false;
+    double avgFps = 0.0;
+    FrameTimeHistogram histogram;
+
+    ~AgentState() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+void markFailed(AgentState& agent, const std::string& reason) {
+    if (!agent.failed && !agent.done) {
+        std::cerr << "Агент " << (agent.node.empty() ? agent.address : agent.node) << ": " << reason << std::endl;
+    }
+    agent.failed = !agent.done;
+    if (agent.fd >= 0) {
+        ::close(agent.fd);
+        agent.fd = -1;
+    }
+}
+
+int openListener(const std::string& address, std::string& error) {
+    std::string host;
+    int port = 0;
+    if (!splitHostPort(address, host, port)) {
+        error = "invalid listen address " + address;
+        return -1;
+    }
+    sockaddr_in bindAddress {};
+    bindAddress.sin_family = AF_INET;
+    bindAddress.sin_port = htons(static_cast<uint16_t>(port));
+    if (host.empty() || host == "*") {
+        bindAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+    } else if (inet_pton(AF_INET, host.c_str(), &bindAddress.sin_addr) != 1) {
+        error = "invalid listen address " + address;
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&bindAddress), sizeof(bindAddress)) < 0 || listen(fd, 64) < 0) {
+        error = std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Шаг 1: ждем подключения и hello от всех агентов
+bool acceptAgents(int listenFd, const CoordinatorOptions& options, std::vector<std::unique_ptr<AgentState>>& agents) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.joinTimeoutSec);
+    int ready = 0;
+    while (ready < options.agents) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            std::cerr << "Подключились не все агенты: " << ready << " из " << options.agents << std::endl;
+            return false;
+        }
+        // Агенты, приславшие hello, до старта молчат, но опрашиваются дальше:
+        // отключившийся до старта не должен считаться готовым
+        std::vector<pollfd> fds {{listenFd, POLLIN, 0}};
+        std::vector<AgentState*> owners {nullptr};
+        for (const auto& agent : agents) {
+            fds.push_back({agent->fd, POLLIN, 0});
+            owners.push_back(agent.get());
+        }
+        if (poll(fds.data(), fds.size(), 200) <= 0) {
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in peer {};
+            socklen_t length = sizeof(peer);
+            int fd = accept4(listenFd, reinterpret_cast<sockaddr*>(&peer), &length, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                int noDelay = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                auto agent = std::make_unique<AgentState>();
+                agent->fd = fd;
+                char text[INET_ADDRSTRLEN] = {};
+                inet_ntop(AF_INET, &peer.sin_addr, text, sizeof(text));
+                agent->address = std::string(text) + ":" + std::to_string(ntohs(peer.sin_port));
+                agents.push_back(std::move(agent));
+            }
+        }
+        for (size_t i = 1; i < fds.size(); ++i) {
+            AgentState& agent = *owners[i];
+            if (!fds[i].revents) {
+                continue;
+            }
+            std::string line;
+            if (!receiveInto(agent.fd, agent.buffer)) {
+                std::cerr << "Агент " << (agent.hello ? agent.node : agent.address) << " отключился до начала" << std::endl;
+                ::close(agent.fd);
+                agent.fd = -1;
+                if (agent.hello) {
+                    --ready;
+                }
+                continue;
+            }
+            JsonValue message;
+            std::string error;
+            if (!agent.hello && takeLine(agent.buffer, line) && parseJson(line, message, error) &&
+                message["type"].asString() == "hello") {
+                agent.hello = true;
+                agent.node = message["node"].asString();
+                agent.gpu = message["gpu"].asString();
+                agent.driver = message["driver"].asString();
+                agent.cpu = message["cpu"].asString();
+                ++ready;
+                std::cout << "Подключен " << agent.node << " (" << agent.address << "): " << agent.gpu
+                          << " [" << ready << "/" << options.agents << "]" << std::endl;
+            }
+        }
+        agents.erase(std::remove_if(agents.begin(), agents.end(), [](const auto& a) { return a->fd < 0; }), agents.end());
+    }
+    return true;
+}
+
+// Шаг 2: оценка сдвига часов по пингу с наименьшей задержкой
+bool syncClock(AgentState& agent) {
+    double bestRtt = -1.0;
+    for (int round = 0; round < CLOCK_SYNC_ROUNDS; ++round) {
+        double t0 = nowMs();
+        JsonValue ping = JsonValue::object();
+        ping.set("type", "ping").set("t0", t0);
+        if (!sendMessage(agent.fd, ping)) {
+            return false;
+        }
+        std::string line;
+        JsonValue pong;
+        std::string error;
+        if (readLineFrom(agent.fd, agent.buffer, line, CLOCK_SYNC_TIMEOUT_MS) != 1 || !parseJson(line, pong, error)
+            || pong["type"].asString() != "pong") {
+            return false;
+        }
+        double t2 = nowMs();
+        double rtt = t2 - t0;
+        if (bestRtt < 0 || rtt < bestRtt) {
+            bestRtt = rtt;
+            agent.rttMs = rtt;
+            agent.offsetMs = pong["t1"].asNumber() - (t0 + t2) / 2.0;
+        }
+    }
+    return true;
+}
+
+// Выравнивание с учетом UTF-8: setw считает байты, а не символы
+std::string padded(const std::string& text, size_t width, bool alignLeft) {
+    size_t length = 0;
+    for (unsigned char c : text) {
+        length += (c & 0xC0) != 0x80;
+    }
+    std::string padding(width > length ? width - length : 0, ' ');
+    return alignLeft ? text + padding : padding + text;
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+// Шаг 5: отчет по узлам и по всему парку
+int printReport(const CoordinatorOptions& options, const std::vector<std::unique_ptr<AgentState>>& agents) {
+    std::vector<double> nodeFps;
+    FrameTimeHistogram fleetHistogram;
+    double throughput = 0.0;
+    int failed = 0;
+    for (const auto& agent : agents) {
+        if (agent->done) {
+            nodeFps.push_back(agent->avgFps);
+            fleetHistogram.merge(agent->histogram);
+            throughput += agent->avgFps;
+        } else {
+            ++failed;
+        }
+    }
+
+    double medianFps = median(nodeFps);
+    std::vector<double> deviations;
+    for (double fps : nodeFps) {
+        deviations.push_back(std::fabs(fps - medianFps));
+    }
+    double mad = median(deviations);
+
+    // Выброс - отклонение от медианы больше порога и по модифицированной
+    // z-оценке (Иглевич-Хоаглин). Для двух узлов большинства нет, не ищем
+    auto isOutlier = [&](double fps) {
+        double deviationPercent = medianFps > 0 ? std::fabs(fps - medianFps) / medianFps * 100.0 : 0.0;
+        if (nodeFps.size() < 3 || deviationPercent <= options.outlierPercent) {
+            return false;
+        }
+        return mad == 0.0 || std::fabs(0.6745 * (fps - medianFps) / mad) > OUTLIER_Z;
+    };
+
+    JsonValue nodes = JsonValue::array();
+    std::cout << "\n=== Результаты по узлам ===" << std::endl;
+    std::cout << padded("Узел", 24, true) << padded("Кадров", 10, false) << padded("Ср. FPS", 12, false)
+              << padded("P50 мс", 10, false) << padded("P99 мс", 10, false) << padded("P99.9 мс", 11, false)
+              << "  GPU" << std::endl;
+    std::cout << std::fixed;
+    for (const auto& agent : agents) {
+        JsonValue node = JsonValue::object();
+        node.set("node", agent->node).set("address", agent->address).set("gpu", agent->gpu)
+            .set("driver", agent->driver).set("cpu", agent->cpu).set("clock_offset_ms", agent->offsetMs);
+        std::cout << padded(agent->node, 24, true);
+        if (!agent->done) {
+            node.set("status", "failed");
+            std::cout << "  нет результата" << std::endl;
+            nodes.push(node);
+            continue;
+        }
+        bool outlier = isOutlier(agent->avgFps);
+        node.set("status", outlier ? "outlier" : "ok")
+            .set("frames", agent->histogram.total())
+            .set("avg_fps", agent->avgFps)
+            .set("p50_ms", agent->histogram.percentile(50.0))
+            .set("p99_ms", agent->histogram.percentile(99.0))
+            .set("p999_ms", agent->histogram.percentile(99.9));
+        nodes.push(node);
+        std::cout << std::setw(10) << agent->histogram.total()
+                  << std::setw(12) << std::setprecision(2) << agent->avgFps
+                  << std::setw(10) << std::setprecision(3) << agent->histogram.percentile(50.0)
+                  << std::setw(10) << agent->histogram.percentile(99.0)
+                  << std::setw(11) << agent->histogram.percentile(99.9)
+                  << "  " << agent->gpu << (outlier ? "  <- ВЫБРОС" : "") << std::endl;
+    }
+
+    JsonValue fleet = JsonValue::object();
+    fleet.set("nodes", static_cast<int>(agents.size()))
+         .set("failed", failed)
+         .set("frames", fleetHistogram.total())
+         .set("throughput_fps", throughput)
+         .set("median_node_fps", medianFps);
+    std::cout << "\n=== Парк ===" << std::endl;
+    std::cout << "Узлов: " << agents.size() - failed << " из " << agents.size() << std::endl;
+    std::cout << "Суммарная производительность: " << std::setprecision(2) << throughput << " FPS" << std::endl;
+    if (!nodeFps.empty()) {
+        auto [minIt, maxIt] = std::minmax_element(nodeFps.begin(), nodeFps.end());
+        fleet.set("min_node_fps", *minIt).set("max_node_fps", *maxIt)
+             .set("p50_ms", fleetHistogram.percentile(50.0))
+             .set("p99_ms", fleetHistogram.percentile(99.0))
+             .set("p999_ms", fleetHistogram.percentile(99.9));
+        std::cout << "FPS узла: медиана " << medianFps << ", мин " << *minIt << ", макс " << *maxIt << std::endl;
+        std::cout << "Время кадра по парку: P50 " << std::setprecision(3) << fleetHistogram.percentile(50.0)
+                  << " мс, P99 " << fleetHistogram.percentile(99.0)
+                  << " мс, P99.9 " << fleetHistogram.percentile(99.9) << " мс" << std::endl;
+    }
+
+    if (!options.reportPath.empty()) {
+        JsonValue report = JsonValue::object();
+        report.set("scenario", scenarioToJson(options.scenario)).set("nodes", nodes).set("fleet", fleet);
+        std::ofstream file(options.reportPath);
+        file << report.dump() << "\n";
+        if (!file) {
+            std::cerr << "Failed to write report " << options.reportPath << std::endl;
+            return 1;
+        }
+        std::cout << "Отчет сохранен: " << options.reportPath << std::endl;
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+} // namespace
+
+bool splitHostPort(const std::string& address, std::string& host, int& port) {
+    size_t colon = address.rfind(':');
+    host = address.substr(0, colon);
+    port = FLEET_DEFAULT_PORT;
+    if (colon == std::string::npos) {
+        return !host.empty();
+    }
+    std::string portText = address.substr(colon + 1);
+    char* end = nullptr;
+    long value = std::strtol(portText.c_str(), &end, 10);
+    if (portText.empty() || *end != '\0' || value <= 0 || value > 65535) {
+        return false;
+    }
+    port = static_cast<int>(value);
+    return true;
+}
+
+int runCoordinator(const CoordinatorOptions& options) {
+    std::string error;
+    int listenFd = openListener(options.listenAddress, error);
+    if (listenFd < 0) {
+        std::cerr << "Failed to listen on " << options.listenAddress << ": " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Координатор: " << options.listenAddress << ", ждем агентов: " << options.agents << std::endl;
+
+    std::vector<std::unique_ptr<AgentState>> agents;
+    bool joined = acceptAgents(listenFd, options, agents);
+    ::close(listenFd);
+    if (!joined) {
+        return 1;
+    }
+
+    double maxRtt = 0.0;
+    for (auto& agent : agents) {
+        if (!syncClock(*agent)) {
+            markFailed(*agent, "no response to clock sync");
+            continue;
+        }
+        maxRtt = std::max(maxRtt, agent->rttMs);
+        std::cout << agent->node << ": сдвиг часов " << std::fixed << std::setprecision(1) << agent->offsetMs
+                  << " мс, задержка " << agent->rttMs << " мс" << std::endl;
+    }
+
+    // Шаг 3: общий старт, время переводится в часы каждого агента
+    double startMs = nowMs() + options.leadSec * 1000.0 + maxRtt;
+    JsonValue scenario = scenarioToJson(options.scenario);
+    for (auto& agent : agents) {
+        if (agent->failed) {
+            continue;
+        }
+        JsonValue start = JsonValue::object();
+        start.set("type", "start").set("at_ms", startMs + agent->offsetMs).set("scenario", scenario);
+        if (!sendMessage(agent->fd, start)) {
+            markFailed(*agent, "failed to send start");
+        }
+    }
+    std::cout << "Старт через " << std::setprecision(1) << (startMs - nowMs()) / 1000.0 << " с" << std::endl;
+
+    // Шаг 4: сбор результатов, суммарный FPS печатается, когда секунду прислали
+    // все работающие узлы. Узел отпал - ждать его секунды больше незачем
+    double deadlineMs = startMs + (options.scenario.warmupSec + options.scenario.durationSec + RESULT_GRACE_SEC) * 1000.0;
+    std::map<int, std::pair<int, double>> seconds; // секунда -> (узлов, сумма FPS)
+    auto printSecond = [](int second, int count, double sumFps) {
+        std::cout << "Время: " << std::setw(4) << second << "с | Узлов: " << count
+                  << " | Суммарный FPS: " << std::setw(10) << std::setprecision(2) << sumFps << std::endl;
+    };
+    // Печатает секунды, которые прислали все работающие узлы; all - и неполные
+    auto flushSeconds = [&](bool all) {
+        int active = static_cast<int>(std::count_if(agents.begin(), agents.end(),
+                                                    [](const auto& a) { return !a->failed; }));
+        for (auto it = seconds.begin(); it != seconds.end();) {
+            auto [count, sumFps] = it->second;
+            // Узел мог прислать секунду и отпасть: узлов в ней больше, чем работает
+            if (count >= active || all) {
+                printSecond(it->first, count, sumFps);
+                it = seconds.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+    while (nowMs() < deadlineMs) {
+        std::vector<pollfd> fds;
+        std::vector<AgentState*> owners;
+        for (auto& agent : agents) {
+            if (agent->fd >= 0 && !agent->done) {
+                fds.push_back({agent->fd, POLLIN, 0});
+                owners.push_back(agent.get());
+            }
+        }
+        if (fds.empty()) {
+            break;
+        }
+        if (poll(fds.data(), fds.size(), 200) <= 0) {
+            continue;
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            AgentState& agent = *owners[i];
+            if (!fds[i].revents) {
+                continue;
+            }
+            if (!receiveInto(agent.fd, agent.buffer)) {
+                markFailed(agent, "disconnected");
+                flushSeconds(false);
+                continue;
+            }
+            std::string line;
+            while (agent.fd >= 0 && takeLine(agent.buffer, line)) {
+                JsonValue message;
+                if (!parseJson(line, message, error)) {
+                    continue;
+                }
+                const std::string& type = message["type"].asString();
+                if (type == "sample") {
+                    int second = static_cast<int>(message["t"].asNumber());
+                    auto& [count, sumFps] = seconds[second];
+                    ++count;
+                    sumFps += message["fps"].asNumber();
+                    flushSeconds(false);
+                } else if (type == "done") {
+                    std::vector<uint64_t> counts(FrameTimeHistogram::BUCKET_COUNT, 0);
+                    for (const JsonValue& bucket : message["histogram"].items()) {
+                        if (!bucket.isArray() || bucket.size() != 2) {
+                            continue;
+                        }
+                        int index = static_cast<int>(bucket.items()[0].asNumber());
+                        if (index >= 0 && index < FrameTimeHistogram::BUCKET_COUNT) {
+                            counts[index] = static_cast<uint64_t>(bucket.items()[1].asNumber());
+                        }
+                    }
+                    agent.histogram = FrameTimeHistogram::fromCounts(counts);
+                    agent.avgFps = message["avg_fps"].asNumber();
+                    agent.done = true;
+                    std::cout << agent.node << ": готово, " << agent.histogram.total() << " кадров" << std::endl;
+                }
+            }
+        }
+    }
+    for (auto& agent : agents) {
+        if (!agent->done) {
+            markFailed(*agent, "no result before deadline");
+        }
+    }
+    flushSeconds(true);
+
+    return printReport(options, agents);
+}
+
+FleetAgent::~FleetAgent() {
+    close();
+}
+
+bool FleetAgent::connect(const std::string& address, std::string& error) {
+    std::string host;
+    int port = 0;
+    if (!splitHostPort(address, host, port)) {
+        error = "invalid coordinator address " + address;
+        return false;
+    }
+    addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result);
+    if (status != 0) {
+        error = gai_strerror(status);
+        return false;
+    }
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            fd_ = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(result);
+    if (fd_ < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    int noDelay = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    // Зависший координатор не должен останавливать рендеринг дольше секунды
+    timeval timeout {1, 0};
+    setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    return true;
+}
+
+void FleetAgent::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool FleetAgent::sendLine(const std::string& line) {
+    if (fd_ < 0) {
+        return false;
+    }
+    if (!sendAll(fd_, line + "\n")) {
+        std::cerr << "Lost connection to coordinator" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+int FleetAgent::readLine(std::string& line, int timeoutMs) {
+    return readLineFrom(fd_, buffer_, line, timeoutMs);
+}
+
+bool FleetAgent::sendHello(const std::string& node, const std::string& gpu, const std::string& driver, const std::string& cpu) {
+    JsonValue hello = JsonValue::object();
+    hello.set("type", "hello").set("node", node).set("gpu", gpu).set("driver", driver).set("cpu", cpu);
+    return sendLine(hello.dump());
+}
+
+bool FleetAgent::waitForStart(FleetScenario& scenario, std::chrono::system_clock::time_point& startAt,
+                              const std::function<bool()>& idle, std::string& error) {
+    while (fd_ >= 0) {
+        std::string line;
+        int status = readLine(line, 100);
+        if (status < 0) {
+            error = "coordinator closed the connection";
+            close();
+            return false;
+        }
+        if (status == 0) {
+            if (!idle()) {
+                error = "interrupted";
+                return false;
+            }
+            continue;
+        }
+
+        JsonValue message;
+        if (!parseJson(line, message, error)) {
+            continue;
+        }
+        const std::string& type = message["type"].asString();
+        if (type == "ping") {
+            JsonValue pong = JsonValue::object();
+            pong.set("type", "pong").set("t0", message["t0"]).set("t1", nowMs());
+            sendLine(pong.dump());
+        } else if (type == "start") {
+            const JsonValue& s = message["scenario"];
+            scenario.workload = s["workload"].isString() ? s["workload"].asString() : scenario.workload;
+            scenario.cubeSize = static_cast<int>(s["cube_size"].asNumber(scenario.cubeSize));
+            scenario.warmupSec = s["warmup"].asNumber(scenario.warmupSec);
+            scenario.durationSec = s["duration"].asNumber(scenario.durationSec);
+            auto at = std::chrono::duration<double, std::milli>(message["at_ms"].asNumber());
+            startAt = std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(at));
+            return true;
+        }
+    }
+    error = "not connected";
+    return false;
+}
+
+void FleetAgent::sendSample(double t, double fps, double fpsEstimate, double p50Ms, double p99Ms, uint64_t frames) {
+    JsonValue sample = JsonValue::object();
+    sample.set("type", "sample").set("t", t).set("fps", fps).set("fps_estimate", fpsEstimate)
+          .set("p50_ms", p50Ms).set("p99_ms", p99Ms).set("frames", frames);
+    sendLine(sample.dump());
+}
+
+void FleetAgent::sendDone(const FrameTimeHistogram& histogram, double avgFps) {
+    // Только непустые корзины: [[индекс, счетчик], ...]
+    JsonValue buckets = JsonValue::array();
+    const std::vector<uint64_t>& counts = histogram.counts();
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] > 0) {
+            JsonValue bucket = JsonValue::array();
+            bucket.push(static_cast<int>(i)).push(counts[i]);
+            buckets.push(bucket);
+        }
+    }
+    JsonValue done = JsonValue::object();
+    done.set("type", "done").set("frames", histogram.total()).set("avg_fps", avgFps).set("histogram", buckets);
+    sendLine(done.dump());
+}
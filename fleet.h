@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include "stats.h"
+
+// Прогон на нескольких машинах: координатор раздает сценарий, запускает
+// агентов в один момент времени и собирает их результаты.
+//
+// Протокол - JSON по строке через TCP:
+//   агент -> hello {node, gpu, driver, cpu}
+//   координатор -> ping {t0}, агент -> pong {t0, t1}  (оценка сдвига часов)
+//   координатор -> start {at_ms, scenario}           (at_ms - по часам агента)
+//   агент -> sample {t, fps, fps_estimate, p50_ms, p99_ms, frames} раз в секунду
+//   агент -> done {frames, avg_fps, histogram}
+
+constexpr int FLEET_DEFAULT_PORT = 7070;
+
+struct FleetScenario {
+    std::string workload = "cube";
+    int cubeSize = 3;
+    double warmupSec = 1.0;
+    double durationSec = 30.0;
+};
+
+struct CoordinatorOptions {
+    std::string listenAddress = "0.0.0.0:7070";
+    int agents = 1;
+    FleetScenario scenario;
+    double leadSec = 3.0;            // Запас до общего старта
+    double joinTimeoutSec = 300.0;   // Сколько ждать подключения всех агентов
+    double outlierPercent = 2.0;     // Отклонение от медианы, если разброс узлов нулевой
+    std::string reportPath;          // JSON отчет, пусто - только консоль
+};
+
+// Подкоманда coordinator, возвращает код завершения программы
+int runCoordinator(const CoordinatorOptions& options);
+
+// Сторона агента, работает в потоке рендеринга
+class FleetAgent {
+public:
+    ~FleetAgent();
+
+    bool connect(const std::string& address, std::string& error);
+    void close();
+    [[nodiscard]] bool isConnected() const { return fd_ >= 0; }
+
+    bool sendHello(const std::string& node, const std::string& gpu, const std::string& driver, const std::string& cpu);
+
+    // Отвечает на ping и ждет start. idle вызывается между ожиданиями,
+    // чтобы окно оставалось отзывчивым
+    bool waitForStart(FleetScenario& scenario, std::chrono::system_clock::time_point& startAt,
+                      const std::function<bool()>& idle, std::string& error);
+
+    void sendSample(double t, double fps, double fpsEstimate, double p50Ms, double p99Ms, uint64_t frames);
+    void sendDone(const FrameTimeHistogram& histogram, double avgFps);
+
+private:
+    bool sendLine(const std::string& line);
+    // 1 - строка прочитана, 0 - таймаут, -1 - соединение закрыто
+    int readLine(std::string& line, int timeoutMs);
+
+    int fd_ = -1;
+    std::string buffer_;
+};
+
+// host:port, порт по умолчанию FLEET_DEFAULT_PORT
+bool splitHostPort(const std::string& address, std::string& host, int& port);
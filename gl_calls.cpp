@@ -0,0 +1,48 @@
+#include "gl_calls.h"
+
+GlCallStats glCalls;
+
+const char* glCallKindName(int kind) {
+    switch (kind) {
+        case GL_CALL_DRAW: return "draw";
+        case GL_CALL_STATE: return "state";
+        case GL_CALL_UNIFORM: return "uniform";
+        case GL_CALL_LOOKUP: return "lookup";
+        case GL_CALL_UPLOAD: return "upload";
+        case GL_CALL_SYNC: return "sync";
+        case GL_CALL_OBJECT: return "object";
+        default: return "unknown";
+    }
+}
+
+const char* glCallPassName(int pass) {
+    return pass == GL_CALL_PASS_OTHER ? "other" : gpuPassName(pass);
+}
+
+uint64_t GlCallCounts::totalCalls() const {
+    uint64_t sum = 0;
+    for (uint64_t value : calls) {
+        sum += value;
+    }
+    return sum;
+}
+
+GlCallCounts& GlCallCounts::operator+=(const GlCallCounts& other) {
+    for (int kind = 0; kind < GL_CALL_KIND_COUNT; ++kind) {
+        calls[kind] += other.calls[kind];
+    }
+    bytes += other.bytes;
+    return *this;
+}
+
+void GlCallStats::endFrame() {
+    if (!enabled_) {
+        return;
+    }
+    for (int pass = 0; pass < GL_CALL_PASS_COUNT; ++pass) {
+        total_[pass] += frame_[pass];
+    }
+    lastFrame_ = frame_;
+    frame_ = {};
+    ++frames_;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "gpu_timer.h"
+
+// Виды вызовов GL, которые считает слой перехвата (gl_intercept.h)
+enum GlCallKind {
+    GL_CALL_DRAW,    // отрисовка и очистка
+    GL_CALL_STATE,   // привязки, включение возможностей, атрибуты
+    GL_CALL_UNIFORM, // glUniform*
+    GL_CALL_LOOKUP,  // glGetUniformLocation
+    GL_CALL_UPLOAD,  // загрузка и отображение буферов и текстур
+    GL_CALL_SYNC,    // fence
+    GL_CALL_OBJECT,  // создание и удаление объектов, сборка шейдеров
+    GL_CALL_KIND_COUNT
+};
+
+[[nodiscard]] const char* glCallKindName(int kind);
+
+// Вызовы вне проходов кадра (очистка, потоковые буферы) - отдельная строка
+constexpr int GL_CALL_PASS_OTHER = GPU_PASS_COUNT;
+constexpr int GL_CALL_PASS_COUNT = GPU_PASS_COUNT + 1;
+
+[[nodiscard]] const char* glCallPassName(int pass);
+
+struct GlCallCounts {
+    std::array<uint64_t, GL_CALL_KIND_COUNT> calls {};
+    uint64_t bytes = 0; // переданные драйверу данные: буферы, текстуры, uniform
+
+    [[nodiscard]] uint64_t totalCalls() const;
+    GlCallCounts& operator+=(const GlCallCounts& other);
+};
+
+using GlPassCalls = std::array<GlCallCounts, GL_CALL_PASS_COUNT>;
+
+// Счетчики вызовов GL по кадрам и проходам. Выключены по умолчанию, включаются
+// --gl-calls; выключенный слой стоит одной проверки на вызов
+class GlCallStats {
+public:
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    [[nodiscard]] bool enabled() const { return enabled_; }
+
+    void count(GlCallKind kind, uint64_t bytes = 0) {
+        if (enabled_) {
+            GlCallCounts& counts = frame_[pass_];
+            ++counts.calls[kind];
+            counts.bytes += bytes;
+        }
+    }
+    // Данные, записанные в постоянно отображенный буфер без вызова GL
+    void countMappedWrite(uint64_t bytes) {
+        if (enabled_) {
+            frame_[pass_].bytes += bytes;
+        }
+    }
+
+    void beginPass(GpuPass pass) { pass_ = pass; }
+    void endPass() { pass_ = GL_CALL_PASS_OTHER; }
+
+    // Закрывает кадр: счетчики кадра переходят в lastFrame()
+    void endFrame();
+    [[nodiscard]] const GlPassCalls& lastFrame() const { return lastFrame_; }
+    [[nodiscard]] const GlPassCalls& total() const { return total_; }
+    [[nodiscard]] uint64_t frames() const { return frames_; }
+
+private:
+    bool enabled_ = false;
+    int pass_ = GL_CALL_PASS_OTHER;
+    GlPassCalls frame_ {};
+    GlPassCalls lastFrame_ {};
+    GlPassCalls total_ {};
+    uint64_t frames_ = 0;
+};
+
+extern GlCallStats glCalls;
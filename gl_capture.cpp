@@ -0,0 +1,399 @@
+#include "gl_capture.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+
+#include "gl_capture_parser.h"
+#include "null_backend.h"
+#include "stats.h"
+
+GlCapture glCapture;
+
+namespace {
+
+float asFloat(int64_t bits) {
+    uint32_t raw = static_cast<uint32_t>(bits);
+    float value;
+    std::memcpy(&value, &raw, sizeof(value));
+    return value;
+}
+
+const void* asOffset(int64_t value) {
+    return reinterpret_cast<const void*>(static_cast<uintptr_t>(value));
+}
+
+void execute(const ReplayCommand& c, std::vector<GLuint>& names, std::vector<GLint>& locations) {
+    const int64_t* a = c.args;
+    switch (c.op) {
+        case GlOp::Clear: glClear(static_cast<GLbitfield>(a[0])); break;
+        case GlOp::DrawArrays: glDrawArrays(a[0], a[1], a[2]); break;
+        case GlOp::DrawElements: glDrawElements(a[0], a[1], a[2], asOffset(a[3])); break;
+        case GlOp::DrawArraysInstanced: glDrawArraysInstanced(a[0], a[1], a[2], a[3]); break;
+        case GlOp::DrawElementsInstanced: glDrawElementsInstanced(a[0], a[1], a[2], asOffset(a[3]), a[4]); break;
+        case GlOp::MultiDrawArrays: {
+            auto* firsts = reinterpret_cast<const GLint*>(c.data);
+            glMultiDrawArrays(a[0], firsts, firsts + a[1], a[1]);
+            break;
+        }
+        case GlOp::MultiDrawElements: {
+            auto* counts = reinterpret_cast<const GLsizei*>(c.data);
+            auto* offsets = reinterpret_cast<const void* const*>(c.data + a[2] * sizeof(GLsizei));
+            glMultiDrawElements(a[0], counts, a[1], offsets, a[2]);
+            break;
+        }
+        case GlOp::ClearColor: glClearColor(asFloat(a[0]), asFloat(a[1]), asFloat(a[2]), asFloat(a[3])); break;
+        case GlOp::Viewport: glViewport(a[0], a[1], a[2], a[3]); break;
+        case GlOp::UseProgram: glUseProgram(names[a[0]]); break;
+        case GlOp::BindVertexArray: glBindVertexArray(names[a[0]]); break;
+        case GlOp::BindBuffer: glBindBuffer(a[0], names[a[1]]); break;
+        case GlOp::BindTexture: glBindTexture(a[0], names[a[1]]); break;
+        case GlOp::ActiveTexture: glActiveTexture(a[0]); break;
+        case GlOp::Enable: glEnable(a[0]); break;
+        case GlOp::Disable: glDisable(a[0]); break;
+        case GlOp::BlendFunc: glBlendFunc(a[0], a[1]); break;
+        case GlOp::PointSize: glPointSize(asFloat(a[0])); break;
+        case GlOp::VertexAttribPointer: glVertexAttribPointer(a[0], a[1], a[2], a[3], a[4], asOffset(a[5])); break;
+        case GlOp::EnableVertexAttribArray: glEnableVertexAttribArray(a[0]); break;
+        case GlOp::VertexAttribDivisor: glVertexAttribDivisor(a[0], a[1]); break;
+        case GlOp::PixelStorei: glPixelStorei(a[0], a[1]); break;
+        case GlOp::TexParameteri: glTexParameteri(a[0], a[1], a[2]); break;
+        case GlOp::GetUniformLocation: {
+            std::string name(reinterpret_cast<const char*>(c.data), c.size);
+            GLint location = glGetUniformLocation(names[a[0]], name.c_str());
+            if (a[1] >= 0) {
+                locations[a[1]] = location;
+            }
+            break;
+        }
+        case GlOp::Uniform1i: glUniform1i(locations[a[0]], static_cast<GLint>(a[1])); break;
+        case GlOp::Uniform1f: glUniform1f(locations[a[0]], asFloat(a[1])); break;
+        case GlOp::Uniform3f: glUniform3f(locations[a[0]], asFloat(a[1]), asFloat(a[2]), asFloat(a[3])); break;
+        case GlOp::Uniform3fv:
+            glUniform3fv(locations[a[0]], a[1], reinterpret_cast<const GLfloat*>(c.data));
+            break;
+        case GlOp::UniformMatrix4fv:
+            glUniformMatrix4fv(locations[a[0]], a[1], a[2], reinterpret_cast<const GLfloat*>(c.data));
+            break;
+        case GlOp::BufferData: glBufferData(a[0], a[1], a[3] ? c.data : nullptr, a[2]); break;
+        case GlOp::BufferSubData: glBufferSubData(a[0], a[1], c.size, c.data); break;
+        case GlOp::MapWrite:
+            if (void* pointer = glMapBufferRange(a[0], a[1], c.size, static_cast<GLbitfield>(a[2]))) {
+                std::memcpy(pointer, c.data, c.size);
+                glUnmapBuffer(a[0]);
+            }
+            break;
+        case GlOp::TexImage2D:
+            glTexImage2D(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], c.size ? c.data : nullptr);
+            break;
+        case GlOp::GenBuffer: glGenBuffers(1, &names[a[0]]); break;
+        case GlOp::GenVertexArray: glGenVertexArrays(1, &names[a[0]]); break;
+        case GlOp::GenTexture: glGenTextures(1, &names[a[0]]); break;
+        case GlOp::DeleteBuffer: glDeleteBuffers(1, &names[a[0]]); break;
+        case GlOp::DeleteVertexArray: glDeleteVertexArrays(1, &names[a[0]]); break;
+        case GlOp::CreateShader: names[a[1]] = glCreateShader(a[0]); break;
+        case GlOp::ShaderSource: {
+            auto* source = reinterpret_cast<const GLchar*>(c.data);
+            GLint length = static_cast<GLint>(c.size);
+            glShaderSource(names[a[0]], 1, &source, &length);
+            break;
+        }
+        case GlOp::CompileShader: glCompileShader(names[a[0]]); break;
+        case GlOp::CreateProgram: names[a[0]] = glCreateProgram(); break;
+        case GlOp::AttachShader: glAttachShader(names[a[0]], names[a[1]]); break;
+        case GlOp::LinkProgram: glLinkProgram(names[a[0]]); break;
+        case GlOp::DeleteShader: glDeleteShader(names[a[0]]); break;
+        default: break;
+    }
+}
+
+// Шейдер или программа из записи не собрались на этом драйвере: без них
+// повтор мерил бы кадры, которые ничего не рисуют
+bool checkBuilt(const ReplayCommand& c, const std::vector<GLuint>& names, std::string& error) {
+    GLint success = GL_TRUE;
+    char infoLog[1024] = "";
+    if (c.op == GlOp::CompileShader) {
+        glGetShaderiv(names[c.args[0]], GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(names[c.args[0]], sizeof(infoLog), nullptr, infoLog);
+            error = std::string("shader compilation failed:\n") + infoLog;
+        }
+    } else if (c.op == GlOp::LinkProgram) {
+        glGetProgramiv(names[c.args[0]], GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(names[c.args[0]], sizeof(infoLog), nullptr, infoLog);
+            error = std::string("program linking failed:\n") + infoLog;
+        }
+    }
+    return success != GL_FALSE;
+}
+
+} // namespace
+
+void GlCapture::begin(int frames, int width, int height) {
+    recording_ = frames > 0;
+    inFrames_ = false;
+    targetFrames_ = frames;
+    capturedFrames_ = 0;
+    width_ = static_cast<uint64_t>(width);
+    height_ = static_cast<uint64_t>(height);
+    const GLubyte* renderer = nullBackend.active() ? nullptr : glGetString(GL_RENDERER);
+    renderer_ = renderer ? reinterpret_cast<const char*>(renderer) : "";
+    stream_.clear();
+    frameStart_ = 0;
+    frameResources_ = false;
+    previousFrameStart_ = NO_FRAME;
+    previousFrameResources_ = false;
+    droppedWarmupFrames_ = 0;
+    boundBuffers_.clear();
+    bufferSizes_.clear();
+    uniformLocations_.clear();
+}
+
+void GlCapture::notePrologue(GlOp op, const int64_t* args) {
+    switch (op) {
+        case GlOp::BindBuffer:
+            boundBuffers_[args[0]] = args[1];
+            break;
+        case GlOp::BufferData: {
+            // Тот же размер - переотображение потокового буфера, данные кадра
+            int64_t buffer = boundBuffers_[args[0]];
+            auto it = bufferSizes_.find(buffer);
+            if (it == bufferSizes_.end() || it->second != args[1]) {
+                bufferSizes_[buffer] = args[1];
+                frameResources_ = true;
+            }
+            break;
+        }
+        case GlOp::GetUniformLocation:
+            if (uniformLocations_.emplace(args[0], args[1]).second) {
+                frameResources_ = true;
+            }
+            break;
+        case GlOp::VertexAttribPointer:
+        case GlOp::EnableVertexAttribArray:
+        case GlOp::VertexAttribDivisor:
+        case GlOp::PixelStorei:
+        case GlOp::TexParameteri:
+        case GlOp::TexImage2D:
+        case GlOp::GenBuffer:
+        case GlOp::GenVertexArray:
+        case GlOp::GenTexture:
+        case GlOp::DeleteBuffer:
+        case GlOp::DeleteVertexArray:
+        case GlOp::CreateShader:
+        case GlOp::ShaderSource:
+        case GlOp::CompileShader:
+        case GlOp::CreateProgram:
+        case GlOp::AttachShader:
+        case GlOp::LinkProgram:
+        case GlOp::DeleteShader:
+            frameResources_ = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void GlCapture::startFrames() {
+    if (recording_ && !inFrames_) {
+        record(GlOp::EndPrologue);
+        inFrames_ = true;
+        if (droppedWarmupFrames_ > 0) {
+            std::cout << "Запись команд GL: из пролога убрано кадров прогрева без новых объектов: "
+                      << droppedWarmupFrames_ << std::endl;
+        }
+    }
+}
+
+bool GlCapture::endFrame() {
+    if (recording_ && !inFrames_) {
+        // Прошлый кадр прогрева без новых объектов не нужен: его состояние
+        // перекрывает только что законченный
+        if (previousFrameStart_ != NO_FRAME && !previousFrameResources_) {
+            stream_.erase(stream_.begin() + static_cast<std::ptrdiff_t>(previousFrameStart_),
+                          stream_.begin() + static_cast<std::ptrdiff_t>(frameStart_));
+            frameStart_ = previousFrameStart_;
+            ++droppedWarmupFrames_;
+        }
+        previousFrameStart_ = frameStart_;
+        previousFrameResources_ = frameResources_;
+        frameStart_ = stream_.size();
+        frameResources_ = false;
+        return false;
+    }
+    if (!inFrames()) {
+        return false;
+    }
+    record(GlOp::EndFrame);
+    if (++capturedFrames_ < targetFrames_) {
+        return false;
+    }
+    recording_ = false;
+    inFrames_ = false;
+    return true;
+}
+
+bool GlCapture::save(const std::string& path, std::string& error) {
+    std::vector<uint8_t> header(CAPTURE_MAGIC, CAPTURE_MAGIC + CAPTURE_MAGIC_SIZE);
+    std::swap(header, stream_);
+    putVarint(width_);
+    putVarint(height_);
+    putVarint(static_cast<uint64_t>(capturedFrames_));
+    putBytes(renderer_.data(), renderer_.size());
+    std::swap(header, stream_);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    file.write(reinterpret_cast<const char*>(stream_.data()), static_cast<std::streamsize>(stream_.size()));
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+void GlCapture::putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        stream_.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    stream_.push_back(static_cast<uint8_t>(value));
+}
+
+void GlCapture::putBytes(const void* data, size_t size) {
+    putVarint(size);
+    auto* bytes = static_cast<const uint8_t*>(data);
+    stream_.insert(stream_.end(), bytes, bytes + size);
+}
+
+int replayCapture(const std::string& path, double durationSec) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Не удалось открыть запись: " << path << std::endl;
+        return -1;
+    }
+    std::vector<uint8_t> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (content.size() < CAPTURE_MAGIC_SIZE || std::memcmp(content.data(), CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE) != 0) {
+        std::cerr << path << ": not a GL capture" << std::endl;
+        return -1;
+    }
+
+    CaptureReader reader(content.data() + CAPTURE_MAGIC_SIZE, content.size() - CAPTURE_MAGIC_SIZE);
+    uint64_t width = 0, height = 0, frames = 0;
+    const uint8_t* rendererData = nullptr;
+    size_t rendererSize = 0;
+    if (!reader.varint(width) || !reader.varint(height) || !reader.varint(frames) ||
+        !reader.bytes(rendererData, rendererSize)) {
+        std::cerr << path << ": truncated header" << std::endl;
+        return -1;
+    }
+    CaptureParser parser;
+    std::string error;
+    if (!parser.parse(reader, error)) {
+        std::cerr << path << ": " << error << std::endl;
+        return -1;
+    }
+    if (parser.prologueEnd == parser.commands.size()) {
+        std::cerr << path << ": no frames" << std::endl;
+        return -1;
+    }
+
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(static_cast<int>(width), static_cast<int>(height),
+                                          "Rubik GPU Benchmark - replay", nullptr, nullptr);
+    if (window == nullptr) {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (glewInit() != GLEW_OK) {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwSwapInterval(0);
+
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    std::cout << "Запись: " << path << ", " << frames << " кадров, " << parser.commands.size() - parser.prologueEnd
+              << " команд в кадрах, " << std::fixed << std::setprecision(1) << content.size() / (1024.0 * 1024.0) << " MB" << std::endl;
+    std::cout << "Записано на: " << std::string(reinterpret_cast<const char*>(rendererData), rendererSize) << std::endl;
+    std::cout << "Повтор на:   " << (renderer ? reinterpret_cast<const char*>(renderer) : "?") << std::endl;
+
+    std::vector<GLuint> names(parser.nameSlots, 0);
+    std::vector<GLint> locations(parser.locationDefaults.begin(), parser.locationDefaults.end());
+    const ReplayCommand* commands = parser.commands.data();
+    const ReplayCommand* framesBegin = commands + parser.prologueEnd;
+    const ReplayCommand* framesEnd = commands + parser.commands.size();
+    for (const ReplayCommand* c = commands; c != framesBegin; ++c) {
+        execute(*c, names, locations);
+        if (!checkBuilt(*c, names, error)) {
+            std::cerr << path << ": " << error << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+    }
+
+    // Цикл повтора: только команды, обмен буферов и события окна
+    // Как и у прогона, память не растет с длительностью
+    FrameTimeReservoir frameTimes;
+    double submitSumMs = 0.0;
+    // Сборку шейдеров в кадрах проверяем на первом проходе, дальше без glGet
+    bool firstPass = true;
+    auto start = std::chrono::steady_clock::now();
+    auto frameStart = start;
+    const ReplayCommand* c = framesBegin;
+    while (!glfwWindowShouldClose(window)) {
+        for (; c->op != GlOp::EndFrame; ++c) {
+            execute(*c, names, locations);
+            if (firstPass && !checkBuilt(*c, names, error)) {
+                std::cerr << path << ": " << error << std::endl;
+                glfwTerminate();
+                return -1;
+            }
+        }
+        auto submitted = std::chrono::steady_clock::now();
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        if (++c == framesEnd) {
+            c = framesBegin;
+            firstPass = false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        submitSumMs += std::chrono::duration<double, std::milli>(submitted - frameStart).count();
+        frameTimes.add(std::chrono::duration<float, std::milli>(now - frameStart).count());
+        frameStart = now;
+        if (std::chrono::duration<double>(now - start).count() >= durationSec) {
+            break;
+        }
+    }
+    double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    glfwTerminate();
+
+    if (frameTimes.seen() == 0) {
+        return 0;
+    }
+    std::vector<float> sorted = frameTimes.release();
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << "\nПовтор завершен: " << frameTimes.seen() << " кадров за " << std::setprecision(1) << elapsedSec << " с" << std::endl;
+    std::cout << "FPS: " << std::setprecision(2) << frameTimes.seen() / elapsedSec << std::endl;
+    std::cout << "Отправка команд: " << std::setprecision(3) << submitSumMs / frameTimes.seen() << " мс/кадр" << std::endl;
+    std::cout << "Время кадра P50/P99: " << percentileSorted(sorted, 50.0) << " / " << percentileSorted(sorted, 99.0)
+              << " мс" << std::endl;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Операции записанного потока команд GL. Номера пишутся в файл - новые только в конец
+enum class GlOp : uint8_t {
+    EndPrologue,
+    EndFrame,
+
+    // Отрисовка
+    Clear,
+    DrawArrays,
+    DrawElements,
+    DrawArraysInstanced,
+    DrawElementsInstanced,
+    MultiDrawArrays,
+    MultiDrawElements,
+
+    // Состояние
+    ClearColor,
+    Viewport,
+    UseProgram,
+    BindVertexArray,
+    BindBuffer,
+    BindTexture,
+    ActiveTexture,
+    Enable,
+    Disable,
+    BlendFunc,
+    PointSize,
+    VertexAttribPointer,
+    EnableVertexAttribArray,
+    VertexAttribDivisor,
+    PixelStorei,
+    TexParameteri,
+
+    // Uniform
+    GetUniformLocation,
+    Uniform1i,
+    Uniform1f,
+    Uniform3f,
+    Uniform3fv,
+    UniformMatrix4fv,
+
+    // Данные
+    BufferData,
+    BufferSubData,
+    MapWrite,
+    TexImage2D,
+
+    // Объекты
+    GenBuffer,
+    GenVertexArray,
+    GenTexture,
+    DeleteBuffer,
+    DeleteVertexArray,
+    CreateShader,
+    ShaderSource,
+    CompileShader,
+    CreateProgram,
+    AttachShader,
+    LinkProgram,
+    DeleteShader,
+
+    Count
+};
+
+// Запись потока команд GL для прогона без кода приложения (rgbench replay).
+// Пишется с момента создания контекста: настройка и кадры прогрева попадают в
+// пролог (без отрисовки, только создание объектов и состояние), следующие N
+// кадров - в тело цикла повтора. Из кадров прогрева в прологе остаются те,
+// что создают или переопределяют объекты, и последний - его состояние
+// застают кадры тела; uniform и привязки остальных перекрыты им. Аргументы - zigzag varint, данные загрузок и
+// исходники шейдеров копируются целиком. Файл пишется, когда записаны все кадры
+//
+// Формат файла: "RGBCAP1\n", varint ширина, высота, число кадров, строка
+// GL_RENDERER (varint длина + байты), затем поток: байт операции, аргументы,
+// у операций с данными - varint длина и байты
+class GlCapture {
+public:
+    void begin(int frames, int width, int height);
+    [[nodiscard]] bool recording() const { return recording_; }
+    // Идут кадры тела цикла: отрисовка и записи в отображенные буферы пишутся
+    [[nodiscard]] bool inFrames() const { return recording_ && inFrames_; }
+
+    // Конец пролога, со следующего вызова пишутся кадры
+    void startFrames();
+    // Конец кадра. true - записаны все кадры, пора вызвать save()
+    bool endFrame();
+    bool save(const std::string& path, std::string& error);
+    [[nodiscard]] int frames() const { return capturedFrames_; }
+    [[nodiscard]] size_t size() const { return stream_.size(); }
+
+    template <typename... Args>
+    void record(GlOp op, Args... args) {
+        if (recording_) {
+            if (!inFrames_) {
+                const int64_t values[] = {argValue(args)..., 0};
+                notePrologue(op, values);
+            }
+            stream_.push_back(static_cast<uint8_t>(op));
+            (put(args), ...);
+        }
+    }
+    // То же с данными после аргументов
+    template <typename... Args>
+    void recordData(GlOp op, const void* data, size_t size, Args... args) {
+        if (recording_) {
+            record(op, args...);
+            putBytes(data, size);
+        }
+    }
+
+private:
+    // Все аргументы - zigzag varint, float - его биты
+    template <typename T>
+    static int64_t argValue(T value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            float f = static_cast<float>(value);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        } else if constexpr (std::is_pointer_v<T>) {
+            return static_cast<int64_t>(reinterpret_cast<uintptr_t>(value));
+        } else {
+            return static_cast<int64_t>(value);
+        }
+    }
+    template <typename T>
+    void put(T value) {
+        int64_t signedValue = argValue(value);
+        putVarint((static_cast<uint64_t>(signedValue) << 1) ^ static_cast<uint64_t>(signedValue >> 63));
+    }
+    // Пролог: отмечает кадр прогрева, который создает объекты
+    void notePrologue(GlOp op, const int64_t* args);
+    void putVarint(uint64_t value);
+    void putBytes(const void* data, size_t size);
+
+    bool recording_ = false;
+    bool inFrames_ = false;
+    int targetFrames_ = 0;
+    int capturedFrames_ = 0;
+    uint64_t width_ = 0;
+    uint64_t height_ = 0;
+    std::string renderer_;
+    std::vector<uint8_t> stream_;
+
+    // Кадры прогрева: начало текущего и прошлого в stream_
+    static constexpr size_t NO_FRAME = static_cast<size_t>(-1);
+    size_t frameStart_ = 0;
+    bool frameResources_ = false;
+    size_t previousFrameStart_ = NO_FRAME;
+    bool previousFrameResources_ = false;
+    int droppedWarmupFrames_ = 0;
+    std::map<int64_t, int64_t> boundBuffers_;   // Цель -> буфер
+    std::map<int64_t, int64_t> bufferSizes_;    // Буфер -> размер последнего BufferData
+    std::set<std::pair<int64_t, int64_t>> uniformLocations_;
+};
+
+extern GlCapture glCapture;
+
+// Повтор записанного потока: пролог один раз, затем кадры по кругу в течение
+// durationSec. Печатает FPS и перцентили времени кадра
+int replayCapture(const std::string& path, double durationSec);
@@ -0,0 +1,301 @@
+#include "gl_capture_parser.h"
+
+#include <GL/glew.h>
+
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+struct OpInfo {
+    int args;
+    bool data;
+};
+
+// Число аргументов и наличие данных по операциям, в порядке GlOp
+constexpr OpInfo OP_INFO[] = {
+    {0, false}, // EndPrologue
+    {0, false}, // EndFrame
+    {1, false}, // Clear
+    {3, false}, // DrawArrays
+    {4, false}, // DrawElements
+    {4, false}, // DrawArraysInstanced
+    {5, false}, // DrawElementsInstanced
+    {2, true},  // MultiDrawArrays: mode, drawCount; first[], count[]
+    {3, true},  // MultiDrawElements: mode, type, drawCount; count[], uint64 offset[]
+    {4, false}, // ClearColor
+    {4, false}, // Viewport
+    {1, false}, // UseProgram
+    {1, false}, // BindVertexArray
+    {2, false}, // BindBuffer
+    {2, false}, // BindTexture
+    {1, false}, // ActiveTexture
+    {1, false}, // Enable
+    {1, false}, // Disable
+    {2, false}, // BlendFunc
+    {1, false}, // PointSize
+    {6, false}, // VertexAttribPointer
+    {1, false}, // EnableVertexAttribArray
+    {2, false}, // VertexAttribDivisor
+    {2, false}, // PixelStorei
+    {3, false}, // TexParameteri
+    {2, true},  // GetUniformLocation: program, location; name
+    {2, false}, // Uniform1i
+    {2, false}, // Uniform1f
+    {4, false}, // Uniform3f
+    {2, true},  // Uniform3fv
+    {3, true},  // UniformMatrix4fv
+    {4, true},  // BufferData: target, size, usage, hasData
+    {2, true},  // BufferSubData
+    {3, true},  // MapWrite: target, offset, access
+    {8, true},  // TexImage2D
+    {1, false}, // GenBuffer
+    {1, false}, // GenVertexArray
+    {1, false}, // GenTexture
+    {1, false}, // DeleteBuffer
+    {1, false}, // DeleteVertexArray
+    {2, false}, // CreateShader
+    {1, true},  // ShaderSource
+    {1, false}, // CompileShader
+    {1, false}, // CreateProgram
+    {2, false}, // AttachShader
+    {1, false}, // LinkProgram
+    {1, false}, // DeleteShader
+};
+static_assert(std::size(OP_INFO) == static_cast<size_t>(GlOp::Count), "OP_INFO out of sync with GlOp");
+
+bool isCount(int64_t value) {
+    return value >= 0 && value <= INT32_MAX;
+}
+
+bool invalid(const ReplayCommand& c, const char* what, std::string& error) {
+    error = std::string("invalid ") + what + " in operation " + std::to_string(static_cast<int>(c.op));
+    return false;
+}
+
+// Байт на пиксель как у textureBytes в gl_intercept.h: так размер считает запись
+uint64_t pixelBytes(int64_t format, int64_t type) {
+    uint64_t components = 4;
+    switch (format) {
+        case GL_RED: components = 1; break;
+        case GL_RG: components = 2; break;
+        case GL_RGB: case GL_BGR: components = 3; break;
+        default: break;
+    }
+    return components * (type == GL_UNSIGNED_BYTE || type == GL_BYTE ? 1 : 4);
+}
+
+uint64_t textureBytes(int64_t width, int64_t height, int64_t format, int64_t type) {
+    return static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * pixelBytes(format, type);
+}
+
+} // namespace
+
+bool CaptureParser::parse(CaptureReader& reader, std::string& error) {
+    std::vector<size_t> payloadOffsets;
+    while (!reader.done()) {
+        uint8_t opByte = reader.byte();
+        if (opByte >= static_cast<uint8_t>(GlOp::Count)) {
+            error = "unknown operation " + std::to_string(opByte);
+            return false;
+        }
+        ReplayCommand command {};
+        command.op = static_cast<GlOp>(opByte);
+        const OpInfo& info = OP_INFO[opByte];
+        for (int i = 0; i < info.args; ++i) {
+            if (!reader.signedVarint(command.args[i])) {
+                error = "truncated stream";
+                return false;
+            }
+        }
+        if (info.data) {
+            const uint8_t* data = nullptr;
+            if (!reader.bytes(data, command.size)) {
+                error = "truncated stream";
+                return false;
+            }
+            size_t offset = payload.size();
+            if (command.size > 0) {
+                payload.resize(offset + (command.size + 7) / 8);
+                std::memcpy(payload.data() + offset, data, command.size);
+            }
+            payloadOffsets.push_back(offset);
+        }
+        if (!validate(command, error)) {
+            return false;
+        }
+        translate(command);
+        if (command.op == GlOp::EndPrologue) {
+            prologueEnd = commands.size();
+            continue;
+        }
+        commands.push_back(command);
+    }
+    if (commands.empty() || commands.back().op != GlOp::EndFrame) {
+        error = "truncated stream";
+        return false;
+    }
+
+    size_t next = 0;
+    for (ReplayCommand& command : commands) {
+        if (OP_INFO[static_cast<size_t>(command.op)].data) {
+            command.data = reinterpret_cast<const uint8_t*>(payload.data() + payloadOffsets[next++]);
+        }
+    }
+    return true;
+}
+
+// Данные команды должны совпадать с ее аргументами: иначе повтор передаст
+// драйверу указатель за конец записи. Аргументы еще не переведены в индексы
+bool CaptureParser::validate(const ReplayCommand& c, std::string& error) {
+    const int64_t* a = c.args;
+    uint64_t expected = c.size;
+    switch (c.op) {
+        case GlOp::MultiDrawArrays:
+            if (!isCount(a[1])) {
+                return invalid(c, "draw count", error);
+            }
+            expected = static_cast<uint64_t>(a[1]) * 2 * sizeof(int32_t);
+            break;
+        case GlOp::MultiDrawElements:
+            if (!isCount(a[2])) {
+                return invalid(c, "draw count", error);
+            }
+            expected = static_cast<uint64_t>(a[2]) * (sizeof(int32_t) + sizeof(uint64_t));
+            break;
+        case GlOp::Uniform3fv:
+        case GlOp::UniformMatrix4fv:
+            if (!isCount(a[1])) {
+                return invalid(c, "uniform count", error);
+            }
+            expected = static_cast<uint64_t>(a[1]) * (c.op == GlOp::Uniform3fv ? 3 : 16) * sizeof(float);
+            break;
+        case GlOp::BufferData:
+            if (a[1] < 0) {
+                return invalid(c, "buffer size", error);
+            }
+            expected = a[3] ? static_cast<uint64_t>(a[1]) : 0;
+            break;
+        case GlOp::BufferSubData:
+        case GlOp::MapWrite:
+            if (a[1] < 0) {
+                return invalid(c, "buffer offset", error);
+            }
+            break;
+        case GlOp::PixelStorei:
+            if (a[0] == GL_UNPACK_ALIGNMENT) {
+                unpackAlignment_ = a[1];
+            }
+            break;
+        case GlOp::TexImage2D:
+            if (!isCount(a[3]) || !isCount(a[4])) {
+                return invalid(c, "texture size", error);
+            }
+            if (c.size > 0) {
+                expected = textureBytes(a[3], a[4], a[6], a[7]);
+                if (expected != c.size || unpackedBytes(a[3], a[4], a[6], a[7]) > c.size) {
+                    return invalid(c, "texture data size", error);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    if (expected != c.size) {
+        return invalid(c, "data size", error);
+    }
+    return true;
+}
+
+uint64_t CaptureParser::unpackedBytes(int64_t width, int64_t height, int64_t format, int64_t type) const {
+    if (width == 0 || height == 0) {
+        return 0;
+    }
+    uint64_t row = static_cast<uint64_t>(width) * pixelBytes(format, type);
+    uint64_t alignment = unpackAlignment_ > 0 ? static_cast<uint64_t>(unpackAlignment_) : 1;
+    uint64_t stride = (row + alignment - 1) / alignment * alignment;
+    return stride * static_cast<uint64_t>(height - 1) + row;
+}
+
+// Новый объект с этим именем: следующие ссылки идут в новую ячейку
+int64_t CaptureParser::define(NameKind kind, int64_t name) {
+    size_t slot = nameSlots++;
+    names_[{kind, name}] = slot;
+    return static_cast<int64_t>(slot);
+}
+
+int64_t CaptureParser::use(NameKind kind, int64_t name) {
+    if (name == 0) {
+        return 0;
+    }
+    auto it = names_.find({kind, name});
+    // Объект создан до записи - такого быть не должно, привязываем к 0
+    return it != names_.end() ? static_cast<int64_t>(it->second) : 0;
+}
+
+int64_t CaptureParser::location(int64_t program, int64_t location) {
+    if (location < 0) {
+        return 0;
+    }
+    auto it = locations_.find({program, location});
+    if (it != locations_.end()) {
+        return static_cast<int64_t>(it->second);
+    }
+    // Расположение не запрашивалось при записи - используем записанное как есть
+    locations_[{program, location}] = locationSlots;
+    locationDefaults.push_back(location);
+    return static_cast<int64_t>(locationSlots++);
+}
+
+void CaptureParser::translate(ReplayCommand& c) {
+    switch (c.op) {
+        case GlOp::UseProgram:
+            c.args[0] = currentProgram_ = use(NAME_PROGRAM, c.args[0]);
+            break;
+        case GlOp::BindVertexArray: c.args[0] = use(NAME_VERTEX_ARRAY, c.args[0]); break;
+        case GlOp::BindBuffer: c.args[1] = use(NAME_BUFFER, c.args[1]); break;
+        case GlOp::BindTexture: c.args[1] = use(NAME_TEXTURE, c.args[1]); break;
+        case GlOp::GetUniformLocation: {
+            int64_t program = use(NAME_PROGRAM, c.args[0]);
+            c.args[0] = program;
+            if (c.args[1] >= 0) {
+                // Повторный запрос того же uniform пишет в ту же ячейку
+                auto key = std::make_pair(program, c.args[1]);
+                auto it = locations_.find(key);
+                if (it == locations_.end()) {
+                    it = locations_.emplace(key, locationSlots++).first;
+                    locationDefaults.push_back(c.args[1]);
+                }
+                c.args[1] = static_cast<int64_t>(it->second);
+            } else {
+                c.args[1] = -1;
+            }
+            break;
+        }
+        case GlOp::Uniform1i:
+        case GlOp::Uniform1f:
+        case GlOp::Uniform3f:
+        case GlOp::Uniform3fv:
+        case GlOp::UniformMatrix4fv:
+            c.args[0] = location(currentProgram_, c.args[0]);
+            break;
+        case GlOp::GenBuffer: c.args[0] = define(NAME_BUFFER, c.args[0]); break;
+        case GlOp::GenVertexArray: c.args[0] = define(NAME_VERTEX_ARRAY, c.args[0]); break;
+        case GlOp::GenTexture: c.args[0] = define(NAME_TEXTURE, c.args[0]); break;
+        case GlOp::DeleteBuffer: c.args[0] = use(NAME_BUFFER, c.args[0]); break;
+        case GlOp::DeleteVertexArray: c.args[0] = use(NAME_VERTEX_ARRAY, c.args[0]); break;
+        case GlOp::CreateShader: c.args[1] = define(NAME_SHADER, c.args[1]); break;
+        case GlOp::ShaderSource:
+        case GlOp::CompileShader:
+        case GlOp::DeleteShader:
+            c.args[0] = use(NAME_SHADER, c.args[0]);
+            break;
+        case GlOp::CreateProgram: c.args[0] = define(NAME_PROGRAM, c.args[0]); break;
+        case GlOp::AttachShader:
+            c.args[0] = use(NAME_PROGRAM, c.args[0]);
+            c.args[1] = use(NAME_SHADER, c.args[1]);
+            break;
+        case GlOp::LinkProgram: c.args[0] = use(NAME_PROGRAM, c.args[0]); break;
+        default: break;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gl_capture.h"
+
+// Разбор файла записи для rgbench replay (формат - в gl_capture.h). Без
+// вызовов GL, чтобы проверка потока команд работала и в тестах
+constexpr char CAPTURE_MAGIC[] = "RGBCAP1\n";
+constexpr size_t CAPTURE_MAGIC_SIZE = sizeof(CAPTURE_MAGIC) - 1;
+constexpr int CAPTURE_MAX_ARGS = 8;
+
+// Команда повтора: имена объектов и uniform заменены индексами в таблицах,
+// которые заполняются при выполнении Gen/Create и GetUniformLocation
+struct ReplayCommand {
+    GlOp op;
+    int64_t args[CAPTURE_MAX_ARGS];
+    const uint8_t* data;
+    size_t size;
+};
+
+class CaptureReader {
+public:
+    CaptureReader(const uint8_t* data, size_t size) : pos_(data), end_(data + size) {}
+
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos_ == end_) {
+                return false;
+            }
+            uint8_t byte = *pos_++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    bool signedVarint(int64_t& value) {
+        uint64_t raw;
+        if (!varint(raw)) {
+            return false;
+        }
+        value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        return true;
+    }
+    bool bytes(const uint8_t*& data, size_t& size) {
+        uint64_t length;
+        if (!varint(length) || length > static_cast<uint64_t>(end_ - pos_)) {
+            return false;
+        }
+        data = pos_;
+        size = length;
+        pos_ += length;
+        return true;
+    }
+    [[nodiscard]] bool done() const { return pos_ == end_; }
+    [[nodiscard]] uint8_t byte() { return *pos_++; }
+
+private:
+    const uint8_t* pos_;
+    const uint8_t* end_;
+};
+
+// Разбор потока в команды с заменой имен на индексы таблиц
+class CaptureParser {
+public:
+    std::vector<ReplayCommand> commands;
+    size_t prologueEnd = 0;
+    size_t nameSlots = 1;     // 0 - имя 0
+    size_t locationSlots = 1; // 0 - расположение -1
+    std::vector<int64_t> locationDefaults {-1};
+    // Данные команд с выравниванием по 8 байт: матрицы и массивы смещений
+    // передаются драйверу по указателю
+    std::vector<uint64_t> payload;
+
+    // false - поток оборван или команда не сходится со своими данными
+    bool parse(CaptureReader& reader, std::string& error);
+
+private:
+    enum NameKind { NAME_BUFFER, NAME_VERTEX_ARRAY, NAME_TEXTURE, NAME_SHADER, NAME_PROGRAM };
+
+    bool validate(const ReplayCommand& c, std::string& error);
+    // Сколько драйвер прочитает с учетом выравнивания строк GL_UNPACK_ALIGNMENT
+    [[nodiscard]] uint64_t unpackedBytes(int64_t width, int64_t height, int64_t format, int64_t type) const;
+
+    int64_t define(NameKind kind, int64_t name);
+    int64_t use(NameKind kind, int64_t name);
+    int64_t location(int64_t program, int64_t location);
+    void translate(ReplayCommand& c);
+
+    std::map<std::pair<NameKind, int64_t>, size_t> names_;
+    std::map<std::pair<int64_t, int64_t>, size_t> locations_;
+    int64_t currentProgram_ = 0;
+    int64_t unpackAlignment_ = 4;
+};
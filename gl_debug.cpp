@@ -0,0 +1,123 @@
+#include "gl_debug.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+#include "gles_context.h"
+
+GlDebug glDebug;
+
+namespace {
+
+void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                              const GLchar* message, const void* userParam) {
+    static_cast<GlDebug*>(const_cast<void*>(userParam))->onMessage(source, type, id, severity, message, length);
+}
+
+} // namespace
+
+const char* GlDebug::severityName(int severity) {
+    switch (severity) {
+        case SEVERITY_HIGH: return "high";
+        case SEVERITY_MEDIUM: return "medium";
+        case SEVERITY_LOW: return "low";
+        case SEVERITY_NOTIFICATION: return "notification";
+    }
+    return "unknown";
+}
+
+const char* GlDebug::typeName(int type) {
+    switch (type) {
+        case TYPE_ERROR: return "error";
+        case TYPE_PERFORMANCE: return "performance";
+        case TYPE_OTHER: return "other";
+    }
+    return "unknown";
+}
+
+void GlDebug::windowHints(GlContextMode mode) {
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, mode == GlContextMode::Debug ? GLFW_TRUE : GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_NO_ERROR, mode == GlContextMode::NoError ? GLFW_TRUE : GLFW_FALSE);
+}
+
+bool GlDebug::init(GlContextMode mode, GlDebugSeverity minSeverity, std::string& error) {
+    mode_ = GlContextMode::Default;
+    if (mode == GlContextMode::NoError) {
+        // GLFW молча снимает подсказку, если GLX или EGL не умеют такой контекст.
+        // Флаги контекста на ES есть только с 3.2, там верим расширению
+        bool noError = false;
+        if (glesContext.active()) {
+            noError = glfwExtensionSupported("GL_KHR_no_error");
+        } else {
+            GLint flags = 0;
+            glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+            noError = (flags & GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR) != 0;
+        }
+        if (!noError) {
+            error = "context was created with error checking (no KHR_no_error)";
+            return false;
+        }
+        mode_ = mode;
+        return true;
+    }
+    if (mode != GlContextMode::Debug) {
+        return true;
+    }
+
+    bool available = glesContext.active() ? glesContext.debugOutput() : (GLEW_VERSION_4_3 || GLEW_KHR_debug);
+    if (!available) {
+        error = "KHR_debug is not supported";
+        return false;
+    }
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(debugCallback, this);
+
+    // Сначала выключаем все, затем включаем важности от high до минимальной.
+    // Более поздний вызов перекрывает ранний для совпавших сообщений
+    static constexpr GLenum SEVERITIES[] = {
+        GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_NOTIFICATION
+    };
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    for (int i = 0; i <= static_cast<int>(minSeverity); ++i) {
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, SEVERITIES[i], 0, nullptr, GL_TRUE);
+    }
+    for (GLenum source : {GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_SOURCE_THIRD_PARTY}) {
+        glDebugMessageControl(source, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    }
+    mode_ = mode;
+    return true;
+}
+
+uint64_t GlDebug::totalMessages() const {
+    uint64_t total = 0;
+    for (const auto& count : severities_) {
+        total += count;
+    }
+    return total;
+}
+
+void GlDebug::onMessage(unsigned int source, unsigned int type, unsigned int id, unsigned int severity,
+                        const char* message, int length) {
+    int severityIndex = SEVERITY_NOTIFICATION;
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: severityIndex = SEVERITY_HIGH; break;
+        case GL_DEBUG_SEVERITY_MEDIUM: severityIndex = SEVERITY_MEDIUM; break;
+        case GL_DEBUG_SEVERITY_LOW: severityIndex = SEVERITY_LOW; break;
+    }
+    int typeIndex = type == GL_DEBUG_TYPE_ERROR ? TYPE_ERROR
+                  : type == GL_DEBUG_TYPE_PERFORMANCE ? TYPE_PERFORMANCE : TYPE_OTHER;
+    severities_[severityIndex].fetch_add(1, std::memory_order_relaxed);
+    types_[typeIndex].fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (printed_.size() >= MAX_PRINTED || !printed_.insert(static_cast<uint64_t>(source) << 32 | id).second) {
+        return;
+    }
+    std::string_view text(message, length >= 0 ? static_cast<size_t>(length) : std::strlen(message));
+    std::cerr << "GL debug [" << severityName(severityIndex) << " " << typeName(typeIndex) << " #" << id << "]: "
+              << text << std::endl;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "options.h"
+
+// Проверка ошибок GL без опроса glGetError (--gl-context). В режиме debug
+// драйвер сам сообщает об ошибках и проблемах производительности через
+// обратный вызов KHR_debug. Вывод асинхронный, без GL_DEBUG_OUTPUT_SYNCHRONOUS,
+// и вызов может прийти из потока драйвера: счетчики атомарные, печать под
+// мьютексом. Сообщения ниже заданной важности и из источников application и
+// third party (метки инструментов отладки) отбрасывает сам драйвер. В режиме
+// no-error контекст создается вообще без проверок, и разница FPS с default -
+// цена проверок в драйвере
+class GlDebug {
+public:
+    enum Severity { SEVERITY_HIGH, SEVERITY_MEDIUM, SEVERITY_LOW, SEVERITY_NOTIFICATION, SEVERITY_COUNT };
+    enum Type { TYPE_ERROR, TYPE_PERFORMANCE, TYPE_OTHER, TYPE_COUNT };
+
+    [[nodiscard]] static const char* severityName(int severity);
+    [[nodiscard]] static const char* typeName(int type);
+
+    // Подсказки GLFW перед созданием окна GL или ES
+    static void windowHints(GlContextMode mode);
+
+    // После glewInit. false - режим недоступен, контекст работает как default
+    bool init(GlContextMode mode, GlDebugSeverity minSeverity, std::string& error);
+    // Режим, который действует на самом деле
+    [[nodiscard]] GlContextMode mode() const { return mode_; }
+
+    [[nodiscard]] uint64_t messages(int severity) const { return severities_[severity]; }
+    [[nodiscard]] uint64_t messagesOfType(int type) const { return types_[type]; }
+    [[nodiscard]] uint64_t totalMessages() const;
+
+    // Из обратного вызова драйвера
+    void onMessage(unsigned int source, unsigned int type, unsigned int id, unsigned int severity,
+                   const char* message, int length);
+
+private:
+    // Разных сообщений в stderr, дальше только счетчики
+    static constexpr size_t MAX_PRINTED = 32;
+
+    GlContextMode mode_ = GlContextMode::Default;
+    std::array<std::atomic<uint64_t>, SEVERITY_COUNT> severities_ {};
+    std::array<std::atomic<uint64_t>, TYPE_COUNT> types_ {};
+    std::mutex mutex_;
+    std::unordered_set<uint64_t> printed_; // источник << 32 | id
+};
+
+// Один GL контекст на процесс
+extern GlDebug glDebug;
@@ -0,0 +1,42 @@
+#include "gl_dsa.h"
+
+#include <GL/glew.h>
+
+#include "gl_intercept.h"
+#include "gles_context.h"
+
+GlDsa glDsa;
+
+void GlDsa::init(bool allowed) {
+    enabled_ = false;
+    if (!allowed) {
+        fallbackReason_ = "--no-dsa";
+    } else if (nullBackend.active()) {
+        fallbackReason_ = "no GL context";
+    } else if (glesContext.active()) {
+        fallbackReason_ = "OpenGL ES";
+    } else if (glCapture.recording()) {
+        fallbackReason_ = "capture";
+    } else if (!GLEW_VERSION_4_5 && !GLEW_ARB_direct_state_access) {
+        fallbackReason_ = "no ARB_direct_state_access";
+    } else {
+        fallbackReason_ = nullptr;
+        enabled_ = true;
+    }
+}
+
+void GlDsa::createBuffers(int count, unsigned int* buffers) const {
+    if (enabled_) {
+        glCreateBuffers(count, buffers);
+    } else {
+        glGenBuffers(count, buffers);
+    }
+}
+
+void GlDsa::createVertexArrays(int count, unsigned int* arrays) const {
+    if (enabled_) {
+        glCreateVertexArrays(count, arrays);
+    } else {
+        glGenVertexArrays(count, arrays);
+    }
+}
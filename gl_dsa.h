@@ -0,0 +1,27 @@
+#pragma once
+
+// Direct State Access (GL 4.5 или GL_ARB_direct_state_access): буферы, VAO и
+// текстуры создаются glCreate* и меняются по имени объекта, без привязки к
+// точке привязки. Путь выбирается при запуске; без расширения, с --no-dsa, на
+// ES, с пустым бэкендом и при записи потока команд (повтор знает только вызовы
+// с привязкой) остается путь GL 3.3. Объекты, которые меняются через DSA,
+// нужно создавать здесь: имя от glGen* становится объектом только при привязке
+class GlDsa {
+public:
+    // После glewInit и начала записи. allowed - путь не запрещен опцией
+    void init(bool allowed);
+    [[nodiscard]] bool enabled() const { return enabled_; }
+    // Почему остался путь 3.3, nullptr - DSA включен
+    [[nodiscard]] const char* fallbackReason() const { return fallbackReason_; }
+
+    // glCreate* с DSA, иначе glGen*
+    void createBuffers(int count, unsigned int* buffers) const;
+    void createVertexArrays(int count, unsigned int* arrays) const;
+
+private:
+    bool enabled_ = false;
+    const char* fallbackReason_ = "not initialized";
+};
+
+// Один GL контекст на процесс
+extern GlDsa glDsa;
@@ -0,0 +1,719 @@
+#pragma once
+
+// Слой перехвата вызовов GL: подсчет (gl_calls.h) и запись потока команд
+// (gl_capture.h). Подключается последним из заголовков GL в единицах
+// трансляции, которые работают с GL: обертки ниже вызывают настоящие функции,
+// а макросы после них подменяют имена в коде. С пустым бэкендом (null_backend.h)
+// обертки считают и пишут вызовы, но до драйвера их не пропускают. Запросы
+// (glGet*) и замеры времени на GPU не перехватываются, кроме тех, что нужны при
+// настройке и без контекста GL
+
+#include <GL/glew.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gl_calls.h"
+#include "gl_capture.h"
+#include "null_backend.h"
+
+namespace gl_intercept {
+
+inline uint64_t textureBytes(GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data) {
+    if (!data) {
+        return 0;
+    }
+    int components = 4;
+    switch (format) {
+        case GL_RED: components = 1; break;
+        case GL_RG: components = 2; break;
+        case GL_RGB: case GL_BGR: components = 3; break;
+        default: break;
+    }
+    uint64_t componentSize = type == GL_UNSIGNED_BYTE || type == GL_BYTE ? 1 : 4;
+    return static_cast<uint64_t>(width) * height * components * componentSize;
+}
+
+// Отображение буфера во время записи: код пишет в копию, при unmap она
+// переносится в буфер и попадает в запись (из отображения на запись читать нельзя)
+struct CapturedMapping {
+    GLenum target = 0;
+    GLintptr offset = 0;
+    GLbitfield access = 0;
+    void* pointer = nullptr;
+    std::vector<uint8_t> shadow;
+};
+inline CapturedMapping capturedMapping;
+
+// Отрисовка: в пролог записи не попадает
+inline void clear(GLbitfield mask) {
+    glCalls.count(GL_CALL_DRAW);
+    if (glCapture.inFrames()) {
+        glCapture.record(GlOp::Clear, mask);
+    }
+    if (!nullBackend.active()) {
+        glClear(mask);
+    }
+}
+inline void drawArrays(GLenum mode, GLint first, GLsizei count) {
+    glCalls.count(GL_CALL_DRAW);
+    if (glCapture.inFrames()) {
+        glCapture.record(GlOp::DrawArrays, mode, first, count);
+    }
+    if (!nullBackend.active()) {
+        glDrawArrays(mode, first, count);
+    }
+}
+inline void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    glCalls.count(GL_CALL_DRAW);
+    if (glCapture.inFrames()) {
+        glCapture.record(GlOp::DrawElements, mode, count, type, indices);
+    }
+    if (!nullBackend.active()) {
+        glDrawElements(mode, count, type, indices);
+    }
+}
+inline void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    glCalls.count(GL_CALL_DRAW);
+    if (glCapture.inFrames()) {
+        glCapture.record(GlOp::DrawArraysInstanced, mode, first, count, instances);
+    }
+    if (!nullBackend.active()) {
+        glDrawArraysInstanced(mode, first, count, instances);
+    }
+}
+inline void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances) {
+    glCalls.count(GL_CALL_DRAW);
+    if (glCapture.inFrames()) {
+        glCapture.record(GlOp::DrawElementsInstanced, mode, count, type, indices, instances);
+    }
+    if (!nullBackend.active()) {
+        glDrawElementsInstanced(mode, count, type, indices, instances);
+    }
+}
+inline void multiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawCount) {
+    glCalls.count(GL_CALL_DRAW);
+    if (glCapture.inFrames()) {
+        std::vector<GLint> ranges(first, first + drawCount);
+        ranges.insert(ranges.end(), count, count + drawCount);
+        glCapture.recordData(GlOp::MultiDrawArrays, ranges.data(), ranges.size() * sizeof(GLint), mode, drawCount);
+    }
+    if (!nullBackend.active()) {
+        glMultiDrawArrays(mode, first, count, drawCount);
+    }
+}
+inline void multiDrawElements(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawCount) {
+    glCalls.count(GL_CALL_DRAW);
+    if (glCapture.inFrames()) {
+        // count[], затем смещения по 8 байт
+        std::vector<uint8_t> ranges(drawCount * (sizeof(GLsizei) + sizeof(uint64_t)));
+        std::memcpy(ranges.data(), count, drawCount * sizeof(GLsizei));
+        for (GLsizei i = 0; i < drawCount; ++i) {
+            uint64_t offset = reinterpret_cast<uintptr_t>(indices[i]);
+            std::memcpy(ranges.data() + drawCount * sizeof(GLsizei) + i * sizeof(uint64_t), &offset, sizeof(offset));
+        }
+        glCapture.recordData(GlOp::MultiDrawElements, ranges.data(), ranges.size(), mode, type, drawCount);
+    }
+    if (!nullBackend.active()) {
+        glMultiDrawElements(mode, count, type, indices, drawCount);
+    }
+}
+
+// Состояние
+inline void useProgram(GLuint program) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::UseProgram, program);
+    if (!nullBackend.active()) {
+        glUseProgram(program);
+    }
+}
+inline void bindVertexArray(GLuint vao) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::BindVertexArray, vao);
+    if (!nullBackend.active()) {
+        glBindVertexArray(vao);
+    }
+}
+inline void bindBuffer(GLenum target, GLuint buffer) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::BindBuffer, target, buffer);
+    if (!nullBackend.active()) {
+        glBindBuffer(target, buffer);
+    }
+}
+inline void bindTexture(GLenum target, GLuint texture) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::BindTexture, target, texture);
+    if (!nullBackend.active()) {
+        glBindTexture(target, texture);
+    }
+}
+inline void activeTexture(GLenum unit) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::ActiveTexture, unit);
+    if (!nullBackend.active()) {
+        glActiveTexture(unit);
+    }
+}
+inline void enable(GLenum cap) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::Enable, cap);
+    if (!nullBackend.active()) {
+        glEnable(cap);
+    }
+}
+inline void disable(GLenum cap) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::Disable, cap);
+    if (!nullBackend.active()) {
+        glDisable(cap);
+    }
+}
+inline void blendFunc(GLenum source, GLenum destination) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::BlendFunc, source, destination);
+    if (!nullBackend.active()) {
+        glBlendFunc(source, destination);
+    }
+}
+inline void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::Viewport, x, y, width, height);
+    if (!nullBackend.active()) {
+        glViewport(x, y, width, height);
+    }
+}
+inline void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::ClearColor, r, g, b, a);
+    if (!nullBackend.active()) {
+        glClearColor(r, g, b, a);
+    }
+}
+inline void pointSize(GLfloat size) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::PointSize, size);
+    if (!nullBackend.active()) {
+        glPointSize(size);
+    }
+}
+inline void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::VertexAttribPointer, index, size, type, normalized, stride, pointer);
+    if (!nullBackend.active()) {
+        glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    }
+}
+inline void enableVertexAttribArray(GLuint index) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::EnableVertexAttribArray, index);
+    if (!nullBackend.active()) {
+        glEnableVertexAttribArray(index);
+    }
+}
+inline void vertexAttribDivisor(GLuint index, GLuint divisor) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::VertexAttribDivisor, index, divisor);
+    if (!nullBackend.active()) {
+        glVertexAttribDivisor(index, divisor);
+    }
+}
+inline void pixelStorei(GLenum name, GLint value) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::PixelStorei, name, value);
+    if (!nullBackend.active()) {
+        glPixelStorei(name, value);
+    }
+}
+inline void texParameteri(GLenum target, GLenum name, GLint value) {
+    glCalls.count(GL_CALL_STATE);
+    glCapture.record(GlOp::TexParameteri, target, name, value);
+    if (!nullBackend.active()) {
+        glTexParameteri(target, name, value);
+    }
+}
+
+// Uniform
+inline GLint getUniformLocation(GLuint program, const GLchar* name) {
+    glCalls.count(GL_CALL_LOOKUP);
+    GLint location = nullBackend.active() ? static_cast<GLint>(nullBackend.newName()) : glGetUniformLocation(program, name);
+    glCapture.recordData(GlOp::GetUniformLocation, name, std::strlen(name), program, location);
+    return location;
+}
+inline void uniform1i(GLint location, GLint value) {
+    glCalls.count(GL_CALL_UNIFORM, sizeof(GLint));
+    glCapture.record(GlOp::Uniform1i, location, value);
+    if (!nullBackend.active()) {
+        glUniform1i(location, value);
+    }
+}
+inline void uniform1f(GLint location, GLfloat value) {
+    glCalls.count(GL_CALL_UNIFORM, sizeof(GLfloat));
+    glCapture.record(GlOp::Uniform1f, location, value);
+    if (!nullBackend.active()) {
+        glUniform1f(location, value);
+    }
+}
+inline void uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+    glCalls.count(GL_CALL_UNIFORM, 3 * sizeof(GLfloat));
+    glCapture.record(GlOp::Uniform3f, location, x, y, z);
+    if (!nullBackend.active()) {
+        glUniform3f(location, x, y, z);
+    }
+}
+inline void uniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+    glCalls.count(GL_CALL_UNIFORM, count * 3 * sizeof(GLfloat));
+    glCapture.recordData(GlOp::Uniform3fv, value, count * 3 * sizeof(GLfloat), location, count);
+    if (!nullBackend.active()) {
+        glUniform3fv(location, count, value);
+    }
+}
+inline void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    glCalls.count(GL_CALL_UNIFORM, count * 16 * sizeof(GLfloat));
+    glCapture.recordData(GlOp::UniformMatrix4fv, value, count * 16 * sizeof(GLfloat), location, count, transpose);
+    if (!nullBackend.active()) {
+        glUniformMatrix4fv(location, count, transpose, value);
+    }
+}
+
+// Загрузка данных
+inline void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glCalls.count(GL_CALL_UPLOAD, data ? size : 0);
+    glCapture.recordData(GlOp::BufferData, data, data ? size : 0, target, size, usage, data != nullptr);
+    if (!nullBackend.active()) {
+        glBufferData(target, size, data, usage);
+    }
+}
+inline void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    glCalls.count(GL_CALL_UPLOAD, size);
+    glCapture.recordData(GlOp::BufferSubData, data, size, target, offset);
+    if (!nullBackend.active()) {
+        glBufferSubData(target, offset, size, data);
+    }
+}
+inline void* mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    // Постоянное отображение на весь буфер не считается: записи в него учитывает countMappedWrite
+    bool transient = (access & GL_MAP_PERSISTENT_BIT) == 0 && (access & GL_MAP_WRITE_BIT) != 0;
+    glCalls.count(GL_CALL_UPLOAD, transient ? length : 0);
+    void* pointer = nullBackend.active() ? nullBackend.map(length) : glMapBufferRange(target, offset, length, access);
+    if (pointer && transient && glCapture.inFrames()) {
+        capturedMapping.target = target;
+        capturedMapping.offset = offset;
+        capturedMapping.access = access;
+        capturedMapping.pointer = pointer;
+        capturedMapping.shadow.resize(length);
+        return capturedMapping.shadow.data();
+    }
+    return pointer;
+}
+inline GLboolean unmapBuffer(GLenum target) {
+    glCalls.count(GL_CALL_UPLOAD);
+    if (capturedMapping.pointer && capturedMapping.target == target) {
+        const std::vector<uint8_t>& shadow = capturedMapping.shadow;
+        std::memcpy(capturedMapping.pointer, shadow.data(), shadow.size());
+        glCapture.recordData(GlOp::MapWrite, shadow.data(), shadow.size(),
+                             capturedMapping.target, capturedMapping.offset, capturedMapping.access);
+        capturedMapping.pointer = nullptr;
+    }
+    return nullBackend.active() ? GL_TRUE : glUnmapBuffer(target);
+}
+inline void texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                       GLint border, GLenum format, GLenum type, const void* data) {
+    uint64_t bytes = textureBytes(width, height, format, type, data);
+    glCalls.count(GL_CALL_UPLOAD, bytes);
+    glCapture.recordData(GlOp::TexImage2D, data, bytes, target, level, internalFormat, width, height, border, format, type);
+    if (!nullBackend.active()) {
+        glTexImage2D(target, level, internalFormat, width, height, border, format, type, data);
+    }
+}
+
+// Direct State Access (gl_dsa.h): в запись не попадает, при записи DSA выключен
+inline void createBuffers(GLsizei count, GLuint* buffers) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glCreateBuffers(count, buffers);
+    }
+}
+inline void createVertexArrays(GLsizei count, GLuint* arrays) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glCreateVertexArrays(count, arrays);
+    }
+}
+inline void createTextures(GLenum target, GLsizei count, GLuint* textures) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glCreateTextures(target, count, textures);
+    }
+}
+inline void namedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage) {
+    glCalls.count(GL_CALL_UPLOAD, data ? size : 0);
+    if (!nullBackend.active()) {
+        glNamedBufferData(buffer, size, data, usage);
+    }
+}
+inline void namedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data) {
+    glCalls.count(GL_CALL_UPLOAD, size);
+    if (!nullBackend.active()) {
+        glNamedBufferSubData(buffer, offset, size, data);
+    }
+}
+inline void* mapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    bool transient = (access & GL_MAP_PERSISTENT_BIT) == 0 && (access & GL_MAP_WRITE_BIT) != 0;
+    glCalls.count(GL_CALL_UPLOAD, transient ? length : 0);
+    return nullBackend.active() ? nullBackend.map(length) : glMapNamedBufferRange(buffer, offset, length, access);
+}
+inline GLboolean unmapNamedBuffer(GLuint buffer) {
+    glCalls.count(GL_CALL_UPLOAD);
+    return nullBackend.active() ? GL_TRUE : glUnmapNamedBuffer(buffer);
+}
+inline void vertexArrayVertexBuffer(GLuint vao, GLuint binding, GLuint buffer, GLintptr offset, GLsizei stride) {
+    glCalls.count(GL_CALL_STATE);
+    if (!nullBackend.active()) {
+        glVertexArrayVertexBuffer(vao, binding, buffer, offset, stride);
+    }
+}
+inline void vertexArrayElementBuffer(GLuint vao, GLuint buffer) {
+    glCalls.count(GL_CALL_STATE);
+    if (!nullBackend.active()) {
+        glVertexArrayElementBuffer(vao, buffer);
+    }
+}
+inline void vertexArrayAttribFormat(GLuint vao, GLuint index, GLint size, GLenum type, GLboolean normalized, GLuint offset) {
+    glCalls.count(GL_CALL_STATE);
+    if (!nullBackend.active()) {
+        glVertexArrayAttribFormat(vao, index, size, type, normalized, offset);
+    }
+}
+inline void vertexArrayAttribBinding(GLuint vao, GLuint index, GLuint binding) {
+    glCalls.count(GL_CALL_STATE);
+    if (!nullBackend.active()) {
+        glVertexArrayAttribBinding(vao, index, binding);
+    }
+}
+inline void enableVertexArrayAttrib(GLuint vao, GLuint index) {
+    glCalls.count(GL_CALL_STATE);
+    if (!nullBackend.active()) {
+        glEnableVertexArrayAttrib(vao, index);
+    }
+}
+inline void vertexArrayBindingDivisor(GLuint vao, GLuint binding, GLuint divisor) {
+    glCalls.count(GL_CALL_STATE);
+    if (!nullBackend.active()) {
+        glVertexArrayBindingDivisor(vao, binding, divisor);
+    }
+}
+inline void textureStorage2D(GLuint texture, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glTextureStorage2D(texture, levels, internalFormat, width, height);
+    }
+}
+inline void textureSubImage2D(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                              GLenum format, GLenum type, const void* data) {
+    glCalls.count(GL_CALL_UPLOAD, textureBytes(width, height, format, type, data));
+    if (!nullBackend.active()) {
+        glTextureSubImage2D(texture, level, x, y, width, height, format, type, data);
+    }
+}
+inline void textureParameteri(GLuint texture, GLenum name, GLint value) {
+    glCalls.count(GL_CALL_STATE);
+    if (!nullBackend.active()) {
+        glTextureParameteri(texture, name, value);
+    }
+}
+
+// Синхронизация: в запись не попадает, повтор без постоянного отображения fence не нужен
+inline GLsync fenceSync(GLenum condition, GLbitfield flags) {
+    glCalls.count(GL_CALL_SYNC);
+    return nullBackend.active() ? nullptr : glFenceSync(condition, flags);
+}
+inline GLenum clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    glCalls.count(GL_CALL_SYNC);
+    return nullBackend.active() ? GL_ALREADY_SIGNALED : glClientWaitSync(sync, flags, timeout);
+}
+inline void deleteSync(GLsync sync) {
+    glCalls.count(GL_CALL_SYNC);
+    if (!nullBackend.active()) {
+        glDeleteSync(sync);
+    }
+}
+
+// Объекты
+inline void genBuffers(GLsizei count, GLuint* buffers) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glGenBuffers(count, buffers);
+    }
+    for (GLsizei i = 0; i < count; ++i) {
+        if (nullBackend.active()) {
+            buffers[i] = nullBackend.newName();
+        }
+        glCapture.record(GlOp::GenBuffer, buffers[i]);
+    }
+}
+inline void genVertexArrays(GLsizei count, GLuint* arrays) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glGenVertexArrays(count, arrays);
+    }
+    for (GLsizei i = 0; i < count; ++i) {
+        if (nullBackend.active()) {
+            arrays[i] = nullBackend.newName();
+        }
+        glCapture.record(GlOp::GenVertexArray, arrays[i]);
+    }
+}
+inline void genTextures(GLsizei count, GLuint* textures) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glGenTextures(count, textures);
+    }
+    for (GLsizei i = 0; i < count; ++i) {
+        if (nullBackend.active()) {
+            textures[i] = nullBackend.newName();
+        }
+        glCapture.record(GlOp::GenTexture, textures[i]);
+    }
+}
+inline void deleteBuffers(GLsizei count, const GLuint* buffers) {
+    glCalls.count(GL_CALL_OBJECT);
+    for (GLsizei i = 0; i < count; ++i) {
+        glCapture.record(GlOp::DeleteBuffer, buffers[i]);
+    }
+    if (!nullBackend.active()) {
+        glDeleteBuffers(count, buffers);
+    }
+}
+inline void deleteVertexArrays(GLsizei count, const GLuint* arrays) {
+    glCalls.count(GL_CALL_OBJECT);
+    for (GLsizei i = 0; i < count; ++i) {
+        glCapture.record(GlOp::DeleteVertexArray, arrays[i]);
+    }
+    if (!nullBackend.active()) {
+        glDeleteVertexArrays(count, arrays);
+    }
+}
+inline GLuint createShader(GLenum type) {
+    glCalls.count(GL_CALL_OBJECT);
+    GLuint shader = nullBackend.active() ? nullBackend.newName() : glCreateShader(type);
+    glCapture.record(GlOp::CreateShader, type, shader);
+    return shader;
+}
+inline void shaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (glCapture.recording()) {
+        std::string source;
+        for (GLsizei i = 0; i < count; ++i) {
+            source.append(strings[i], lengths && lengths[i] >= 0 ? lengths[i] : std::strlen(strings[i]));
+        }
+        glCapture.recordData(GlOp::ShaderSource, source.data(), source.size(), shader);
+    }
+    if (!nullBackend.active()) {
+        glShaderSource(shader, count, strings, lengths);
+    }
+}
+inline void compileShader(GLuint shader) {
+    glCalls.count(GL_CALL_OBJECT);
+    glCapture.record(GlOp::CompileShader, shader);
+    if (!nullBackend.active()) {
+        glCompileShader(shader);
+    }
+}
+inline GLuint createProgram() {
+    glCalls.count(GL_CALL_OBJECT);
+    GLuint program = nullBackend.active() ? nullBackend.newName() : glCreateProgram();
+    glCapture.record(GlOp::CreateProgram, program);
+    return program;
+}
+inline void attachShader(GLuint program, GLuint shader) {
+    glCalls.count(GL_CALL_OBJECT);
+    glCapture.record(GlOp::AttachShader, program, shader);
+    if (!nullBackend.active()) {
+        glAttachShader(program, shader);
+    }
+}
+inline void linkProgram(GLuint program) {
+    glCalls.count(GL_CALL_OBJECT);
+    glCapture.record(GlOp::LinkProgram, program);
+    if (!nullBackend.active()) {
+        glLinkProgram(program);
+    }
+}
+inline void deleteShader(GLuint shader) {
+    glCalls.count(GL_CALL_OBJECT);
+    glCapture.record(GlOp::DeleteShader, shader);
+    if (!nullBackend.active()) {
+        glDeleteShader(shader);
+    }
+}
+
+inline void deleteProgram(GLuint program) {
+    glCalls.count(GL_CALL_OBJECT);
+    if (!nullBackend.active()) {
+        glDeleteProgram(program);
+    }
+}
+
+// Запросы при настройке: без контекста шейдеры считаются собранными, ошибок нет
+inline void getShaderiv(GLuint shader, GLenum name, GLint* params) {
+    if (nullBackend.active()) {
+        *params = GL_TRUE;
+        return;
+    }
+    glGetShaderiv(shader, name, params);
+}
+inline void getProgramiv(GLuint program, GLenum name, GLint* params) {
+    if (nullBackend.active()) {
+        *params = GL_TRUE;
+        return;
+    }
+    glGetProgramiv(program, name, params);
+}
+inline GLenum getError() {
+    return nullBackend.active() ? GL_NO_ERROR : glGetError();
+}
+
+} // namespace gl_intercept
+
+// Функции GL 1.5+ в GLEW - макросы на указатели, их нужно снять перед подменой
+#undef glClear
+#undef glDrawArrays
+#undef glDrawElements
+#undef glDrawArraysInstanced
+#undef glDrawElementsInstanced
+#undef glMultiDrawArrays
+#undef glMultiDrawElements
+#undef glUseProgram
+#undef glBindVertexArray
+#undef glBindBuffer
+#undef glBindTexture
+#undef glActiveTexture
+#undef glEnable
+#undef glDisable
+#undef glBlendFunc
+#undef glViewport
+#undef glClearColor
+#undef glPointSize
+#undef glVertexAttribPointer
+#undef glEnableVertexAttribArray
+#undef glVertexAttribDivisor
+#undef glPixelStorei
+#undef glTexParameteri
+#undef glGetUniformLocation
+#undef glUniform1i
+#undef glUniform1f
+#undef glUniform3f
+#undef glUniform3fv
+#undef glUniformMatrix4fv
+#undef glBufferData
+#undef glBufferSubData
+#undef glMapBufferRange
+#undef glUnmapBuffer
+#undef glTexImage2D
+#undef glCreateBuffers
+#undef glCreateVertexArrays
+#undef glCreateTextures
+#undef glNamedBufferData
+#undef glNamedBufferSubData
+#undef glMapNamedBufferRange
+#undef glUnmapNamedBuffer
+#undef glVertexArrayVertexBuffer
+#undef glVertexArrayElementBuffer
+#undef glVertexArrayAttribFormat
+#undef glVertexArrayAttribBinding
+#undef glEnableVertexArrayAttrib
+#undef glVertexArrayBindingDivisor
+#undef glTextureStorage2D
+#undef glTextureSubImage2D
+#undef glTextureParameteri
+#undef glFenceSync
+#undef glClientWaitSync
+#undef glDeleteSync
+#undef glGenBuffers
+#undef glGenVertexArrays
+#undef glGenTextures
+#undef glDeleteBuffers
+#undef glDeleteVertexArrays
+#undef glCreateShader
+#undef glShaderSource
+#undef glCompileShader
+#undef glCreateProgram
+#undef glAttachShader
+#undef glLinkProgram
+#undef glDeleteShader
+#undef glDeleteProgram
+#undef glGetShaderiv
+#undef glGetProgramiv
+#undef glGetError
+
+#define glClear gl_intercept::clear
+#define glDrawArrays gl_intercept::drawArrays
+#define glDrawElements gl_intercept::drawElements
+#define glDrawArraysInstanced gl_intercept::drawArraysInstanced
+#define glDrawElementsInstanced gl_intercept::drawElementsInstanced
+#define glMultiDrawArrays gl_intercept::multiDrawArrays
+#define glMultiDrawElements gl_intercept::multiDrawElements
+#define glUseProgram gl_intercept::useProgram
+#define glBindVertexArray gl_intercept::bindVertexArray
+#define glBindBuffer gl_intercept::bindBuffer
+#define glBindTexture gl_intercept::bindTexture
+#define glActiveTexture gl_intercept::activeTexture
+#define glEnable gl_intercept::enable
+#define glDisable gl_intercept::disable
+#define glBlendFunc gl_intercept::blendFunc
+#define glViewport gl_intercept::viewport
+#define glClearColor gl_intercept::clearColor
+#define glPointSize gl_intercept::pointSize
+#define glVertexAttribPointer gl_intercept::vertexAttribPointer
+#define glEnableVertexAttribArray gl_intercept::enableVertexAttribArray
+#define glVertexAttribDivisor gl_intercept::vertexAttribDivisor
+#define glPixelStorei gl_intercept::pixelStorei
+#define glTexParameteri gl_intercept::texParameteri
+#define glGetUniformLocation gl_intercept::getUniformLocation
+#define glUniform1i gl_intercept::uniform1i
+#define glUniform1f gl_intercept::uniform1f
+#define glUniform3f gl_intercept::uniform3f
+#define glUniform3fv gl_intercept::uniform3fv
+#define glUniformMatrix4fv gl_intercept::uniformMatrix4fv
+#define glBufferData gl_intercept::bufferData
+#define glBufferSubData gl_intercept::bufferSubData
+#define glMapBufferRange gl_intercept::mapBufferRange
+#define glUnmapBuffer gl_intercept::unmapBuffer
+#define glTexImage2D gl_intercept::texImage2D
+#define glCreateBuffers gl_intercept::createBuffers
+#define glCreateVertexArrays gl_intercept::createVertexArrays
+#define glCreateTextures gl_intercept::createTextures
+#define glNamedBufferData gl_intercept::namedBufferData
+#define glNamedBufferSubData gl_intercept::namedBufferSubData
+#define glMapNamedBufferRange gl_intercept::mapNamedBufferRange
+#define glUnmapNamedBuffer gl_intercept::unmapNamedBuffer
+#define glVertexArrayVertexBuffer gl_intercept::vertexArrayVertexBuffer
+#define glVertexArrayElementBuffer gl_intercept::vertexArrayElementBuffer
+#define glVertexArrayAttribFormat gl_intercept::vertexArrayAttribFormat
+#define glVertexArrayAttribBinding gl_intercept::vertexArrayAttribBinding
+#define glEnableVertexArrayAttrib gl_intercept::enableVertexArrayAttrib
+#define glVertexArrayBindingDivisor gl_intercept::vertexArrayBindingDivisor
+#define glTextureStorage2D gl_intercept::textureStorage2D
+#define glTextureSubImage2D gl_intercept::textureSubImage2D
+#define glTextureParameteri gl_intercept::textureParameteri
+#define glFenceSync gl_intercept::fenceSync
+#define glClientWaitSync gl_intercept::clientWaitSync
+#define glDeleteSync gl_intercept::deleteSync
+#define glGenBuffers gl_intercept::genBuffers
+#define glGenVertexArrays gl_intercept::genVertexArrays
+#define glGenTextures gl_intercept::genTextures
+#define glDeleteBuffers gl_intercept::deleteBuffers
+#define glDeleteVertexArrays gl_intercept::deleteVertexArrays
+#define glCreateShader gl_intercept::createShader
+#define glShaderSource gl_intercept::shaderSource
+#define glCompileShader gl_intercept::compileShader
+#define glCreateProgram gl_intercept::createProgram
+#define glAttachShader gl_intercept::attachShader
+#define glLinkProgram gl_intercept::linkProgram
+#define glDeleteShader gl_intercept::deleteShader
+#define glDeleteProgram gl_intercept::deleteProgram
+#define glGetShaderiv gl_intercept::getShaderiv
+#define glGetProgramiv gl_intercept::getProgramiv
+#define glGetError gl_intercept::getError
@@ -0,0 +1,127 @@
+#include "gl_state.h"
+
+#include <GL/glew.h>
+
+#include "gl_intercept.h"
+
+GlStateCache glState;
+
+void GlStateCache::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    invalidate();
+}
+
+void GlStateCache::invalidate() {
+    program_ = UNKNOWN;
+    vao_ = UNKNOWN;
+    arrayBuffer_ = UNKNOWN;
+    activeUnit_ = UNKNOWN;
+    textures_.fill(UNKNOWN);
+    caps_.fill(-1);
+    blendSource_ = UNKNOWN;
+    blendDestination_ = UNKNOWN;
+}
+
+bool GlStateCache::change(bool redundant) {
+    if (redundant) {
+        ++frame_.skipped;
+        ++total_.skipped;
+        if (enabled_) {
+            return false;
+        }
+    }
+    ++frame_.issued;
+    ++total_.issued;
+    return true;
+}
+
+void GlStateCache::useProgram(unsigned int program) {
+    if (change(program == program_)) {
+        glUseProgram(program);
+    }
+    program_ = program;
+}
+
+void GlStateCache::bindVertexArray(unsigned int vao) {
+    if (change(vao == vao_)) {
+        glBindVertexArray(vao);
+    }
+    vao_ = vao;
+}
+
+void GlStateCache::bindBuffer(unsigned int target, unsigned int buffer) {
+    if (target != GL_ARRAY_BUFFER) {
+        change(false);
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (change(buffer == arrayBuffer_)) {
+        glBindBuffer(target, buffer);
+    }
+    arrayBuffer_ = buffer;
+}
+
+void GlStateCache::activeTexture(unsigned int unit) {
+    if (change(unit == activeUnit_)) {
+        glActiveTexture(unit);
+    }
+    activeUnit_ = unit;
+}
+
+void GlStateCache::bindTexture(unsigned int target, unsigned int texture) {
+    unsigned int index = activeUnit_ - GL_TEXTURE0;
+    if (target != GL_TEXTURE_2D || activeUnit_ == UNKNOWN || index >= TEXTURE_UNITS) {
+        change(false);
+        glBindTexture(target, texture);
+        return;
+    }
+    if (change(texture == textures_[index])) {
+        glBindTexture(target, texture);
+    }
+    textures_[index] = texture;
+}
+
+GlStateCache::Cap GlStateCache::capIndex(unsigned int cap) {
+    switch (cap) {
+    case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+    case GL_CULL_FACE: return CAP_CULL_FACE;
+    case GL_BLEND: return CAP_BLEND;
+    default: return CAP_UNKNOWN;
+    }
+}
+
+void GlStateCache::setCap(unsigned int cap, bool on) {
+    Cap index = capIndex(cap);
+    if (change(index != CAP_UNKNOWN && caps_[index] == static_cast<int>(on))) {
+        if (on) {
+            glEnable(cap);
+        } else {
+            glDisable(cap);
+        }
+    }
+    if (index != CAP_UNKNOWN) {
+        caps_[index] = on;
+    }
+}
+
+void GlStateCache::enable(unsigned int cap) {
+    setCap(cap, true);
+}
+
+void GlStateCache::disable(unsigned int cap) {
+    setCap(cap, false);
+}
+
+void GlStateCache::blendFunc(unsigned int source, unsigned int destination) {
+    if (change(source == blendSource_ && destination == blendDestination_)) {
+        glBlendFunc(source, destination);
+    }
+    blendSource_ = source;
+    blendDestination_ = destination;
+}
+
+void GlStateCache::endFrame() {
+    lastFrame_ = frame_;
+    frame_ = {};
+    ++frames_;
+}
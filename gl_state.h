@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Кэш состояния GL: помнит текущую программу, VAO, буфер вершин, текстуры по
+// блокам, включенные возможности (глубина, отсечение, смешивание) и функцию
+// смешивания, и не отправляет в драйвер вызовы, которые ничего не меняют.
+// Весь код, меняющий это состояние, должен идти через кэш, иначе после него
+// нужен invalidate()
+class GlStateCache {
+public:
+    static constexpr int TEXTURE_UNITS = 16;
+
+    struct Counters {
+        uint64_t issued = 0;  // ушло в драйвер
+        uint64_t skipped = 0; // избыточные вызовы
+    };
+
+    GlStateCache() { invalidate(); }
+
+    // false - все вызовы уходят в драйвер, избыточные только считаются
+    void setEnabled(bool enabled);
+    [[nodiscard]] bool enabled() const { return enabled_; }
+
+    // Состояние неизвестно: следующий вызов каждого вида уйдет в драйвер
+    void invalidate();
+
+    void useProgram(unsigned int program);
+    void bindVertexArray(unsigned int vao);
+    // Кэшируется только GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER - часть VAO
+    void bindBuffer(unsigned int target, unsigned int buffer);
+    void activeTexture(unsigned int unit);
+    // Кэшируется только GL_TEXTURE_2D активного блока
+    void bindTexture(unsigned int target, unsigned int texture);
+    // Кэшируются GL_DEPTH_TEST, GL_CULL_FACE и GL_BLEND
+    void enable(unsigned int cap);
+    void disable(unsigned int cap);
+    void blendFunc(unsigned int source, unsigned int destination);
+
+    // Закрывает кадр: счетчики кадра переходят в lastFrame()
+    void endFrame();
+    [[nodiscard]] const Counters& lastFrame() const { return lastFrame_; }
+    [[nodiscard]] const Counters& total() const { return total_; }
+    [[nodiscard]] uint64_t frames() const { return frames_; }
+
+private:
+    enum Cap { CAP_DEPTH_TEST, CAP_CULL_FACE, CAP_BLEND, CAP_COUNT, CAP_UNKNOWN = CAP_COUNT };
+
+    // true - вызов нужно отправить в драйвер
+    bool change(bool redundant);
+    void setCap(unsigned int cap, bool on);
+    static Cap capIndex(unsigned int cap);
+
+    // UNKNOWN - значение, которого GL не выдает, поэтому первый вызов не пропускается
+    static constexpr unsigned int UNKNOWN = 0xFFFFFFFFu;
+
+    bool enabled_ = true;
+    unsigned int program_ = UNKNOWN;
+    unsigned int vao_ = UNKNOWN;
+    unsigned int arrayBuffer_ = UNKNOWN;
+    unsigned int activeUnit_ = UNKNOWN;
+    std::array<unsigned int, TEXTURE_UNITS> textures_ {};
+    std::array<int, CAP_COUNT> caps_ {}; // -1 - неизвестно, 0/1
+    unsigned int blendSource_ = UNKNOWN;
+    unsigned int blendDestination_ = UNKNOWN;
+
+    Counters frame_;
+    Counters lastFrame_;
+    Counters total_;
+    uint64_t frames_ = 0;
+};
+
+// Один GL контекст на процесс - один кэш
+extern GlStateCache glState;
@@ -0,0 +1,77 @@
+#include "gles_context.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+GlesContext glesContext;
+
+namespace {
+
+constexpr std::string_view DESKTOP_VERSION = "#version 330 core";
+constexpr std::string_view ES_VERSION = "#version 300 es\nprecision highp float;\nprecision highp int;";
+
+// Функция из ядра ES или ее вариант из расширения, если GLEW ее не загрузил
+template <typename Proc>
+bool loadProc(Proc& proc, const char* name, const char* extensionName = nullptr) {
+    if (!proc) {
+        proc = reinterpret_cast<Proc>(glfwGetProcAddress(name));
+    }
+    if (!proc && extensionName) {
+        proc = reinterpret_cast<Proc>(glfwGetProcAddress(extensionName));
+    }
+    return proc != nullptr;
+}
+
+} // namespace
+
+bool GlesContext::init(std::string& error) {
+    const GLubyte* version = glGetString(GL_VERSION);
+    if (!version || std::string_view(reinterpret_cast<const char*>(version)).rfind("OpenGL ES", 0) != 0) {
+        error = "context is not OpenGL ES";
+        return false;
+    }
+
+    // Ядро ES 3.0, которое GLEW относит к GL 3.1 - 4.3
+    bool loaded = loadProc(glDrawArraysInstanced, "glDrawArraysInstanced")
+               && loadProc(glDrawElementsInstanced, "glDrawElementsInstanced")
+               && loadProc(glVertexAttribDivisor, "glVertexAttribDivisor")
+               && loadProc(glFenceSync, "glFenceSync")
+               && loadProc(glClientWaitSync, "glClientWaitSync")
+               && loadProc(glDeleteSync, "glDeleteSync")
+               && loadProc(glInvalidateFramebuffer, "glInvalidateFramebuffer");
+    if (!loaded) {
+        error = "OpenGL ES 3.0 entry points not found";
+        return false;
+    }
+
+    timerQuery_ = glfwExtensionSupported("GL_EXT_disjoint_timer_query")
+               && loadProc(glGetQueryObjectui64v, "glGetQueryObjectui64v", "glGetQueryObjectui64vEXT");
+    bufferStorage_ = glfwExtensionSupported("GL_EXT_buffer_storage")
+                  && loadProc(glBufferStorage, "glBufferStorage", "glBufferStorageEXT");
+    debugOutput_ = glfwExtensionSupported("GL_KHR_debug")
+                && loadProc(glDebugMessageCallback, "glDebugMessageCallback", "glDebugMessageCallbackKHR")
+                && loadProc(glDebugMessageControl, "glDebugMessageControl", "glDebugMessageControlKHR");
+    multiDraw_ = glfwExtensionSupported("GL_EXT_multi_draw_arrays")
+              && loadProc(glMultiDrawArrays, "glMultiDrawArrays", "glMultiDrawArraysEXT")
+              && loadProc(glMultiDrawElements, "glMultiDrawElements", "glMultiDrawElementsEXT");
+    active_ = true;
+    return true;
+}
+
+std::string GlesContext::shaderSource(std::string_view source) const {
+    std::string result(source);
+    size_t header = result.find(DESKTOP_VERSION);
+    if (active_ && header != std::string::npos) {
+        result.replace(header, DESKTOP_VERSION.size(), ES_VERSION);
+    }
+    return result;
+}
+
+void GlesContext::endFrame() {
+    if (!active_) {
+        return;
+    }
+    // Кадр по умолчанию: вложения называются GL_DEPTH и GL_STENCIL
+    const GLenum attachments[] = {GL_DEPTH, GL_STENCIL};
+    glInvalidateFramebuffer(GL_FRAMEBUFFER, 2, attachments);
+}
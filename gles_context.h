@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Бэкенд OpenGL ES 3.x (--backend gles) для плат ARM: контекст создается GLFW
+// через EGL, сцена и шейдеры те же, что у GL. GLEW собран для настольного GL
+// и на контексте ES загружает функции только до версии из GL_VERSION, поэтому
+// недостающие функции ES 3.0 и расширений догружаются здесь. Кадр
+// заканчивается glInvalidateFramebuffer для глубины: тайловому GPU не нужно
+// выгружать ее из памяти тайла
+class GlesContext {
+public:
+    // После glewInit на текущем контексте ES. false - нет нужных функций
+    bool init(std::string& error);
+    [[nodiscard]] bool active() const { return active_; }
+
+    // GL_EXT_disjoint_timer_query: время проходов на GPU
+    [[nodiscard]] bool timerQuery() const { return timerQuery_; }
+    // GL_EXT_buffer_storage: постоянное отображение потоковых буферов без
+    // glBufferData и glMapBufferRange посреди кадра
+    [[nodiscard]] bool bufferStorage() const { return bufferStorage_; }
+    // GL_KHR_debug: отладочный вывод для --gl-context debug
+    [[nodiscard]] bool debugOutput() const { return debugOutput_; }
+    // GL_EXT_multi_draw_arrays: glMultiDraw* не входят в ядро ES, без
+    // расширения наружные грани рисуются вызовом на грань
+    [[nodiscard]] bool multiDraw() const { return multiDraw_; }
+
+    // Исходник шейдера для текущего контекста: на ES заголовок #version 330 core
+    // меняется на #version 300 es с точностью по умолчанию
+    [[nodiscard]] std::string shaderSource(std::string_view source) const;
+
+    // Перед обменом буферов: содержимое глубины кадру больше не нужно
+    void endFrame();
+
+private:
+    bool active_ = false;
+    bool timerQuery_ = false;
+    bool bufferStorage_ = false;
+    bool debugOutput_ = false;
+    bool multiDraw_ = false;
+};
+
+extern GlesContext glesContext;
@@ -0,0 +1,220 @@
+#include "gpu_info.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+// Константа из GLX_MESA_query_renderer, glx.h не подключаем, чтобы не тянуть Xlib
+constexpr int GLX_RENDERER_VIDEO_MEMORY_MESA_ = 0x8187;
+
+using PFNGLXQUERYCURRENTRENDERERINTEGERMESA = int (*)(int attribute, unsigned int* value);
+using PFNEGLGETCURRENTDISPLAY = void* (*)();
+using PFNEGLGETDISPLAYDRIVERNAME = const char* (*)(void* display);
+
+namespace {
+
+// Каталог DRM устройства с mem_info_vram_* (amdgpu), пусто если не найден
+std::string findSysfsVRAMDir() {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/class/drm", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("card", 0) != 0 || name.find('-') != std::string::npos) {
+            continue;
+        }
+        std::string dir = entry.path().string() + "/device";
+        if (std::filesystem::exists(dir + "/mem_info_vram_total", ec)) {
+            return dir;
+        }
+    }
+    return "";
+}
+
+long long readSysfsBytes(const std::string& path) {
+    std::ifstream file(path);
+    long long value = -1;
+    if (!(file >> value)) {
+        return -1;
+    }
+    return value;
+}
+
+// Каталог ищем один раз, дальше опрос - это только чтение двух файлов
+const std::string& sysfsVRAMDir() {
+    static const std::string dir = findSysfsVRAMDir();
+    return dir;
+}
+
+bool readSysfsVRAM(VRAMStatus& status) {
+    const std::string& dir = sysfsVRAMDir();
+    if (dir.empty()) {
+        return false;
+    }
+    long long total = readSysfsBytes(dir + "/mem_info_vram_total");
+    long long used = readSysfsBytes(dir + "/mem_info_vram_used");
+    if (total <= 0) {
+        return false;
+    }
+    status.totalMB = total / (1024 * 1024);
+    if (used >= 0) {
+        status.usedMB = used / (1024 * 1024);
+        status.freeMB = status.totalMB - status.usedMB;
+    }
+    return true;
+}
+
+// Каталог hwmon первой видеокарты, у которой есть датчик температуры
+std::string findHwmonDir() {
+    std::error_code ec;
+    for (const auto& card : std::filesystem::directory_iterator("/sys/class/drm", ec)) {
+        std::string name = card.path().filename().string();
+        if (name.rfind("card", 0) != 0 || name.find('-') != std::string::npos) {
+            continue;
+        }
+        for (const auto& hwmon : std::filesystem::directory_iterator(card.path() / "device" / "hwmon", ec)) {
+            if (std::filesystem::exists(hwmon.path() / "temp1_input", ec)) {
+                return hwmon.path().string();
+            }
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+GpuSensors readGpuSensors() {
+    static const std::string dir = findHwmonDir();
+    GpuSensors sensors;
+    if (dir.empty()) {
+        return sensors;
+    }
+    long long temperature = readSysfsBytes(dir + "/temp1_input");   // Миллиградусы
+    if (temperature >= 0) {
+        sensors.temperatureC = temperature / 1000.0;
+    }
+    long long power = readSysfsBytes(dir + "/power1_average");      // Микроватты
+    if (power < 0) {
+        power = readSysfsBytes(dir + "/power1_input");
+    }
+    if (power >= 0) {
+        sensors.powerW = power / 1000000.0;
+    }
+    return sensors;
+}
+
+VRAMStatus queryVRAM() {
+    VRAMStatus status;
+
+    if (glfwExtensionSupported("GL_NVX_gpu_memory_info")) {
+        GLint totalKB = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &totalKB);
+        if (totalKB > 0) {
+            status.totalMB = totalKB / 1024;
+            status.source = status.liveSource = "GL_NVX_gpu_memory_info";
+            pollVRAM(status);
+            return status;
+        }
+    }
+
+    if (glfwExtensionSupported("GLX_MESA_query_renderer")) {
+        auto queryRenderer = reinterpret_cast<PFNGLXQUERYCURRENTRENDERERINTEGERMESA>(
+            glfwGetProcAddress("glXQueryCurrentRendererIntegerMESA"));
+        unsigned int videoMemoryMB = 0;
+        if (queryRenderer && queryRenderer(GLX_RENDERER_VIDEO_MEMORY_MESA_, &videoMemoryMB) && videoMemoryMB > 0) {
+            status.totalMB = videoMemoryMB;
+            status.source = "GLX_MESA_query_renderer";
+        }
+    }
+
+    // Без GLX_MESA_query_renderer (EGL, Wayland) общий объем берем из sysfs:
+    // GL_ATI_meminfo сообщает только свободную память
+    VRAMStatus sysfs;
+    bool haveSysfs = readSysfsVRAM(sysfs);
+    if (status.totalMB < 0 && haveSysfs) {
+        status.totalMB = sysfs.totalMB;
+        status.source = "sysfs";
+    }
+
+    // Живые данные: GL_ATI_meminfo, иначе sysfs
+    if (glfwExtensionSupported("GL_ATI_meminfo")) {
+        status.liveSource = "GL_ATI_meminfo";
+    } else if (haveSysfs) {
+        status.liveSource = "sysfs";
+    }
+    if (status.source.empty()) {
+        status.source = status.liveSource;
+    }
+
+    pollVRAM(status);
+    return status;
+}
+
+void pollVRAM(VRAMStatus& status) {
+    if (status.liveSource == "GL_NVX_gpu_memory_info") {
+        GLint availableKB = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &availableKB);
+        status.freeMB = availableKB / 1024;
+        status.usedMB = status.totalMB - status.freeMB;
+    } else if (status.liveSource == "GL_ATI_meminfo") {
+        // [0] - общий свободный объем пула в КБ
+        GLint freeKB[4] = {};
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, freeKB);
+        status.freeMB = freeKB[0] / 1024;
+        if (status.totalMB > 0) {
+            status.usedMB = status.totalMB - status.freeMB;
+        }
+    } else if (status.liveSource == "sysfs") {
+        VRAMStatus sysfs;
+        if (readSysfsVRAM(sysfs)) {
+            status.usedMB = sysfs.usedMB;
+            status.freeMB = sysfs.freeMB;
+        }
+    }
+}
+
+std::string getDriverInfo() {
+    std::string result;
+    const GLubyte* version = glGetString(GL_VERSION);
+    if (version) {
+        result = reinterpret_cast<const char*>(version);
+    }
+
+    if (glfwExtensionSupported("EGL_MESA_query_driver")) {
+        auto getCurrentDisplay = reinterpret_cast<PFNEGLGETCURRENTDISPLAY>(glfwGetProcAddress("eglGetCurrentDisplay"));
+        auto getDriverName = reinterpret_cast<PFNEGLGETDISPLAYDRIVERNAME>(glfwGetProcAddress("eglGetDisplayDriverName"));
+        if (getCurrentDisplay && getDriverName) {
+            const char* name = getDriverName(getCurrentDisplay());
+            if (name) {
+                result += std::string(" (") + name + ")";
+            }
+        }
+    }
+
+    return result.empty() ? "Unknown" : result;
+}
+
+std::string formatVRAM(const VRAMStatus& status) {
+    std::stringstream ss;
+    ss << "VRAM: ";
+    if (status.totalMB > 0) {
+        ss << status.totalMB << " MB";
+    } else {
+        ss << "Unknown";
+    }
+    if (status.usedMB >= 0) {
+        ss << " (used " << status.usedMB << " MB)";
+    } else if (status.freeMB >= 0) {
+        ss << " (free " << status.freeMB << " MB)";
+    }
+    return ss.str();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+// Состояние видеопамяти. Значения в мегабайтах, -1 - неизвестно
+struct VRAMStatus {
+    long long totalMB = -1;
+    long long usedMB = -1;
+    long long freeMB = -1;
+    std::string source;       // Откуда получен общий объем (расширение или sysfs)
+    std::string liveSource;   // Чем опрашивается текущее использование, пусто - недоступно
+};
+
+// Полный опрос видеопамяти при старте. Требует текущий GL контекст.
+// Порядок: GL_NVX_gpu_memory_info, GLX_MESA_query_renderer, GL_ATI_meminfo, DRM sysfs
+// (общий объем из sysfs, если его не дало расширение)
+[[nodiscard]] VRAMStatus queryVRAM();
+
+// Быстрый опрос текущего свободного/занятого объема во время теста
+void pollVRAM(VRAMStatus& status);
+
+// Имя драйвера (EGL_MESA_query_driver) и строка GL_VERSION
+[[nodiscard]] std::string getDriverInfo();
+
+// Датчики видеокарты из hwmon (amdgpu, nouveau и др.), -1 - нет данных
+struct GpuSensors {
+    double temperatureC = -1.0;
+    double powerW = -1.0;
+};
+
+[[nodiscard]] GpuSensors readGpuSensors();
+
+[[nodiscard]] std::string formatVRAM(const VRAMStatus& status);
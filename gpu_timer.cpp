@@ -0,0 +1,120 @@
+#include "gpu_timer.h"
+
+#include <GL/glew.h>
+
+#include "gles_context.h"
+
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+void GpuTimer::init() {
+    // На ES запросы GL_TIME_ELAPSED есть только с GL_EXT_disjoint_timer_query
+    if (initialized_ || (glesContext.active() && !glesContext.timerQuery())) {
+        return;
+    }
+    for (Slot& slot : slots_) {
+        glGenQueries(GPU_PASS_COUNT, slot.queries.data());
+    }
+    initialized_ = true;
+}
+
+void GpuTimer::destroy() {
+    if (!initialized_) {
+        return;
+    }
+    for (Slot& slot : slots_) {
+        glDeleteQueries(GPU_PASS_COUNT, slot.queries.data());
+    }
+    initialized_ = false;
+}
+
+void GpuTimer::beginFrame(uint64_t frameIndex) {
+    if (!initialized_) {
+        return;
+    }
+    int next = (current_ + 1) % FRAMES_IN_FLIGHT;
+    // Если GPU отстал больше чем на FRAMES_IN_FLIGHT кадров, самый старый кадр теряем
+    if (slots_[next].pending) {
+        slots_[next].pending = false;
+        oldest_ = (next + 1) % FRAMES_IN_FLIGHT;
+    }
+    current_ = next;
+
+    Slot& slot = slots_[current_];
+    slot.frameIndex = frameIndex;
+    slot.used.fill(false);
+    slot.pending = true;
+}
+
+void GpuTimer::begin(GpuPass pass) {
+    if (!initialized_) {
+        return;
+    }
+    Slot& slot = slots_[current_];
+    glBeginQuery(GL_TIME_ELAPSED, slot.queries[pass]);
+    slot.used[pass] = true;
+    active_ = pass;
+}
+
+void GpuTimer::end() {
+    if (!initialized_ || active_ < 0) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    active_ = -1;
+}
+
+bool GpuTimer::collect(uint64_t& frameIndex, GpuPassTimes& times) {
+    if (!initialized_) {
+        return false;
+    }
+    // Текущий кадр еще записывается
+    while (oldest_ != current_ && !slots_[oldest_].pending) {
+        oldest_ = (oldest_ + 1) % FRAMES_IN_FLIGHT;
+    }
+    if (oldest_ == current_) {
+        return false;
+    }
+
+    Slot& slot = slots_[oldest_];
+    // Запросы завершаются по порядку, достаточно проверить последний использованный
+    for (int pass = GPU_PASS_COUNT - 1; pass >= 0; --pass) {
+        if (slot.used[pass]) {
+            GLint available = 0;
+            glGetQueryObjectiv(slot.queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                return false;
+            }
+            break;
+        }
+    }
+
+    // EXT_disjoint_timer_query: смена частоты или вытеснение GPU портит все
+    // запросы в полете. Чтение флага его сбрасывает, поэтому отбрасываются
+    // все ожидающие кадры вместе с текущим
+    if (glesContext.active()) {
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (disjoint) {
+            for (Slot& pending : slots_) {
+                pending.pending = false;
+            }
+            oldest_ = current_;
+            ++disjointEvents_;
+            return false;
+        }
+    }
+
+    for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+        GLuint64 elapsed = 0;
+        if (slot.used[pass]) {
+            glGetQueryObjectui64v(slot.queries[pass], GL_QUERY_RESULT, &elapsed);
+        }
+        times[pass] = elapsed;
+    }
+    frameIndex = slot.frameIndex;
+    slot.pending = false;
+    oldest_ = (oldest_ + 1) % FRAMES_IN_FLIGHT;
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Проходы кадра, время которых измеряется на GPU
+enum GpuPass {
+    GPU_PASS_CUBE,
+    GPU_PASS_GRAPH,
+    GPU_PASS_TEXT,
+    GPU_PASS_COUNT
+};
+
+[[nodiscard]] inline const char* gpuPassName(int pass) {
+    switch (pass) {
+        case GPU_PASS_CUBE: return "cube";
+        case GPU_PASS_GRAPH: return "graph";
+        case GPU_PASS_TEXT: return "text";
+        default: return "unknown";
+    }
+}
+
+using GpuPassTimes = std::array<uint64_t, GPU_PASS_COUNT>;
+
+// Замер времени проходов запросами GL_TIME_ELAPSED (ядро GL 3.3).
+// Результаты читаются с задержкой в несколько кадров, чтобы не ждать GPU
+class GpuTimer {
+public:
+    static constexpr int FRAMES_IN_FLIGHT = 6;
+
+    void init();
+    void destroy();
+
+    void beginFrame(uint64_t frameIndex);
+    void begin(GpuPass pass);
+    void end();
+
+    // Забирает результаты самого старого готового кадра, false - готовых нет
+    bool collect(uint64_t& frameIndex, GpuPassTimes& times);
+    // Сколько раз ES сообщил GL_GPU_DISJOINT_EXT и замеры были отброшены
+    [[nodiscard]] uint64_t disjointEvents() const { return disjointEvents_; }
+
+private:
+    struct Slot {
+        std::array<unsigned int, GPU_PASS_COUNT> queries {};
+        std::array<bool, GPU_PASS_COUNT> used {};
+        uint64_t frameIndex = 0;
+        bool pending = false;
+    };
+
+    std::array<Slot, FRAMES_IN_FLIGHT> slots_ {};
+    int current_ = 0;
+    int oldest_ = 0;
+    int active_ = -1;
+    bool initialized_ = false;
+    uint64_t disjointEvents_ = 0;
+};
@@ -0,0 +1,122 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(int threads) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < threads; ++i) {
+        threads_.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t chunk, const Task& task, int workers) {
+    if (count == 0) {
+        return;
+    }
+    chunk = std::max<size_t>(chunk, 1);
+    int participants = workers > 0 ? std::min(workers, threadCount()) : threadCount();
+    size_t chunks = (count + chunk - 1) / chunk;
+    if (participants == 1 || chunks == 1) {
+        task(0, count);
+        return;
+    }
+
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        activeWorkers_ = participants;
+        generation = ++generation_;
+    }
+
+    // Соседние куски одному участнику - лучше для кэша и предвыборки
+    remaining_ = chunks;
+    size_t perQueue = (chunks + participants - 1) / participants;
+    for (int q = 0; q < participants; ++q) {
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        for (size_t c = q * perQueue; c < std::min(chunks, (q + 1) * perQueue); ++c) {
+            queues_[q]->chunks.push_back({c * chunk, std::min(count, (c + 1) * chunk), &task});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted_ = generation;
+    }
+    wake_.notify_all();
+
+    while (runOne(0, generation)) {
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return remaining_ == 0; });
+}
+
+bool JobSystem::mayTake(int index, uint64_t generation) const {
+    return generation_ == generation && index < activeWorkers_;
+}
+
+bool JobSystem::runOne(int index, uint64_t generation) {
+    Chunk chunk {};
+    bool found = false;
+    {
+        Queue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.chunks.empty() && mayTake(index, generation)) {
+            chunk = own.chunks.front();
+            own.chunks.pop_front();
+            found = true;
+        }
+    }
+    for (int i = 1; !found && i < threadCount(); ++i) {
+        Queue& victim = *queues_[(index + i) % threadCount()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty() && mayTake(index, generation)) {
+            chunk = victim.chunks.back();
+            victim.chunks.pop_back();
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    (*chunk.task)(chunk.begin, chunk.end);
+    if (remaining_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_all();
+    }
+    return true;
+}
+
+void JobSystem::workerLoop(int index) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || posted_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = posted_;
+            if (index >= activeWorkers_) {
+                continue;
+            }
+        }
+        while (runOne(index, seen)) {
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков для параллельных циклов по кубикам. Каждый участник получает
+// свой непрерывный диапазон кусков, а закончив его, забирает куски с конца
+// чужих очередей (work stealing)
+class JobSystem {
+public:
+    using Task = std::function<void(size_t begin, size_t end)>;
+
+    // threads - всего участников вместе с вызывающим потоком, 0 - по числу ядер
+    explicit JobSystem(int threads = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Выполняет task над [0, count) кусками по chunk. workers ограничивает
+    // число участников (0 - все). Возвращает после завершения всех кусков
+    void parallelFor(size_t count, size_t chunk, const Task& task, int workers = 0);
+
+    [[nodiscard]] int threadCount() const { return static_cast<int>(queues_.size()); }
+
+private:
+    struct Chunk {
+        size_t begin;
+        size_t end;
+        const Task* task;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    void workerLoop(int index);
+    // Берет кусок из своей очереди или крадет чужой, false - работы нет.
+    // Поток прошлого поколения или сверх workers куски не берет
+    bool runOne(int index, uint64_t generation);
+    // Под замком очереди: кусок в ней виден только после смены поколения
+    bool mayTake(int index, uint64_t generation) const;
+
+    std::vector<std::unique_ptr<Queue>> queues_;  // 0 - вызывающий поток
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    // Поколение и участники меняются до раздачи кусков, posted_ будит потоки
+    // после нее
+    std::atomic<uint64_t> generation_ {0};
+    std::atomic<int> activeWorkers_ {0};
+    uint64_t posted_ = 0;
+    std::atomic<size_t> remaining_ {0};
+    bool stop_ = false;
+};
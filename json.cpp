@@ -0,0 +1,425 @@
+#include "json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+constexpr int MAX_DEPTH = 64;
+
+class Parser {
+public:
+    explicit Parser(const std::string& text) : text_(text) {}
+
+    bool parse(JsonValue& value, std::string& error) {
+        if (!parseValue(value, 0)) {
+            error = error_ + " at offset " + std::to_string(pos_);
+            return false;
+        }
+        skipSpace();
+        if (pos_ != text_.size()) {
+            error = "trailing characters at offset " + std::to_string(pos_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void skipSpace() {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool fail(const char* message) {
+        error_ = message;
+        return false;
+    }
+
+    bool literal(const char* word) {
+        size_t length = std::char_traits<char>::length(word);
+        if (text_.compare(pos_, length, word) != 0) {
+            return fail("invalid literal");
+        }
+        pos_ += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        skipSpace();
+        if (pos_ >= text_.size()) {
+            return fail("unexpected end");
+        }
+        char c = text_[pos_];
+        if (c == '{') {
+            return parseObject(value, depth);
+        }
+        if (c == '[') {
+            return parseArray(value, depth);
+        }
+        if (c == '"') {
+            std::string s;
+            if (!parseString(s)) {
+                return false;
+            }
+            value = JsonValue(std::move(s));
+            return true;
+        }
+        if (c == 't') {
+            value = JsonValue(true);
+            return literal("true");
+        }
+        if (c == 'f') {
+            value = JsonValue(false);
+            return literal("false");
+        }
+        if (c == 'n') {
+            value = JsonValue();
+            return literal("null");
+        }
+        return parseNumber(value);
+    }
+
+    // Грамматика числа JSON: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?.
+    // strtod сам по себе принял бы 0x1F, inf и ведущие нули
+    bool parseNumber(JsonValue& value) {
+        size_t end = pos_;
+        if (end < text_.size() && text_[end] == '-') {
+            ++end;
+        }
+        if (end >= text_.size() || !isDigit(text_[end])) {
+            return fail(end == pos_ ? "unexpected character" : "invalid number");
+        }
+        if (text_[end] == '0') {
+            ++end;
+        } else {
+            end = skipDigits(end);
+        }
+        if (end < text_.size() && text_[end] == '.') {
+            if (end + 1 >= text_.size() || !isDigit(text_[end + 1])) {
+                return fail("invalid number");
+            }
+            end = skipDigits(end + 1);
+        }
+        if (end < text_.size() && (text_[end] == 'e' || text_[end] == 'E')) {
+            ++end;
+            if (end < text_.size() && (text_[end] == '+' || text_[end] == '-')) {
+                ++end;
+            }
+            if (end >= text_.size() || !isDigit(text_[end])) {
+                return fail("invalid number");
+            }
+            end = skipDigits(end);
+        }
+
+        std::string token = text_.substr(pos_, end - pos_);
+        char* parsed = nullptr;
+        double number = std::strtod(token.c_str(), &parsed);
+        if (parsed != token.c_str() + token.size() || !std::isfinite(number)) {
+            return fail("invalid number");
+        }
+        pos_ = end;
+        value = JsonValue(number);
+        return true;
+    }
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    size_t skipDigits(size_t pos) const {
+        while (pos < text_.size() && isDigit(text_[pos])) {
+            ++pos;
+        }
+        return pos;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseHex4(uint32_t& code) {
+        if (pos_ + 4 > text_.size()) {
+            return fail("truncated escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char h = text_[pos_++];
+            code <<= 4;
+            if (h >= '0' && h <= '9') code |= h - '0';
+            else if (h >= 'a' && h <= 'f') code |= h - 'a' + 10;
+            else if (h >= 'A' && h <= 'F') code |= h - 'A' + 10;
+            else return fail("invalid escape");
+        }
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        ++pos_; // "
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '"') {
+                return true;
+            }
+            // Управляющие символы в строке JSON допустимы только экранированными
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return fail("control character in string");
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                break;
+            }
+            char e = text_[pos_++];
+            switch (e) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t code;
+                    if (!parseHex4(code)) {
+                        return false;
+                    }
+                    // Суррогатная пара: старшая половина только со следующей за ней младшей
+                    if (code >= 0xDC00 && code < 0xE000) {
+                        return fail("unpaired surrogate");
+                    }
+                    if (code >= 0xD800 && code < 0xDC00) {
+                        if (text_.compare(pos_, 2, "\\u") != 0) {
+                            return fail("unpaired surrogate");
+                        }
+                        pos_ += 2;
+                        uint32_t low;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            return fail("unpaired surrogate");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        ++pos_; // [
+        value = JsonValue::array();
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            JsonValue item;
+            if (!parseValue(item, depth + 1)) {
+                return false;
+            }
+            value.push(std::move(item));
+            skipSpace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == ']') {
+                ++pos_;
+                return true;
+            } else {
+                return fail("expected , or ]");
+            }
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        ++pos_; // {
+        value = JsonValue::object();
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            skipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') {
+                return fail("expected key");
+            }
+            std::string key;
+            if (!parseString(key)) {
+                return false;
+            }
+            skipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != ':') {
+                return fail("expected :");
+            }
+            ++pos_;
+            JsonValue item;
+            if (!parseValue(item, depth + 1)) {
+                return false;
+            }
+            value.set(key, std::move(item));
+            skipSpace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == '}') {
+                ++pos_;
+                return true;
+            } else {
+                return fail("expected , or }");
+            }
+        }
+    }
+
+    const std::string& text_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+void dumpString(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+    static const JsonValue null;
+    for (const auto& member : members_) {
+        if (member.first == key) {
+            return member.second;
+        }
+    }
+    return null;
+}
+
+bool JsonValue::has(const std::string& key) const {
+    for (const auto& member : members_) {
+        if (member.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+JsonValue& JsonValue::set(const std::string& key, JsonValue value) {
+    type_ = Type::Object;
+    for (auto& member : members_) {
+        if (member.first == key) {
+            member.second = std::move(value);
+            return *this;
+        }
+    }
+    members_.emplace_back(key, std::move(value));
+    return *this;
+}
+
+JsonValue& JsonValue::push(JsonValue value) {
+    type_ = Type::Array;
+    items_.push_back(std::move(value));
+    return *this;
+}
+
+std::string JsonValue::dump() const {
+    std::string out;
+    dumpTo(out);
+    return out;
+}
+
+void JsonValue::dumpTo(std::string& out) const {
+    switch (type_) {
+        case Type::Null:
+            out += "null";
+            break;
+        case Type::Bool:
+            out += bool_ ? "true" : "false";
+            break;
+        case Type::Number: {
+            if (!std::isfinite(number_)) {
+                out += "null";
+            } else if (number_ == std::floor(number_) && std::fabs(number_) < 1e15) {
+                out += std::to_string(static_cast<int64_t>(number_));
+            } else {
+                // Кратчайшая запись, которая читается обратно без потерь
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%.15g", number_);
+                if (std::strtod(buffer, nullptr) != number_) {
+                    std::snprintf(buffer, sizeof(buffer), "%.17g", number_);
+                }
+                out += buffer;
+            }
+            break;
+        }
+        case Type::String:
+            dumpString(out, string_);
+            break;
+        case Type::Array:
+            out += '[';
+            for (size_t i = 0; i < items_.size(); ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                items_[i].dumpTo(out);
+            }
+            out += ']';
+            break;
+        case Type::Object:
+            out += '{';
+            for (size_t i = 0; i < members_.size(); ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                dumpString(out, members_[i].first);
+                out += ':';
+                members_[i].second.dumpTo(out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+bool parseJson(const std::string& text, JsonValue& value, std::string& error) {
+    Parser parser(text);
+    return parser.parse(value, error);
+}
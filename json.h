@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Минимальный JSON для управляющих протоколов: разбор строки и сериализация.
+// Числа хранятся как double, ключи объекта - в порядке добавления
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+    JsonValue(bool value) : type_(Type::Bool), bool_(value) {}
+    JsonValue(int value) : type_(Type::Number), number_(value) {}
+    JsonValue(int64_t value) : type_(Type::Number), number_(static_cast<double>(value)) {}
+    JsonValue(uint64_t value) : type_(Type::Number), number_(static_cast<double>(value)) {}
+    JsonValue(double value) : type_(Type::Number), number_(value) {}
+    JsonValue(const char* value) : type_(Type::String), string_(value) {}
+    JsonValue(std::string value) : type_(Type::String), string_(std::move(value)) {}
+
+    static JsonValue array() { JsonValue v; v.type_ = Type::Array; return v; }
+    static JsonValue object() { JsonValue v; v.type_ = Type::Object; return v; }
+
+    [[nodiscard]] Type type() const { return type_; }
+    [[nodiscard]] bool isNull() const { return type_ == Type::Null; }
+    [[nodiscard]] bool isNumber() const { return type_ == Type::Number; }
+    [[nodiscard]] bool isString() const { return type_ == Type::String; }
+    [[nodiscard]] bool isObject() const { return type_ == Type::Object; }
+    [[nodiscard]] bool isArray() const { return type_ == Type::Array; }
+
+    [[nodiscard]] bool asBool(bool fallback = false) const { return type_ == Type::Bool ? bool_ : fallback; }
+    [[nodiscard]] double asNumber(double fallback = 0.0) const { return type_ == Type::Number ? number_ : fallback; }
+    [[nodiscard]] const std::string& asString() const { return string_; }
+
+    // Объект: поиск и добавление/замена поля. Отсутствующее поле - null
+    [[nodiscard]] const JsonValue& operator[](const std::string& key) const;
+    [[nodiscard]] bool has(const std::string& key) const;
+    JsonValue& set(const std::string& key, JsonValue value);
+    [[nodiscard]] const std::vector<std::pair<std::string, JsonValue>>& members() const { return members_; }
+
+    // Массив
+    JsonValue& push(JsonValue value);
+    [[nodiscard]] const std::vector<JsonValue>& items() const { return items_; }
+    [[nodiscard]] size_t size() const { return type_ == Type::Array ? items_.size() : members_.size(); }
+
+    // Компактная запись в одну строку
+    [[nodiscard]] std::string dump() const;
+
+private:
+    void dumpTo(std::string& out) const;
+
+    Type type_ = Type::Null;
+    bool bool_ = false;
+    double number_ = 0.0;
+    std::string string_;
+    std::vector<JsonValue> items_;
+    std::vector<std::pair<std::string, JsonValue>> members_;
+};
+
+// false при ошибке, описание в error
+bool parseJson(const std::string& text, JsonValue& value, std::string& error);
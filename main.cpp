@@ -12,21 +12,47 @@
 #include <chrono>
 #include <algorithm>
 #include <limits>
+#include <cstring>
 #include <cmath>
-#include <ft2build.h>
-#include FT_FREETYPE_H
-#include <filesystem>
 #include <fstream>
 #include <string_view>
+#include <thread>
+#include <unistd.h>
 #include <openssl/md5.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "asset_bundle.h"
+#include "control.h"
+#include "cube_mesh.h"
+#include "fleet.h"
+#include "gl_capture.h"
+#include "gl_debug.h"
+#include "gl_dsa.h"
+#include "gl_intercept.h"
+#include "gl_state.h"
+#include "gles_context.h"
+#include "gpu_info.h"
+#include "gpu_timer.h"
+#include "job_system.h"
+#include "metrics_server.h"
+#include "null_backend.h"
+#include "options.h"
+#include "pipeline_stats.h"
+#include "results.h"
+#include "results_db.h"
+#include "shm_metrics.h"
+#include "soft_raster.h"
+#include "startup.h"
+#include "stats.h"
+#include "stream_buffer.h"
+#include "trace.h"
+#include "vulkan_renderer.h"
 
 int currentGraphIndex = 0;
 float minFps = std::numeric_limits<float>::max();
 float maxFps = 0.0f;
 unsigned int shaderProgram;
+unsigned int instancedShaderProgram;
+unsigned int transformShaderProgram;
 unsigned int lineVAO, lineVBO;
 unsigned int lineShaderProgram;
 
@@ -43,82 +69,26 @@ struct Character {
     glm::ivec2   Size;
     glm::ivec2   Bearing;
     unsigned int Advance;
+    std::vector<uint8_t> Bitmap;  // Маска глифа для программного растеризатора
 };
 
 std::map<char, Character> Characters;
-unsigned int textVAO, textVBO;
-unsigned int textShaderProgram;
-
-std::string_view vertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec3 aPos;
-    layout (location = 1) in vec3 aColor;
-    out vec3 ourColor;
-    uniform mat4 model;
-    uniform mat4 view;
-    uniform mat4 projection;
-    void main()
-    {
-        gl_Position = projection * view * model * vec4(aPos, 1.0);
-        ourColor = aColor;
-    }
-)";
+unsigned int textVAO;
 
-std::string_view fragmentShaderSource = R"(
-    #version 330 core
-    in vec3 ourColor;
-    out vec4 FragColor;
-    void main()
-    {
-        FragColor = vec4(ourColor, 1.0);
-    }
-)";
+// Текст и график каждый кадр пишутся в кольцевой буфер
+constexpr size_t HUD_STREAM_FRAME_SIZE = 256 * 1024;
+StreamBuffer hudStream;
+unsigned int textShaderProgram;
 
-std::string_view textVertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
-    out vec2 TexCoords;
-    uniform mat4 projection;
-    void main()
-    {
-        gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-        TexCoords = vertex.zw;
-    }
-)";
-
-std::string_view textFragmentShaderSource = R"(
-    #version 330 core
-    in vec2 TexCoords;
-    out vec4 color;
-    uniform sampler2D text;
-    uniform vec3 textColor;
-    void main()
-    {    
-        vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-        color = vec4(textColor, 1.0) * sampled;
-    }
-)";
-
-// шейдеры для линий
-std::string_view lineVertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec2 aPos;
-    uniform mat4 projection;
-    void main()
-    {
-        gl_Position = projection * vec4(aPos.x, aPos.y, 0.0, 1.0);
-    }
-)";
+// Оверлей рисуется в координатах 800 x 800 при любом размере окна
+const glm::mat4 HUD_PROJECTION = glm::ortho(0.0f, 800.0f, 0.0f, 800.0f);
 
-std::string_view lineFragmentShaderSource = R"(
-    #version 330 core
-    out vec4 FragColor;
-    uniform vec3 color;
-    void main()
-    {
-        FragColor = vec4(color, 1.0);
-    }
-)";
+// Записи набора ресурсов, без которых запуск невозможен
+const char* const REQUIRED_ASSETS[] = {
+    "shaders/gl_cube.vert", "shaders/gl_cube.frag", "shaders/gl_instanced.vert", "shaders/gl_transform.vert",
+    "shaders/gl_text.vert", "shaders/gl_text.frag", "shaders/gl_line.vert", "shaders/gl_line.frag",
+    "font/glyphs", "font/atlas"
+};
 
 // Функция для фильтра Калмана
 double kalmanFilter(double measurement, double& estimate, double& errorEstimate, double processNoise, double measurementNoise) {
@@ -134,106 +104,252 @@ double kalmanFilter(double measurement, double& estimate, double& errorEstimate,
     return estimate;
 }
 
-void loadFont()
-{
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft))
-    {
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        return;
-    }
+// Окно измерения, управляемое командами start/stop через сокет
+struct MeasurementWindow {
+    bool active = false;
+    std::string label;
+    std::chrono::steady_clock::time_point start;
+    double elapsedSec = 0.0;
+    double durationSec = 0.0;       // 0 - до команды stop
+    FrameTimeReservoir frameTimes;
+    std::vector<std::pair<std::string, double>> marks; // Фаза и время её начала от старта окна
+};
 
-    FT_Face face;
-    if (FT_New_Face(ft, "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf", 0, &face))
-    {
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-        return;
+JsonValue measurementStats(const MeasurementWindow& window) {
+    JsonValue stats = JsonValue::object();
+    stats.set("label", window.label)
+         .set("active", window.active)
+         .set("elapsed_sec", window.elapsedSec)
+         .set("frames", window.frameTimes.seen());
+    if (window.frameTimes.seen() > 0) {
+        std::vector<float> sorted = window.frameTimes.samples();
+        std::sort(sorted.begin(), sorted.end());
+        double totalMs = window.frameTimes.totalMs();
+        stats.set("avg_fps", totalMs > 0 ? 1000.0 * window.frameTimes.seen() / totalMs : 0.0)
+             .set("p50_ms", percentileSorted(sorted, 50.0))
+             .set("p90_ms", percentileSorted(sorted, 90.0))
+             .set("p99_ms", percentileSorted(sorted, 99.0))
+             .set("max_ms", static_cast<double>(window.frameTimes.maxMs()));
     }
+    JsonValue marks = JsonValue::array();
+    for (const auto& mark : window.marks) {
+        JsonValue entry = JsonValue::object();
+        entry.set("phase", mark.first).set("t_sec", mark.second);
+        marks.push(entry);
+    }
+    stats.set("marks", marks);
+    return stats;
+}
 
-    FT_Set_Pixel_Sizes(face, 0, 48); // Увеличено с 24 до 48
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+// Маски глифов из атласа набора ресурсов, без GL: идет в потоке запуска, пока
+// главный поток создает окно. Атлас растеризован FreeType при сборке
+std::map<char, Character> unpackFont(const AssetBundle& assets)
+{
+    std::map<char, Character> glyphs;
+    AssetImage atlas;
+    std::string_view records = assets.find("font/glyphs");
+    if (!assets.image("font/atlas", atlas) || atlas.channels != 1 ||
+        records.size() != ASSET_GLYPH_COUNT * sizeof(AssetGlyph)) {
+        std::cout << "ERROR::ASSETS: Invalid glyph atlas" << std::endl;
+        return glyphs;
+    }
 
-    for (unsigned char c = 0; c < 128; c++)
+    for (int c = 0; c < ASSET_GLYPH_COUNT; c++)
     {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-        {
-            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+        AssetGlyph glyph;
+        std::memcpy(&glyph, records.data() + c * sizeof(AssetGlyph), sizeof(glyph));
+        if (!glyph.loaded || glyph.width < 0 || glyph.height < 0 ||
+            glyph.atlasX + glyph.width > static_cast<uint32_t>(atlas.width) ||
+            glyph.atlasY + glyph.height > static_cast<uint32_t>(atlas.height)) {
             continue;
         }
 
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
         Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            static_cast<unsigned int>(face->glyph->advance.x)
+            0,
+            glm::ivec2(glyph.width, glyph.height),
+            glm::ivec2(glyph.bearingX, glyph.bearingY),
+            glyph.advance,
+            {}
         };
-        Characters.insert(std::pair<char, Character>(c, character));
+        character.Bitmap.resize(static_cast<size_t>(glyph.width) * glyph.height);
+        for (int32_t row = 0; row < glyph.height; row++) {
+            std::memcpy(character.Bitmap.data() + static_cast<size_t>(row) * glyph.width,
+                        atlas.pixels + static_cast<size_t>(glyph.atlasY + row) * atlas.width + glyph.atlasX, glyph.width);
+        }
+        glyphs.insert(std::pair<char, Character>(c, std::move(character)));
+    }
+    return glyphs;
+}
 
-     }
+// Текстуры глифов из готовых масок. Маски остаются только программному
+// растеризатору и Vulkan
+void uploadFont(std::map<char, Character> glyphs)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bool keepBitmaps = softRaster.enabled() || vulkanRenderer.enabled();
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    for (auto& [c, character] : glyphs)
+    {
+        GLsizei width = character.Size.x, height = character.Size.y;
+        const uint8_t* pixels = character.Bitmap.empty() ? nullptr : character.Bitmap.data();
+        unsigned int texture;
+        if (glDsa.enabled()) {
+            // Неизменяемое хранилище по имени текстуры, привязка не трогается.
+            // У пробела глифа нет: хранилище нулевого размера не создается
+            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+            if (width > 0 && height > 0) {
+                glTextureStorage2D(texture, 1, GL_R8, width, height);
+                glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, pixels);
+            }
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        } else {
+            glGenTextures(1, &texture);
+            glState.bindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                GL_R8,  // ES 3.0 принимает только размерный формат
+                width,
+                height,
+                0,
+                GL_RED,
+                GL_UNSIGNED_BYTE,
+                pixels
+            );
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        character.TextureID = texture;
+        if (!keepBitmaps) {
+            std::vector<uint8_t>().swap(character.Bitmap);
+        }
+    }
+    Characters = std::move(glyphs);
 }
 
 void renderText(const std::string& text, float x, float y, float scale, glm::vec3 color)
 {
-    glUseProgram(textShaderProgram);
-    glUniform3f(glGetUniformLocation(textShaderProgram, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(textVAO);
-
+    // Вершины всей строки одной загрузкой, дальше вызов отрисовки на глиф
+    constexpr size_t GLYPH_VERTEX_SIZE = 4 * sizeof(float);
+    std::vector<float> vertices;
+    vertices.reserve(text.size() * 6 * 4);
     for (char c : text)
     {
-        Character ch = Characters[c];
-        
+        const Character& ch = Characters[c];
+
         float xpos = x + ch.Bearing.x * scale;
         float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
 
         float w = ch.Size.x * scale;
         float h = ch.Size.y * scale;
 
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
+        vertices.insert(vertices.end(), {
+            xpos,     ypos + h,   0.0f, 0.0f,
+            xpos,     ypos,       0.0f, 1.0f,
+            xpos + w, ypos,       1.0f, 1.0f,
 
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }
-        };
+            xpos,     ypos + h,   0.0f, 0.0f,
+            xpos + w, ypos,       1.0f, 1.0f,
+            xpos + w, ypos + h,   1.0f, 0.0f
+        });
 
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (softRaster.enabled()) {
+            softRaster.drawGlyph(HUD_PROJECTION, glm::vec2(xpos, ypos), glm::vec2(xpos + w, ypos + h),
+                                 packSoftColor(color.x, color.y, color.z), ch.Bitmap.data(), ch.Size.x, ch.Size.y);
+        }
+        if (vulkanRenderer.enabled()) {
+            vulkanRenderer.drawGlyph(HUD_PROJECTION, glm::vec2(xpos, ypos), glm::vec2(xpos + w, ypos + h),
+                                     color, ch.Bitmap.data(), ch.Size.x, ch.Size.y);
+        }
 
         x += (ch.Advance >> 6) * scale;
     }
+    if (vertices.empty()) {
+        return;
+    }
+    size_t offset = hudStream.upload(vertices.data(), vertices.size() * sizeof(float), GLYPH_VERTEX_SIZE);
+    if (offset == SIZE_MAX) {
+        return;
+    }
+
+    glState.useProgram(textShaderProgram);
+    glUniform3f(glGetUniformLocation(textShaderProgram, "textColor"), color.x, color.y, color.z);
+    glState.activeTexture(GL_TEXTURE0);
+    glState.bindVertexArray(textVAO);
+
+    GLint first = static_cast<GLint>(offset / GLYPH_VERTEX_SIZE);
+    for (char c : text)
+    {
+        glState.bindTexture(GL_TEXTURE_2D, Characters[c].TextureID);
+        glDrawArrays(GL_TRIANGLES, first, 6);
+        first += 6;
+    }
+}
 
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+// Кубик Рубика для программного растеризатора: те же кубики и грани, что рисует
+// GL, по два треугольника на грань с цветом грани из CUBE_VERTICES
+void softDrawCube(const glm::mat4& viewProjection, const glm::mat4& rotation, int cubeSize, bool cull)
+{
+    CubeLayout layout = cubeLayout(cubeSize);
+    for (int x = 0; x < cubeSize; x++) {
+        for (int y = 0; y < cubeSize; y++) {
+            for (int z = 0; z < cubeSize; z++) {
+                unsigned faces = cull ? visibleCubeFaces(cubeSize, x, y, z) : ALL_CUBE_FACES;
+                if (faces == 0) {
+                    continue;
+                }
+                glm::mat4 model = glm::translate(rotation, layout.offset(x, y, z));
+                model = viewProjection * glm::scale(model, glm::vec3(layout.cubieSize));
+                for (int face = 0; face < CUBE_FACE_COUNT; face++) {
+                    if ((faces & (1u << face)) == 0) {
+                        continue;
+                    }
+                    const float* vertex = &CUBE_VERTICES[face * CUBE_FACE_VERTICES * CUBE_VERTEX_FLOATS];
+                    uint32_t color = packSoftColor(vertex[3], vertex[4], vertex[5]);
+                    glm::vec4 clip[CUBE_FACE_VERTICES];
+                    for (int i = 0; i < CUBE_FACE_VERTICES; i++, vertex += CUBE_VERTEX_FLOATS) {
+                        clip[i] = model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f);
+                    }
+                    softRaster.drawTriangle(clip[0], clip[1], clip[2], color, cull);
+                    softRaster.drawTriangle(clip[3], clip[4], clip[5], color, cull);
+                }
+            }
+        }
+    }
+}
+
+// Линии (пары вершин, вдоль осей) и точки размером 2 графика прямоугольниками:
+// для программного растеризатора и Vulkan, у которых нет линий и точек GL
+void drawGraphRects(const float* vertices, size_t count, GLenum mode, glm::vec3 color)
+{
+    uint32_t packed = packSoftColor(color.x, color.y, color.z);
+    auto rect = [&](glm::vec2 min, glm::vec2 max) {
+        if (softRaster.enabled()) {
+            softRaster.drawRect(HUD_PROJECTION, min, max, packed);
+        }
+        if (vulkanRenderer.enabled()) {
+            vulkanRenderer.drawRect(HUD_PROJECTION, min, max, color);
+        }
+    };
+    if (mode == GL_LINES) {
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            glm::vec2 a(vertices[i * 2], vertices[i * 2 + 1]);
+            glm::vec2 b(vertices[i * 2 + 2], vertices[i * 2 + 3]);
+            rect(glm::vec2(std::min(a.x, b.x), std::min(a.y, b.y)), glm::vec2(std::max(a.x, b.x), std::max(a.y, b.y)));
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        glm::vec2 point(vertices[i * 2], vertices[i * 2 + 1]);
+        rect(point - glm::vec2(1.0f, 1.0f), point + glm::vec2(1.0f, 1.0f));
+    }
 }
 
 void checkShaderCompileErrors(unsigned int shader, std::string type)
@@ -260,9 +376,34 @@ void checkShaderCompileErrors(unsigned int shader, std::string type)
     }
 }
 
+// Компиляция и сборка без запроса статуса: статус запрашивается после загрузок
+// запуска, и драйвер успевает собрать шейдеры параллельно с ними
+unsigned int startShaderCompile(GLenum type, std::string_view source)
+{
+    unsigned int shader = glCreateShader(type);
+    std::string text = glesContext.shaderSource(source);
+    const char* textPtr = text.c_str();
+    glShaderSource(shader, 1, &textPtr, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+unsigned int startProgramLink(unsigned int vertexShader, unsigned int fragmentShader)
+{
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    return program;
+}
 
 void checkOpenGLError(const char* stmt, const char* fname, int line)
 {
+    // glGetError ждет драйвер. С отладочным выводом ошибки приходят в обратный
+    // вызов, а контекст без проверок их не выдает
+    if (glDebug.mode() != GlContextMode::Default) {
+        return;
+    }
     GLenum err = glGetError();
     if (err != GL_NO_ERROR)
     {
@@ -295,15 +436,15 @@ float getTextWidth(const std::string& text, float scale) {
 }
 
 void drawLine(float x1, float y1, float x2, float y2, glm::vec3 color, unsigned int program) {
-    glUseProgram(program);
+    glState.useProgram(program);
     
     float vertices[] = {
         x1, y1, 0.0f,
         x2, y2, 0.0f
     };
     
-    glBindVertexArray(lineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+    glState.bindVertexArray(lineVAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, lineVBO);
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
     
     glm::mat4 projection = glm::ortho(0.0f, 800.0f, 0.0f, 800.0f);
@@ -316,6 +457,70 @@ void drawLine(float x1, float y1, float x2, float y2, glm::vec3 color, unsigned
     glDrawArrays(GL_LINES, 0, 2);
 }
 
+// Атрибуты вершин кубика (позиция и цвет) из vbo, индексы из ebo
+void setCubeVertexAttributes(unsigned int vao, unsigned int vbo, unsigned int ebo, const CubeMesh& mesh) {
+    GLsizei stride = vertexStride(mesh.format);
+    if (glDsa.enabled()) {
+        // Оба атрибута читают точку привязки 0, формат задается по имени VAO
+        glVertexArrayVertexBuffer(vao, 0, vbo, 0, stride);
+        if (mesh.format == VertexFormat::Packed) {
+            glVertexArrayAttribFormat(vao, 0, 3, GL_HALF_FLOAT, GL_FALSE, 0);
+            glVertexArrayAttribFormat(vao, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4 * sizeof(uint16_t));
+        } else {
+            glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+            glVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+        }
+        for (GLuint attribute = 0; attribute < 2; attribute++) {
+            glVertexArrayAttribBinding(vao, attribute, 0);
+            glEnableVertexArrayAttrib(vao, attribute);
+        }
+        glVertexArrayElementBuffer(vao, mesh.indexed() ? ebo : 0);
+        return;
+    }
+    glState.bindVertexArray(vao);
+    glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (mesh.format == VertexFormat::Packed) {
+        glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(4 * sizeof(uint16_t)));
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    // Индексный буфер запоминается в VAO
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexed() ? ebo : 0);
+    glState.bindVertexArray(0);
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Загружает геометрию кубика в VAO, возвращает тип индексов (0 - без индексов)
+GLenum uploadCubeMesh(unsigned int vao, unsigned int vbo, unsigned int ebo, const CubeMesh& mesh) {
+    if (glDsa.enabled()) {
+        glNamedBufferData(vbo, mesh.vertices.size(), mesh.vertices.data(), GL_STATIC_DRAW);
+        if (mesh.indexed()) {
+            glNamedBufferData(ebo, mesh.indices.size(), mesh.indices.data(), GL_STATIC_DRAW);
+        }
+    } else {
+        // Привязка индексного буфера меняет текущий VAO
+        glState.bindVertexArray(0);
+        glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size(), mesh.vertices.data(), GL_STATIC_DRAW);
+        glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+        if (mesh.indexed()) {
+            glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size(), mesh.indices.data(), GL_STATIC_DRAW);
+            glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+    }
+    setCubeVertexAttributes(vao, vbo, ebo, mesh);
+
+    if (!mesh.indexed()) {
+        return 0;
+    }
+    return mesh.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
 // константы для рафика
 const int GRAPH_WIDTH = 550;
 const int GRAPH_HEIGHT = 100;
@@ -348,47 +553,6 @@ std::string getMonitorInfo(GLFWwindow* window) {
     return ss.str();
 }
 
-std::string exec(const char* cmd) {
-    std::array<char, 128> buffer;
-    std::string result;
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd, "r"), pclose);
-    if (!pipe) {
-        throw std::runtime_error("popen() failed!");
-    }
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
-    }
-    return result;
-}
-
-[[nodiscard]] std::string getVRAMInfo() {
-    std::string result;
-    try {
-        result = exec("glxinfo | grep 'Video memory'");
-        
-        // Удаляем лишние пробелы и переносы строк
-        result.erase(std::remove(result.begin(), result.end(), '\n'), result.end());
-        result.erase(std::remove(result.begin(), result.end(), '\r'), result.end());
-        
-        // Извлекаем только объем памяти
-        size_t colonPos = result.find(':');
-        if (colonPos != std::string::npos) {
-            result = result.substr(colonPos + 1);
-            // Удаляем начальные пробелы
-            result.erase(0, result.find_first_not_of(' '));
-        }
-        
-        // Если результат пустой, возвращаем "Unknown"
-        if (result.empty()) {
-            result = "Unknown";
-        }
-    } catch (std::exception& e) {
-        result = "Unknown";
-    }
-    
-    return "VRAM: " + result;
-}
-
 std::string getCPUInfo() {
     std::ifstream cpuinfo("/proc/cpuinfo");
     std::string line;
@@ -421,49 +585,6 @@ std::string getRAMInfo() {
     return "RAM: " + ss.str();
 }
 
-GLFWimage createTransparentIcon(const char* filename, int targetSize) {
-    GLFWimage icon = {};
-    int width, height, channels;
-    unsigned char* data = stbi_load(filename, &width, &height, &channels, 4);
-
-    if (!data) {
-        return icon;
-    }
-
-    // Создаем новое изображение с заданным размером и прозрачным фоном
-    icon.width = targetSize;
-    icon.height = targetSize;
-    std::unique_ptr<unsigned char[]> pixels(new unsigned char[targetSize * targetSize * 4]);
-    memset(pixels.get(), 0, targetSize * targetSize * 4);
-
-    // Вычисляем коэффициент масштабирования
-    float scale = std::min((float)targetSize / width, (float)targetSize / height);
-    int newWidth = static_cast<int>(width * scale);
-    int newHeight = static_cast<int>(height * scale);
-
-    // Вычисляем отступы для центрирования
-    int offsetX = (targetSize - newWidth) / 2;
-    int offsetY = (targetSize - newHeight) / 2;
-
-    // Копируем и масштабируем изображение
-    for (int y = 0; y < newHeight; ++y) {
-        for (int x = 0; x < newWidth; ++x) {
-            int srcX = static_cast<int>(x / scale);
-            int srcY = static_cast<int>(y / scale);
-            int srcIndex = (srcY * width + srcX) * 4;
-            int dstIndex = ((y + offsetY) * targetSize + (x + offsetX)) * 4;
-
-            for (int c = 0; c < 4; ++c) {
-                pixels[dstIndex + c] = data[srcIndex + c];
-            }
-        }
-    }
-
-    stbi_image_free(data);
-    icon.pixels = pixels.release();
-    return icon;
-}
-
 const int WINDOW_WIDTH = 800;
 const int WINDOW_HEIGHT = 800;
 const float TEXT_SCALE = 0.4f;
@@ -500,68 +621,279 @@ std::string calculateMD5(const std::string& filename) {
     return ss.str().substr(0, 8); // Возвращаем первые 8 символов хеша
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-    std::vector<std::string> iconPaths = {
-        "include/ico.png",
-        "../include/ico.png",
-        "ico.png",
-        "../ico.png"
-    };
+    auto mainStart = std::chrono::steady_clock::now();
+    Options options;
+    std::string optionsError;
+    if (!parseOptions(argc, argv, options, optionsError)) {
+        std::cerr << "Ошибка: " << optionsError << std::endl;
+        printUsage(argv[0]);
+        return -1;
+    }
+    if (options.showHelp) {
+        printUsage(argv[0]);
+        return 0;
+    }
 
-    std::string iconPath;
-    for (const auto& path : iconPaths) {
-        if (std::filesystem::exists(path)) {
-            iconPath = path;
-            break;
+    std::string databasePath = options.databasePath.empty() ? defaultDatabasePath() : options.databasePath;
+
+    // Запросы к базе результатов не требуют окна и GL контекста
+    if (options.command == "db") {
+        DatabaseQuery query;
+        query.kind = options.commandArgs.empty() ? "history" : options.commandArgs[0];
+        query.fingerprint = options.fingerprint;
+        query.sinceSeconds = options.sinceSeconds;
+        query.limit = options.limit;
+        if (query.kind == "show") {
+            if (options.commandArgs.size() < 2) {
+                std::cerr << "Укажите номер прогона: db show <N>" << std::endl;
+                return -1;
+            }
+            query.runId = std::atoll(options.commandArgs[1].c_str());
+        }
+        return runDatabaseQuery(databasePath, query);
+    }
+    if (options.command == "analyze") {
+        if (options.commandArgs.empty()) {
+            std::cerr << "Укажите файл трассы: analyze <файл>" << std::endl;
+            return -1;
         }
+        TraceAnalysisOptions analysis;
+        analysis.windowSec = options.traceWindowSec;
+        return analyzeTrace(options.commandArgs[0], analysis);
+    }
+    if (options.command == "monitor") {
+        int64_t pid = options.commandArgs.empty() ? 0 : std::atoll(options.commandArgs[0].c_str());
+        return monitorSharedMetrics(pid, options.once);
+    }
+    if (options.command == "coordinator") {
+        CoordinatorOptions coordinator;
+        coordinator.listenAddress = options.listenAddress;
+        coordinator.agents = options.agents;
+        coordinator.reportPath = options.reportPath;
+        coordinator.outlierPercent = options.thresholdPercent;
+        coordinator.scenario.workload = workloadName(options.workload);
+        coordinator.scenario.cubeSize = options.cubeSize;
+        coordinator.scenario.warmupSec = options.warmupSec;
+        coordinator.scenario.durationSec = options.durationSec > 0 ? options.durationSec : coordinator.scenario.durationSec;
+        return runCoordinator(coordinator);
+    }
+    if (options.command == "ctl") {
+        if (options.commandArgs.empty()) {
+            std::cerr << "Укажите метод: ctl <метод> [параметры JSON]" << std::endl;
+            return -1;
+        }
+        return sendControlRequest(options.controlPath, options.commandArgs[0],
+                                  options.commandArgs.size() > 1 ? options.commandArgs[1] : "");
+    }
+    if (options.command == "replay") {
+        if (options.commandArgs.empty()) {
+            std::cerr << "Укажите файл записи: replay <файл>" << std::endl;
+            return -1;
+        }
+        return replayCapture(options.commandArgs[0], options.durationSec > 0 ? options.durationSec : 10.0);
+    }
+    if (!options.command.empty()) {
+        std::cerr << "Неизвестная команда: " << options.command << std::endl;
+        printUsage(argv[0]);
+        return -1;
     }
 
-    if (iconPath.empty()) {
-        std::cerr << "Предупреждение: файл иконки не найден. Программа продолжит работу бе иконки." << std::endl;
+    // Базовый прогон читаем до создания окна, чтобы не ждать конца теста ради ошибки
+    BenchmarkResults baseline;
+    if (!options.baselinePath.empty()) {
+        std::string loadError;
+        if (!loadResults(options.baselinePath, baseline, loadError)) {
+            std::cerr << "Не удалось загрузить базовый прогон: " << loadError << std::endl;
+            return -1;
+        }
     }
 
-    // Инициализация GLFW
-    if (!glfwInit())
-    {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
+    // Шейдеры, глифы и иконка: набор встроен при сборке или задан --assets и
+    // отображается в память. Файлы при запуске не ищутся
+    AssetBundle assets;
+    std::string assetsError;
+    if (!(options.assetsPath.empty() ? assets.openEmbedded(assetsError) : assets.openFile(options.assetsPath, assetsError))) {
+        std::cerr << "Failed to load assets: " << assetsError << std::endl;
         return -1;
     }
+    for (const char* name : REQUIRED_ASSETS) {
+        if (assets.find(name).empty()) {
+            std::cerr << "Failed to load assets: no " << name << " in " << assets.source() << std::endl;
+            return -1;
+        }
+    }
+    std::cout << "Набор ресурсов: " << assets.source() << ", " << assets.size() / 1024 << " KB" << std::endl;
+
+    // Работа CPU запуска идет в потоках, пока главный поток создает окно и
+    // собирает шейдеры. Результаты объявлены до графа: он ждет задачи в деструкторе
+    std::string cpuInfo, ramInfo;
+    std::map<char, Character> glyphs;
+    StartupGraph startup(options.parallelStartup, mainStart);
+    StartupGraph::TaskId sysinfoTask = startup.add("sysinfo", [&]() {
+        cpuInfo = getCPUInfo();
+        ramInfo = getRAMInfo();
+    });
+    StartupGraph::TaskId fontTask = startup.add("шрифт", [&]() { glyphs = unpackFont(assets); });
+
+    // Пустой бэкенд работает без окна и контекста: закрыть его некому, поэтому
+    // прогон всегда ограничен по времени
+    GLFWwindow* window = nullptr;
+    // Пул потоков нагрузки threaded, программного растеризатора и записи команд
+    // Vulkan, создается при первом использовании
+    std::unique_ptr<JobSystem> jobSystem;
+    if (options.backend == Backend::Null || options.backend == Backend::Soft) {
+        // Программный растеризатор рисует сам, команды GL ему не нужны
+        nullBackend.enable();
+        if (options.durationSec <= 0) {
+            options.durationSec = 10.0;
+        }
+        if (options.backend == Backend::Soft) {
+            jobSystem = std::make_unique<JobSystem>(options.transformThreads);
+            softRaster.init(jobSystem.get());
+            std::cout << "Бэкенд soft: сцену рисует программный растеризатор на " << jobSystem->threadCount() << " потоках, ";
+        } else {
+            std::cout << "Бэкенд null: команды GL отбрасываются, FPS - работа CPU без GPU, ";
+        }
+        std::cout << options.durationSec << " с" << std::endl;
+    } else {
+        // Инициализация GLFW
+        if (!glfwInit())
+        {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
 
-    // Настройка GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        // Настройка GLFW. Окну Vulkan контекст GL не нужен
+        if (options.backend == Backend::Vulkan) {
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        } else if (options.backend == Backend::GLES) {
+            // ES 3.0 - минимум, Mesa и драйверы Mali выдают старшую версию
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+        } else {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        }
+        if (options.backend != Backend::Vulkan) {
+            GlDebug::windowHints(options.glContext);
+        }
     
-    // запретить изменение размера ока
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        // запретить изменение размера ока
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Rubik GPU Benchmark", nullptr, nullptr);
-    if (window == nullptr)
-    {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
+        // Создание окна
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Rubik GPU Benchmark", nullptr, nullptr);
+        if (window == nullptr)
+        {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        if (options.backend == Backend::Vulkan) {
+            // Сцену рисует Vulkan, вызовы GL отбрасываются как у пустого бэкенда
+            nullBackend.enable();
+            jobSystem = std::make_unique<JobSystem>(options.transformThreads);
+            std::string vulkanError;
+            if (!vulkanRenderer.init(window, jobSystem.get(), vulkanError)) {
+                std::cerr << "Failed to initialize Vulkan: " << vulkanError << std::endl;
+                glfwTerminate();
+                return -1;
+            }
+            std::cout << "Бэкенд vulkan: " << vulkanRenderer.deviceName() << ", запись команд кубика на "
+                      << jobSystem->threadCount() << " потоках" << std::endl;
+            // Результаты и база получают нагрузку, которая рисовалась на самом деле
+            if (!backendSupportsWorkload(options.backend, options.workload)) {
+                std::cerr << "Нагрузка " << workloadName(options.workload)
+                          << " в Vulkan не реализована, рисуется threaded" << std::endl;
+                options.workload = Workload::Threaded;
+            }
+            if (!backendSupportsVertexFormat(options.backend, options.vertexFormat)) {
+                std::cerr << "Формат вершин " << vertexFormatName(options.vertexFormat)
+                          << " в Vulkan не реализован, используется float" << std::endl;
+                options.vertexFormat = VertexFormat::Float;
+            }
+        } else {
+            glfwMakeContextCurrent(window);
 
-    // Добавьте эту проверку
-    const char* error_description;
-    int error_code = glfwGetError(&error_description);
-    if (error_code != GLFW_NO_ERROR) {
-        std::cerr << "GLFW Error (" << error_code << "): " << error_description << std::endl;
-    }
+            // Добавьте эту проверку
+            const char* error_description;
+            int error_code = glfwGetError(&error_description);
+            if (error_code != GLFW_NO_ERROR) {
+                std::cerr << "GLFW Error (" << error_code << "): " << error_description << std::endl;
+            }
 
-    // Инициизация GLEW
-    if (glewInit() != GLEW_OK)
-    {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return -1;
+            // Инициизация GLEW. На контексте EGL функции загружаются, но GLEW,
+            // собранный для GLX, не находит дисплей GLX - это не ошибка
+            GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+            if (options.backend == Backend::GLES && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) {
+                glewStatus = GLEW_OK;
+            }
+#endif
+            if (glewStatus != GLEW_OK)
+            {
+                std::cerr << "Failed to initialize GLEW" << std::endl;
+                return -1;
+            }
+            if (options.backend == Backend::GLES) {
+                std::string glesError;
+                if (!glesContext.init(glesError)) {
+                    std::cerr << "Failed to initialize OpenGL ES: " << glesError << std::endl;
+                    glfwTerminate();
+                    return -1;
+                }
+                std::cout << "Бэкенд gles: " << glGetString(GL_VERSION) << ", таймеры GPU: "
+                          << (glesContext.timerQuery() ? "да" : "нет") << ", multi-draw: "
+                          << (glesContext.multiDraw() ? "да" : "нет") << std::endl;
+            }
+            if (options.glContext != GlContextMode::Default) {
+                std::string contextError;
+                if (!glDebug.init(options.glContext, options.glDebugSeverity, contextError)) {
+                    std::cerr << "GL context mode " << glContextModeName(options.glContext) << " is unavailable: "
+                              << contextError << ", using default" << std::endl;
+                } else if (glDebug.mode() == GlContextMode::Debug) {
+                    std::cout << "Контекст GL: debug, сообщения KHR_debug важности "
+                              << glDebugSeverityName(options.glDebugSeverity) << " и выше" << std::endl;
+                } else {
+                    std::cout << "Контекст GL: no-error, драйвер не проверяет вызовы" << std::endl;
+                }
+            }
+        }
+    }
+    glState.setEnabled(options.stateCache);
+    glCalls.setEnabled(options.glCalls);
+    // Запись начинается до создания первого объекта GL
+    if (!options.capturePath.empty()) {
+        glCapture.begin(options.captureFrames, WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
+    glDsa.init(options.dsa);
+    if (!nullBackend.active()) {
+        std::cout << "Direct State Access: " << (glDsa.enabled() ? "да" : "нет")
+                  << (glDsa.enabled() ? "" : std::string(" (") + glDsa.fallbackReason() + ")") << std::endl;
     }
 
     // Отключаем VSync
-    glfwSwapInterval(0);
+    int swapInterval = 0;
+    if (window && !nullBackend.active()) {
+        glfwSwapInterval(swapInterval);
+    }
+
+    // Без окна размер кадра меняет только set_resolution, а закрывает - quit и --duration
+    int nullFramebufferWidth = WINDOW_WIDTH, nullFramebufferHeight = WINDOW_HEIGHT;
+    auto getFramebufferSize = [&](int& width, int& height) {
+        if (window) {
+            glfwGetFramebufferSize(window, &width, &height);
+        } else {
+            width = nullFramebufferWidth;
+            height = nullFramebufferHeight;
+        }
+    };
+    bool closeRequested = false;
 
     // Добавляем переменные для подсчета FPS и фильтра Калмна
     auto lastTime = std::chrono::steady_clock::now();
@@ -572,176 +904,199 @@ int main()
     const double measurementNoise = 36.0;
     bool isFirstMeasurement = true;
 
-    // Компиляция шейдеров
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    const char* vertexShaderSourcePtr = vertexShaderSource.data();
-    glShaderSource(vertexShader, 1, &vertexShaderSourcePtr, NULL);
-    glCompileShader(vertexShader);
-    checkShaderCompileErrors(vertexShader, "VERTEX");
-
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* fragmentShaderSourcePtr = fragmentShaderSource.data();
-    glShaderSource(fragmentShader, 1, &fragmentShaderSourcePtr, NULL);
-    glCompileShader(fragmentShader);
-    checkShaderCompileErrors(fragmentShader, "FRAGMENT");
-
-    // После компиляции шейдеров
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    checkShaderCompileErrors(shaderProgram, "PROGRAM");
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    loadFont();
-
-    unsigned int textVertexShader = glCreateShader(GL_VERTEX_SHADER);
-    const char* textVertexShaderSourcePtr = textVertexShaderSource.data();
-    glShaderSource(textVertexShader, 1, &textVertexShaderSourcePtr, NULL);
-    glCompileShader(textVertexShader);
-    checkShaderCompileErrors(textVertexShader, "TEXT_VERTEX");
-
-    unsigned int textFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* textFragmentShaderSourcePtr = textFragmentShaderSource.data();
-    glShaderSource(textFragmentShader, 1, &textFragmentShaderSourcePtr, NULL);
-    glCompileShader(textFragmentShader);
-    checkShaderCompileErrors(textFragmentShader, "TEXT_FRAGMENT");
-
-    textShaderProgram = glCreateProgram();
-    glAttachShader(textShaderProgram, textVertexShader);
-    glAttachShader(textShaderProgram, textFragmentShader);
-    glLinkProgram(textShaderProgram);
-    checkShaderCompileErrors(textShaderProgram, "TEXT_PROGRAM");
-
-    glDeleteShader(textVertexShader);
-    glDeleteShader(textFragmentShader);
+    startup.stage("окно и контекст");
 
-    glGenVertexArrays(1, &textVAO);
-    glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // Компиляция шейдеров. С KHR_parallel_shader_compile драйвер собирает их в
+    // своих потоках; все шейдеры отправляются сразу, статусы проверяются ниже
+    if (startup.parallel() && !nullBackend.active() && !glesContext.active()) {
+        if (GLEW_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        } else if (GLEW_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        }
+    }
+    unsigned int vertexShader = startShaderCompile(GL_VERTEX_SHADER, assets.find("shaders/gl_cube.vert"));
+    unsigned int fragmentShader = startShaderCompile(GL_FRAGMENT_SHADER, assets.find("shaders/gl_cube.frag"));
+    unsigned int instancedVertexShader = startShaderCompile(GL_VERTEX_SHADER, assets.find("shaders/gl_instanced.vert"));
+    unsigned int transformVertexShader = startShaderCompile(GL_VERTEX_SHADER, assets.find("shaders/gl_transform.vert"));
+    unsigned int textVertexShader = startShaderCompile(GL_VERTEX_SHADER, assets.find("shaders/gl_text.vert"));
+    unsigned int textFragmentShader = startShaderCompile(GL_FRAGMENT_SHADER, assets.find("shaders/gl_text.frag"));
+    unsigned int lineVertexShader = startShaderCompile(GL_VERTEX_SHADER, assets.find("shaders/gl_line.vert"));
+    unsigned int lineFragmentShader = startShaderCompile(GL_FRAGMENT_SHADER, assets.find("shaders/gl_line.frag"));
+
+    shaderProgram = startProgramLink(vertexShader, fragmentShader);
+    instancedShaderProgram = startProgramLink(instancedVertexShader, fragmentShader);
+    transformShaderProgram = startProgramLink(transformVertexShader, fragmentShader);
+    textShaderProgram = startProgramLink(textVertexShader, textFragmentShader);
+    lineShaderProgram = startProgramLink(lineVertexShader, lineFragmentShader);
+    startup.stage("отправка шейдеров");
+
+    // Загрузки в GL, пока драйвер собирает шейдеры
+    startup.wait(fontTask);
+    uploadFont(std::move(glyphs));
+
+    hudStream.init(HUD_STREAM_FRAME_SIZE);
+    std::cout << "Потоковый буфер: " << (hudStream.persistent() ? (glesContext.active() ? "persistent (EXT_buffer_storage)" : "persistent (ARB_buffer_storage)") : "orphaning")
+              << ", " << HUD_STREAM_FRAME_SIZE / 1024 << " KB на кадр" << std::endl;
+
+    glDsa.createVertexArrays(1, &textVAO);
+    if (glDsa.enabled()) {
+        glVertexArrayVertexBuffer(textVAO, 0, hudStream.buffer(), 0, 4 * sizeof(float));
+        glVertexArrayAttribFormat(textVAO, 0, 4, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(textVAO, 0, 0);
+        glEnableVertexArrayAttrib(textVAO, 0);
+    } else {
+        glState.bindVertexArray(textVAO);
+        glState.bindBuffer(GL_ARRAY_BUFFER, hudStream.buffer());
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+        glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+        glState.bindVertexArray(0);
+    }
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.enable(GL_BLEND);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glGenVertexArrays(1, &lineVAO);
     glGenBuffers(1, &lineVBO);
-    glBindVertexArray(lineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+    glState.bindVertexArray(lineVAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, lineVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void*>(0));
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    // Компиляция шейдеров для линий
-    unsigned int lineVertexShader = glCreateShader(GL_VERTEX_SHADER);
-    const char* lineVertexShaderSourcePtr = lineVertexShaderSource.data();
-    glShaderSource(lineVertexShader, 1, &lineVertexShaderSourcePtr, NULL);
-    glCompileShader(lineVertexShader);
-    checkShaderCompileErrors(lineVertexShader, "LINE_VERTEX");
-
-    unsigned int lineFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* lineFragmentShaderSourcePtr = lineFragmentShaderSource.data();
-    glShaderSource(lineFragmentShader, 1, &lineFragmentShaderSourcePtr, NULL);
-    glCompileShader(lineFragmentShader);
-    checkShaderCompileErrors(lineFragmentShader, "LINE_FRAGMENT");
-
-    lineShaderProgram = glCreateProgram();
-    glAttachShader(lineShaderProgram, lineVertexShader);
-    glAttachShader(lineShaderProgram, lineFragmentShader);
-    glLinkProgram(lineShaderProgram);
-    checkShaderCompileErrors(lineShaderProgram, "LINE_PROGRAM");
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.bindVertexArray(0);
+
+    // VAO графика, вершины из кольцевого буфера
+    glDsa.createVertexArrays(1, &lineVAO);
+    if (glDsa.enabled()) {
+        glVertexArrayVertexBuffer(lineVAO, 0, hudStream.buffer(), 0, 2 * sizeof(float));
+        glVertexArrayAttribFormat(lineVAO, 0, 2, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(lineVAO, 0, 0);
+        glEnableVertexArrayAttrib(lineVAO, 0);
+    } else {
+        glState.bindVertexArray(lineVAO);
+        glState.bindBuffer(GL_ARRAY_BUFFER, hudStream.buffer());
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), static_cast<void*>(0));
+        glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+        glState.bindVertexArray(0);
+    }
 
-    glDeleteShader(lineVertexShader);
-    glDeleteShader(lineFragmentShader);
+    // Единичный куб для отрисовки по кубику, пересобирается при смене формата вершин
+    unsigned int VBO, VAO, EBO;
+    glDsa.createVertexArrays(1, &VAO);
+    glDsa.createBuffers(1, &VBO);
+    glDsa.createBuffers(1, &EBO);
+
+    // Тот же куб с матрицами кубиков из буфера инстансов (нагрузка threaded)
+    // Матрицы пишутся в свой кольцевой буфер, указатели атрибутов ставятся на
+    // смещение текущего кадра перед отрисовкой. С DSA столбцы матрицы читают
+    // точку привязки 1, и перед кадром в нее ставится только буфер со смещением
+    unsigned int transformVAO;
+    glDsa.createVertexArrays(1, &transformVAO);
+    if (glDsa.enabled()) {
+        for (GLuint column = 0; column < 4; column++) {
+            glVertexArrayAttribFormat(transformVAO, 2 + column, 4, GL_FLOAT, GL_FALSE, column * 4 * sizeof(float));
+            glVertexArrayAttribBinding(transformVAO, 2 + column, 1);
+            glEnableVertexArrayAttrib(transformVAO, 2 + column);
+        }
+        glVertexArrayBindingDivisor(transformVAO, 1, 1);
+    } else {
+        glState.bindVertexArray(transformVAO);
+        for (int column = 0; column < 4; column++) {
+            glEnableVertexAttribArray(2 + column);
+            glVertexAttribDivisor(2 + column, 1);
+        }
+        glState.bindVertexArray(0);
+    }
+    StreamBuffer instanceStream;
+
+    VertexFormat unitFormat = options.vertexFormat;
+    GLenum unitIndexType = 0;
+    auto uploadUnitCube = [&]() {
+        CubeMesh mesh = buildUnitCubeMesh(unitFormat);
+        unitIndexType = uploadCubeMesh(VAO, VBO, EBO, mesh);
+        setCubeVertexAttributes(transformVAO, VBO, EBO, mesh);
+    };
+    uploadUnitCube();
 
-    // Создание VAO и VBO для линий
-    glGenVertexArrays(1, &lineVAO);
-    glGenBuffers(1, &lineVBO);
-    glBindVertexArray(lineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * GRAPH_WIDTH * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), static_cast<void*>(0));
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    // Вершины куба с цветами
-    std::array<float, 216> vertices = {
-        // позиции          // цвета
-        -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-
-        -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f,
-
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 1.0f,
-
-         0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,
-
-        -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,
-
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f,
-         0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f
+    auto loadUnitCube = [&](VertexFormat format) {
+        if (unitFormat != format) {
+            unitFormat = format;
+            uploadUnitCube();
+        }
     };
 
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    // Запеченный кубик целиком, пересобирается при смене размера
+    unsigned int bakedVAO, bakedVBO, bakedEBO;
+    glDsa.createVertexArrays(1, &bakedVAO);
+    glDsa.createBuffers(1, &bakedVBO);
+    glDsa.createBuffers(1, &bakedEBO);
+    int bakedCubeSize = 0;
+    bool bakedCull = false;
+    VertexFormat bakedFormat = VertexFormat::Float;
+    GLenum bakedIndexType = 0;
+    GLsizei bakedCount = 0;  // Число индексов или вершин без индексов
+
+    auto bakeCube = [&](int size, bool cull, VertexFormat format) {
+        if (bakedCubeSize == size && bakedCull == cull && bakedFormat == format) {
+            return;
+        }
+        auto bakeStart = std::chrono::steady_clock::now();
+        CubeMesh mesh = bakeCubeMesh(cubeLayout(size), cull, format);
+        bakedIndexType = uploadCubeMesh(bakedVAO, bakedVBO, bakedEBO, mesh);
+        bakedCubeSize = size;
+        bakedCull = cull;
+        bakedFormat = format;
+        bakedCount = static_cast<GLsizei>(mesh.indexed() ? mesh.indexCount : mesh.vertexCount);
+        std::cout << "Запеченный кубик " << size << "x" << size << "x" << size << " (" << vertexFormatName(format)
+                  << "): " << mesh.vertexCount << " вершин, " << mesh.indexCount << " индексов, "
+                  << (mesh.vertices.size() + mesh.indices.size()) / 1024 << " KB, "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count()
+                  << " мс" << std::endl;
+    };
 
-    glBindVertexArray(VAO);
+    startup.stage("загрузки");
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    // Статусы сборки. Драйвер без параллельной сборки доделывает ее здесь
+    checkShaderCompileErrors(vertexShader, "VERTEX");
+    checkShaderCompileErrors(fragmentShader, "FRAGMENT");
+    checkShaderCompileErrors(instancedVertexShader, "INSTANCED_VERTEX");
+    checkShaderCompileErrors(transformVertexShader, "TRANSFORM_VERTEX");
+    checkShaderCompileErrors(textVertexShader, "TEXT_VERTEX");
+    checkShaderCompileErrors(textFragmentShader, "TEXT_FRAGMENT");
+    checkShaderCompileErrors(lineVertexShader, "LINE_VERTEX");
+    checkShaderCompileErrors(lineFragmentShader, "LINE_FRAGMENT");
+    checkShaderCompileErrors(shaderProgram, "PROGRAM");
+    checkShaderCompileErrors(instancedShaderProgram, "INSTANCED_PROGRAM");
+    checkShaderCompileErrors(transformShaderProgram, "TRANSFORM_PROGRAM");
+    checkShaderCompileErrors(textShaderProgram, "TEXT_PROGRAM");
+    checkShaderCompileErrors(lineShaderProgram, "LINE_PROGRAM");
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    glDeleteShader(vertexShader);
+    glDeleteShader(instancedVertexShader);
+    glDeleteShader(transformVertexShader);
+    glDeleteShader(fragmentShader);
+    glDeleteShader(textVertexShader);
+    glDeleteShader(textFragmentShader);
+    glDeleteShader(lineVertexShader);
+    glDeleteShader(lineFragmentShader);
+    startup.stage("сборка шейдеров");
 
-    glEnable(GL_DEPTH_TEST);
+    glState.enable(GL_DEPTH_TEST);
 
     std::string fpsText = "FPS: 0";
     std::string avgFpsText = "Avg: 0";
 
     double fps = 0.0;
 
-    std::string gpuName = getGPUName();
+    std::string gpuName = nullBackend.active() ? "Null backend (CPU only)" : getGPUName();
+    if (softRaster.enabled()) {
+        gpuName = "Software rasterizer (" + std::to_string(jobSystem->threadCount()) + " threads)";
+    } else if (vulkanRenderer.enabled()) {
+        gpuName = vulkanRenderer.deviceName() + " (Vulkan)";
+    }
 
     float cameraDistance = 5.0f;
     float minDistance = 3.0f;
@@ -750,39 +1105,446 @@ int main()
 
     auto startTime = std::chrono::steady_clock::now();
 
-    std::string monitorInfo = getMonitorInfo(window);
-    std::string vramInfo = getVRAMInfo();
-    std::string cpuInfo = getCPUInfo();
-    std::string ramInfo = getRAMInfo();
-
-    // Используем уже определенную переменную iconPath
-    if (!iconPath.empty()) {
-        GLFWimage icon = createTransparentIcon(iconPath.c_str(), 32);
-        if (icon.pixels) {
-            glfwSetWindowIcon(window, 1, &icon);
-            stbi_image_free(icon.pixels);
+    std::string monitorInfo = window ? getMonitorInfo(window) : "none";
+    VRAMStatus vramStatus = nullBackend.active() ? VRAMStatus{} : queryVRAM();
+    std::string vramInfo = formatVRAM(vramStatus);
+    std::string driverInfo = vulkanRenderer.enabled() ? vulkanRenderer.driverInfo()
+                           : nullBackend.active() ? "none" : getDriverInfo();
+    startup.wait(sysinfoTask);
+
+    // Иконка уже уменьшена при сборке, GLFW копирует пиксели прямо из набора
+    AssetImage iconImage;
+    if (window && assets.image("icon", iconImage) && iconImage.channels == 4) {
+        GLFWimage icon = {iconImage.width, iconImage.height, const_cast<unsigned char*>(iconImage.pixels)};
+        glfwSetWindowIcon(window, 1, &icon);
+    }
+    startup.stage("сведения о системе");
+
+    std::cout << "Драйвер: " << driverInfo << std::endl;
+    std::cout << vramInfo << " [" << (vramStatus.source.empty() ? "нет данных" : vramStatus.source) << "]" << std::endl;
+
+    auto lastFPSUpdateTime = std::chrono::steady_clock::now();
+
+    // Время кадров для итоговой статистики и сравнения: выборка постоянного
+    // размера и гистограмма всех кадров, память не растет на долгих прогонах
+    FrameTimeReservoir frameTimes;
+    FrameTimeHistogram frameHistogram;
+    auto previousFrameTime = lastFPSUpdateTime;
+
+    // Покадровая трасса и замер проходов на GPU
+    uint64_t frameIndex = 0;
+    GpuTimer gpuTimer;
+    // Вершины и запуски вершинного шейдера прохода кубика, если драйвер их считает
+    PipelineStats pipelineStats;
+    pipelineStats.init();
+    TraceWriter traceWriter;
+    if (!options.tracePath.empty()) {
+        if (traceWriter.open(options.tracePath, gpuName + " | " + driverInfo + " | " + programVersion)) {
+            if (!nullBackend.active()) {
+                gpuTimer.init();
+            }
+            std::cout << "Запись трассы: " << options.tracePath << std::endl;
         } else {
-            std::cerr << "Не удалось загрузить иконку" << std::endl;
+            std::cerr << "Не удалось создать файл трассы " << options.tracePath << std::endl;
         }
     }
 
-    auto lastFPSUpdateTime = std::chrono::steady_clock::now();
+    // Сервер метрик читает снимок, который публикуется раз в секунду
+    MetricsServer metricsServer;
+    TelemetrySnapshot telemetry;
+    GpuPassTimes gpuPassSumNs {};
+    uint64_t gpuPassFrames = 0;
+
+    // Те же данные за секунду для сегмента в разделяемой памяти
+    SharedMetricsWriter sharedMetricsWriter;
+    SharedMetrics sharedMetrics;
+    std::vector<float> secondFrameTimesMs;
+    uint64_t submitSumNs = 0;
+    uint64_t swapSumNs = 0;
+    uint64_t phaseFrames = 0;
+    if (options.sharedMemory) {
+        std::string error;
+        if (sharedMetricsWriter.open(gpuName, programVersion, error)) {
+            std::cout << "Метрики в разделяемой памяти: /dev/shm" << sharedMetricsWriter.name() << std::endl;
+        } else {
+            std::cerr << "Failed to create shared memory segment: " << error << std::endl;
+        }
+    }
+    if (options.metricsPort > 0) {
+        std::string error;
+        metricsServer.setInfo(gpuName, driverInfo, programVersion);
+        if (metricsServer.start(options.metricsBind, options.metricsPort, error)) {
+            if (!nullBackend.active()) {
+                gpuTimer.init();
+            }
+            std::cout << "Метрики: http://" << options.metricsBind << ":" << options.metricsPort << "/metrics" << std::endl;
+        } else {
+            std::cerr << "Failed to start metrics server: " << error << std::endl;
+        }
+    }
+    auto toTraceNs = [&startTime](std::chrono::steady_clock::time_point t) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t - startTime).count());
+    };
 
     // Теперь версия программы устанавливается через cmake
     // Убираем эту строку, так как версия уже установлена через define
     // programVersion = calculateMD5(__FILE__);
 
+    // Текущая нагрузка и окна измерения, меняются через управляющий сокет
+    Workload workload = options.workload;
+    int cubeSize = options.cubeSize;
+    bool cullHidden = options.cullHidden;
+    VertexFormat vertexFormat = options.vertexFormat;
+    bool configChanged = false; // Для результатов: сцену меняли командами управления
+    std::string currentPhase;
+
+    // Нагрузка threaded: пул потоков (объявлен при выборе бэкенда)
+    std::vector<glm::vec3> transformOffsets;
+    int transformCubeSize = 0;
+    bool transformCull = false;
+    uint64_t transformSumNs = 0;
+    uint64_t transformFrames = 0;
+    double transformMs = 0.0;
+
+    // Время расчета матриц на 1, 2, 4... потоках, чтобы видеть масштабирование по ядрам
+    auto measureTransformScaling = [&]() {
+        std::vector<float> scratch(transformOffsets.size() * CUBIE_TRANSFORM_FLOATS);
+        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), 0.5f, glm::vec3(0.5f, 1.0f, 0.0f));
+        std::cout << "Расчет матриц " << transformOffsets.size() << " кубиков, потоки: мс (ускорение)";
+        std::vector<int> workerCounts;
+        for (int workers = 1; workers < jobSystem->threadCount(); workers *= 2) {
+            workerCounts.push_back(workers);
+        }
+        workerCounts.push_back(jobSystem->threadCount());
+        double singleMs = 0.0;
+        for (int workers : workerCounts) {
+            double bestMs = std::numeric_limits<double>::max();
+            for (int run = 0; run < 5; run++) {
+                auto runStart = std::chrono::steady_clock::now();
+                jobSystem->parallelFor(transformOffsets.size(), TRANSFORM_CHUNK, [&](size_t begin, size_t end) {
+                    writeCubieTransforms(rotation, 1.0f, transformOffsets.data() + begin, end - begin,
+                                         scratch.data() + begin * CUBIE_TRANSFORM_FLOATS);
+                }, workers);
+                bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count());
+            }
+            if (workers == 1) {
+                singleMs = bestMs;
+            }
+            std::cout << (workers == 1 ? " " : ", ") << workers << ": " << std::fixed << std::setprecision(2) << bestMs
+                      << " (x" << singleMs / std::max(bestMs, 1e-6) << ")";
+        }
+        std::cout << std::endl;
+    };
+
+    auto prepareTransforms = [&]() {
+        if (!jobSystem) {
+            jobSystem = std::make_unique<JobSystem>(options.transformThreads);
+        }
+        if (transformCubeSize == cubeSize && transformCull == cullHidden) {
+            return;
+        }
+        transformOffsets = cubieOffsets(cubeLayout(cubeSize), cullHidden);
+        transformCubeSize = cubeSize;
+        transformCull = cullHidden;
+        measureTransformScaling();
+    };
+    MeasurementWindow measurement;
+    MeasurementWindow lastMeasurement;
+
+    auto printGeometry = [&]() {
+        if (workload == Workload::Clear) {
+            return;
+        }
+        if (cullHidden) {
+            CubeCullStats cull = cubeCullStats(cubeSize);
+            std::cout << "Отсечение скрытых: кубиков " << cull.cubies - cull.visibleCubies << " из " << cull.cubies
+                      << ", граней " << cull.faces - cull.visibleFaces << " из " << cull.faces << std::endl;
+        }
+        CubeGeometryStats geometry = cubeGeometryStats(cubeSize, cullHidden, workload, vertexFormat);
+        std::cout << "Вершины " << vertexFormatName(vertexFormat) << " (" << vertexStride(vertexFormat)
+                  << " Б): за кадр " << geometry.draws << " вызовов, " << geometry.shadedVertices << " вершин, "
+                  << geometry.vertexBytes / 1024 << " KB вершин + " << geometry.indexBytes / 1024
+                  << " KB индексов, попадания в кэш вершин (оценка модели FIFO) "
+                  << static_cast<int>(geometry.cacheHitRate * 100.0 + 0.5) << "%"
+                  << (pipelineStats.enabled() ? ", замер - в итогах" : "") << std::endl;
+    };
+
+    auto finishMeasurement = [&]() {
+        measurement.active = false;
+        lastMeasurement = std::move(measurement);
+        measurement = MeasurementWindow();
+        JsonValue stats = measurementStats(lastMeasurement);
+        std::cout << "Окно измерения '" << lastMeasurement.label << "': " << lastMeasurement.frameTimes.seen()
+                  << " кадров, среднее FPS " << std::fixed << std::setprecision(2) << stats["avg_fps"].asNumber()
+                  << ", P99 " << stats["p99_ms"].asNumber() << " мс" << std::endl;
+    };
+
+    auto handleControl = [&](const std::string& method, const JsonValue& params, RpcError& error) -> JsonValue {
+        JsonValue result = JsonValue::object();
+        if (method == "status") {
+            int width = 0, height = 0;
+            getFramebufferSize(width, height);
+            result.set("fps", fps)
+                  .set("backend", backendName(options.backend))
+                  .set("fps_estimate", fpsEstimate)
+                  .set("frames", frameIndex)
+                  .set("uptime_sec", std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count())
+                  .set("workload", workloadName(workload))
+                  .set("cube_size", cubeSize)
+                  .set("cull", cullHidden)
+                  .set("vertex_format", vertexFormatName(vertexFormat))
+                  .set("transform_ms", transformMs)
+                  .set("stream_fence_waits", hudStream.fenceWaits() + instanceStream.fenceWaits())
+                  .set("state_cache", glState.enabled())
+                  .set("dsa", glDsa.enabled())
+                  .set("gl_context", glContextModeName(glDebug.mode()))
+                  .set("startup_ms", startup.firstFrameMs())
+                  .set("gl_debug_messages", glDebug.totalMessages())
+                  .set("state_calls_issued", glState.lastFrame().issued)
+                  .set("state_calls_skipped", glState.lastFrame().skipped)
+                  .set("width", width)
+                  .set("height", height)
+                  .set("vsync", swapInterval)
+                  .set("phase", currentPhase)
+                  .set("measuring", measurement.active);
+            if (pipelineStats.frames() > 0) {
+                result.set("vertices_submitted_per_frame", pipelineStats.verticesSubmitted() / pipelineStats.frames())
+                      .set("vertex_shader_invocations_per_frame", pipelineStats.shaderInvocations() / pipelineStats.frames())
+                      .set("vertex_reuse_rate", pipelineStats.reuseRate());
+            }
+        } else if (method == "start") {
+            if (measurement.active) {
+                finishMeasurement();
+            }
+            measurement.active = true;
+            measurement.label = params["label"].isString() ? params["label"].asString() : "window";
+            measurement.durationSec = std::max(0.0, params["duration"].asNumber());
+            measurement.start = std::chrono::steady_clock::now();
+            result.set("label", measurement.label).set("duration", measurement.durationSec);
+        } else if (method == "stop") {
+            if (measurement.active) {
+                finishMeasurement();
+            }
+            result = measurementStats(lastMeasurement);
+        } else if (method == "stats") {
+            result = measurementStats(measurement.active ? measurement : lastMeasurement);
+        } else if (method == "mark") {
+            if (!params["phase"].isString()) {
+                error = {RPC_INVALID_PARAMS, "phase is required"};
+                return {};
+            }
+            currentPhase = params["phase"].asString();
+            if (measurement.active) {
+                double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - measurement.start).count();
+                measurement.marks.emplace_back(currentPhase, t);
+            }
+            std::cout << "Фаза: " << currentPhase << std::endl;
+            result.set("phase", currentPhase);
+        } else if (method == "set_workload") {
+            Workload nextWorkload = workload;
+            if (params.has("name") && !parseWorkload(params["name"].asString(), nextWorkload)) {
+                error = {RPC_INVALID_PARAMS, "unknown workload"};
+                return {};
+            }
+            if (!backendSupportsWorkload(options.backend, nextWorkload)) {
+                error = {RPC_INVALID_PARAMS, std::string("workload ") + workloadName(nextWorkload) + " is not implemented on " +
+                                                 backendName(options.backend)};
+                return {};
+            }
+            // Предел проверяется и при смене одной нагрузки: cube не тянет размер instanced
+            int size = params.has("cube_size") ? static_cast<int>(params["cube_size"].asNumber()) : cubeSize;
+            int maxSize = maxCubeSize(nextWorkload, options.backend);
+            if (size < 1 || size > maxSize) {
+                error = {RPC_INVALID_PARAMS, "cube_size must be 1.." + std::to_string(maxSize) + " for " +
+                                                 workloadName(nextWorkload)};
+                return {};
+            }
+            VertexFormat nextFormat = vertexFormat;
+            if (params.has("vertex_format") && !parseVertexFormat(params["vertex_format"].asString(), nextFormat)) {
+                error = {RPC_INVALID_PARAMS, "unknown vertex format"};
+                return {};
+            }
+            if (!backendSupportsVertexFormat(options.backend, nextFormat)) {
+                error = {RPC_INVALID_PARAMS, std::string("vertex format ") + vertexFormatName(nextFormat) +
+                                                 " is not implemented on " + backendName(options.backend)};
+                return {};
+            }
+            // Отклоненный запрос сцену не меняет, результаты не помечаются
+            configChanged = true;
+            workload = nextWorkload;
+            cubeSize = size;
+            vertexFormat = nextFormat;
+            if (params.has("cull")) {
+                cullHidden = params["cull"].asBool();
+            }
+            if (workload == Workload::Baked) {
+                bakeCube(cubeSize, cullHidden, vertexFormat);
+            } else if (workload == Workload::Threaded) {
+                prepareTransforms();
+            }
+            printGeometry();
+            pipelineStats.reset();
+            CubeCullStats cull = cubeCullStats(cubeSize);
+            CubeGeometryStats geometry = cubeGeometryStats(cubeSize, cullHidden, workload, vertexFormat);
+            result.set("workload", workloadName(workload))
+                  .set("cube_size", cubeSize)
+                  .set("cull", cullHidden)
+                  .set("culled_cubies", cullHidden ? cull.cubies - cull.visibleCubies : 0)
+                  .set("culled_faces", cullHidden ? cull.faces - cull.visibleFaces : 0)
+                  .set("vertex_format", vertexFormatName(vertexFormat))
+                  .set("vertex_bytes_per_frame", geometry.vertexBytes)
+                  .set("index_bytes_per_frame", geometry.indexBytes)
+                  .set("vertex_cache_hit_rate_estimate", geometry.cacheHitRate);
+        } else if (method == "set_resolution") {
+            int width = static_cast<int>(params["width"].asNumber());
+            int height = static_cast<int>(params["height"].asNumber());
+            if (width < 64 || height < 64 || width > 16384 || height > 16384) {
+                error = {RPC_INVALID_PARAMS, "width and height must be 64..16384"};
+                return {};
+            }
+            if (window) {
+                glfwSetWindowSize(window, width, height);
+            } else {
+                nullFramebufferWidth = width;
+                nullFramebufferHeight = height;
+            }
+            configChanged = true;
+            result.set("width", width).set("height", height);
+        } else if (method == "set_vsync") {
+            swapInterval = std::max(0, static_cast<int>(params["interval"].asNumber(params["enabled"].asBool() ? 1 : 0)));
+            if (vulkanRenderer.enabled()) {
+                vulkanRenderer.setVsync(swapInterval > 0);
+            } else if (window) {
+                glfwSwapInterval(swapInterval);
+            }
+            result.set("vsync", swapInterval);
+        } else if (method == "quit") {
+            closeRequested = true;
+        } else {
+            error = {RPC_METHOD_NOT_FOUND, "unknown method " + method};
+        }
+        return result;
+    };
+
+    ControlServer controlServer;
+    if (options.control) {
+        std::string controlPath = options.controlPath.empty() ? defaultControlPath() : options.controlPath;
+        std::string error;
+        if (controlServer.start(controlPath, error)) {
+            std::cout << "Управляющий сокет: " << controlPath << std::endl;
+        } else {
+            std::cerr << "Failed to open control socket " << controlPath << ": " << error << std::endl;
+        }
+    }
+
+    // В режиме агента сценарий и момент старта задает координатор
+    FleetAgent fleetAgent;
+    if (!options.agentAddress.empty()) {
+        char hostname[256] = {};
+        gethostname(hostname, sizeof(hostname) - 1);
+        std::string error;
+        if (!fleetAgent.connect(options.agentAddress, error)
+            || !fleetAgent.sendHello(hostname, gpuName, driverInfo, cpuInfo)) {
+            std::cerr << "Failed to connect to coordinator " << options.agentAddress << ": " << error << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        std::cout << "Ждем старта от координатора " << options.agentAddress << std::endl;
+
+        FleetScenario scenario;
+        std::chrono::system_clock::time_point startAt;
+        auto keepWindowAlive = [&]() {
+            if (!window) {
+                return true;
+            }
+            glfwPollEvents();
+            return !glfwWindowShouldClose(window);
+        };
+        if (!fleetAgent.waitForStart(scenario, startAt, keepWindowAlive, error)) {
+            std::cerr << "Coordinator did not start the run: " << error << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        if (!parseWorkload(scenario.workload, workload)) {
+            std::cerr << "Unknown workload from coordinator: " << scenario.workload << std::endl;
+        }
+        if (!backendSupportsWorkload(options.backend, workload)) {
+            std::cerr << "Нагрузка " << workloadName(workload) << " в " << backendName(options.backend)
+                      << " не реализована, рисуется threaded" << std::endl;
+            workload = Workload::Threaded;
+        }
+        cubeSize = std::clamp(scenario.cubeSize, 1, maxCubeSize(workload, options.backend));
+        options.warmupSec = scenario.warmupSec;
+        options.durationSec = scenario.durationSec;
+
+        while (std::chrono::system_clock::now() < startAt && keepWindowAlive()) {
+            auto remaining = startAt - std::chrono::system_clock::now();
+            std::this_thread::sleep_for(std::min<std::chrono::system_clock::duration>(remaining, std::chrono::milliseconds(20)));
+        }
+        startTime = std::chrono::steady_clock::now();
+        lastFPSUpdateTime = startTime;
+        previousFrameTime = startTime;
+        std::cout << "Старт: " << workloadName(workload) << ", " << options.durationSec << " с" << std::endl;
+    }
+
+    if (workload == Workload::Baked) {
+        bakeCube(cubeSize, cullHidden, vertexFormat);
+    } else if (workload == Workload::Threaded) {
+        prepareTransforms();
+    }
+    printGeometry();
+
     // Главный цикл рендеринга
-    while (!glfwWindowShouldClose(window))
+    while (!closeRequested && !(window && glfwWindowShouldClose(window)))
     {
+        if (controlServer.isRunning()) {
+            controlServer.processPending(handleControl);
+        }
+
         // Измеряем FPS
         auto currentTime = std::chrono::steady_clock::now();
         nbFrames++;
+
+        FrameRecord frameRecord;
+        frameRecord.frameIndex = frameIndex;
+        frameRecord.cpuStartNs = toTraceNs(currentTime);
+        // Кадры записи потока команд идут после прогрева, до первой команды кадра
+        double secondsSinceStart = std::chrono::duration<double>(currentTime - startTime).count();
+        if (secondsSinceStart >= options.warmupSec) {
+            glCapture.startFrames();
+        }
+        gpuTimer.beginFrame(frameIndex);
+        hudStream.beginFrame();
+        instanceStream.beginFrame();
+
+        if (secondsSinceStart >= options.warmupSec) {
+            float frameMs = std::chrono::duration<float, std::milli>(currentTime - previousFrameTime).count();
+            frameTimes.add(frameMs);
+            frameHistogram.add(frameMs);
+        }
+        if (frameIndex > 0) {
+            double frameSeconds = std::chrono::duration<double>(currentTime - previousFrameTime).count();
+            telemetry.addFrameTime(frameSeconds);
+            secondFrameTimesMs.push_back(static_cast<float>(frameSeconds * 1000.0));
+            if (measurement.active) {
+                measurement.frameTimes.add(static_cast<float>(frameSeconds * 1000.0));
+                measurement.elapsedSec = std::chrono::duration<double>(currentTime - measurement.start).count();
+                if (measurement.durationSec > 0 && measurement.elapsedSec >= measurement.durationSec) {
+                    finishMeasurement();
+                }
+            }
+        }
+        previousFrameTime = currentTime;
+
+        if (options.durationSec > 0 && secondsSinceStart >= options.durationSec) {
+            closeRequested = true;
+        }
         
         auto timeSinceLastUpdate = std::chrono::duration_cast<std::chrono::duration<double>>(currentTime - lastFPSUpdateTime).count();
         
         if (timeSinceLastUpdate >= 1.0) { // Если пошла 1 секунда
             fps = static_cast<double>(nbFrames) / timeSinceLastUpdate;
+            transformMs = transformFrames > 0 ? transformSumNs / 1e6 / transformFrames : 0.0;
             
             if (fps > 0) {
                 if (isFirstValidMeasurement) {
@@ -825,7 +1587,15 @@ int main()
                 std::stringstream ss;
                 ss << "Rubik GPU Benchmark - FPS: " << std::fixed << std::setprecision(2) << fps
                    << " Avg FPS: " << std::fixed << std::setprecision(2) << fpsEstimate;
-                glfwSetWindowTitle(window, ss.str().c_str());
+                if (window) {
+                    glfwSetWindowTitle(window, ss.str().c_str());
+                }
+
+                // Обновляем занятую видеопамять
+                if (!nullBackend.active()) {
+                    pollVRAM(vramStatus);
+                    vramInfo = formatVRAM(vramStatus);
+                }
 
                 // Рассчитываем время от старта программы
                 auto elapsedSeconds = std::chrono::duration_cast<std::chrono::seconds>(currentTime - startTime).count();
@@ -833,10 +1603,76 @@ int main()
                 // Изменяем формат вывода в консоль, оставляем только информацию о FPS
                 std::cout << "Время: " << std::setw(4) << elapsedSeconds << "с | FPS: " 
                           << std::setw(7) << std::fixed << std::setprecision(2) << fps 
-                          << " | Среднее FPS: " << std::setw(7) << std::fixed << std::setprecision(2) << fpsEstimate 
-                          << std::endl;
+                          << " | Среднее FPS: " << std::setw(7) << std::fixed << std::setprecision(2) << fpsEstimate;
+                if (vramStatus.usedMB >= 0) {
+                    std::cout << " | VRAM: " << std::setw(6) << vramStatus.usedMB << " MB";
+                }
+                if (transformFrames > 0) {
+                    std::cout << " | Матрицы: " << std::setprecision(3) << transformMs << " мс";
+                }
+                std::cout << std::endl;
+            }
+
+            // Средние времена проходов GPU за секунду, 0 - нет данных
+            double gpuPassMs[GPU_PASS_COUNT] = {};
+            for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+                gpuPassMs[pass] = gpuPassFrames > 0 ? gpuPassSumNs[pass] / 1e6 / gpuPassFrames : 0.0;
+            }
+            gpuPassSumNs = {};
+            gpuPassFrames = 0;
+
+            if (metricsServer.isRunning()) {
+                telemetry.uptimeSec = secondsSinceStart;
+                telemetry.fps = fps;
+                telemetry.fpsEstimate = fpsEstimate;
+                telemetry.fpsErrorEstimate = fpsErrorEstimate;
+                std::copy(std::begin(gpuPassMs), std::end(gpuPassMs), telemetry.gpuPassMs);
+                telemetry.vramTotalMB = vramStatus.totalMB;
+                telemetry.vramUsedMB = vramStatus.usedMB;
+                GpuSensors sensors = readGpuSensors();
+                telemetry.gpuTemperatureC = sensors.temperatureC;
+                telemetry.gpuPowerW = sensors.powerW;
+                metricsServer.publish(telemetry);
+            }
+
+            // Перцентили времени кадра за секунду для внешних потребителей
+            double secondP50Ms = 0.0, secondP90Ms = 0.0, secondP99Ms = 0.0, secondMaxMs = 0.0;
+            if ((sharedMetricsWriter.isOpen() || fleetAgent.isConnected()) && !secondFrameTimesMs.empty()) {
+                secondMaxMs = *std::max_element(secondFrameTimesMs.begin(), secondFrameTimesMs.end());
+                secondP50Ms = percentileInPlace(secondFrameTimesMs, 50.0);
+                secondP90Ms = percentileInPlace(secondFrameTimesMs, 90.0);
+                secondP99Ms = percentileInPlace(secondFrameTimesMs, 99.0);
             }
 
+            if (fleetAgent.isConnected()) {
+                fleetAgent.sendSample(std::floor(secondsSinceStart), fps, fpsEstimate, secondP50Ms, secondP99Ms, telemetry.frames);
+            }
+
+            if (sharedMetricsWriter.isOpen()) {
+                ++sharedMetrics.updates;
+                sharedMetrics.frames = telemetry.frames;
+                sharedMetrics.framesLastSecond = secondFrameTimesMs.size();
+                sharedMetrics.uptimeSec = secondsSinceStart;
+                sharedMetrics.fps = fps;
+                sharedMetrics.fpsEstimate = fpsEstimate;
+                sharedMetrics.fpsErrorEstimate = fpsErrorEstimate;
+                sharedMetrics.frameTimeP50Ms = secondP50Ms;
+                sharedMetrics.frameTimeP90Ms = secondP90Ms;
+                sharedMetrics.frameTimeP99Ms = secondP99Ms;
+                sharedMetrics.frameTimeMaxMs = secondMaxMs;
+                sharedMetrics.cpuSubmitMs = phaseFrames > 0 ? submitSumNs / 1e6 / phaseFrames : 0.0;
+                sharedMetrics.swapMs = phaseFrames > 0 ? swapSumNs / 1e6 / phaseFrames : 0.0;
+                std::copy(std::begin(gpuPassMs), std::end(gpuPassMs), sharedMetrics.gpuPassMs);
+                sharedMetrics.vramUsedMB = vramStatus.usedMB;
+                sharedMetricsWriter.publish(sharedMetrics);
+            }
+            secondFrameTimesMs.clear();
+            transformSumNs = 0;
+            transformFrames = 0;
+            submitSumNs = 0;
+            swapSumNs = 0;
+            phaseFrames = 0;
+
             nbFrames = 0;
             lastFPSUpdateTime = currentTime;
         }
@@ -852,11 +1688,22 @@ int main()
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // Размер окна может смениться командой set_resolution
+        int framebufferWidth = WINDOW_WIDTH, framebufferHeight = WINDOW_HEIGHT;
+        getFramebufferSize(framebufferWidth, framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+        if (softRaster.enabled()) {
+            softRaster.beginFrame(framebufferWidth, framebufferHeight, packSoftColor(0.2f, 0.3f, 0.3f));
+        }
+        if (vulkanRenderer.enabled()) {
+            vulkanRenderer.beginFrame(frameIndex, framebufferWidth, framebufferHeight, glm::vec3(0.2f, 0.3f, 0.3f));
+        }
+
         // Активация шейдерной прграммы
-        glUseProgram(shaderProgram);
+        glState.useProgram(shaderProgram);
 
-        // Обновление расстояния камеры
-        cameraDistance = 5.0f + 2.0f * sin(glfwGetTime() * zoomSpeed);
+        // Обновление расстояния камеры. Анимация идет от старта прогона, одинаково на всех бэкендах
+        cameraDistance = 5.0f + 2.0f * sin(secondsSinceStart * zoomSpeed);
         cameraDistance = glm::clamp(cameraDistance, minDistance, maxDistance);
 
         // Создае матриц преобразования
@@ -869,10 +1716,10 @@ int main()
             glm::vec3(0.0f, 0.0f, 0.0f),
             glm::vec3(0.0f, 1.0f, 0.0f)
         );
-        projection = glm::perspective(glm::radians(45.0f), static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT, 0.1f, 100.0f);
+        projection = glm::perspective(glm::radians(45.0f), static_cast<float>(framebufferWidth) / std::max(framebufferHeight, 1), 0.1f, 100.0f);
 
         // Вращение вего кубика Рубика
-        glm::mat4 rubiksCubeRotation = glm::rotate(glm::mat4(1.0f), (float)glfwGetTime(), glm::vec3(0.5f, 1.0f, 0.0f));
+        glm::mat4 rubiksCubeRotation = glm::rotate(glm::mat4(1.0f), (float)secondsSinceStart, glm::vec3(0.5f, 1.0f, 0.0f));
 
         // Передача матриц ида и проекции в шейдер
         unsigned int viewLoc = glGetUniformLocation(shaderProgram, "view");
@@ -886,37 +1733,175 @@ int main()
         }
 
         // Определение размеров и зазоров
-        float cubeSize = 0.3f;
-        float gap = 0.01f;
-        float totalSize = cubeSize + gap;
+        CubeLayout layout = cubeLayout(cubeSize);
+        unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
 
         // Отрисовка кубиков
-        glBindVertexArray(VAO);
-        for (int x = -1; x <= 1; x++) {
-            for (int y = -1; y <= 1; y++) {
-                for (int z = -1; z <= 1; z++) {
-                    glm::mat4 model = glm::mat4(1.0f);
-                    model = rubiksCubeRotation * model; // Примеяем вращение ко всему кубику Рубика
-                    model = glm::translate(model, glm::vec3(x * totalSize, y * totalSize, z * totalSize));
-                    model = glm::scale(model, glm::vec3(cubeSize, cubeSize, cubeSize));
-
-                    unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
-                    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-                    glDrawArrays(GL_TRIANGLES, 0, 36);
+        gpuTimer.begin(GPU_PASS_CUBE);
+        glCalls.beginPass(GPU_PASS_CUBE);
+        if (workload != Workload::Clear) {
+            pipelineStats.begin();
+        }
+        if (cullHidden) {
+            glState.enable(GL_CULL_FACE);
+        }
+        if (workload == Workload::Cube) {
+            loadUnitCube(vertexFormat);
+            glState.bindVertexArray(VAO);
+            for (int x = 0; x < cubeSize; x++) {
+                for (int y = 0; y < cubeSize; y++) {
+                    for (int z = 0; z < cubeSize; z++) {
+                        unsigned faces = cullHidden ? visibleCubeFaces(cubeSize, x, y, z) : ALL_CUBE_FACES;
+                        if (faces == 0) {
+                            continue;
+                        }
+
+                        glm::mat4 model = glm::mat4(1.0f);
+                        model = rubiksCubeRotation * model; // Примеяем вращение ко всему кубику Рубика
+                        model = glm::translate(model, layout.offset(x, y, z));
+                        model = glm::scale(model, glm::vec3(layout.cubieSize));
+
+                        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+
+                        if (faces == ALL_CUBE_FACES) {
+                            if (unitIndexType) {
+                                glDrawElements(GL_TRIANGLES, CUBE_VERTEX_COUNT, unitIndexType, nullptr);
+                            } else {
+                                glDrawArrays(GL_TRIANGLES, 0, CUBE_VERTEX_COUNT);
+                            }
+                            continue;
+                        }
+                        // Только наружные грани, одним вызовом
+                        GLint firsts[CUBE_FACE_COUNT];
+                        const void* offsets[CUBE_FACE_COUNT];
+                        GLsizei counts[CUBE_FACE_COUNT];
+                        GLsizei ranges = 0;
+                        for (int face = 0; face < CUBE_FACE_COUNT; face++) {
+                            if (faces & (1u << face)) {
+                                firsts[ranges] = face * CUBE_FACE_VERTICES;
+                                offsets[ranges] = reinterpret_cast<const void*>(face * CUBE_FACE_VERTICES * sizeof(uint16_t));
+                                counts[ranges] = CUBE_FACE_VERTICES;
+                                ranges++;
+                            }
+                        }
+                        if (glesContext.active() && !glesContext.multiDraw()) {
+                            for (GLsizei range = 0; range < ranges; range++) {
+                                if (unitIndexType) {
+                                    glDrawElements(GL_TRIANGLES, counts[range], unitIndexType, offsets[range]);
+                                } else {
+                                    glDrawArrays(GL_TRIANGLES, firsts[range], counts[range]);
+                                }
+                            }
+                        } else if (unitIndexType) {
+                            glMultiDrawElements(GL_TRIANGLES, counts, unitIndexType, offsets, ranges);
+                        } else {
+                            glMultiDrawArrays(GL_TRIANGLES, firsts, counts, ranges);
+                        }
+                    }
+                }
+            }
+        } else if (workload == Workload::Baked) {
+            bakeCube(cubeSize, cullHidden, vertexFormat);
+            glState.bindVertexArray(bakedVAO);
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(rubiksCubeRotation));
+            if (bakedIndexType) {
+                glDrawElements(GL_TRIANGLES, bakedCount, bakedIndexType, nullptr);
+            } else {
+                glDrawArrays(GL_TRIANGLES, 0, bakedCount);
+            }
+        } else if (workload == Workload::Instanced) {
+            // Постоянная работа CPU на кадр при любом размере кубика
+            loadUnitCube(vertexFormat);
+            glState.useProgram(instancedShaderProgram);
+            glUniformMatrix4fv(glGetUniformLocation(instancedShaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(instancedShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(glGetUniformLocation(instancedShaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(rubiksCubeRotation));
+            glUniform1i(glGetUniformLocation(instancedShaderProgram, "cubeSize"), cubeSize);
+            glUniform1f(glGetUniformLocation(instancedShaderProgram, "cubieSize"), layout.cubieSize);
+            glUniform1f(glGetUniformLocation(instancedShaderProgram, "spacing"), layout.totalSize);
+            glUniform1i(glGetUniformLocation(instancedShaderProgram, "cullHidden"), cullHidden);
+            glUniform1i(glGetUniformLocation(instancedShaderProgram, "faceVertices"), unitIndexType ? CUBE_FACE_CORNERS : CUBE_FACE_VERTICES);
+            glState.bindVertexArray(VAO);
+            GLsizei instances = cubeSize * cubeSize * cubeSize;
+            if (unitIndexType) {
+                glDrawElementsInstanced(GL_TRIANGLES, CUBE_VERTEX_COUNT, unitIndexType, nullptr, instances);
+            } else {
+                glDrawArraysInstanced(GL_TRIANGLES, 0, CUBE_VERTEX_COUNT, instances);
+            }
+        } else if (workload == Workload::Threaded) {
+            loadUnitCube(vertexFormat);
+            prepareTransforms();
+            GLsizei instances = static_cast<GLsizei>(transformOffsets.size());
+            size_t instanceBytes = transformOffsets.size() * CUBIE_TRANSFORM_FLOATS * sizeof(float);
+
+            // Регион кадра не используется GPU (fence или новое хранилище), поэтому
+            // потоки считают матрицы параллельно с отрисовкой прошлых кадров
+            auto transformStart = std::chrono::steady_clock::now();
+            if (instanceBytes > instanceStream.frameSize()) {
+                instanceStream.init(instanceBytes);
+                instanceStream.beginFrame();
+            }
+            size_t instanceOffset = 0;
+            auto* instanceData = static_cast<float*>(instanceStream.map(instanceBytes, 64, instanceOffset));
+            if (instanceData) {
+                jobSystem->parallelFor(transformOffsets.size(), TRANSFORM_CHUNK, [&](size_t begin, size_t end) {
+                    writeCubieTransforms(rubiksCubeRotation, layout.cubieSize, transformOffsets.data() + begin, end - begin,
+                                         instanceData + begin * CUBIE_TRANSFORM_FLOATS);
+                });
+                instanceStream.unmap();
+                if (glDsa.enabled()) {
+                    glVertexArrayVertexBuffer(transformVAO, 1, instanceStream.buffer(), instanceOffset,
+                                              CUBIE_TRANSFORM_FLOATS * sizeof(float));
+                } else {
+                    glState.bindVertexArray(transformVAO);
+                    glState.bindBuffer(GL_ARRAY_BUFFER, instanceStream.buffer());
+                    for (int column = 0; column < 4; column++) {
+                        glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, CUBIE_TRANSFORM_FLOATS * sizeof(float),
+                                              (void*)(instanceOffset + column * 4 * sizeof(float)));
+                    }
+                    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
                 }
+            } else {
+                instances = 0;
             }
+            transformSumNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - transformStart).count();
+            ++transformFrames;
+
+            glState.useProgram(transformShaderProgram);
+            glUniformMatrix4fv(glGetUniformLocation(transformShaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(transformShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glState.bindVertexArray(transformVAO);
+            if (unitIndexType) {
+                glDrawElementsInstanced(GL_TRIANGLES, CUBE_VERTEX_COUNT, unitIndexType, nullptr, instances);
+            } else {
+                glDrawArraysInstanced(GL_TRIANGLES, 0, CUBE_VERTEX_COUNT, instances);
+            }
+        }
+        if (softRaster.enabled() && workload != Workload::Clear) {
+            softDrawCube(projection * view, rubiksCubeRotation, cubeSize, cullHidden);
+        }
+        if (vulkanRenderer.enabled() && workload != Workload::Clear) {
+            vulkanRenderer.drawCube(projection * view, rubiksCubeRotation, cubeSize, cullHidden);
         }
+        glState.disable(GL_CULL_FACE);
+
+        pipelineStats.end();
+        gpuTimer.end();
+
+        glCalls.endPass();
 
         // Отрисовка графика
-        glDisable(GL_DEPTH_TEST);
-        glUseProgram(lineShaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(lineShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(glm::ortho(0.0f, 800.0f, 0.0f, 800.0f)));
+        gpuTimer.begin(GPU_PASS_GRAPH);
+        glCalls.beginPass(GPU_PASS_GRAPH);
+        glState.disable(GL_DEPTH_TEST);
+        glState.useProgram(lineShaderProgram);
+        glUniformMatrix4fv(glGetUniformLocation(lineShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(HUD_PROJECTION));
 
-        glBindVertexArray(lineVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+        glState.bindVertexArray(lineVAO);
 
-        glPointSize(2.0f); // Увеличиваем размер точек для лучшей видимости
+        if (!glesContext.active()) {
+            glPointSize(2.0f); // Увеличиваем размер точек для лучшей видимости
+        }
 
         // Рисуем рамку графика
         glUniform3f(glGetUniformLocation(lineShaderProgram, "color"), 1.0f, 1.0f, 1.0f); // Белый цвет
@@ -926,8 +1911,14 @@ int main()
             GRAPH_LEFT + GRAPH_WIDTH, GRAPH_BOTTOM + GRAPH_HEIGHT, GRAPH_LEFT, GRAPH_BOTTOM + GRAPH_HEIGHT,
             GRAPH_LEFT, GRAPH_BOTTOM + GRAPH_HEIGHT, GRAPH_LEFT, GRAPH_BOTTOM
         };
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(frameVertices), frameVertices);
-        glDrawArrays(GL_LINES, 0, 8);
+        constexpr size_t GRAPH_VERTEX_SIZE = 2 * sizeof(float);
+        size_t frameOffset = hudStream.upload(frameVertices, sizeof(frameVertices), GRAPH_VERTEX_SIZE);
+        if (frameOffset != SIZE_MAX) {
+            glDrawArrays(GL_LINES, frameOffset / GRAPH_VERTEX_SIZE, 8);
+        }
+        if (softRaster.enabled() || vulkanRenderer.enabled()) {
+            drawGraphRects(frameVertices, 8, GL_LINES, glm::vec3(1.0f, 1.0f, 1.0f));
+        }
 
         // Рисем текущи FPS (красные токи)
         glUniform3f(glGetUniformLocation(lineShaderProgram, "color"), 1.0f, 0.0f, 0.0f); // Красный цвет
@@ -942,8 +1933,13 @@ int main()
             }
         }
         if (!pointVertices.empty()) {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, pointVertices.size() * sizeof(float), pointVertices.data());
-            glDrawArrays(GL_POINTS, 0, pointVertices.size() / 2);
+            size_t pointOffset = hudStream.upload(pointVertices.data(), pointVertices.size() * sizeof(float), GRAPH_VERTEX_SIZE);
+            if (pointOffset != SIZE_MAX) {
+                glDrawArrays(GL_POINTS, pointOffset / GRAPH_VERTEX_SIZE, pointVertices.size() / 2);
+            }
+        }
+        if (softRaster.enabled() || vulkanRenderer.enabled()) {
+            drawGraphRects(pointVertices.data(), pointVertices.size() / 2, GL_POINTS, glm::vec3(1.0f, 0.0f, 0.0f));
         }
 
         // Рисуем средний FPS (зеленые точки)
@@ -959,15 +1955,22 @@ int main()
             }
         }
         if (!pointVertices.empty()) {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, pointVertices.size() * sizeof(float), pointVertices.data());
-            glDrawArrays(GL_POINTS, 0, pointVertices.size() / 2);
+            size_t pointOffset = hudStream.upload(pointVertices.data(), pointVertices.size() * sizeof(float), GRAPH_VERTEX_SIZE);
+            if (pointOffset != SIZE_MAX) {
+                glDrawArrays(GL_POINTS, pointOffset / GRAPH_VERTEX_SIZE, pointVertices.size() / 2);
+            }
         }
-
-        glBindVertexArray(0);
+        if (softRaster.enabled() || vulkanRenderer.enabled()) {
+            drawGraphRects(pointVertices.data(), pointVertices.size() / 2, GL_POINTS, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        gpuTimer.end();
+        glCalls.endPass();
 
         // Рендеринг текста
-        glUseProgram(textShaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(textShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(glm::ortho(0.0f, 800.0f, 0.0f, 800.0f)));
+        gpuTimer.begin(GPU_PASS_TEXT);
+        glCalls.beginPass(GPU_PASS_TEXT);
+        glState.useProgram(textShaderProgram);
+        glUniformMatrix4fv(glGetUniformLocation(textShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(HUD_PROJECTION));
 
         float textScale = TEXT_SCALE;
         float textX = 10.0f; // Отступ слева
@@ -992,6 +1995,53 @@ int main()
 
         // Рендеринг информации о мониторе
         renderText(monitorInfo, textX, textY, textScale, glm::vec3(0.7f, 0.7f, 0.7f)); // Светло-серый цвет
+        textY -= lineSpacing;
+
+        // Смены состояния GL за прошлый кадр: отправленные и пропущенные кэшем
+        std::string stateText = "GL state: " + std::to_string(glState.lastFrame().issued) + " issued, "
+                              + std::to_string(glState.lastFrame().skipped) + (glState.enabled() ? " skipped" : " redundant")
+                              + (glDsa.enabled() ? ", DSA" : "");
+        renderText(stateText, textX, textY, textScale, glm::vec3(0.7f, 0.7f, 0.7f));
+
+        // Сообщения отладочного вывода GL с начала прогона
+        if (glDebug.mode() == GlContextMode::Debug) {
+            textY -= lineSpacing;
+            std::string debugText = "GL debug: " + std::to_string(glDebug.totalMessages()) + " messages, "
+                                  + std::to_string(glDebug.messagesOfType(GlDebug::TYPE_ERROR)) + " errors, "
+                                  + std::to_string(glDebug.messagesOfType(GlDebug::TYPE_PERFORMANCE)) + " performance";
+            renderText(debugText, textX, textY, textScale, glm::vec3(0.7f, 0.7f, 0.7f));
+        }
+
+        // Программный растеризатор за прошлый кадр
+        if (softRaster.enabled()) {
+            std::ostringstream rasterText;
+            rasterText << "Soft raster: " << softRaster.lastFrame().triangles << " tris, " << std::fixed << std::setprecision(2)
+                       << softRaster.lastFrame().rasterNs / 1e6 << " ms";
+            textY -= lineSpacing;
+            renderText(rasterText.str(), textX, textY, textScale, glm::vec3(0.7f, 0.7f, 0.7f));
+        }
+        if (vulkanRenderer.enabled()) {
+            textY -= lineSpacing;
+            renderText("Vulkan: cube in " + std::to_string(vulkanRenderer.cubeCommandBuffers()) + " secondary command buffers",
+                       textX, textY, textScale, glm::vec3(0.7f, 0.7f, 0.7f));
+        }
+
+        // Вызовы GL за прошлый кадр по проходам
+        if (glCalls.enabled()) {
+            auto renderCallsRow = [&](const std::string& name, const GlCallCounts& counts) {
+                std::ostringstream row;
+                row << name << ": " << counts.totalCalls() << " calls, " << counts.calls[GL_CALL_DRAW] << " draws, "
+                    << std::fixed << std::setprecision(1) << counts.bytes / 1024.0 << " KB";
+                textY -= lineSpacing;
+                renderText(row.str(), textX, textY, textScale, glm::vec3(0.8f, 0.8f, 0.5f));
+            };
+            GlCallCounts frameCalls;
+            for (int pass = 0; pass < GL_CALL_PASS_COUNT; ++pass) {
+                renderCallsRow(glCallPassName(pass), glCalls.lastFrame()[pass]);
+                frameCalls += glCalls.lastFrame()[pass];
+            }
+            renderCallsRow("GL frame", frameCalls);
+        }
 
         // Рендеринг FPS и AVG FPS рядом с графиком
         fpsStream.str("");
@@ -1016,19 +2066,108 @@ int main()
         float versionTextWidth = getTextWidth(versionText, textScale);
         renderText(versionText, WINDOW_WIDTH - versionTextWidth - 10, 10, textScale, glm::vec3(1.0f, 1.0f, 1.0f)); // Белый цвет
 
-        glEnable(GL_DEPTH_TEST);
+        gpuTimer.end();
+
+        glCalls.endPass();
+
+        glState.enable(GL_DEPTH_TEST);
+
+        // Регионы кольцевых буферов освобождаются, когда GPU дойдет до этой точки
+        hudStream.endFrame();
+        instanceStream.endFrame();
+        glState.endFrame();
+        glCalls.endFrame();
+        if (glCapture.endFrame()) {
+            std::string captureError;
+            if (glCapture.save(options.capturePath, captureError)) {
+                std::cout << "Записано кадров команд GL: " << glCapture.frames() << " в " << options.capturePath << " ("
+                          << std::fixed << std::setprecision(1) << glCapture.size() / (1024.0 * 1024.0) << " MB)" << std::endl;
+            } else {
+                std::cerr << "Не удалось сохранить запись команд GL: " << captureError << std::endl;
+            }
+        }
 
         // Обмен буферов и обрабтка событий GLFW
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        frameRecord.submitNs = toTraceNs(std::chrono::steady_clock::now());
+        if (window && !nullBackend.active()) {
+            glesContext.endFrame();
+            glfwSwapBuffers(window);
+        }
+        // Программный растеризатор рисует кадр на месте обмена буферов, Vulkan
+        // здесь отправляет команды и показывает кадр
+        if (softRaster.enabled()) {
+            softRaster.endFrame();
+        }
+        if (vulkanRenderer.enabled()) {
+            vulkanRenderer.endFrame();
+        }
+        frameRecord.swapEndNs = toTraceNs(std::chrono::steady_clock::now());
+        startup.firstFrame();
+
+        submitSumNs += frameRecord.submitNs - frameRecord.cpuStartNs;
+        swapSumNs += frameRecord.swapEndNs - frameRecord.submitNs;
+        ++phaseFrames;
+
+        if (traceWriter.isOpen()) {
+            traceWriter.addFrame(frameRecord);
+        }
+        uint64_t gpuFrameIndex;
+        GpuPassTimes gpuTimes;
+        auto collectGpu = [&]() {
+            return vulkanRenderer.enabled() ? vulkanRenderer.collect(gpuFrameIndex, gpuTimes)
+                                            : gpuTimer.collect(gpuFrameIndex, gpuTimes);
+        };
+        while (collectGpu()) {
+            if (traceWriter.isOpen()) {
+                traceWriter.resolveGpu(gpuFrameIndex, gpuTimes);
+            }
+            for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+                gpuPassSumNs[pass] += gpuTimes[pass];
+            }
+            ++gpuPassFrames;
+        }
+        pipelineStats.collect();
+        ++frameIndex;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+
+    controlServer.stop();
+    metricsServer.stop();
+    sharedMetricsWriter.close();
+    traceWriter.close();
+    if (gpuTimer.disjointEvents() > 0) {
+        std::cout << "Время GPU: " << gpuTimer.disjointEvents()
+                  << " раз GL_GPU_DISJOINT_EXT, замеры кадров в полете отброшены" << std::endl;
     }
+    gpuTimer.destroy();
+    pipelineStats.destroy();
 
     // Выводим сглаженное значение FPS в консоль перед завершением программы
     // Очистка ресурсов
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteVertexArrays(1, &bakedVAO);
+    glDeleteBuffers(1, &bakedVBO);
+    glDeleteBuffers(1, &bakedEBO);
+    glDeleteVertexArrays(1, &transformVAO);
+    instanceStream.destroy();
+    hudStream.destroy();
     glDeleteProgram(shaderProgram);
+    glDeleteProgram(instancedShaderProgram);
+    glDeleteProgram(transformShaderProgram);
 
+    // Настоящий размер кадра для отпечатка, пока окно еще есть: его могли
+    // растянуть или сменить командой set_resolution
+    int framebufferWidth = WINDOW_WIDTH, framebufferHeight = WINDOW_HEIGHT;
+    getFramebufferSize(framebufferWidth, framebufferHeight);
+
+    std::string vulkanDevice = vulkanRenderer.deviceName();
+    int vulkanCubeBuffers = vulkanRenderer.cubeCommandBuffers();
+    vulkanRenderer.destroy();
     glfwTerminate();
 
     // После выхода из главного цикла
@@ -1038,7 +2177,168 @@ int main()
     std::cout << "Минимальное FPS: " << std::fixed << std::setprecision(2) << minFps << std::endl;
     std::cout << "Максимальное FPS: " << std::fixed << std::setprecision(2) << maxFps << std::endl;
     std::cout << "Среднее FPS: " << std::fixed << std::setprecision(2) << fpsEstimate << std::endl;
+    if (softRaster.enabled()) {
+        double frames = static_cast<double>(std::max<uint64_t>(softRaster.frames(), 1));
+        std::cout << "Бэкенд soft: FPS программного растеризатора на " << jobSystem->threadCount() << " потоках, "
+                  << std::setprecision(0) << softRaster.total().triangles / frames << " треугольников за кадр, растеризация "
+                  << std::setprecision(2) << softRaster.total().rasterNs / frames / 1e6 << " мс" << std::endl;
+        if (!options.softFramePath.empty()) {
+            std::string frameError;
+            if (softRaster.saveFrame(options.softFramePath, frameError)) {
+                std::cout << "Последний кадр сохранен: " << options.softFramePath << std::endl;
+            } else {
+                std::cerr << "Не удалось сохранить кадр: " << frameError << std::endl;
+            }
+        }
+    } else if (options.backend == Backend::Vulkan) {
+        std::cout << "Бэкенд vulkan: " << vulkanDevice << ", кубик в " << vulkanCubeBuffers
+                  << " вторичных буферах команд на " << jobSystem->threadCount() << " потоках" << std::endl;
+    } else if (nullBackend.active()) {
+        std::cout << "Бэкенд null: FPS - чистая стоимость кадра на CPU, GPU и драйвер не участвуют" << std::endl;
+    }
+    if (workload != Workload::Clear) {
+        // Оценка по последней нагрузке и среднему FPS
+        CubeGeometryStats geometry = cubeGeometryStats(cubeSize, cullHidden, workload, vertexFormat);
+        std::cout << "Выборка вершин (" << vertexFormatName(vertexFormat) << ", оценка модели): "
+                  << geometry.vertexBytes * fpsEstimate / (1024 * 1024) << " MB/с вершин, "
+                  << geometry.indexBytes * fpsEstimate / (1024 * 1024) << " MB/с индексов, кэш вершин FIFO "
+                  << geometry.cacheHitRate * 100.0 << "%" << std::endl;
+        if (pipelineStats.frames() > 0) {
+            // Прочитано вершин по числу запусков шейдера, которое посчитал драйвер
+            double frames = static_cast<double>(pipelineStats.frames());
+            double invocations = pipelineStats.shaderInvocations() / frames;
+            std::cout << "Вершины за кадр (ARB_pipeline_statistics_query, " << pipelineStats.frames()
+                      << " кадров): отправлено " << static_cast<uint64_t>(pipelineStats.verticesSubmitted() / frames)
+                      << ", запусков вершинного шейдера " << static_cast<uint64_t>(invocations)
+                      << ", переиспользовано " << pipelineStats.reuseRate() * 100.0 << "%, "
+                      << invocations * vertexStride(vertexFormat) * fpsEstimate / (1024 * 1024) << " MB/с вершин"
+                      << std::endl;
+        }
+    }
+    if (glState.frames() > 0) {
+        double frames = static_cast<double>(glState.frames());
+        std::cout << "Смены состояния GL за кадр: " << glState.total().issued / frames << " отправлено, "
+                  << glState.total().skipped / frames << (glState.enabled() ? " пропущено кэшем" : " избыточных")
+                  << (glDsa.enabled() ? ", путь DSA" : ", путь с привязками") << std::endl;
+    }
+    if (glDebug.mode() == GlContextMode::Debug) {
+        std::cout << "Отладочный вывод GL: " << glDebug.totalMessages() << " сообщений (";
+        for (int severity = 0; severity < GlDebug::SEVERITY_COUNT; ++severity) {
+            std::cout << (severity ? ", " : "") << GlDebug::severityName(severity) << " " << glDebug.messages(severity);
+        }
+        std::cout << "; ";
+        for (int type = 0; type < GlDebug::TYPE_COUNT; ++type) {
+            std::cout << (type ? ", " : "") << GlDebug::typeName(type) << " " << glDebug.messagesOfType(type);
+        }
+        std::cout << ")" << std::endl;
+    }
+
+    BenchmarkResults results;
+    results.version = programVersion;
+    results.gpu = gpuName;
+    results.driver = driverInfo;
+    results.startupMs = startup.firstFrameMs();
+    if (!nullBackend.active()) {
+        results.glContext = glContextModeName(glDebug.mode());
+    }
+    results.cpu = cpuInfo;
+    results.monitor = monitorInfo;
+    results.workload = workloadName(workload);
+    results.cubeSize = cubeSize;
+    results.cull = cullHidden;
+    results.vertexFormat = vertexFormatName(vertexFormat);
+    results.backend = backendName(options.backend);
+    results.dsa = glDsa.enabled();
+    results.resolution = std::to_string(framebufferWidth) + "x" + std::to_string(framebufferHeight);
+    results.configChanged = configChanged;
+    results.durationSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    results.minFps = minFps;
+    results.maxFps = maxFps;
+    results.avgFps = fpsEstimate;
+    results.frames = frameTimes.seen();
+    results.frameTimesMs = frameTimes.release();
+    results.histogram = frameHistogram;
+    if (glCalls.frames() > 0) {
+        double frames = static_cast<double>(glCalls.frames());
+        std::cout << "Вызовы GL за кадр:" << std::endl;
+        for (int pass = 0; pass < GL_CALL_PASS_COUNT; ++pass) {
+            const GlCallCounts& counts = glCalls.total()[pass];
+            std::string passName = glCallPassName(pass);
+            std::cout << "  " << std::left << std::setw(6) << passName << std::right << std::setprecision(1);
+            for (int kind = 0; kind < GL_CALL_KIND_COUNT; ++kind) {
+                double perFrame = counts.calls[kind] / frames;
+                results.glCalls[passName + "." + glCallKindName(kind)] = perFrame;
+                std::cout << " " << glCallKindName(kind) << " " << perFrame;
+            }
+            results.glCalls[passName + ".bytes"] = counts.bytes / frames;
+            std::cout << " | " << counts.bytes / frames / 1024.0 << " KB" << std::endl;
+        }
+    }
+
+    if (!results.frameTimesMs.empty()) {
+        std::cout << "Время кадра P50/P99: " << std::setprecision(3) << percentile(results.frameTimesMs, 50.0)
+                  << " / " << percentile(results.frameTimesMs, 99.0) << " мс" << std::endl;
+    }
+
+    if (fleetAgent.isConnected()) {
+        double totalMs = frameTimes.totalMs();
+        fleetAgent.sendDone(results.histogram, totalMs > 0 ? 1000.0 * results.frames / totalMs : 0.0);
+        fleetAgent.close();
+    }
+
+    if (!options.savePath.empty()) {
+        if (saveResults(options.savePath, results)) {
+            std::cout << "Результаты сохранены: " << options.savePath << std::endl;
+        } else {
+            std::cerr << "Не удалось сохранить результаты в " << options.savePath << std::endl;
+        }
+    }
+
+    if (!options.noDatabase && !results.frameTimesMs.empty()) {
+        HardwareFingerprint fingerprint;
+        fingerprint.gpu = gpuName;
+        fingerprint.cpu = cpuInfo;
+        fingerprint.driver = driverInfo;
+        fingerprint.kernel = getKernelVersion();
+        fingerprint.resolution = results.resolution;
+
+        std::string dbError;
+        int64_t runId = storeRun(databasePath, fingerprint, results, dbError);
+        if (runId >= 0) {
+            std::cout << "Прогон #" << runId << " записан в " << databasePath
+                      << " (отпечаток " << fingerprint.id() << ")" << std::endl;
+        } else {
+            std::cerr << "Не удалось записать прогон в базу: " << dbError << std::endl;
+        }
+    }
+
+    if (!options.baselinePath.empty()) {
+        if (results.frameTimesMs.empty()) {
+            std::cerr << "Нет кадров для сравнения с базовым прогоном" << std::endl;
+            return -1;
+        }
+        // Разные сцены сравниваются с предупреждением; регрессия все равно дает
+        // код 2, чтобы проверка в CI не проходила молча
+        std::vector<std::string> differences = configurationDifferences(baseline, results);
+        if (!differences.empty()) {
+            std::cerr << "\nПредупреждение: конфигурация отличается от базового прогона, сравниваются разные сцены:"
+                      << std::endl;
+            for (const std::string& difference : differences) {
+                std::cerr << "  " << difference << std::endl;
+            }
+        }
+        Comparison comparison = compareResults(baseline, results, options.alpha, options.thresholdPercent);
+        printComparison(comparison, options.alpha);
+        printGlCallsComparison(baseline, results);
+        printGlContextComparison(baseline, results, comparison);
+        printStartupComparison(baseline, results);
+        if (comparison.verdict == Verdict::Regressed) {
+            if (!differences.empty()) {
+                std::cerr << "Регрессия при другой конфигурации, проверьте различия выше" << std::endl;
+            }
+            return 2;
+        }
+    }
 
     return 0;
 }
-
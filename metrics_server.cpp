@@ -0,0 +1,234 @@
+#include "metrics_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+constexpr int POLL_INTERVAL_MS = 200;
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+std::string escapeLabel(const std::string& value) {
+    std::string result;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+void metricHeader(std::ostringstream& out, const char* name, const char* type, const char* help,
+                  const char* unit = nullptr) {
+    out << "# TYPE " << name << " " << type << "\n";
+    if (unit) {
+        out << "# UNIT " << name << " " << unit << "\n";
+    }
+    out << "# HELP " << name << " " << help << "\n";
+}
+
+} // namespace
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::setInfo(const std::string& gpu, const std::string& driver, const std::string& version) {
+    gpu_ = gpu;
+    driver_ = driver;
+    version_ = version;
+}
+
+bool MetricsServer::start(const std::string& bindAddress, int port, std::string& error) {
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, bindAddress.c_str(), &address.sin_addr) != 1) {
+        error = "invalid bind address " + bindAddress;
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listenFd_, 16) < 0) {
+        error = std::strerror(errno);
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    stop_ = false;
+    thread_ = std::thread(&MetricsServer::serveLoop, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (listenFd_ < 0) {
+        return;
+    }
+    stop_ = true;
+    thread_.join();
+    close(listenFd_);
+    listenFd_ = -1;
+}
+
+void MetricsServer::serveLoop() {
+    while (!stop_) {
+        pollfd pfd {listenFd_, POLLIN, 0};
+        if (poll(&pfd, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+        int clientFd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            continue;
+        }
+        handleClient(clientFd);
+        close(clientFd);
+    }
+}
+
+void MetricsServer::handleClient(int clientFd) {
+    // Медленный клиент не должен держать поток дольше секунды
+    timeval timeout {1, 0};
+    setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE) {
+        ssize_t n = recv(clientFd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    line >> method >> target;
+    target = target.substr(0, target.find('?'));
+
+    std::string status = "200 OK";
+    std::string contentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+    std::string body;
+    if (method != "GET" && method != "HEAD") {
+        status = "405 Method Not Allowed";
+        contentType = "text/plain";
+        body = "Method not allowed\n";
+    } else if (target == "/metrics") {
+        body = renderMetrics();
+    } else {
+        status = "404 Not Found";
+        contentType = "text/plain";
+        body = "Use /metrics\n";
+    }
+
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << "\r\n"
+             << "Content-Type: " << contentType << "\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n";
+    if (method != "HEAD") {
+        response << body;
+    }
+    sendAll(clientFd, response.str());
+}
+
+std::string MetricsServer::renderMetrics() const {
+    TelemetrySnapshot s;
+    bool fresh = snapshot_.load(s);
+
+    std::ostringstream out;
+    out << std::setprecision(9);
+
+    metricHeader(out, "rgbench", "info", "Benchmark and GPU description");
+    out << "rgbench_info{gpu=\"" << escapeLabel(gpu_) << "\",driver=\"" << escapeLabel(driver_)
+        << "\",version=\"" << escapeLabel(version_) << "\"} 1\n";
+
+    metricHeader(out, "rgbench_up", "gauge", "1 if a consistent snapshot was read");
+    out << "rgbench_up " << (fresh ? 1 : 0) << "\n";
+
+    metricHeader(out, "rgbench_uptime_seconds", "gauge", "Time since benchmark start", "seconds");
+    out << "rgbench_uptime_seconds " << s.uptimeSec << "\n";
+
+    metricHeader(out, "rgbench_fps", "gauge", "Frames per second over the last second");
+    out << "rgbench_fps " << s.fps << "\n";
+
+    metricHeader(out, "rgbench_fps_estimate", "gauge", "Kalman filtered FPS estimate");
+    out << "rgbench_fps_estimate " << s.fpsEstimate << "\n";
+
+    metricHeader(out, "rgbench_fps_estimate_variance", "gauge", "Kalman filter error estimate");
+    out << "rgbench_fps_estimate_variance " << s.fpsErrorEstimate << "\n";
+
+    metricHeader(out, "rgbench_frames", "counter", "Frames rendered since start");
+    out << "rgbench_frames_total " << s.frames << "\n";
+
+    metricHeader(out, "rgbench_frame_time_seconds", "histogram", "Frame time distribution", "seconds");
+    uint64_t cumulative = 0;
+    for (int i = 0; i < TELEMETRY_FRAME_BUCKET_COUNT; ++i) {
+        cumulative += s.frameTimeBuckets[i];
+        out << "rgbench_frame_time_seconds_bucket{le=\"" << TELEMETRY_FRAME_BUCKETS[i] << "\"} " << cumulative << "\n";
+    }
+    cumulative += s.frameTimeBuckets[TELEMETRY_FRAME_BUCKET_COUNT];
+    out << "rgbench_frame_time_seconds_bucket{le=\"+Inf\"} " << cumulative << "\n"
+        << "rgbench_frame_time_seconds_sum " << s.frameTimeSumSec << "\n"
+        << "rgbench_frame_time_seconds_count " << cumulative << "\n";
+
+    metricHeader(out, "rgbench_gpu_pass_seconds", "gauge", "Average GPU time per pass over the last second", "seconds");
+    for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+        out << "rgbench_gpu_pass_seconds{pass=\"" << gpuPassName(pass) << "\"} " << s.gpuPassMs[pass] / 1000.0 << "\n";
+    }
+
+    if (s.vramTotalMB >= 0) {
+        metricHeader(out, "rgbench_vram_total_bytes", "gauge", "Total video memory", "bytes");
+        out << "rgbench_vram_total_bytes " << s.vramTotalMB * 1024 * 1024 << "\n";
+    }
+    if (s.vramUsedMB >= 0) {
+        metricHeader(out, "rgbench_vram_used_bytes", "gauge", "Used video memory", "bytes");
+        out << "rgbench_vram_used_bytes " << s.vramUsedMB * 1024 * 1024 << "\n";
+    }
+    if (s.gpuTemperatureC >= 0) {
+        metricHeader(out, "rgbench_gpu_temperature_celsius", "gauge", "GPU temperature", "celsius");
+        out << "rgbench_gpu_temperature_celsius " << s.gpuTemperatureC << "\n";
+    }
+    if (s.gpuPowerW >= 0) {
+        metricHeader(out, "rgbench_gpu_power_watts", "gauge", "GPU power draw", "watts");
+        out << "rgbench_gpu_power_watts " << s.gpuPowerW << "\n";
+    }
+
+    out << "# EOF\n";
+    return out.str();
+}
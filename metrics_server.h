@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "telemetry.h"
+
+// Встроенный HTTP сервер метрик в формате OpenMetrics (GET /metrics).
+// Работает в своем потоке и читает снимки без блокировок, поэтому
+// опрос Prometheus не задерживает кадры
+class MetricsServer {
+public:
+    ~MetricsServer();
+
+    // Статические метки rgbench_info, задаются до start()
+    void setInfo(const std::string& gpu, const std::string& driver, const std::string& version);
+
+    bool start(const std::string& bindAddress, int port, std::string& error);
+    void stop();
+
+    // Вызывается потоком рендеринга
+    void publish(const TelemetrySnapshot& snapshot) { snapshot_.store(snapshot); }
+
+    [[nodiscard]] bool isRunning() const { return listenFd_ >= 0; }
+
+private:
+    void serveLoop();
+    void handleClient(int clientFd);
+    [[nodiscard]] std::string renderMetrics() const;
+
+    Seqlock<TelemetrySnapshot> snapshot_;
+    std::string gpu_;
+    std::string driver_;
+    std::string version_;
+
+    int listenFd_ = -1;
+    std::atomic<bool> stop_ {false};
+    std::thread thread_;
+};
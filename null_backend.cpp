@@ -0,0 +1,10 @@
+#include "null_backend.h"
+
+NullBackend nullBackend;
+
+void* NullBackend::map(size_t size) {
+    if (scratch_.size() < size) {
+        scratch_.resize(size);
+    }
+    return scratch_.data();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Пустой бэкенд отрисовки (--backend null): окно и контекст GL не создаются,
+// вызовы проходят через слой перехвата (подсчет, запись, кэш состояния), но до
+// драйвера не доходят. Кадр целиком - матрицы, история FPS, раскладка текста,
+// статистика - считается на CPU, и FPS показывает чистую стоимость приложения
+class NullBackend {
+public:
+    void enable() { active_ = true; }
+    [[nodiscard]] bool active() const { return active_; }
+
+    // Имена объектов выдаются по порядку, как у драйвера
+    unsigned newName() { return ++lastName_; }
+    // Память вместо отображенного буфера: данные пишутся и отбрасываются
+    void* map(size_t size);
+
+private:
+    bool active_ = false;
+    unsigned lastName_ = 0;
+    std::vector<uint8_t> scratch_;
+};
+
+extern NullBackend nullBackend;
@@ -0,0 +1,411 @@
+#include "options.h"
+
+#include <iostream>
+
+#include "results_db.h"
+
+namespace {
+
+bool parseDouble(const std::string& text, double& value) {
+    try {
+        size_t pos = 0;
+        value = std::stod(text, &pos);
+        return pos == text.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace
+
+const char* workloadName(Workload workload) {
+    switch (workload) {
+        case Workload::Cube: return "cube";
+        case Workload::Baked: return "baked";
+        case Workload::Instanced: return "instanced";
+        case Workload::Threaded: return "threaded";
+        case Workload::Clear: return "clear";
+    }
+    return "unknown";
+}
+
+bool parseWorkload(const std::string& name, Workload& workload) {
+    for (Workload candidate : {Workload::Cube, Workload::Baked, Workload::Instanced, Workload::Threaded, Workload::Clear}) {
+        if (name == workloadName(candidate)) {
+            workload = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool backendSupportsWorkload(Backend backend, Workload workload) {
+    return backend != Backend::Vulkan || workload == Workload::Threaded || workload == Workload::Clear;
+}
+
+bool backendSupportsVertexFormat(Backend backend, VertexFormat format) {
+    return backend != Backend::Vulkan || format == VertexFormat::Float;
+}
+
+int maxCubeSize(Workload workload, Backend backend) {
+    if (backend == Backend::Soft) {
+        return 64;
+    }
+    if (backend == Backend::Vulkan) {
+        return 128;
+    }
+    switch (workload) {
+        case Workload::Cube: return 64;
+        case Workload::Baked: return 100;
+        case Workload::Threaded: return 128;
+        case Workload::Instanced: return MAX_CUBE_SIZE;
+        case Workload::Clear: return MAX_CUBE_SIZE;
+    }
+    return 64;
+}
+
+const char* vertexFormatName(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Float: return "float";
+        case VertexFormat::Indexed: return "indexed";
+        case VertexFormat::Packed: return "packed";
+    }
+    return "unknown";
+}
+
+bool parseVertexFormat(const std::string& name, VertexFormat& format) {
+    for (VertexFormat candidate : {VertexFormat::Float, VertexFormat::Indexed, VertexFormat::Packed}) {
+        if (name == vertexFormatName(candidate)) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* backendName(Backend backend) {
+    switch (backend) {
+        case Backend::GL: return "gl";
+        case Backend::Null: return "null";
+        case Backend::Soft: return "soft";
+        case Backend::Vulkan: return "vulkan";
+        case Backend::GLES: return "gles";
+    }
+    return "unknown";
+}
+
+bool parseBackend(const std::string& name, Backend& backend) {
+    for (Backend candidate : {Backend::GL, Backend::Null, Backend::Soft, Backend::Vulkan, Backend::GLES}) {
+        if (name == backendName(candidate)) {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* glContextModeName(GlContextMode mode) {
+    switch (mode) {
+        case GlContextMode::Default: return "default";
+        case GlContextMode::Debug: return "debug";
+        case GlContextMode::NoError: return "no-error";
+    }
+    return "unknown";
+}
+
+bool parseGlContextMode(const std::string& name, GlContextMode& mode) {
+    for (GlContextMode candidate : {GlContextMode::Default, GlContextMode::Debug, GlContextMode::NoError}) {
+        if (name == glContextModeName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* glDebugSeverityName(GlDebugSeverity severity) {
+    switch (severity) {
+        case GlDebugSeverity::High: return "high";
+        case GlDebugSeverity::Medium: return "medium";
+        case GlDebugSeverity::Low: return "low";
+        case GlDebugSeverity::Notification: return "notification";
+    }
+    return "unknown";
+}
+
+bool parseGlDebugSeverity(const std::string& name, GlDebugSeverity& severity) {
+    for (GlDebugSeverity candidate : {GlDebugSeverity::High, GlDebugSeverity::Medium, GlDebugSeverity::Low,
+                                      GlDebugSeverity::Notification}) {
+        if (name == glDebugSeverityName(candidate)) {
+            severity = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options, std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            options.showHelp = true;
+            continue;
+        }
+        if (arg == "--no-db") {
+            options.noDatabase = true;
+            continue;
+        }
+        if (arg == "--shm") {
+            options.sharedMemory = true;
+            continue;
+        }
+        if (arg == "--cull") {
+            options.cullHidden = true;
+            continue;
+        }
+        if (arg == "--no-state-cache") {
+            options.stateCache = false;
+            continue;
+        }
+        if (arg == "--no-dsa") {
+            options.dsa = false;
+            continue;
+        }
+        if (arg == "--serial-startup") {
+            options.parallelStartup = false;
+            continue;
+        }
+        if (arg == "--gl-calls") {
+            options.glCalls = true;
+            continue;
+        }
+        if (arg == "--once") {
+            options.once = true;
+            continue;
+        }
+        if (arg == "--control") {
+            options.control = true;
+            continue;
+        }
+
+        // Позиционные аргументы: первый - подкоманда, остальные - её аргументы
+        if (arg.empty() || arg[0] != '-') {
+            if (options.command.empty()) {
+                options.command = arg;
+            } else {
+                options.commandArgs.push_back(arg);
+            }
+            continue;
+        }
+
+        // Все остальные параметры требуют значение
+        if (i + 1 >= argc) {
+            error = "missing value for " + arg;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--duration") {
+            if (!parseDouble(value, options.durationSec) || options.durationSec < 0) {
+                error = "invalid duration: " + value;
+                return false;
+            }
+        } else if (arg == "--warmup") {
+            if (!parseDouble(value, options.warmupSec) || options.warmupSec < 0) {
+                error = "invalid warmup: " + value;
+                return false;
+            }
+        } else if (arg == "--save") {
+            options.savePath = value;
+        } else if (arg == "--baseline") {
+            options.baselinePath = value;
+        } else if (arg == "--alpha") {
+            if (!parseDouble(value, options.alpha) || options.alpha <= 0 || options.alpha >= 1) {
+                error = "invalid alpha: " + value;
+                return false;
+            }
+        } else if (arg == "--threshold") {
+            if (!parseDouble(value, options.thresholdPercent) || options.thresholdPercent < 0) {
+                error = "invalid threshold: " + value;
+                return false;
+            }
+        } else if (arg == "--db") {
+            options.databasePath = value;
+        } else if (arg == "--fingerprint") {
+            options.fingerprint = value;
+        } else if (arg == "--since") {
+            if (!parseAge(value, options.sinceSeconds)) {
+                error = "invalid age: " + value + " (expected e.g. 30d, 12h, 2w)";
+                return false;
+            }
+        } else if (arg == "--limit") {
+            double limit = 0;
+            if (!parseDouble(value, limit) || limit < 1) {
+                error = "invalid limit: " + value;
+                return false;
+            }
+            options.limit = static_cast<int>(limit);
+        } else if (arg == "--trace") {
+            options.tracePath = value;
+        } else if (arg == "--assets") {
+            options.assetsPath = value;
+        } else if (arg == "--capture") {
+            options.capturePath = value;
+        } else if (arg == "--capture-frames") {
+            double frames = 0;
+            if (!parseDouble(value, frames) || frames < 1 || frames > 1000000 || frames != static_cast<int>(frames)) {
+                error = "invalid capture frames: " + value;
+                return false;
+            }
+            options.captureFrames = static_cast<int>(frames);
+        } else if (arg == "--window") {
+            if (!parseDouble(value, options.traceWindowSec) || options.traceWindowSec <= 0) {
+                error = "invalid window: " + value;
+                return false;
+            }
+        } else if (arg == "--metrics-port") {
+            double port = 0;
+            if (!parseDouble(value, port) || port < 0 || port > 65535 || port != static_cast<int>(port)) {
+                error = "invalid metrics port: " + value;
+                return false;
+            }
+            options.metricsPort = static_cast<int>(port);
+        } else if (arg == "--metrics-bind") {
+            options.metricsBind = value;
+        } else if (arg == "--workload") {
+            if (!parseWorkload(value, options.workload)) {
+                error = "unknown workload: " + value;
+                return false;
+            }
+        } else if (arg == "--cube-size") {
+            double size = 0;
+            if (!parseDouble(value, size) || size < 1 || size > MAX_CUBE_SIZE) {
+                error = "invalid cube size: " + value;
+                return false;
+            }
+            options.cubeSize = static_cast<int>(size);
+        } else if (arg == "--threads") {
+            double threads = 0;
+            if (!parseDouble(value, threads) || threads < 0 || threads > 1024) {
+                error = "invalid thread count: " + value;
+                return false;
+            }
+            options.transformThreads = static_cast<int>(threads);
+        } else if (arg == "--vertex-format") {
+            if (!parseVertexFormat(value, options.vertexFormat)) {
+                error = "unknown vertex format: " + value;
+                return false;
+            }
+        } else if (arg == "--backend") {
+            if (!parseBackend(value, options.backend)) {
+                error = "unknown backend: " + value;
+                return false;
+            }
+        } else if (arg == "--gl-context") {
+            if (!parseGlContextMode(value, options.glContext)) {
+                error = "unknown GL context mode: " + value;
+                return false;
+            }
+        } else if (arg == "--gl-debug-severity") {
+            if (!parseGlDebugSeverity(value, options.glDebugSeverity)) {
+                error = "unknown debug severity: " + value;
+                return false;
+            }
+        } else if (arg == "--soft-frame") {
+            options.softFramePath = value;
+        } else if (arg == "--agent") {
+            options.agentAddress = value;
+        } else if (arg == "--listen") {
+            options.listenAddress = value;
+        } else if (arg == "--agents") {
+            double agents = 0;
+            if (!parseDouble(value, agents) || agents < 1) {
+                error = "invalid agent count: " + value;
+                return false;
+            }
+            options.agents = static_cast<int>(agents);
+        } else if (arg == "--report") {
+            options.reportPath = value;
+        } else if (arg == "--control-socket") {
+            options.control = true;
+            options.controlPath = value;
+        } else {
+            error = "unknown option: " + arg;
+            return false;
+        }
+    }
+    // Предел размера - после разбора: --workload и --backend могут идти позже
+    if (options.cubeSize > maxCubeSize(options.workload, options.backend)) {
+        error = "cube size " + std::to_string(options.cubeSize) + " exceeds " +
+                std::to_string(maxCubeSize(options.workload, options.backend)) + " for workload " +
+                workloadName(options.workload) + " on backend " + backendName(options.backend);
+        return false;
+    }
+    // replay создает настольный контекст 3.3: шейдеры "#version 300 es" он не соберет
+    if (!options.capturePath.empty() && options.backend == Backend::GLES) {
+        error = "--capture is not supported with backend gles: replay runs on desktop GL";
+        return false;
+    }
+    return true;
+}
+
+void printUsage(const char* programName) {
+    std::cout << "Использование: " << programName << " [параметры]\n"
+              << "       " << programName << " db <history|best|worst|trend|fingerprints|show <N>> [параметры]\n"
+              << "       " << programName << " analyze <трасса> [--window <сек>]\n"
+              << "       " << programName << " monitor [pid] [--once]\n"
+              << "       " << programName << " coordinator --agents <N> [--listen <адрес:порт>] [--report <файл>]\n"
+              << "       " << programName << " ctl <метод> [параметры JSON] [--control-socket <путь>]\n"
+              << "       " << programName << " replay <запись> [--duration <сек>]\n"
+              << "  --duration <сек>     Длительность теста, 0 - до закрытия окна (по умолчанию 0)\n"
+              << "  --warmup <сек>       Прогрев, не учитываемый в результатах (по умолчанию 1)\n"
+              << "  --workload <имя>     Нагрузка: cube, baked, instanced, threaded или clear (по умолчанию cube)\n"
+              << "  --cube-size <N>      Размер кубика N x N x N (по умолчанию 3), до 64 для cube и\n"
+              << "                       soft, 100 для baked, 128 для threaded и vulkan, 256 для\n"
+              << "                       instanced\n"
+              << "  --cull               Не рисовать внутренние кубики и грани, включить GL_CULL_FACE\n"
+              << "  --vertex-format <ф>  Формат вершин: float, indexed или packed (по умолчанию float)\n"
+              << "  --threads <N>        Потоки расчета матриц для threaded, растеризации soft и записи\n"
+              << "                       команд vulkan (по умолчанию по числу ядер)\n"
+              << "  --no-state-cache     Отправлять в драйвер и избыточные смены состояния GL\n"
+              << "  --no-dsa             Менять буферы, VAO и текстуры через привязку (путь GL 3.3),\n"
+              << "                       даже если есть ARB_direct_state_access\n"
+              << "  --serial-startup     Запуск без потоков и параллельной сборки шейдеров\n"
+              << "  --assets <файл>      Набор ресурсов (шейдеры, глифы, иконка) вместо встроенного\n"
+              << "  --backend <имя>      Бэкенд отрисовки: gl, null - без GPU, только работа CPU, soft -\n"
+              << "                       программный растеризатор на потоках CPU, vulkan или gles -\n"
+              << "                       OpenGL ES 3.x через EGL (по умолчанию gl)\n"
+              << "  --soft-frame <файл>  soft: сохранить последний кадр в PPM\n"
+              << "  --gl-context <режим> Проверка ошибок GL: default, debug - сообщения KHR_debug в\n"
+              << "                       обратный вызов, или no-error - контекст без проверок\n"
+              << "                       (KHR_no_error); по умолчанию default\n"
+              << "  --gl-debug-severity <у> debug: минимальная важность сообщений: high, medium, low\n"
+              << "                       или notification (по умолчанию low)\n"
+              << "  --gl-calls           Считать вызовы GL и переданные байты за кадр по проходам\n"
+              << "  --save <файл>        Сохранить результаты (время кадров) в файл\n"
+              << "  --baseline <файл>    Сравнить с сохраненными ранее результатами\n"
+              << "  --alpha <p>          Уровень значимости сравнения (по умолчанию 0.01)\n"
+              << "  --threshold <%>      Минимальное значимое изменение (по умолчанию 2)\n"
+              << "  --db <файл>          База результатов (по умолчанию ~/.local/share/rgbench/results.db)\n"
+              << "  --no-db              Не записывать прогон в базу\n"
+              << "  --fingerprint <id>   Отпечаток конфигурации для запросов, all - все (по умолчанию последний)\n"
+              << "  --since <возраст>    Только прогоны не старше, например 30d, 12h, 2w\n"
+              << "  --limit <N>          Число строк в history/best/worst (по умолчанию 20)\n"
+              << "  --trace <файл>       Записать покадровую бинарную трассу\n"
+              << "  --capture <файл>     Записать поток команд GL для rgbench replay\n"
+              << "  --capture-frames <N> Кадров в записи после прогрева (по умолчанию 300)\n"
+              << "  --window <сек>       Размер окна статистики в analyze (по умолчанию 60)\n"
+              << "  --metrics-port <N>   Отдавать метрики OpenMetrics на http://<адрес>:N/metrics\n"
+              << "  --metrics-bind <адр> Адрес сервера метрик (по умолчанию 127.0.0.1)\n"
+              << "  --shm                Публиковать живые метрики в /dev/shm/rgbench-<pid>\n"
+              << "  --once               monitor: вывести один снимок и выйти\n"
+              << "  --control            Принимать команды через Unix-сокет (JSON-RPC)\n"
+              << "  --control-socket <п> Путь управляющего сокета\n"
+              << "  --agent <хост:порт>  Работать агентом координатора, сценарий задает координатор\n"
+              << "  --listen <адр:порт>  coordinator: адрес для агентов (по умолчанию 0.0.0.0:7070)\n"
+              << "  --agents <N>         coordinator: число агентов (по умолчанию 1)\n"
+              << "  --report <файл>      coordinator: сохранить сводный отчет в JSON\n"
+              << "  -h, --help           Показать эту справку\n"
+              << "\nКод возврата 2 означает значимую регрессию относительно --baseline." << std::endl;
+}
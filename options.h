@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Нагрузка, которую рисует основной проход
+enum class Workload {
+    Cube,   // Кубик Рубика N x N x N, один вызов отрисовки на кубик
+    Baked,  // Все кубики в одном статическом буфере, один вызов отрисовки
+    Instanced, // Один инстансный вызов, положение кубика считает шейдер по gl_InstanceID
+    Threaded,  // Матрицы кубиков считают потоки CPU в буфер инстансов
+    Clear   // Только очистка и оверлей - накладные расходы кадра
+};
+
+[[nodiscard]] const char* workloadName(Workload workload);
+bool parseWorkload(const std::string& name, Workload& workload);
+
+// Формат вершин кубика
+enum class VertexFormat {
+    Float,    // 36 вершин без индексов: позиция и цвет во float, 24 байта
+    Indexed,  // 24 уникальные вершины того же формата и индексный буфер
+    Packed    // Индексы, позиция в half float, цвет RGBA8, 12 байт
+};
+
+[[nodiscard]] const char* vertexFormatName(VertexFormat format);
+bool parseVertexFormat(const std::string& name, VertexFormat& format);
+
+// Куда уходят команды отрисовки
+enum class Backend {
+    GL,    // OpenGL 3.3 в окне GLFW
+    Null,  // Без окна и контекста: вызовы GL отбрасываются, FPS - чистая работа CPU
+    Soft,  // Как Null, но сцену рисует программный растеризатор на потоках CPU
+    Vulkan, // Та же сцена через Vulkan, вызовы GL отбрасываются как у Null
+    GLES    // OpenGL ES 3.x через EGL, для плат ARM
+};
+
+[[nodiscard]] const char* backendName(Backend backend);
+bool parseBackend(const std::string& name, Backend& backend);
+
+// Проверка ошибок в контексте GL
+enum class GlContextMode {
+    Default,  // Драйвер проверяет каждый вызов, ошибки только через glGetError
+    Debug,    // Отладочный контекст: сообщения KHR_debug в обратный вызов
+    NoError   // GLFW_CONTEXT_NO_ERROR (KHR_no_error): без проверок, ошибка - неопределенное поведение
+};
+
+[[nodiscard]] const char* glContextModeName(GlContextMode mode);
+bool parseGlContextMode(const std::string& name, GlContextMode& mode);
+
+// Минимальная важность сообщений отладочного вывода
+enum class GlDebugSeverity { High, Medium, Low, Notification };
+
+[[nodiscard]] const char* glDebugSeverityName(GlDebugSeverity severity);
+bool parseGlDebugSeverity(const std::string& name, GlDebugSeverity& severity);
+
+// Vulkan считает матрицы кубиков на CPU в буфер кадра и рисует их одним
+// инстансным проходом с вершинами float - это нагрузка threaded. Остальные
+// нагрузки и форматы вершин у него не реализованы
+[[nodiscard]] bool backendSupportsWorkload(Backend backend, Workload workload);
+[[nodiscard]] bool backendSupportsVertexFormat(Backend backend, VertexFormat format);
+
+// Кубиков по оси: MAX_CUBE_SIZE - потолок разбора, фактический предел
+// зависит от нагрузки и бэкенда (maxCubeSize)
+constexpr int MAX_CUBE_SIZE = 256;
+
+// Вызов на кубик (cube, soft) - до 64; матрица на кубик в буфере (threaded,
+// vulkan) - до 128, 128 МБ на кадр; baked - до 100, без --cull при float
+// ~860 МБ вершин; instanced ограничен только числом экземпляров
+[[nodiscard]] int maxCubeSize(Workload workload, Backend backend);
+
+// Параметры командной строки
+struct Options {
+    double durationSec = 0.0;      // 0 - до закрытия окна
+    double warmupSec = 1.0;        // Кадры прогрева не попадают в результаты
+    std::string savePath;          // Куда сохранить результаты прогона
+    std::string baselinePath;      // С чем сравнивать результаты
+    double alpha = 0.01;           // Уровень значимости для сравнения
+    double thresholdPercent = 2.0; // Минимальное значимое изменение, %
+    bool showHelp = false;
+
+    Workload workload = Workload::Cube;
+    int cubeSize = 3;              // Кубиков по каждой оси
+    bool cullHidden = false;       // Не рисовать внутренние кубики и грани, GL_CULL_FACE
+    VertexFormat vertexFormat = VertexFormat::Float;
+    int transformThreads = 0;      // Потоки для нагрузки threaded, 0 - по числу ядер
+    bool stateCache = true;        // Пропускать избыточные смены состояния GL
+    bool dsa = true;               // Direct State Access, если драйвер его поддерживает
+    bool parallelStartup = true;   // Глифы и /proc в потоках, параллельная сборка шейдеров
+    std::string assetsPath;        // Файл набора ресурсов, пусто - встроенный
+    GlContextMode glContext = GlContextMode::Default;
+    GlDebugSeverity glDebugSeverity = GlDebugSeverity::Low; // Для --gl-context debug
+    bool glCalls = false;          // Считать вызовы GL и байты по кадрам и проходам
+    std::string capturePath;       // Записать поток команд GL, пусто - не писать
+    int captureFrames = 300;       // Кадров в записи после прогрева
+    Backend backend = Backend::GL;
+    std::string softFramePath;     // Сохранить последний кадр программного растеризатора (PPM)
+
+    // Подкоманда (db ...) и её позиционные аргументы
+    std::string command;
+    std::vector<std::string> commandArgs;
+
+    // База результатов
+    std::string databasePath;      // Пусто - путь по умолчанию
+    bool noDatabase = false;       // Не записывать прогон в базу
+    std::string fingerprint;       // Фильтр запросов к базе
+    int64_t sinceSeconds = 0;
+    int limit = 20;
+
+    // Покадровая трасса
+    std::string tracePath;         // Куда писать трассу, пусто - не писать
+    double traceWindowSec = 60.0;  // Размер окна для analyze
+
+    // Экспорт метрик в формате OpenMetrics
+    int metricsPort = 0;           // 0 - сервер не запускается
+    std::string metricsBind = "127.0.0.1";
+    bool sharedMemory = false;     // Публиковать метрики в /dev/shm/rgbench-<pid>
+    bool once = false;             // monitor: один снимок и выход
+
+    // Управляющий сокет
+    bool control = false;
+    std::string controlPath;       // Пусто - путь по умолчанию
+
+    // Прогон на нескольких машинах
+    std::string agentAddress;      // host:port координатора, пусто - обычный режим
+    std::string listenAddress = "0.0.0.0:7070";
+    int agents = 1;                // coordinator: сколько агентов ждать
+    std::string reportPath;        // coordinator: JSON отчет
+};
+
+// Возвращает false при ошибке разбора, текст ошибки в error
+bool parseOptions(int argc, char* argv[], Options& options, std::string& error);
+
+void printUsage(const char* programName);
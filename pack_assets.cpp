@@ -0,0 +1,230 @@
+// Утилита сборки rgbench_pack_assets: растеризует шрифт в атлас, уменьшает
+// иконку и складывает их вместе с шейдерами GL в набор ресурсов
+// (asset_bundle.h). Пишет файл набора и его байты списком для встраивания.
+// Запускается CMake, вручную - для своего набора под --assets:
+//   rgbench_pack_assets <набор> <inc> --font <ttf> [--icon <png>] [--shader <файл>]...
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_bundle.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace {
+
+constexpr int FONT_PIXEL_SIZE = 48;
+constexpr uint32_t ATLAS_WIDTH = 512;
+constexpr uint32_t ATLAS_PADDING = 1; // Между глифами: линейная фильтрация не цепляет соседей
+constexpr int ICON_SIZE = 32;
+
+using Entry = std::pair<std::string, std::vector<uint8_t>>;
+
+template<typename T>
+void append(std::vector<uint8_t>& out, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Глифы ASCII раскладываются полками слева направо, высота атласа - по
+// последней полке
+bool packFont(const std::string& path, std::vector<Entry>& entries) {
+    FT_Library ft;
+    if (FT_Init_FreeType(&ft)) {
+        std::cerr << "Could not init FreeType Library" << std::endl;
+        return false;
+    }
+    FT_Face face;
+    if (FT_New_Face(ft, path.c_str(), 0, &face)) {
+        std::cerr << "Failed to load font " << path << std::endl;
+        FT_Done_FreeType(ft);
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, FONT_PIXEL_SIZE);
+
+    std::vector<AssetGlyph> glyphs(ASSET_GLYPH_COUNT);
+    std::vector<std::vector<uint8_t>> masks(ASSET_GLYPH_COUNT);
+    uint32_t x = 0, y = 0, shelfHeight = 0;
+    for (int c = 0; c < ASSET_GLYPH_COUNT; c++) {
+        AssetGlyph& glyph = glyphs[c];
+        glyph = {};
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+            std::cerr << "Failed to load glyph " << c << std::endl;
+            continue;
+        }
+        const FT_Bitmap& bitmap = face->glyph->bitmap;
+        glyph.width = static_cast<int32_t>(bitmap.width);
+        glyph.height = static_cast<int32_t>(bitmap.rows);
+        glyph.bearingX = face->glyph->bitmap_left;
+        glyph.bearingY = face->glyph->bitmap_top;
+        glyph.advance = static_cast<uint32_t>(face->glyph->advance.x);
+        glyph.loaded = 1;
+
+        if (x + bitmap.width > ATLAS_WIDTH) {
+            x = 0;
+            y += shelfHeight + ATLAS_PADDING;
+            shelfHeight = 0;
+        }
+        glyph.atlasX = x;
+        glyph.atlasY = y;
+        x += bitmap.width + ATLAS_PADDING;
+        shelfHeight = std::max(shelfHeight, bitmap.rows);
+
+        masks[c].resize(static_cast<size_t>(bitmap.width) * bitmap.rows);
+        for (unsigned int row = 0; row < bitmap.rows; row++) {
+            std::memcpy(masks[c].data() + row * bitmap.width, bitmap.buffer + row * bitmap.pitch, bitmap.width);
+        }
+    }
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+
+    AssetImageHeader atlas = {ATLAS_WIDTH, std::max(y + shelfHeight, 1u), 1, 0};
+    std::vector<uint8_t> atlasData;
+    append(atlasData, atlas);
+    atlasData.resize(sizeof(atlas) + static_cast<size_t>(atlas.width) * atlas.height, 0);
+    uint8_t* pixels = atlasData.data() + sizeof(atlas);
+    for (int c = 0; c < ASSET_GLYPH_COUNT; c++) {
+        const AssetGlyph& glyph = glyphs[c];
+        for (int32_t row = 0; row < glyph.height; row++) {
+            std::memcpy(pixels + (glyph.atlasY + row) * atlas.width + glyph.atlasX,
+                        masks[c].data() + static_cast<size_t>(row) * glyph.width, glyph.width);
+        }
+    }
+
+    std::vector<uint8_t> glyphData;
+    for (const AssetGlyph& glyph : glyphs) {
+        append(glyphData, glyph);
+    }
+    entries.emplace_back("font/glyphs", std::move(glyphData));
+    entries.emplace_back("font/atlas", std::move(atlasData));
+    std::cout << "Атлас глифов: " << atlas.width << "x" << atlas.height << std::endl;
+    return true;
+}
+
+// Иконка окна: вписывается в квадрат с прозрачным фоном, по центру
+bool packIcon(const std::string& path, std::vector<Entry>& entries) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        std::cerr << "Failed to load icon " << path << std::endl;
+        return false;
+    }
+
+    AssetImageHeader icon = {ICON_SIZE, ICON_SIZE, 4, 0};
+    std::vector<uint8_t> iconData;
+    append(iconData, icon);
+    iconData.resize(sizeof(icon) + ICON_SIZE * ICON_SIZE * 4, 0);
+    uint8_t* pixels = iconData.data() + sizeof(icon);
+
+    float scale = std::min((float)ICON_SIZE / width, (float)ICON_SIZE / height);
+    int newWidth = static_cast<int>(width * scale);
+    int newHeight = static_cast<int>(height * scale);
+    int offsetX = (ICON_SIZE - newWidth) / 2;
+    int offsetY = (ICON_SIZE - newHeight) / 2;
+    for (int y = 0; y < newHeight; ++y) {
+        for (int x = 0; x < newWidth; ++x) {
+            int srcIndex = (static_cast<int>(y / scale) * width + static_cast<int>(x / scale)) * 4;
+            int dstIndex = ((y + offsetY) * ICON_SIZE + (x + offsetX)) * 4;
+            std::memcpy(pixels + dstIndex, data + srcIndex, 4);
+        }
+    }
+    stbi_image_free(data);
+    entries.emplace_back("icon", std::move(iconData));
+    return true;
+}
+
+bool writeFile(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Использование: " << argv[0]
+                  << " <набор> <inc> --font <ttf> [--icon <png>] [--shader <файл>]..." << std::endl;
+        return 1;
+    }
+    std::string bundlePath = argv[1];
+    std::string includePath = argv[2];
+
+    std::vector<Entry> entries;
+    bool hasFont = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Не указано значение для " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--font") {
+            if (!packFont(value, entries)) {
+                return 1;
+            }
+            hasFont = true;
+        } else if (arg == "--icon") {
+            if (!packIcon(value, entries)) {
+                return 1;
+            }
+        } else if (arg == "--shader") {
+            // Имя записи - shaders/ и имя файла без каталога
+            std::vector<uint8_t> source;
+            if (!readFile(value, source)) {
+                std::cerr << "Failed to read shader " << value << std::endl;
+                return 1;
+            }
+            std::string name = "shaders/" + value.substr(value.find_last_of('/') + 1);
+            if (name.size() >= ASSET_NAME_SIZE) {
+                std::cerr << "Shader name is too long: " << name << std::endl;
+                return 1;
+            }
+            entries.emplace_back(name, std::move(source));
+        } else {
+            std::cerr << "Неизвестный параметр: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (!hasFont) {
+        std::cerr << "Не указан шрифт: --font <ttf>" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> blob = packAssetBundle(entries);
+    std::string bytes(blob.begin(), blob.end());
+    if (!writeFile(bundlePath, bytes)) {
+        std::cerr << "Failed to write " << bundlePath << std::endl;
+        return 1;
+    }
+
+    // Список байт для инициализатора массива, по 32 в строке
+    std::string list;
+    list.reserve(blob.size() * 4);
+    for (size_t i = 0; i < blob.size(); ++i) {
+        list += std::to_string(blob[i]);
+        list += (i % 32 == 31) ? ",\n" : ",";
+    }
+    list += "\n";
+    if (!writeFile(includePath, list)) {
+        std::cerr << "Failed to write " << includePath << std::endl;
+        return 1;
+    }
+    std::cout << "Набор ресурсов: " << entries.size() << " записей, " << blob.size() / 1024 << " KB" << std::endl;
+    return 0;
+}
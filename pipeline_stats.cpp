@@ -0,0 +1,86 @@
+#include "pipeline_stats.h"
+
+#include <GL/glew.h>
+
+#include "gles_context.h"
+#include "null_backend.h"
+
+#ifndef GL_VERTICES_SUBMITTED_ARB
+#define GL_VERTICES_SUBMITTED_ARB 0x82EE
+#endif
+#ifndef GL_VERTEX_SHADER_INVOCATIONS_ARB
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#endif
+
+void PipelineStats::init() {
+    if (initialized_ || nullBackend.active() || glesContext.active() ||
+        !(GLEW_VERSION_4_6 || GLEW_ARB_pipeline_statistics_query)) {
+        return;
+    }
+    glGenQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+    initialized_ = true;
+}
+
+void PipelineStats::destroy() {
+    if (!initialized_) {
+        return;
+    }
+    glDeleteQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+    initialized_ = false;
+}
+
+void PipelineStats::begin() {
+    if (!initialized_ || pending_) {
+        return;
+    }
+    glBeginQuery(GL_VERTICES_SUBMITTED_ARB, queries_[0]);
+    glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB, queries_[1]);
+    active_ = true;
+}
+
+void PipelineStats::end() {
+    if (!active_) {
+        return;
+    }
+    glEndQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB);
+    glEndQuery(GL_VERTICES_SUBMITTED_ARB);
+    active_ = false;
+    pending_ = true;
+}
+
+void PipelineStats::collect() {
+    if (!pending_) {
+        return;
+    }
+    // Запросы завершаются по порядку, достаточно проверить последний
+    GLint available = 0;
+    glGetQueryObjectiv(queries_[0], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return;
+    }
+    GLuint64 submitted = 0, invocations = 0;
+    glGetQueryObjectui64v(queries_[0], GL_QUERY_RESULT, &submitted);
+    glGetQueryObjectui64v(queries_[1], GL_QUERY_RESULT, &invocations);
+    pending_ = false;
+    if (discard_) {
+        discard_ = false;
+        return;
+    }
+    ++frames_;
+    verticesSubmitted_ += submitted;
+    shaderInvocations_ += invocations;
+}
+
+void PipelineStats::reset() {
+    frames_ = 0;
+    verticesSubmitted_ = 0;
+    shaderInvocations_ = 0;
+    discard_ = pending_ || active_;
+}
+
+double PipelineStats::reuseRate() const {
+    if (verticesSubmitted_ == 0) {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(shaderInvocations_) / static_cast<double>(verticesSubmitted_);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Счетчики конвейера GL_ARB_pipeline_statistics_query для прохода кубика:
+// сколько вершин отправлено и сколько раз запущен вершинный шейдер. Их
+// разница - переиспользование вершин кэшем после трансформации, измеренное
+// драйвером, а не модель FIFO из cube_mesh.h. В полете один замер: пока он не
+// прочитан, кадры не замеряются, поэтому ожидания GPU нет
+class PipelineStats {
+public:
+    // Настольный GL 4.6 или расширение; на ES, null и Vulkan замеров нет
+    void init();
+    void destroy();
+    [[nodiscard]] bool enabled() const { return initialized_; }
+
+    void begin();
+    void end();
+    // Забирает готовый замер, если он есть
+    void collect();
+    // Нагрузку сменили: сумма и замер в полете больше не относятся к ней
+    void reset();
+
+    [[nodiscard]] uint64_t frames() const { return frames_; }
+    [[nodiscard]] uint64_t verticesSubmitted() const { return verticesSubmitted_; }
+    [[nodiscard]] uint64_t shaderInvocations() const { return shaderInvocations_; }
+    // Доля отправленных вершин, не запустивших шейдер; 0 без замеров
+    [[nodiscard]] double reuseRate() const;
+
+private:
+    std::array<unsigned int, 2> queries_ {};  // Отправлено, запусков шейдера
+    bool initialized_ = false;
+    bool active_ = false;
+    bool pending_ = false;
+    bool discard_ = false;
+    uint64_t frames_ = 0;
+    uint64_t verticesSubmitted_ = 0;
+    uint64_t shaderInvocations_ = 0;
+};
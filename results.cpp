@@ -0,0 +1,321 @@
+#include "results.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+constexpr const char* RESULTS_HEADER = "# RGBench results 1";
+constexpr const char* GL_CALLS_PREFIX = "gl.";
+constexpr double TAIL_PERCENTILE = 90.0;
+
+double relativePercent(double diff, double base) {
+    return base > 0 ? diff / base * 100.0 : 0.0;
+}
+
+// Кадры не быстрее перцентиля p: хвост распределения для критерия по P99
+std::vector<float> upperTail(const std::vector<float>& values, double p) {
+    double threshold = percentile(values, p);
+    std::vector<float> tail;
+    for (float v : values) {
+        if (v >= threshold) {
+            tail.push_back(v);
+        }
+    }
+    return tail;
+}
+
+const char* effectSizeName(double cliffsDelta) {
+    double magnitude = std::fabs(cliffsDelta);
+    if (magnitude < 0.147) return "negligible";
+    if (magnitude < 0.33) return "small";
+    if (magnitude < 0.474) return "medium";
+    return "large";
+}
+
+} // namespace
+
+bool saveResults(const std::string& path, const BenchmarkResults& results) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    file << RESULTS_HEADER << "\n"
+         << "version=" << results.version << "\n"
+         << "gpu=" << results.gpu << "\n"
+         << "driver=" << results.driver << "\n"
+         << "cpu=" << results.cpu << "\n"
+         << "monitor=" << results.monitor << "\n"
+         << "gl_context=" << results.glContext << "\n"
+         << "workload=" << results.workload << "\n"
+         << "cube_size=" << results.cubeSize << "\n"
+         << "cull=" << results.cull << "\n"
+         << "vertex_format=" << results.vertexFormat << "\n"
+         << "backend=" << results.backend << "\n"
+         << "dsa=" << results.dsa << "\n"
+         << "resolution=" << results.resolution << "\n"
+         << "config_changed=" << results.configChanged << "\n"
+         << std::fixed << std::setprecision(3)
+         << "duration=" << results.durationSec << "\n"
+         << "min_fps=" << results.minFps << "\n"
+         << "max_fps=" << results.maxFps << "\n"
+         << "avg_fps=" << results.avgFps << "\n"
+         << "startup_ms=" << results.startupMs << "\n"
+         << "frames=" << results.frames << "\n";
+    for (const auto& [key, value] : results.glCalls) {
+        file << GL_CALLS_PREFIX << key << "=" << value << "\n";
+    }
+    file << "frame_times_ms=" << results.frameTimesMs.size() << "\n"
+         << std::setprecision(4);
+    for (float t : results.frameTimesMs) {
+        file << t << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool loadResults(const std::string& path, BenchmarkResults& results, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != RESULTS_HEADER) {
+        error = path + " is not a results file";
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+
+        try {
+            if (key == "version") results.version = value;
+            else if (key == "gpu") results.gpu = value;
+            else if (key == "driver") results.driver = value;
+            else if (key == "cpu") results.cpu = value;
+            else if (key == "monitor") results.monitor = value;
+            else if (key == "gl_context") results.glContext = value;
+            else if (key == "workload") results.workload = value;
+            else if (key == "cube_size") results.cubeSize = std::stoi(value);
+            else if (key == "cull") results.cull = value == "1";
+            else if (key == "vertex_format") results.vertexFormat = value;
+            else if (key == "backend") results.backend = value;
+            else if (key == "dsa") results.dsa = value == "1";
+            else if (key == "resolution") results.resolution = value;
+            else if (key == "config_changed") results.configChanged = value == "1";
+            else if (key == "duration") results.durationSec = std::stod(value);
+            else if (key == "min_fps") results.minFps = std::stod(value);
+            else if (key == "max_fps") results.maxFps = std::stod(value);
+            else if (key == "avg_fps") results.avgFps = std::stod(value);
+            else if (key == "startup_ms") results.startupMs = std::stod(value);
+            else if (key == "frames") results.frames = std::stoull(value);
+            else if (key.rfind(GL_CALLS_PREFIX, 0) == 0) results.glCalls[key.substr(3)] = std::stod(value);
+            else if (key == "frame_times_ms") {
+                size_t count = std::stoul(value);
+                results.frameTimesMs.clear();
+                results.frameTimesMs.reserve(count);
+                float t;
+                while (results.frameTimesMs.size() < count && file >> t) {
+                    results.frameTimesMs.push_back(t);
+                }
+                if (results.frameTimesMs.size() != count) {
+                    error = path + ": truncated frame times";
+                    return false;
+                }
+                break;
+            }
+        } catch (const std::exception&) {
+            error = path + ": bad value for " + key;
+            return false;
+        }
+    }
+
+    if (results.frameTimesMs.empty()) {
+        error = path + ": no frame times";
+        return false;
+    }
+    // Файлы до выборки: сохранены все кадры
+    if (results.frames < results.frameTimesMs.size()) {
+        results.frames = results.frameTimesMs.size();
+    }
+    return true;
+}
+
+Comparison compareResults(const BenchmarkResults& baseline, const BenchmarkResults& current,
+                          double alpha, double thresholdPercent) {
+    Comparison c;
+    const auto& a = baseline.frameTimesMs;
+    const auto& b = current.frameTimesMs;
+
+    c.baselineMedian = percentile(a, 50.0);
+    c.currentMedian = percentile(b, 50.0);
+    c.baselineP99 = percentile(a, 99.0);
+    c.currentP99 = percentile(b, 99.0);
+    c.mannWhitney = mannWhitneyU(a, b);
+    c.tailMannWhitney = mannWhitneyU(upperTail(a, TAIL_PERCENTILE), upperTail(b, TAIL_PERCENTILE));
+    c.medianDiff = bootstrapPercentileDiff(a, b, 50.0, 1.0 - alpha);
+    c.p99Diff = bootstrapPercentileDiff(a, b, 99.0, 1.0 - alpha);
+
+    // Время кадра: рост - это хуже
+    const double medianChange = relativePercent(c.medianDiff.estimate, c.baselineMedian);
+    const double p99Change = relativePercent(c.p99Diff.estimate, c.baselineP99);
+    const bool significant = c.mannWhitney.pValue < alpha;
+    const bool tailSignificant = c.tailMannWhitney.pValue < alpha;
+
+    const bool medianWorse = significant && c.medianDiff.low > 0 && medianChange > thresholdPercent;
+    const bool p99Worse = tailSignificant && c.p99Diff.low > 0 && p99Change > thresholdPercent;
+    const bool medianBetter = significant && c.medianDiff.high < 0 && medianChange < -thresholdPercent;
+    const bool p99Better = tailSignificant && c.p99Diff.high < 0 && p99Change < -thresholdPercent;
+
+    if (medianWorse || p99Worse) {
+        c.verdict = Verdict::Regressed;
+    } else if (medianBetter || p99Better) {
+        c.verdict = Verdict::Improved;
+    } else {
+        c.verdict = Verdict::Unchanged;
+    }
+    return c;
+}
+
+void printComparison(const Comparison& c, double alpha) {
+    auto printRow = [](const char* name, double base, double cur, const ConfidenceInterval& ci) {
+        std::cout << name << ":" << std::fixed << std::setprecision(3)
+                  << std::setw(10) << base << " -> " << std::setw(10) << cur << " мс"
+                  << " | разница " << std::showpos << ci.estimate << " ["
+                  << ci.low << ", " << ci.high << "]" << std::noshowpos
+                  << " (" << std::showpos << std::setprecision(2) << relativePercent(ci.estimate, base)
+                  << "%)" << std::noshowpos << std::endl;
+    };
+
+    std::cout << "\nСравнение с базовым прогоном (время кадра, доверие "
+              << std::fixed << std::setprecision(0) << (1.0 - alpha) * 100.0 << "%):" << std::endl;
+    printRow("Медиана", c.baselineMedian, c.currentMedian, c.medianDiff);
+    printRow("P99", c.baselineP99, c.currentP99, c.p99Diff);
+    std::cout << "Манн-Уитни: z = " << std::setprecision(3) << c.mannWhitney.z
+              << ", p = " << std::scientific << std::setprecision(3) << c.mannWhitney.pValue << std::fixed
+              << " | дельта Клиффа = " << std::showpos << std::setprecision(3) << c.mannWhitney.cliffsDelta
+              << std::noshowpos << " (" << effectSizeName(c.mannWhitney.cliffsDelta) << ")" << std::endl;
+    std::cout << "Хвост (кадры выше P90): z = " << std::setprecision(3) << c.tailMannWhitney.z
+              << ", p = " << std::scientific << std::setprecision(3) << c.tailMannWhitney.pValue << std::fixed
+              << " | дельта Клиффа = " << std::showpos << std::setprecision(3) << c.tailMannWhitney.cliffsDelta
+              << std::noshowpos << " (" << effectSizeName(c.tailMannWhitney.cliffsDelta) << ")" << std::endl;
+    std::cout << "Вердикт: " << verdictName(c.verdict) << std::endl;
+}
+
+void printGlCallsComparison(const BenchmarkResults& baseline, const BenchmarkResults& current) {
+    if (baseline.glCalls.empty() || current.glCalls.empty()) {
+        return;
+    }
+    std::cout << "\nВызовы GL за кадр (базовый -> текущий):" << std::endl;
+    int changed = 0;
+    for (const auto& [key, value] : current.glCalls) {
+        auto it = baseline.glCalls.find(key);
+        double base = it != baseline.glCalls.end() ? it->second : 0.0;
+        // Доли вызова - от кадров прогрева и смены нагрузки, это не изменение
+        if (std::fabs(value - base) < 0.5 && std::fabs(relativePercent(value - base, base)) < 1.0) {
+            continue;
+        }
+        std::cout << "  " << std::left << std::setw(16) << key << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << base << " -> " << std::setw(10) << value << std::endl;
+        ++changed;
+    }
+    if (changed == 0) {
+        std::cout << "  без изменений, отправка команд та же" << std::endl;
+    }
+}
+
+void printStartupComparison(const BenchmarkResults& baseline, const BenchmarkResults& current) {
+    if (baseline.startupMs <= 0 || current.startupMs <= 0) {
+        return;
+    }
+    std::cout << "\nВремя до первого кадра: " << std::fixed << std::setprecision(1) << baseline.startupMs << " -> "
+              << current.startupMs << " мс (" << std::showpos
+              << relativePercent(current.startupMs - baseline.startupMs, baseline.startupMs) << "%)" << std::noshowpos
+              << std::endl;
+}
+
+void printGlContextComparison(const BenchmarkResults& baseline, const BenchmarkResults& current,
+                              const Comparison& comparison) {
+    if (baseline.glContext.empty() || current.glContext.empty() || baseline.glContext == current.glContext
+        || comparison.baselineMedian <= 0 || comparison.currentMedian <= 0) {
+        return;
+    }
+    double baselineFps = 1000.0 / comparison.baselineMedian;
+    double currentFps = 1000.0 / comparison.currentMedian;
+    std::cout << "\nКонтекст GL: " << baseline.glContext << " -> " << current.glContext << ", FPS по медиане "
+              << std::fixed << std::setprecision(1) << baselineFps << " -> " << currentFps << " ("
+              << std::showpos << relativePercent(currentFps - baselineFps, baselineFps) << "%)" << std::noshowpos
+              << std::endl;
+
+    // Доля времени кадра с проверками, которую они и занимают
+    bool baselineUnchecked = baseline.glContext == "no-error";
+    if (!baselineUnchecked && current.glContext != "no-error") {
+        return;
+    }
+    double checkedMs = baselineUnchecked ? comparison.currentMedian : comparison.baselineMedian;
+    double uncheckedMs = baselineUnchecked ? comparison.baselineMedian : comparison.currentMedian;
+    std::cout << "Проверки в драйвере (" << (baselineUnchecked ? current.glContext : baseline.glContext) << "): "
+              << std::setprecision(3) << checkedMs - uncheckedMs << " мс на кадр, " << std::setprecision(1)
+              << relativePercent(checkedMs - uncheckedMs, checkedMs) << "% времени кадра"
+              << (comparison.verdict == Verdict::Unchanged ? " (в пределах шума)" : "") << std::endl;
+}
+
+const char* verdictName(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::Improved: return "improved";
+        case Verdict::Regressed: return "regressed";
+        default: return "unchanged";
+    }
+}
+
+std::string runConfiguration(const BenchmarkResults& results) {
+    if (results.workload.empty()) {
+        return "";
+    }
+    std::string config = results.workload + " " + std::to_string(results.cubeSize) + ", " + results.vertexFormat;
+    if (results.cull) {
+        config += ", cull";
+    }
+    config += ", " + results.backend;
+    if (results.dsa) {
+        config += ", dsa";
+    }
+    config += ", " + results.resolution;
+    if (results.configChanged) {
+        config += ", changed";
+    }
+    return config;
+}
+
+std::vector<std::string> configurationDifferences(const BenchmarkResults& baseline, const BenchmarkResults& current) {
+    std::vector<std::string> differences;
+    if (baseline.workload.empty()) {
+        differences.push_back("конфигурация базового прогона не записана");
+        return differences;
+    }
+    auto compare = [&differences](const char* name, const std::string& base, const std::string& cur) {
+        if (base != cur) {
+            differences.push_back(std::string(name) + ": " + base + " -> " + cur);
+        }
+    };
+    auto flag = [](bool value) { return std::string(value ? "да" : "нет"); };
+    compare("нагрузка", baseline.workload, current.workload);
+    compare("размер кубика", std::to_string(baseline.cubeSize), std::to_string(current.cubeSize));
+    compare("отсечение", flag(baseline.cull), flag(current.cull));
+    compare("формат вершин", baseline.vertexFormat, current.vertexFormat);
+    compare("бэкенд", baseline.backend, current.backend);
+    compare("DSA", flag(baseline.dsa), flag(current.dsa));
+    compare("размер кадра", baseline.resolution, current.resolution);
+    if (baseline.configChanged || current.configChanged) {
+        differences.push_back("конфигурация менялась во время прогона");
+    }
+    return differences;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "stats.h"
+
+// Результаты одного прогона
+struct BenchmarkResults {
+    std::string version;
+    std::string gpu;
+    std::string driver;
+    std::string cpu;
+    std::string monitor;
+    std::string glContext;              // Режим контекста GL (--gl-context), пусто - без GL
+    // Конфигурация сцены: время кадра сравнимо только при одинаковой
+    std::string workload;               // Пусто - файл версии без конфигурации
+    int cubeSize = 0;
+    bool cull = false;
+    std::string vertexFormat;
+    std::string backend;
+    bool dsa = false;
+    std::string resolution;             // Размер кадра в конце прогона
+    bool configChanged = false;         // Меняли во время прогона (set_workload, set_resolution)
+    double durationSec = 0.0;
+    double minFps = 0.0;
+    double maxFps = 0.0;
+    double avgFps = 0.0;                // Оценка фильтра Калмана
+    double startupMs = 0.0;             // От начала main() до первого кадра, 0 - нет данных
+    uint64_t frames = 0;                // Кадров после прогрева
+    std::vector<float> frameTimesMs;    // Равномерная выборка времени кадров после прогрева (FrameTimeReservoir)
+    FrameTimeHistogram histogram;       // Все кадры после прогрева, в файл не пишется
+    // Вызовы GL за кадр (--gl-calls): "проход.вид" -> среднее, пусто - не считались
+    std::map<std::string, double> glCalls;
+};
+
+// Текстовый формат: заголовок "ключ=значение", затем выборка времени кадров по одному в строке
+bool saveResults(const std::string& path, const BenchmarkResults& results);
+bool loadResults(const std::string& path, BenchmarkResults& results, std::string& error);
+
+enum class Verdict { Improved, Unchanged, Regressed };
+
+struct Comparison {
+    double baselineMedian = 0.0;
+    double currentMedian = 0.0;
+    double baselineP99 = 0.0;
+    double currentP99 = 0.0;
+    ConfidenceInterval medianDiff;  // мс, текущий - базовый
+    ConfidenceInterval p99Diff;
+    MannWhitneyResult mannWhitney;
+    MannWhitneyResult tailMannWhitney; // По кадрам не быстрее P90 каждого прогона
+    Verdict verdict = Verdict::Unchanged;
+};
+
+// Сравнение распределений времени кадра. Медиана и P99 проверяются одинаково:
+// критерий Манна-Уитни (для P99 - по хвостам выше P90) значим на уровне alpha,
+// бутстреп интервал разности не содержит нуля и изменение больше
+// thresholdPercent. Регрессия - так выросла медиана или P99, улучшение - так
+// уменьшилась медиана или P99 без регрессии другой
+[[nodiscard]] Comparison compareResults(const BenchmarkResults& baseline, const BenchmarkResults& current,
+                                        double alpha, double thresholdPercent);
+
+void printComparison(const Comparison& comparison, double alpha);
+
+// Изменения вызовов GL за кадр: показывает, поменялась ли наша отправка команд
+// или только скорость драйвера
+void printGlCallsComparison(const BenchmarkResults& baseline, const BenchmarkResults& current);
+
+// Время до первого кадра, если оно есть в обоих прогонах
+void printStartupComparison(const BenchmarkResults& baseline, const BenchmarkResults& current);
+
+// Разные режимы контекста GL: разница медиан FPS. Против no-error это цена
+// проверок вызовов в драйвере
+void printGlContextComparison(const BenchmarkResults& baseline, const BenchmarkResults& current,
+                              const Comparison& comparison);
+
+[[nodiscard]] const char* verdictName(Verdict verdict);
+
+// Конфигурация одной строкой, по ней группируются прогоны в базе. Пусто - не записана
+[[nodiscard]] std::string runConfiguration(const BenchmarkResults& results);
+
+// Различия конфигурации, "поле: базовый -> текущий". Пусто - прогоны сравнимы
+[[nodiscard]] std::vector<std::string> configurationDifferences(const BenchmarkResults& baseline,
+                                                                const BenchmarkResults& current);
@@ -0,0 +1,505 @@
+#include "results_db.h"
+
+#include <sqlite3.h>
+#include <openssl/md5.h>
+#include <sys/utsname.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr const char* SCHEMA = R"(
+    CREATE TABLE IF NOT EXISTS fingerprints (
+        id TEXT PRIMARY KEY,
+        gpu TEXT, cpu TEXT, driver TEXT, kernel TEXT, resolution TEXT
+    );
+    CREATE TABLE IF NOT EXISTS runs (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        fingerprint TEXT NOT NULL REFERENCES fingerprints(id),
+        timestamp INTEGER NOT NULL,
+        version TEXT,
+        duration REAL,
+        frames INTEGER,
+        min_fps REAL, max_fps REAL, avg_fps REAL,
+        p50_ms REAL, p99_ms REAL,
+        histogram BLOB,
+        config TEXT
+    );
+    CREATE INDEX IF NOT EXISTS runs_by_fingerprint ON runs(fingerprint, timestamp);
+    CREATE INDEX IF NOT EXISTS runs_by_time ON runs(timestamp);
+)";
+
+// Обертка над sqlite3*, закрывает базу в деструкторе
+class Database {
+public:
+    bool open(const std::string& path, bool create, std::string& error) {
+        int flags = SQLITE_OPEN_READWRITE | (create ? SQLITE_OPEN_CREATE : 0);
+        if (sqlite3_open_v2(path.c_str(), &db_, flags, nullptr) != SQLITE_OK) {
+            error = db_ ? sqlite3_errmsg(db_) : "cannot open " + path;
+            return false;
+        }
+        sqlite3_busy_timeout(db_, 2000);
+        if (!exec(SCHEMA, error)) {
+            return false;
+        }
+        // Столбец config появился позже: в старой базе его добавляем, у старых прогонов он NULL
+        if (sqlite3_exec(db_, "SELECT config FROM runs LIMIT 0", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return exec("ALTER TABLE runs ADD COLUMN config TEXT", error);
+        }
+        return true;
+    }
+
+    bool exec(const char* sql, std::string& error) {
+        char* message = nullptr;
+        if (sqlite3_exec(db_, sql, nullptr, nullptr, &message) != SQLITE_OK) {
+            error = message ? message : "sqlite error";
+            sqlite3_free(message);
+            return false;
+        }
+        return true;
+    }
+
+    sqlite3* handle() const { return db_; }
+
+    ~Database() {
+        if (db_) {
+            sqlite3_close(db_);
+        }
+    }
+
+private:
+    sqlite3* db_ = nullptr;
+};
+
+// Подготовленный запрос, параметры нумеруются с 1 как в sqlite
+class Statement {
+public:
+    Statement(const Database& db, const std::string& sql) {
+        if (sqlite3_prepare_v2(db.handle(), sql.c_str(), -1, &stmt_, nullptr) != SQLITE_OK) {
+            std::cerr << "SQL error: " << sqlite3_errmsg(db.handle()) << std::endl;
+            stmt_ = nullptr;
+        }
+    }
+    ~Statement() { sqlite3_finalize(stmt_); }
+
+    explicit operator bool() const { return stmt_ != nullptr; }
+
+    Statement& bind(int index, const std::string& value) {
+        sqlite3_bind_text(stmt_, index, value.c_str(), -1, SQLITE_TRANSIENT);
+        return *this;
+    }
+    Statement& bind(int index, double value) {
+        sqlite3_bind_double(stmt_, index, value);
+        return *this;
+    }
+    Statement& bind(int index, int64_t value) {
+        sqlite3_bind_int64(stmt_, index, value);
+        return *this;
+    }
+    Statement& bindBlob(int index, const std::vector<unsigned char>& data) {
+        sqlite3_bind_blob(stmt_, index, data.data(), static_cast<int>(data.size()), SQLITE_TRANSIENT);
+        return *this;
+    }
+
+    // true - есть очередная строка
+    bool step() { return stmt_ && sqlite3_step(stmt_) == SQLITE_ROW; }
+    bool run() { return stmt_ && sqlite3_step(stmt_) == SQLITE_DONE; }
+
+    std::string text(int column) const {
+        const unsigned char* value = sqlite3_column_text(stmt_, column);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+    double real(int column) const { return sqlite3_column_double(stmt_, column); }
+    int64_t integer(int column) const { return sqlite3_column_int64(stmt_, column); }
+    std::vector<unsigned char> blob(int column) const {
+        const auto* data = static_cast<const unsigned char*>(sqlite3_column_blob(stmt_, column));
+        int size = sqlite3_column_bytes(stmt_, column);
+        return data ? std::vector<unsigned char>(data, data + size) : std::vector<unsigned char>();
+    }
+
+private:
+    sqlite3_stmt* stmt_ = nullptr;
+};
+
+std::string formatTimestamp(int64_t timestamp) {
+    std::time_t t = static_cast<std::time_t>(timestamp);
+    std::tm tm {};
+    localtime_r(&t, &tm);
+    std::stringstream ss;
+    ss << std::put_time(&tm, "%Y-%m-%d %H:%M");
+    return ss.str();
+}
+
+// Находит полный идентификатор отпечатка по префиксу. "all" - пустая строка (без фильтра)
+bool resolveFingerprint(const Database& db, const std::string& requested, std::string& id) {
+    if (requested == "all") {
+        id.clear();
+        return true;
+    }
+
+    if (requested.empty()) {
+        Statement last(db, "SELECT fingerprint FROM runs ORDER BY id DESC LIMIT 1");
+        if (!last.step()) {
+            std::cerr << "База пуста" << std::endl;
+            return false;
+        }
+        id = last.text(0);
+        return true;
+    }
+
+    Statement match(db, "SELECT id FROM fingerprints WHERE id >= ?1 AND id < ?1 || '~' LIMIT 2");
+    match.bind(1, requested);
+    if (!match.step()) {
+        std::cerr << "Отпечаток " << requested << " не найден" << std::endl;
+        return false;
+    }
+    id = match.text(0);
+    if (match.step()) {
+        std::cerr << "Отпечаток " << requested << " неоднозначен, укажите больше символов" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void printFingerprint(const Database& db, const std::string& id) {
+    if (id.empty()) {
+        std::cout << "Все конфигурации" << std::endl;
+        return;
+    }
+    Statement st(db, "SELECT gpu, cpu, driver, kernel, resolution FROM fingerprints WHERE id = ?1");
+    st.bind(1, id);
+    if (st.step()) {
+        std::cout << "Отпечаток " << id << "\n"
+                  << "  GPU: " << st.text(0) << "\n"
+                  << "  " << st.text(1) << "\n"
+                  << "  Драйвер: " << st.text(2) << "\n"
+                  << "  Ядро: " << st.text(3) << "\n"
+                  << "  Разрешение: " << st.text(4) << std::endl;
+    }
+}
+
+// Условие выборки по отпечатку и времени. ?1 - отпечаток, ?2 - нижняя граница времени,
+// ?4 - конфигурация, если byConfig (пустая строка - прогоны без записанной конфигурации)
+std::string runsFilter(const std::string& fingerprintId, bool byConfig = false) {
+    std::string filter = fingerprintId.empty() ? " WHERE timestamp >= ?2" : " WHERE fingerprint = ?1 AND timestamp >= ?2";
+    return byConfig ? filter + " AND IFNULL(config, '') = ?4" : filter;
+}
+
+// Конфигурации прогонов под фильтром, последняя использованная первой
+std::vector<std::string> runConfigurations(const Database& db, const std::string& fingerprintId, int64_t since) {
+    std::vector<std::string> configs;
+    Statement st(db, "SELECT IFNULL(config, '') AS c FROM runs" + runsFilter(fingerprintId) +
+                     " GROUP BY c ORDER BY MAX(timestamp) DESC");
+    st.bind(1, fingerprintId).bind(2, since);
+    while (st.step()) {
+        configs.push_back(st.text(0));
+    }
+    return configs;
+}
+
+void printConfiguration(const std::string& config) {
+    std::cout << "Конфигурация: " << (config.empty() ? "не записана (прогоны старых версий)" : config) << std::endl;
+}
+
+// config - только прогоны этой конфигурации, nullptr - все со столбцом конфигурации
+int printRuns(const Database& db, const std::string& fingerprintId, int64_t since,
+              const std::string& order, int limit, const std::string* config = nullptr) {
+    Statement st(db, "SELECT id, timestamp, version, duration, avg_fps, min_fps, max_fps, p50_ms, p99_ms, fingerprint,"
+                     " IFNULL(config, '') FROM runs" + runsFilter(fingerprintId, config != nullptr) +
+                     " ORDER BY " + order + " LIMIT ?3");
+    if (!st) {
+        return -1;
+    }
+    st.bind(1, fingerprintId).bind(2, since).bind(3, static_cast<int64_t>(limit));
+    if (config) {
+        st.bind(4, *config);
+    }
+
+    std::cout << std::left << std::setw(7) << "#" << std::setw(18) << "time" << std::setw(10) << "version"
+              << std::right << std::setw(8) << "sec" << std::setw(10) << "avg fps" << std::setw(10) << "min"
+              << std::setw(10) << "max" << std::setw(9) << "p50 ms" << std::setw(9) << "p99 ms";
+    if (fingerprintId.empty()) {
+        std::cout << (config ? "  fingerprint" : "  fingerprint      ");
+    }
+    if (!config) {
+        std::cout << "  config";
+    }
+    std::cout << std::endl;
+
+    int rows = 0;
+    while (st.step()) {
+        std::cout << std::left << std::setw(7) << st.integer(0) << std::setw(18) << formatTimestamp(st.integer(1))
+                  << std::setw(10) << st.text(2) << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(8) << st.real(3)
+                  << std::setprecision(2) << std::setw(10) << st.real(4) << std::setw(10) << st.real(5)
+                  << std::setw(10) << st.real(6) << std::setprecision(3) << std::setw(9) << st.real(7)
+                  << std::setw(9) << st.real(8);
+        if (fingerprintId.empty()) {
+            std::cout << "  " << st.text(9);
+        }
+        if (!config) {
+            std::cout << "  " << st.text(10);
+        }
+        std::cout << std::endl;
+        ++rows;
+    }
+    if (rows == 0) {
+        std::cout << "Нет прогонов" << std::endl;
+    }
+    return 0;
+}
+
+// Тренд считается внутри одной конфигурации: FPS разных сцен не усредняются
+int printTrend(const Database& db, const std::string& fingerprintId, int64_t since, const std::string& config) {
+    Statement days(db, "SELECT date(timestamp, 'unixepoch', 'localtime') AS day, COUNT(*), AVG(avg_fps),"
+                       " MIN(avg_fps), MAX(avg_fps), AVG(p99_ms) FROM runs" + runsFilter(fingerprintId, true) +
+                       " GROUP BY day ORDER BY day");
+    if (!days) {
+        return -1;
+    }
+    days.bind(1, fingerprintId).bind(2, since).bind(4, config);
+
+    std::cout << std::left << std::setw(12) << "day" << std::right << std::setw(6) << "runs"
+              << std::setw(10) << "avg fps" << std::setw(10) << "min" << std::setw(10) << "max"
+              << std::setw(9) << "p99 ms" << std::endl;
+    while (days.step()) {
+        std::cout << std::left << std::setw(12) << days.text(0) << std::right << std::setw(6) << days.integer(1)
+                  << std::fixed << std::setprecision(2) << std::setw(10) << days.real(2)
+                  << std::setw(10) << days.real(3) << std::setw(10) << days.real(4)
+                  << std::setprecision(3) << std::setw(9) << days.real(5) << std::endl;
+    }
+
+    // Наклон линейной регрессии avg_fps по времени, считается агрегатами в самой базе
+    Statement fit(db, "SELECT COUNT(*), SUM(x), SUM(y), SUM(x * x), SUM(x * y) FROM"
+                      " (SELECT (timestamp - ?2) / 86400.0 AS x, avg_fps AS y FROM runs" +
+                      runsFilter(fingerprintId, true) + ")");
+    fit.bind(1, fingerprintId).bind(2, since).bind(4, config);
+    if (fit.step() && fit.integer(0) >= 2) {
+        double n = static_cast<double>(fit.integer(0));
+        double sx = fit.real(1), sy = fit.real(2), sxx = fit.real(3), sxy = fit.real(4);
+        double denominator = n * sxx - sx * sx;
+        if (std::fabs(denominator) > 1e-12) {
+            double slope = (n * sxy - sx * sy) / denominator;
+            double mean = sy / n;
+            std::cout << "Тренд: " << std::showpos << std::setprecision(2) << slope << " FPS/день ("
+                      << (mean > 0 ? slope * 30.0 / mean * 100.0 : 0.0) << "% за 30 дней)"
+                      << std::noshowpos << std::endl;
+        }
+    }
+    return 0;
+}
+
+int printRun(const Database& db, int64_t runId) {
+    Statement st(db, "SELECT fingerprint, timestamp, version, duration, frames, avg_fps, min_fps, max_fps,"
+                     " p50_ms, p99_ms, histogram, IFNULL(config, '') FROM runs WHERE id = ?1");
+    st.bind(1, runId);
+    if (!st.step()) {
+        std::cerr << "Прогон #" << runId << " не найден" << std::endl;
+        return -1;
+    }
+    printFingerprint(db, st.text(0));
+    printConfiguration(st.text(11));
+    std::cout << "Прогон #" << runId << " " << formatTimestamp(st.integer(1)) << ", версия " << st.text(2) << "\n"
+              << std::fixed << std::setprecision(2)
+              << "  Длительность: " << st.real(3) << " с, кадров: " << st.integer(4) << "\n"
+              << "  FPS avg/min/max: " << st.real(5) << " / " << st.real(6) << " / " << st.real(7) << "\n"
+              << std::setprecision(3)
+              << "  Время кадра P50/P99: " << st.real(8) << " / " << st.real(9) << " мс" << std::endl;
+
+    FrameTimeHistogram histogram = decodeHistogram(st.blob(10));
+    if (histogram.total() == 0) {
+        return 0;
+    }
+    uint64_t peak = *std::max_element(histogram.counts().begin(), histogram.counts().end());
+    std::cout << "  Гистограмма времени кадра:" << std::endl;
+    for (int i = 0; i < FrameTimeHistogram::BUCKET_COUNT; ++i) {
+        uint64_t count = histogram.counts()[i];
+        if (count == 0) {
+            continue;
+        }
+        int bar = static_cast<int>(std::ceil(50.0 * count / peak));
+        std::cout << "  <=" << std::setw(10) << std::setprecision(3) << FrameTimeHistogram::upperBoundMs(i)
+                  << " мс " << std::setw(10) << count << " " << std::string(bar, '#') << std::endl;
+    }
+    return 0;
+}
+
+int printFingerprints(const Database& db) {
+    Statement st(db, "SELECT f.id, f.gpu, f.resolution, COUNT(r.id), MAX(r.timestamp) FROM fingerprints f"
+                     " LEFT JOIN runs r ON r.fingerprint = f.id GROUP BY f.id ORDER BY MAX(r.timestamp) DESC");
+    while (st.step()) {
+        std::cout << st.text(0) << "  " << std::setw(5) << st.integer(3) << " прогонов, последний "
+                  << formatTimestamp(st.integer(4)) << "  " << st.text(1) << " " << st.text(2) << std::endl;
+    }
+    return 0;
+}
+
+} // namespace
+
+std::string HardwareFingerprint::id() const {
+    std::string joined = gpu + '\n' + cpu + '\n' + driver + '\n' + kernel + '\n' + resolution;
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    MD5(reinterpret_cast<const unsigned char*>(joined.data()), joined.size(), digest);
+
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (int i = 0; i < 8; ++i) {
+        ss << std::setw(2) << static_cast<unsigned>(digest[i]);
+    }
+    return ss.str();
+}
+
+std::string getKernelVersion() {
+    struct utsname info {};
+    if (uname(&info) != 0) {
+        return "Unknown";
+    }
+    return std::string(info.sysname) + " " + info.release;
+}
+
+std::string defaultDatabasePath() {
+    std::string base;
+    if (const char* xdg = std::getenv("XDG_DATA_HOME"); xdg && *xdg) {
+        base = xdg;
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        base = std::string(home) + "/.local/share";
+    } else {
+        base = ".";
+    }
+    return base + "/rgbench/results.db";
+}
+
+int64_t storeRun(const std::string& dbPath, const HardwareFingerprint& fingerprint,
+                 const BenchmarkResults& results, std::string& error) {
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(dbPath).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    Database db;
+    if (!db.open(dbPath, true, error) || !db.exec("BEGIN", error)) {
+        return -1;
+    }
+
+    const std::string id = fingerprint.id();
+    Statement insertFingerprint(db, "INSERT OR IGNORE INTO fingerprints (id, gpu, cpu, driver, kernel, resolution)"
+                                    " VALUES (?1, ?2, ?3, ?4, ?5, ?6)");
+    insertFingerprint.bind(1, id).bind(2, fingerprint.gpu).bind(3, fingerprint.cpu)
+        .bind(4, fingerprint.driver).bind(5, fingerprint.kernel).bind(6, fingerprint.resolution);
+    if (!insertFingerprint.run()) {
+        error = sqlite3_errmsg(db.handle());
+        return -1;
+    }
+
+    Statement insertRun(db, "INSERT INTO runs (fingerprint, timestamp, version, duration, frames,"
+                            " min_fps, max_fps, avg_fps, p50_ms, p99_ms, histogram, config)"
+                            " VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12)");
+    insertRun.bind(1, id).bind(2, static_cast<int64_t>(std::time(nullptr))).bind(3, results.version)
+        .bind(4, results.durationSec).bind(5, static_cast<int64_t>(results.frames))
+        .bind(6, results.minFps).bind(7, results.maxFps).bind(8, results.avgFps)
+        .bind(9, percentile(results.frameTimesMs, 50.0)).bind(10, percentile(results.frameTimesMs, 99.0))
+        .bindBlob(11, encodeHistogram(results.histogram)).bind(12, runConfiguration(results));
+    if (!insertRun.run()) {
+        error = sqlite3_errmsg(db.handle());
+        return -1;
+    }
+
+    int64_t runId = sqlite3_last_insert_rowid(db.handle());
+    if (!db.exec("COMMIT", error)) {
+        return -1;
+    }
+    return runId;
+}
+
+bool parseAge(const std::string& text, int64_t& seconds) {
+    if (text.empty()) {
+        return false;
+    }
+    char unit = text.back();
+    int64_t multiplier = 0;
+    switch (unit) {
+        case 'm': multiplier = 60; break;
+        case 'h': multiplier = 3600; break;
+        case 'd': multiplier = 86400; break;
+        case 'w': multiplier = 7 * 86400; break;
+        default: return false;
+    }
+    try {
+        size_t pos = 0;
+        long long value = std::stoll(text.substr(0, text.size() - 1), &pos);
+        if (pos != text.size() - 1 || value < 0) {
+            return false;
+        }
+        seconds = value * multiplier;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+int runDatabaseQuery(const std::string& dbPath, const DatabaseQuery& query) {
+    if (!std::filesystem::exists(dbPath)) {
+        std::cerr << "База результатов не найдена: " << dbPath << std::endl;
+        return -1;
+    }
+
+    Database db;
+    std::string error;
+    if (!db.open(dbPath, false, error)) {
+        std::cerr << "Ошибка базы: " << error << std::endl;
+        return -1;
+    }
+
+    if (query.kind == "fingerprints") {
+        return printFingerprints(db);
+    }
+    if (query.kind == "show") {
+        return printRun(db, query.runId);
+    }
+
+    std::string fingerprintId;
+    if (!resolveFingerprint(db, query.fingerprint, fingerprintId)) {
+        return -1;
+    }
+    int64_t since = query.sinceSeconds > 0 ? static_cast<int64_t>(std::time(nullptr)) - query.sinceSeconds : 0;
+
+    printFingerprint(db, fingerprintId);
+    std::cout << std::endl;
+
+    if (query.kind == "history") {
+        return printRuns(db, fingerprintId, since, "timestamp DESC", query.limit);
+    }
+    // Лучшие, худшие и тренд - отдельно по каждой конфигурации сцены
+    if (query.kind == "best" || query.kind == "worst" || query.kind == "trend") {
+        std::vector<std::string> configs = runConfigurations(db, fingerprintId, since);
+        if (configs.empty()) {
+            std::cout << "Нет прогонов" << std::endl;
+        }
+        for (size_t i = 0; i < configs.size(); ++i) {
+            if (i > 0) {
+                std::cout << std::endl;
+            }
+            printConfiguration(configs[i]);
+            int status = query.kind == "trend" ? printTrend(db, fingerprintId, since, configs[i])
+                       : printRuns(db, fingerprintId, since, query.kind == "best" ? "avg_fps DESC" : "avg_fps ASC",
+                                   query.limit, &configs[i]);
+            if (status != 0) {
+                return status;
+            }
+        }
+        return 0;
+    }
+
+    std::cerr << "Неизвестный запрос: " << query.kind << std::endl;
+    return -1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "results.h"
+
+// Отпечаток аппаратной и программной конфигурации, по нему группируются прогоны
+struct HardwareFingerprint {
+    std::string gpu;
+    std::string cpu;
+    std::string driver;
+    std::string kernel;
+    std::string resolution;
+
+    // Короткий идентификатор (первые 16 символов MD5 от всех полей)
+    [[nodiscard]] std::string id() const;
+};
+
+[[nodiscard]] std::string getKernelVersion();
+
+// Путь к базе по умолчанию: $XDG_DATA_HOME/rgbench/results.db или ~/.local/share/rgbench/results.db
+[[nodiscard]] std::string defaultDatabasePath();
+
+// Сохраняет сводку и гистограмму времени кадра прогона, возвращает номер записи или -1
+int64_t storeRun(const std::string& dbPath, const HardwareFingerprint& fingerprint,
+                 const BenchmarkResults& results, std::string& error);
+
+struct DatabaseQuery {
+    std::string kind;          // history, best, worst, trend, show, fingerprints
+    std::string fingerprint;   // Префикс идентификатора, "all" - все, пусто - последний записанный
+    int64_t sinceSeconds = 0;  // Только прогоны не старше, 0 - все
+    int limit = 20;
+    int64_t runId = -1;        // Для show
+};
+
+// Разбор "30d", "12h", "2w", "90m" в секунды, false при ошибке
+bool parseAge(const std::string& text, int64_t& seconds);
+
+// Выполняет запрос к базе и печатает результат, возвращает код завершения программы
+int runDatabaseQuery(const std::string& dbPath, const DatabaseQuery& query);
@@ -0,0 +1,9 @@
+#version 330 core
+
+in vec3 ourColor;
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(ourColor, 1.0);
+}
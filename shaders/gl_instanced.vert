@@ -0,0 +1,31 @@
+#version 330 core
+
+// Положение кубика считается по gl_InstanceID, на кадр меняется только model
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+out vec3 ourColor;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform int cubeSize;
+uniform float cubieSize;
+uniform float spacing;
+uniform bool cullHidden;
+uniform int faceVertices; // 6 без индексов, 4 с индексами
+
+void main()
+{
+    ivec3 cell = ivec3(gl_InstanceID / (cubeSize * cubeSize), (gl_InstanceID / cubeSize) % cubeSize, gl_InstanceID % cubeSize);
+    ourColor = aColor;
+    if (cullHidden) {
+        // Грани по порядку: -Z, +Z, -X, +X, -Y, +Y
+        int face = gl_VertexID / faceVertices;
+        int coord = face < 2 ? cell.z : (face < 4 ? cell.x : cell.y);
+        if (coord != ((face & 1) == 1 ? cubeSize - 1 : 0)) {
+            gl_Position = vec4(0.0); // Вырожденный треугольник отбрасывается
+            return;
+        }
+    }
+    vec3 offset = (vec3(cell) - float(cubeSize - 1) * 0.5) * spacing;
+    gl_Position = projection * view * model * vec4(aPos * cubieSize + offset, 1.0);
+}
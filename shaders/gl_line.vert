@@ -0,0 +1,11 @@
+#version 330 core
+
+// Линии и точки графика FPS
+layout (location = 0) in vec2 aPos;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * vec4(aPos.x, aPos.y, 0.0, 1.0);
+    gl_PointSize = 2.0; // На ES нет glPointSize, GL берет размер из glPointSize
+}
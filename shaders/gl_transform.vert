@@ -0,0 +1,15 @@
+#version 330 core
+
+// Матрица кубика приходит атрибутом из буфера инстансов, его заполняют потоки CPU
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in mat4 aModel;
+out vec3 ourColor;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+    ourColor = aColor;
+}
@@ -0,0 +1,23 @@
+#version 450
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aColor;
+
+// Матрицы model кубиков, индекс - номер инстанса
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    mat4 model[];
+};
+
+layout(push_constant) uniform Frame {
+    mat4 viewProjection;
+};
+
+layout(location = 0) out vec3 color;
+
+void main()
+{
+    gl_Position = viewProjection * model[gl_InstanceIndex] * vec4(aPos, 1.0);
+    // Проекция в соглашении GL: глубина -1..1 переводится в 0..1
+    gl_Position.z = 0.5 * (gl_Position.z + gl_Position.w);
+    color = aColor;
+}
@@ -0,0 +1,13 @@
+#version 450
+
+// Атлас глифов, у сплошных прямоугольников координаты белого блока
+layout(set = 0, binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) in vec2 texCoord;
+layout(location = 1) in vec3 color;
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    fragColor = vec4(color, texture(atlas, texCoord).r);
+}
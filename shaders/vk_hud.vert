@@ -0,0 +1,16 @@
+#version 450
+
+// Вершины оверлея уже в координатах отсечения
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTexCoord;
+layout(location = 2) in vec3 aColor;
+
+layout(location = 0) out vec2 texCoord;
+layout(location = 1) out vec3 color;
+
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    texCoord = aTexCoord;
+    color = aColor;
+}
@@ -0,0 +1,196 @@
+#include "shm_metrics.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+namespace {
+
+constexpr const char* SHM_PREFIX = "rgbench-";
+
+void copyString(char* destination, size_t size, const std::string& source) {
+    size_t length = std::min(size - 1, source.size());
+    std::memcpy(destination, source.data(), length);
+    destination[length] = '\0';
+}
+
+// pid первого сегмента в /dev/shm, 0 - не найден
+int64_t findSharedMetricsPid() {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev/shm", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(SHM_PREFIX, 0) == 0) {
+            int64_t pid = std::atoll(name.c_str() + std::strlen(SHM_PREFIX));
+            if (pid > 0) {
+                return pid;
+            }
+        }
+    }
+    return 0;
+}
+
+bool processAlive(int64_t pid) {
+    return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+void printMetrics(const SharedMetrics& m) {
+    std::cout << "Время: " << std::setw(5) << static_cast<int64_t>(m.uptimeSec) << "с"
+              << std::fixed << std::setprecision(2)
+              << " | FPS: " << std::setw(8) << m.fps
+              << " | Среднее FPS: " << std::setw(8) << m.fpsEstimate
+              << " | P50/P99: " << m.frameTimeP50Ms << "/" << m.frameTimeP99Ms << " мс"
+              << " | CPU: " << m.cpuSubmitMs << " мс | Swap: " << m.swapMs << " мс | GPU:";
+    for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+        std::cout << " " << gpuPassName(pass) << "=" << m.gpuPassMs[pass];
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+std::string sharedMetricsName(int64_t pid) {
+    return "/" + std::string(SHM_PREFIX) + std::to_string(pid);
+}
+
+SharedMetricsWriter::~SharedMetricsWriter() {
+    close();
+}
+
+bool SharedMetricsWriter::open(const std::string& gpu, const std::string& programVersion, std::string& error) {
+    name_ = sharedMetricsName(getpid());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(SharedMetricsSegment)) < 0) {
+        error = std::strerror(errno);
+        ::close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    void* memory = mmap(nullptr, sizeof(SharedMetricsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        error = std::strerror(errno);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    segment_ = new (memory) SharedMetricsSegment {};
+    segment_->version = SHARED_METRICS_VERSION;
+    segment_->segmentSize = sizeof(SharedMetricsSegment);
+    segment_->gpuPassCount = GPU_PASS_COUNT;
+    segment_->pid = getpid();
+    copyString(segment_->gpu, sizeof(segment_->gpu), gpu);
+    copyString(segment_->programVersion, sizeof(segment_->programVersion), programVersion);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment_->magic = SHARED_METRICS_MAGIC;
+    return true;
+}
+
+void SharedMetricsWriter::close() {
+    if (!segment_) {
+        return;
+    }
+    munmap(segment_, sizeof(SharedMetricsSegment));
+    shm_unlink(name_.c_str());
+    segment_ = nullptr;
+}
+
+SharedMetricsReader::~SharedMetricsReader() {
+    close();
+}
+
+bool SharedMetricsReader::open(int64_t pid, std::string& error) {
+    std::string name = sharedMetricsName(pid);
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        error = "/dev/shm" + name + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(SharedMetricsSegment)) {
+        error = "segment is too small";
+        ::close(fd);
+        return false;
+    }
+    void* memory = mmap(nullptr, sizeof(SharedMetricsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    segment_ = static_cast<const SharedMetricsSegment*>(memory);
+    if (segment_->magic != SHARED_METRICS_MAGIC) {
+        error = "segment is not initialized";
+    } else if (segment_->version != SHARED_METRICS_VERSION || segment_->segmentSize != sizeof(SharedMetricsSegment)
+               || segment_->gpuPassCount != GPU_PASS_COUNT) {
+        error = "unsupported segment version " + std::to_string(segment_->version);
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+    close();
+    return false;
+}
+
+void SharedMetricsReader::close() {
+    if (!segment_) {
+        return;
+    }
+    munmap(const_cast<SharedMetricsSegment*>(segment_), sizeof(SharedMetricsSegment));
+    segment_ = nullptr;
+}
+
+int monitorSharedMetrics(int64_t pid, bool once) {
+    if (pid == 0) {
+        pid = findSharedMetricsPid();
+        if (pid == 0) {
+            std::cerr << "Не найдено запущенных тестов с --shm" << std::endl;
+            return 1;
+        }
+    }
+
+    SharedMetricsReader reader;
+    std::string error;
+    if (!reader.open(pid, error)) {
+        std::cerr << "Failed to open metrics segment: " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Процесс " << reader.segment().pid << ": " << reader.segment().gpu
+              << " (версия " << reader.segment().programVersion << ")" << std::endl;
+
+    uint64_t lastUpdate = 0;
+    while (true) {
+        SharedMetrics metrics;
+        if (reader.read(metrics) && metrics.updates != lastUpdate) {
+            lastUpdate = metrics.updates;
+            printMetrics(metrics);
+            if (once) {
+                return 0;
+            }
+        }
+        // Писатель удаляет сегмент при нормальном завершении
+        std::error_code ec;
+        if (!processAlive(pid) || !std::filesystem::exists("/dev/shm" + sharedMetricsName(pid), ec)) {
+            std::cerr << "Процесс " << pid << " завершился" << std::endl;
+            return once ? 1 : 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "telemetry.h"
+
+// Живые метрики в разделяемой памяти /dev/shm/rgbench-<pid>.
+//
+// Сегмент - заголовок с версией и Seqlock<SharedMetrics>. Писатель (поток
+// рендеринга) раз в секунду копирует структуру и никогда не ждет читателей,
+// читатель повторяет копирование, если попал на запись. Читать сегмент можно
+// из любой программы, подключив этот заголовок и telemetry.h.
+
+constexpr uint32_t SHARED_METRICS_MAGIC = 0x4D424752; // "RGBM"
+constexpr uint32_t SHARED_METRICS_VERSION = 1;
+
+struct SharedMetrics {
+    uint64_t updates = 0;             // Номер публикации
+    uint64_t frames = 0;              // Всего кадров с начала теста
+    uint64_t framesLastSecond = 0;
+    double uptimeSec = 0.0;
+
+    double fps = 0.0;
+    double fpsEstimate = 0.0;         // Состояние фильтра Калмана
+    double fpsErrorEstimate = 0.0;
+
+    // Перцентили времени кадра за последнюю секунду, мс
+    double frameTimeP50Ms = 0.0;
+    double frameTimeP90Ms = 0.0;
+    double frameTimeP99Ms = 0.0;
+    double frameTimeMaxMs = 0.0;
+
+    // Средние времена фаз кадра за последнюю секунду, мс
+    double cpuSubmitMs = 0.0;         // От начала кадра до SwapBuffers
+    double swapMs = 0.0;              // Внутри SwapBuffers
+    double gpuPassMs[GPU_PASS_COUNT] = {};
+
+    int64_t vramUsedMB = -1;
+};
+
+struct SharedMetricsSegment {
+    uint32_t magic;                   // Записывается последним, когда сегмент готов
+    uint32_t version;
+    uint32_t segmentSize;             // sizeof(SharedMetricsSegment) у писателя
+    uint32_t gpuPassCount;
+    int64_t pid;
+    char gpu[128];
+    char programVersion[64];
+    Seqlock<SharedMetrics> metrics;
+};
+
+// Имя для shm_open, файл - /dev/shm/rgbench-<pid>
+[[nodiscard]] std::string sharedMetricsName(int64_t pid);
+
+// Сегмент писателя, удаляется в close()
+class SharedMetricsWriter {
+public:
+    ~SharedMetricsWriter();
+
+    bool open(const std::string& gpu, const std::string& programVersion, std::string& error);
+    void close();
+
+    void publish(const SharedMetrics& metrics) { segment_->metrics.store(metrics); }
+
+    [[nodiscard]] bool isOpen() const { return segment_ != nullptr; }
+    [[nodiscard]] const std::string& name() const { return name_; }
+
+private:
+    SharedMetricsSegment* segment_ = nullptr;
+    std::string name_;
+};
+
+// Чтение сегмента другого процесса
+class SharedMetricsReader {
+public:
+    ~SharedMetricsReader();
+
+    bool open(int64_t pid, std::string& error);
+    void close();
+
+    // false - не удалось получить согласованный снимок
+    bool read(SharedMetrics& metrics) const { return segment_->metrics.load(metrics); }
+
+    [[nodiscard]] const SharedMetricsSegment& segment() const { return *segment_; }
+
+private:
+    const SharedMetricsSegment* segment_ = nullptr;
+};
+
+// Подкоманда monitor: печатает метрики запущенного теста раз в секунду.
+// pid 0 - первый найденный сегмент. Возвращает код завершения программы
+int monitorSharedMetrics(int64_t pid, bool once);
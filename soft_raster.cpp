@@ -0,0 +1,314 @@
+#include "soft_raster.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "job_system.h"
+
+SoftRasterizer softRaster;
+
+namespace {
+
+// Перевод из координат отсечения в пиксели, y вниз. false - вершина за камерой
+bool toScreen(const glm::vec4& clip, int width, int height, glm::vec3& screen) {
+    if (clip.w <= 1e-6f) {
+        return false;
+    }
+    float inverseW = 1.0f / clip.w;
+    screen.x = (clip.x * inverseW * 0.5f + 0.5f) * width;
+    screen.y = (0.5f - clip.y * inverseW * 0.5f) * height;
+    screen.z = clip.z * inverseW * 0.5f + 0.5f;
+    return true;
+}
+
+uint32_t blend(uint32_t destination, uint32_t source, uint32_t alpha) {
+    uint32_t result = 0xff000000u;
+    for (int shift = 0; shift < 24; shift += 8) {
+        int d = (destination >> shift) & 0xff;
+        int s = (source >> shift) & 0xff;
+        result |= static_cast<uint32_t>(d + ((s - d) * static_cast<int>(alpha) + 127) / 255) << shift;
+    }
+    return result;
+}
+
+} // namespace
+
+void SoftRasterizer::beginFrame(int width, int height, uint32_t clearColor) {
+    if (width != width_ || height != height_) {
+        width_ = width;
+        height_ = height;
+        stride_ = (width + 3) & ~3;
+        tilesX_ = (width + TILE_SIZE - 1) / TILE_SIZE;
+        tilesY_ = (height + TILE_SIZE - 1) / TILE_SIZE;
+        color_.assign(static_cast<size_t>(stride_) * height, 0);
+        depth_.assign(static_cast<size_t>(stride_) * height, 1.0f);
+        bins_.assign(static_cast<size_t>(tilesX_) * tilesY_, {});
+    }
+    clearColor_ = clearColor;
+    triangles_.clear();
+    rects_.clear();
+    for (std::vector<uint32_t>& bin : bins_) {
+        bin.clear();
+    }
+}
+
+void SoftRasterizer::drawTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, uint32_t color, bool cullBack) {
+    glm::vec3 v[3];
+    if (!toScreen(a, width_, height_, v[0]) || !toScreen(b, width_, height_, v[1]) || !toScreen(c, width_, height_, v[2])) {
+        ++frame_.culled;
+        return;
+    }
+    // y вниз: обход против часовой стрелки в GL дает отрицательную площадь
+    float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    if (area == 0.0f || (cullBack && area > 0.0f)) {
+        ++frame_.culled;
+        return;
+    }
+    if (area < 0.0f) {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    int minX = std::max(0, static_cast<int>(std::floor(std::min({v[0].x, v[1].x, v[2].x}))));
+    int minY = std::max(0, static_cast<int>(std::floor(std::min({v[0].y, v[1].y, v[2].y}))));
+    int maxX = std::min(width_ - 1, static_cast<int>(std::ceil(std::max({v[0].x, v[1].x, v[2].x}))));
+    int maxY = std::min(height_ - 1, static_cast<int>(std::ceil(std::max({v[0].y, v[1].y, v[2].y}))));
+    if (minX > maxX || minY > maxY) {
+        ++frame_.culled;
+        return;
+    }
+
+    Triangle triangle;
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec3& from = v[i];
+        const glm::vec3& to = v[(i + 1) % 3];
+        triangle.edgeA[i] = from.y - to.y;
+        triangle.edgeB[i] = to.x - from.x;
+        triangle.edgeC[i] = -(triangle.edgeA[i] * from.x + triangle.edgeB[i] * from.y);
+    }
+    // Глубина: z0 + (z1 - z0) * w1 + (z2 - z0) * w2, веса - ребра напротив вершин
+    float dz1 = (v[1].z - v[0].z) / area;
+    float dz2 = (v[2].z - v[0].z) / area;
+    triangle.depthA = dz1 * triangle.edgeA[2] + dz2 * triangle.edgeA[0];
+    triangle.depthB = dz1 * triangle.edgeB[2] + dz2 * triangle.edgeB[0];
+    triangle.depthC = v[0].z + dz1 * triangle.edgeC[2] + dz2 * triangle.edgeC[0];
+    triangle.color = color;
+    triangle.minX = minX;
+    triangle.minY = minY;
+    triangle.maxX = maxX;
+    triangle.maxY = maxY;
+
+    triangles_.push_back(triangle);
+    ++frame_.triangles;
+    bin(static_cast<uint32_t>(triangles_.size() - 1), minX, minY, maxX, maxY);
+}
+
+void SoftRasterizer::drawRect(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, uint32_t color) {
+    addRect(transform, min, max, color, nullptr, 0, 0);
+}
+
+void SoftRasterizer::drawGlyph(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, uint32_t color,
+                               const uint8_t* mask, int maskWidth, int maskHeight) {
+    if (mask && maskWidth > 0 && maskHeight > 0) {
+        addRect(transform, min, max, color, mask, maskWidth, maskHeight);
+    }
+}
+
+void SoftRasterizer::addRect(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, uint32_t color,
+                             const uint8_t* mask, int maskWidth, int maskHeight) {
+    glm::vec3 a, b;
+    if (!toScreen(transform * glm::vec4(min, 0.0f, 1.0f), width_, height_, a)
+        || !toScreen(transform * glm::vec4(max, 0.0f, 1.0f), width_, height_, b)) {
+        return;
+    }
+    Rect rect;
+    rect.x0 = static_cast<int>(std::lround(std::min(a.x, b.x)));
+    rect.y0 = static_cast<int>(std::lround(std::min(a.y, b.y)));
+    rect.x1 = std::max(rect.x0 + 1, static_cast<int>(std::lround(std::max(a.x, b.x))));
+    rect.y1 = std::max(rect.y0 + 1, static_cast<int>(std::lround(std::max(a.y, b.y))));
+    rect.color = color;
+    rect.mask = mask;
+    rect.maskWidth = maskWidth;
+    rect.maskHeight = maskHeight;
+
+    int minX = std::max(rect.x0, 0);
+    int minY = std::max(rect.y0, 0);
+    int maxX = std::min(rect.x1, width_) - 1;
+    int maxY = std::min(rect.y1, height_) - 1;
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+    rects_.push_back(rect);
+    ++frame_.rects;
+    bin(static_cast<uint32_t>(rects_.size() - 1) | RECT_BIT, minX, minY, maxX, maxY);
+}
+
+void SoftRasterizer::bin(uint32_t entry, int minX, int minY, int maxX, int maxY) {
+    for (int ty = minY / TILE_SIZE; ty <= maxY / TILE_SIZE; ++ty) {
+        for (int tx = minX / TILE_SIZE; tx <= maxX / TILE_SIZE; ++tx) {
+            bins_[static_cast<size_t>(ty) * tilesX_ + tx].push_back(entry);
+        }
+    }
+}
+
+void SoftRasterizer::endFrame() {
+    auto start = std::chrono::steady_clock::now();
+    jobs_->parallelFor(bins_.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile) {
+            rasterTile(static_cast<int>(tile));
+        }
+    });
+    frame_.rasterNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    lastFrame_ = frame_;
+    total_.triangles += frame_.triangles;
+    total_.culled += frame_.culled;
+    total_.rects += frame_.rects;
+    total_.rasterNs += frame_.rasterNs;
+    frame_ = {};
+    ++frames_;
+}
+
+void SoftRasterizer::rasterTile(int tile) {
+    // Тайл владеет столбцами до выровненного края: хвост строки у последнего тайла
+    int x0 = (tile % tilesX_) * TILE_SIZE;
+    int y0 = (tile / tilesX_) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, stride_);
+    int y1 = std::min(y0 + TILE_SIZE, height_);
+
+    for (int y = y0; y < y1; ++y) {
+        size_t row = static_cast<size_t>(y) * stride_;
+        std::fill(color_.begin() + row + x0, color_.begin() + row + x1, clearColor_);
+        std::fill(depth_.begin() + row + x0, depth_.begin() + row + x1, 1.0f);
+    }
+    for (uint32_t entry : bins_[tile]) {
+        if (entry & RECT_BIT) {
+            rasterRect(rects_[entry & ~RECT_BIT], x0, y0, std::min(x1, width_), y1);
+        } else {
+            rasterTriangle(triangles_[entry], x0, y0, x1, y1);
+        }
+    }
+}
+
+void SoftRasterizer::rasterTriangle(const Triangle& t, int x0, int y0, int x1, int y1) {
+    // Начало выровнено на 4, а край тайла кратен 4: все дорожки SSE внутри тайла
+    x0 = std::max(x0, t.minX & ~3);
+    y0 = std::max(y0, t.minY);
+    x1 = std::min(x1, t.maxX + 1);
+    y1 = std::min(y1, t.maxY + 1);
+#if defined(__SSE2__)
+    // Четыре соседних пикселя строки за шаг
+    const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i color = _mm_set1_epi32(static_cast<int>(t.color));
+    __m128 a0 = _mm_set1_ps(t.edgeA[0]), a1 = _mm_set1_ps(t.edgeA[1]), a2 = _mm_set1_ps(t.edgeA[2]);
+    __m128 depthA = _mm_set1_ps(t.depthA);
+    for (int y = y0; y < y1; ++y) {
+        float py = y + 0.5f;
+        __m128 row0 = _mm_set1_ps(t.edgeB[0] * py + t.edgeC[0]);
+        __m128 row1 = _mm_set1_ps(t.edgeB[1] * py + t.edgeC[1]);
+        __m128 row2 = _mm_set1_ps(t.edgeB[2] * py + t.edgeC[2]);
+        __m128 rowDepth = _mm_set1_ps(t.depthB * py + t.depthC);
+        size_t row = static_cast<size_t>(y) * stride_;
+        for (int x = x0; x < x1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), row0), zero),
+                                                  _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), row1), zero)),
+                                       _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), row2), zero));
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+            float* depth = depth_.data() + row + x;
+            __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+            __m128 stored = _mm_loadu_ps(depth);
+            __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, stored));
+            if (_mm_movemask_ps(pass) == 0) {
+                continue;
+            }
+            _mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, stored)));
+            auto* pixels = reinterpret_cast<__m128i*>(color_.data() + row + x);
+            __m128i passBits = _mm_castps_si128(pass);
+            __m128i old = _mm_loadu_si128(pixels);
+            _mm_storeu_si128(pixels, _mm_or_si128(_mm_and_si128(passBits, color), _mm_andnot_si128(passBits, old)));
+        }
+    }
+#else
+    for (int y = y0; y < y1; ++y) {
+        float py = y + 0.5f;
+        size_t row = static_cast<size_t>(y) * stride_;
+        for (int x = x0; x < x1; ++x) {
+            float px = x + 0.5f;
+            if (t.edgeA[0] * px + t.edgeB[0] * py + t.edgeC[0] < 0.0f
+                || t.edgeA[1] * px + t.edgeB[1] * py + t.edgeC[1] < 0.0f
+                || t.edgeA[2] * px + t.edgeB[2] * py + t.edgeC[2] < 0.0f) {
+                continue;
+            }
+            float z = t.depthA * px + t.depthB * py + t.depthC;
+            if (z < depth_[row + x]) {
+                depth_[row + x] = z;
+                color_[row + x] = t.color;
+            }
+        }
+    }
+#endif
+}
+
+void SoftRasterizer::rasterRect(const Rect& rect, int x0, int y0, int x1, int y1) {
+    x0 = std::max(x0, rect.x0);
+    y0 = std::max(y0, rect.y0);
+    x1 = std::min(x1, rect.x1);
+    y1 = std::min(y1, rect.y1);
+    int rectWidth = rect.x1 - rect.x0;
+    int rectHeight = rect.y1 - rect.y0;
+    for (int y = y0; y < y1; ++y) {
+        uint32_t* pixels = color_.data() + static_cast<size_t>(y) * stride_;
+        if (!rect.mask) {
+            std::fill(pixels + x0, pixels + x1, rect.color);
+            continue;
+        }
+        // Ближайший тексель маски, как у глифа в GL при масштабе 1
+        const uint8_t* maskRow = rect.mask + static_cast<size_t>((y - rect.y0) * rect.maskHeight / rectHeight) * rect.maskWidth;
+        for (int x = x0; x < x1; ++x) {
+            uint32_t coverage = maskRow[(x - rect.x0) * rect.maskWidth / rectWidth];
+            if (coverage == 255) {
+                pixels[x] = rect.color;
+            } else if (coverage > 0) {
+                pixels[x] = blend(pixels[x], rect.color, coverage);
+            }
+        }
+    }
+}
+
+bool SoftRasterizer::saveFrame(const std::string& path, std::string& error) const {
+    if (frames_ == 0) {
+        error = "no frames rendered";
+        return false;
+    }
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    file << "P6\n" << width_ << " " << height_ << "\n255\n";
+    std::vector<uint8_t> line(static_cast<size_t>(width_) * 3);
+    for (int y = 0; y < height_; ++y) {
+        const uint32_t* pixels = color_.data() + static_cast<size_t>(y) * stride_;
+        for (int x = 0; x < width_; ++x) {
+            line[x * 3] = pixels[x] & 0xff;
+            line[x * 3 + 1] = (pixels[x] >> 8) & 0xff;
+            line[x * 3 + 2] = (pixels[x] >> 16) & 0xff;
+        }
+        file.write(reinterpret_cast<const char*>(line.data()), static_cast<std::streamsize>(line.size()));
+    }
+    if (!file) {
+        error = "write failed";
+        return false;
+    }
+    return true;
+}
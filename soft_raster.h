@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+// Цвет пикселя программного растеризатора: RGBA8, R в младшем байте
+[[nodiscard]] inline uint32_t packSoftColor(float r, float g, float b) {
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+    return channel(r) | channel(g) << 8 | channel(b) << 16 | 0xff000000u;
+}
+
+// Счетчики программного растеризатора
+struct SoftRasterStats {
+    uint64_t triangles = 0;   // Попали в бины после отсечения
+    uint64_t culled = 0;      // Задние грани, вырожденные, за камерой и за экраном
+    uint64_t rects = 0;       // Прямоугольники оверлея: линии, точки, глифы
+    uint64_t rasterNs = 0;    // Время растеризации тайлов
+};
+
+// Программный растеризатор (--backend soft): та же сцена, что у GL, в кадре в
+// памяти. Вызывающий поток преобразует вершины и раскладывает примитивы по
+// тайлам 64 x 64, в endFrame() тайлы растеризуются параллельно в пуле потоков
+// без блокировок: у каждого тайла свои пиксели. Треугольники - сплошной цвет,
+// функции ребер и тест глубины считаются по 4 пикселя на SSE2. Порядок
+// примитивов внутри тайла сохраняется, поэтому оверлей ложится поверх кубика
+// как в GL
+class SoftRasterizer {
+public:
+    void init(JobSystem* jobs) { jobs_ = jobs; }
+    [[nodiscard]] bool enabled() const { return jobs_ != nullptr; }
+
+    void beginFrame(int width, int height, uint32_t clearColor);
+    // Треугольник в координатах отсечения с тестом глубины GL_LESS. cullBack -
+    // отбрасывать грани с обходом по часовой стрелке, как GL_CULL_FACE
+    void drawTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, uint32_t color, bool cullBack);
+    // Прямоугольник оверлея без теста глубины: углы переводятся transform в
+    // координаты отсечения, занимает хотя бы пиксель
+    void drawRect(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, uint32_t color);
+    // То же с маской покрытия (глиф, строка 0 - верх): цвет смешивается по маске.
+    // Маска должна жить до endFrame()
+    void drawGlyph(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, uint32_t color,
+                   const uint8_t* mask, int maskWidth, int maskHeight);
+    // Растеризует кадр и закрывает счетчики кадра
+    void endFrame();
+
+    [[nodiscard]] const SoftRasterStats& lastFrame() const { return lastFrame_; }
+    [[nodiscard]] const SoftRasterStats& total() const { return total_; }
+    [[nodiscard]] uint64_t frames() const { return frames_; }
+
+    // Последний кадр в PPM (P6) - эталон для сравнения с выводом GPU
+    bool saveFrame(const std::string& path, std::string& error) const;
+
+private:
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];  // Ребро i: a * x + b * y + c >= 0 внутри
+        float depthA, depthB, depthC;        // Плоскость глубины в пикселях
+        uint32_t color;
+        int minX, minY, maxX, maxY;          // Пиксели внутри кадра, включительно
+    };
+    struct Rect {
+        int x0, y0, x1, y1;                  // [x0, x1) x [y0, y1), y вниз
+        uint32_t color;
+        const uint8_t* mask;
+        int maskWidth, maskHeight;
+    };
+    // Ссылка в бине: индекс треугольника или прямоугольника с RECT_BIT
+    static constexpr uint32_t RECT_BIT = 0x80000000u;
+    static constexpr int TILE_SIZE = 64;
+
+    void addRect(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, uint32_t color,
+                 const uint8_t* mask, int maskWidth, int maskHeight);
+    void bin(uint32_t entry, int minX, int minY, int maxX, int maxY);
+    void rasterTile(int tile);
+    void rasterTriangle(const Triangle& triangle, int x0, int y0, int x1, int y1);
+    void rasterRect(const Rect& rect, int x0, int y0, int x1, int y1);
+
+    JobSystem* jobs_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    int stride_ = 0;                         // Ширина, выровненная на 4 пикселя
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    uint32_t clearColor_ = 0;
+    std::vector<uint32_t> color_;
+    std::vector<float> depth_;
+    std::vector<Triangle> triangles_;
+    std::vector<Rect> rects_;
+    std::vector<std::vector<uint32_t>> bins_;
+
+    SoftRasterStats frame_;
+    SoftRasterStats lastFrame_;
+    SoftRasterStats total_;
+    uint64_t frames_ = 0;
+};
+
+extern SoftRasterizer softRaster;
@@ -0,0 +1,103 @@
+#include "startup.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+StartupGraph::StartupGraph(bool parallel, std::chrono::steady_clock::time_point start)
+    : parallel_(parallel), start_(start) {
+}
+
+StartupGraph::~StartupGraph() {
+    for (const auto& task : tasks_) {
+        task.wait();
+    }
+}
+
+double StartupGraph::nowMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+}
+
+void StartupGraph::setSpan(size_t index, double startMs, double endMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    spans_[index].startMs = startMs;
+    spans_[index].endMs = endMs;
+}
+
+StartupGraph::TaskId StartupGraph::add(const char* name, std::function<void()> work,
+                                       const std::vector<TaskId>& dependencies) {
+    size_t span = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        span = spans_.size();
+        spans_.push_back({name, 0.0, 0.0, parallel_});
+    }
+
+    if (!parallel_) {
+        double startMs = nowMs();
+        work();
+        setSpan(span, startMs, nowMs());
+        std::promise<void> done;
+        done.set_value();
+        tasks_.push_back(done.get_future().share());
+        return tasks_.size() - 1;
+    }
+
+    std::vector<std::shared_future<void>> waitFor;
+    for (TaskId dependency : dependencies) {
+        waitFor.push_back(tasks_.at(dependency));
+    }
+    tasks_.push_back(std::async(std::launch::async, [this, span, work = std::move(work), waitFor = std::move(waitFor)]() {
+        for (const auto& dependency : waitFor) {
+            dependency.get();
+        }
+        double startMs = nowMs();
+        work();
+        setSpan(span, startMs, nowMs());
+    }).share());
+    return tasks_.size() - 1;
+}
+
+void StartupGraph::wait(TaskId task) {
+    const std::shared_future<void>& done = tasks_.at(task);
+    if (done.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        double startMs = nowMs();
+        done.wait();
+        waitMs_ += nowMs() - startMs;
+    }
+    // Исключение задачи выходит здесь, как при последовательном запуске
+    done.get();
+}
+
+void StartupGraph::stage(const char* name) {
+    double now = nowMs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    spans_.push_back({name, lastStageMs_, now, false});
+    lastStageMs_ = now;
+}
+
+void StartupGraph::firstFrame() {
+    if (firstFrameMs_ > 0.0) {
+        return;
+    }
+    stage("первый кадр");
+    firstFrameMs_ = lastStageMs_;
+
+    std::vector<Span> spans;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spans = spans_;
+    }
+    std::stable_sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) { return a.startMs < b.startMs; });
+
+    std::cout << "Запуск (" << (parallel_ ? "параллельный" : "последовательный") << "): первый кадр через "
+              << std::fixed << std::setprecision(1) << firstFrameMs_ << " мс, ожидание задач CPU "
+              << waitMs_ << " мс" << std::endl;
+    for (const Span& span : spans) {
+        if (span.endMs <= 0.0) {
+            continue;
+        }
+        std::cout << "  " << (span.worker ? "[поток] " : "") << span.name << ": " << span.startMs << " - "
+                  << span.endMs << " мс" << std::endl;
+    }
+}
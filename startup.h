@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Граф задач запуска. Работа CPU без GL (нарезка глифов из атласа, разбор
+// /proc) идет в своих потоках, как только готовы ее зависимости, пока главный
+// поток создает окно и собирает шейдеры. Перед загрузкой результата в GL
+// главный поток ждет задачу. Время задач и этапов главного потока от начала
+// main() печатается вместе со временем до первого кадра. Последовательный
+// режим (--serial-startup) выполняет задачу сразу при добавлении - для сравнения
+class StartupGraph {
+public:
+    using TaskId = size_t;
+
+    StartupGraph(bool parallel, std::chrono::steady_clock::time_point start);
+    // Дожидается всех задач: они пишут в переменные main()
+    ~StartupGraph();
+
+    StartupGraph(const StartupGraph&) = delete;
+    StartupGraph& operator=(const StartupGraph&) = delete;
+
+    [[nodiscard]] bool parallel() const { return parallel_; }
+
+    TaskId add(const char* name, std::function<void()> work, const std::vector<TaskId>& dependencies = {});
+    // Из главного потока: ждет задачу, простой главного потока учитывается
+    void wait(TaskId task);
+    // Этап главного потока закончился: от конца прошлого этапа до сейчас
+    void stage(const char* name);
+
+    // Первый кадр показан: печатает сводку, повторные вызовы ничего не делают
+    void firstFrame();
+    // Время до первого кадра, 0 - кадра еще не было
+    [[nodiscard]] double firstFrameMs() const { return firstFrameMs_; }
+
+private:
+    struct Span {
+        std::string name;
+        double startMs = 0.0;
+        double endMs = 0.0;
+        bool worker = false;
+    };
+
+    [[nodiscard]] double nowMs() const;
+    void setSpan(size_t index, double startMs, double endMs);
+
+    bool parallel_;
+    std::chrono::steady_clock::time_point start_;
+    std::vector<std::shared_future<void>> tasks_;
+    std::mutex mutex_;
+    std::vector<Span> spans_;
+    double lastStageMs_ = 0.0;
+    double waitMs_ = 0.0;
+    double firstFrameMs_ = 0.0;
+};
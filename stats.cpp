@@ -0,0 +1,266 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Бутстреп по миллионам кадров слишком дорог, выборку прореживаем.
+// Интервал от этого только шире, то есть вывод остается консервативным
+constexpr size_t BOOTSTRAP_MAX_SAMPLES = 20000;
+
+std::vector<float> subsample(const std::vector<float>& values, std::mt19937_64& rng) {
+    if (values.size() <= BOOTSTRAP_MAX_SAMPLES) {
+        return values;
+    }
+    std::vector<float> result(BOOTSTRAP_MAX_SAMPLES);
+    std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+    for (float& v : result) {
+        v = values[pick(rng)];
+    }
+    return result;
+}
+
+double resampledPercentile(const std::vector<float>& values, std::vector<float>& scratch,
+                           double p, std::mt19937_64& rng) {
+    std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+    for (float& v : scratch) {
+        v = values[pick(rng)];
+    }
+    return percentileInPlace(scratch, p);
+}
+
+} // namespace
+
+double percentileSorted(const std::vector<float>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    double rank = p / 100.0 * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(std::floor(rank));
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    double fraction = rank - lower;
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+double percentile(std::vector<float> values, double p) {
+    return percentileInPlace(values, p);
+}
+
+double percentileInPlace(std::vector<float>& values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    double rank = p / 100.0 * (values.size() - 1);
+    size_t lower = static_cast<size_t>(std::floor(rank));
+    std::nth_element(values.begin(), values.begin() + lower, values.end());
+    double lowerValue = values[lower];
+    if (lower + 1 >= values.size()) {
+        return lowerValue;
+    }
+    // Следующий по порядку элемент - минимум правой части
+    double upperValue = *std::min_element(values.begin() + lower + 1, values.end());
+    return lowerValue + (upperValue - lowerValue) * (rank - lower);
+}
+
+MannWhitneyResult mannWhitneyU(const std::vector<float>& a, const std::vector<float>& b) {
+    MannWhitneyResult result;
+    const double n1 = static_cast<double>(a.size());
+    const double n2 = static_cast<double>(b.size());
+    if (a.empty() || b.empty()) {
+        return result;
+    }
+
+    // Общий ранжированный массив, второй элемент пары - признак выборки b
+    std::vector<std::pair<float, bool>> combined;
+    combined.reserve(a.size() + b.size());
+    for (float v : a) combined.emplace_back(v, false);
+    for (float v : b) combined.emplace_back(v, true);
+    std::sort(combined.begin(), combined.end(),
+              [](const auto& l, const auto& r) { return l.first < r.first; });
+
+    double rankSumB = 0.0;
+    double tieCorrection = 0.0;
+    size_t i = 0;
+    while (i < combined.size()) {
+        size_t j = i;
+        while (j < combined.size() && combined[j].first == combined[i].first) {
+            ++j;
+        }
+        // Связанным значениям присваиваем средний ранг
+        double averageRank = (i + 1 + j) / 2.0;
+        double tieSize = static_cast<double>(j - i);
+        for (size_t k = i; k < j; ++k) {
+            if (combined[k].second) {
+                rankSumB += averageRank;
+            }
+        }
+        tieCorrection += tieSize * tieSize * tieSize - tieSize;
+        i = j;
+    }
+
+    const double n = n1 + n2;
+    result.u = rankSumB - n2 * (n2 + 1) / 2.0;
+    const double meanU = n1 * n2 / 2.0;
+    const double varianceU = n1 * n2 / 12.0 * ((n + 1) - tieCorrection / (n * (n - 1)));
+    if (varianceU > 0) {
+        // Поправка на непрерывность
+        double diff = result.u - meanU;
+        double corrected = std::max(0.0, std::fabs(diff) - 0.5);
+        result.z = std::copysign(corrected / std::sqrt(varianceU), diff);
+        result.pValue = std::erfc(std::fabs(result.z) / std::sqrt(2.0));
+    }
+    result.cliffsDelta = 2.0 * result.u / (n1 * n2) - 1.0;
+    return result;
+}
+
+ConfidenceInterval bootstrapPercentileDiff(const std::vector<float>& a, const std::vector<float>& b,
+                                           double p, double confidence, int iterations, uint64_t seed) {
+    ConfidenceInterval ci;
+    if (a.empty() || b.empty() || iterations <= 0) {
+        return ci;
+    }
+    ci.estimate = percentile(b, p) - percentile(a, p);
+
+    std::mt19937_64 rng(seed);
+    std::vector<float> sampleA = subsample(a, rng);
+    std::vector<float> sampleB = subsample(b, rng);
+    std::vector<float> scratchA(sampleA.size());
+    std::vector<float> scratchB(sampleB.size());
+
+    std::vector<float> diffs(iterations);
+    for (float& d : diffs) {
+        d = static_cast<float>(resampledPercentile(sampleB, scratchB, p, rng) -
+                               resampledPercentile(sampleA, scratchA, p, rng));
+    }
+    std::sort(diffs.begin(), diffs.end());
+
+    double tail = (1.0 - confidence) / 2.0 * 100.0;
+    ci.low = percentileSorted(diffs, tail);
+    ci.high = percentileSorted(diffs, 100.0 - tail);
+    return ci;
+}
+
+void FrameTimeReservoir::add(float ms) {
+    ++seen_;
+    totalMs_ += ms;
+    maxMs_ = std::max(maxMs_, ms);
+    if (samples_.size() < capacity_) {
+        samples_.push_back(ms);
+        return;
+    }
+    uint64_t slot = std::uniform_int_distribution<uint64_t>(0, seen_ - 1)(rng_);
+    if (slot < capacity_) {
+        samples_[slot] = ms;
+    }
+}
+
+void FrameTimeHistogram::merge(const FrameTimeHistogram& other) {
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+}
+
+double FrameTimeHistogram::upperBoundMs(int bucket) {
+    return MIN_MS * std::pow(10.0, static_cast<double>(bucket + 1) / BUCKETS_PER_DECADE);
+}
+
+int FrameTimeHistogram::bucketIndex(double ms) {
+    // Границы считаем один раз: add() вызывается для каждого кадра многочасовых трасс
+    static const std::array<double, BUCKET_COUNT> bounds = [] {
+        std::array<double, BUCKET_COUNT> result {};
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            result[i] = upperBoundMs(i);
+        }
+        return result;
+    }();
+
+    double ratio = ms / MIN_MS;
+    if (!(ratio > 1.0)) {
+        return 0;
+    }
+    // Грубый log2 по экспоненте и линейной мантиссе (ошибка меньше корзины),
+    // затем уточнение по таблице границ
+    int exponent = 0;
+    double mantissa = std::frexp(ratio, &exponent);
+    double log2Ratio = exponent - 2.0 + 2.0 * mantissa;
+    int index = static_cast<int>(log2Ratio * (BUCKETS_PER_DECADE / 3.321928094887362));
+    index = std::clamp(index, 0, BUCKET_COUNT - 1);
+    while (index < BUCKET_COUNT - 1 && ms >= bounds[index]) {
+        ++index;
+    }
+    while (index > 0 && ms < bounds[index - 1]) {
+        --index;
+    }
+    return index;
+}
+
+double FrameTimeHistogram::percentile(double p) const {
+    if (total_ == 0) {
+        return 0.0;
+    }
+    // Ранг как у percentileSorted, внутри корзины интерполируем по логарифму
+    double rank = p / 100.0 * (total_ - 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        if (counts_[i] == 0) {
+            continue;
+        }
+        if (rank < seen + counts_[i]) {
+            double lower = i == 0 ? MIN_MS : upperBoundMs(i - 1);
+            double upper = upperBoundMs(i);
+            double fraction = (rank - seen + 0.5) / counts_[i];
+            return lower * std::pow(upper / lower, fraction);
+        }
+        seen += counts_[i];
+    }
+    return upperBoundMs(BUCKET_COUNT - 1);
+}
+
+FrameTimeHistogram FrameTimeHistogram::fromCounts(const std::vector<uint64_t>& counts) {
+    FrameTimeHistogram histogram;
+    for (size_t i = 0; i < counts.size() && i < histogram.counts_.size(); ++i) {
+        histogram.counts_[i] = counts[i];
+        histogram.total_ += counts[i];
+    }
+    return histogram;
+}
+
+std::vector<unsigned char> encodeHistogram(const FrameTimeHistogram& histogram) {
+    const auto& counts = histogram.counts();
+    int first = 0;
+    int last = static_cast<int>(counts.size()) - 1;
+    while (first <= last && counts[first] == 0) ++first;
+    while (last >= first && counts[last] == 0) --last;
+
+    std::vector<unsigned char> data;
+    if (first > last) {
+        return data;
+    }
+    data.push_back(static_cast<unsigned char>(first & 0xFF));
+    data.push_back(static_cast<unsigned char>(first >> 8));
+    for (int i = first; i <= last; ++i) {
+        for (int b = 0; b < 8; ++b) {
+            data.push_back(static_cast<unsigned char>(counts[i] >> (8 * b)));
+        }
+    }
+    return data;
+}
+
+FrameTimeHistogram decodeHistogram(const std::vector<unsigned char>& data) {
+    std::vector<uint64_t> counts(FrameTimeHistogram::BUCKET_COUNT, 0);
+    if (data.size() >= 2) {
+        size_t first = data[0] | (data[1] << 8);
+        for (size_t offset = 2, i = first; offset + 8 <= data.size() && i < counts.size(); offset += 8, ++i) {
+            uint64_t value = 0;
+            for (int b = 0; b < 8; ++b) {
+                value |= static_cast<uint64_t>(data[offset + b]) << (8 * b);
+            }
+            counts[i] = value;
+        }
+    }
+    return FrameTimeHistogram::fromCounts(counts);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Перцентиль (0..100) по отсортированным данным с линейной интерполяцией
+[[nodiscard]] double percentileSorted(const std::vector<float>& sorted, double p);
+
+// Перцентиль по несортированным данным (копирует и частично сортирует)
+[[nodiscard]] double percentile(std::vector<float> values, double p);
+
+// То же без копии, порядок элементов values меняется
+[[nodiscard]] double percentileInPlace(std::vector<float>& values, double p);
+
+struct MannWhitneyResult {
+    double u = 0.0;           // U статистика для второй выборки
+    double z = 0.0;
+    double pValue = 1.0;      // Двусторонний, нормальное приближение с поправкой на связи
+    double cliffsDelta = 0.0; // > 0 - значения второй выборки чаще больше первой
+};
+
+// Критерий Манна-Уитни для выборок a (базовая) и b (текущая)
+[[nodiscard]] MannWhitneyResult mannWhitneyU(const std::vector<float>& a, const std::vector<float>& b);
+
+struct ConfidenceInterval {
+    double estimate = 0.0;
+    double low = 0.0;
+    double high = 0.0;
+};
+
+// Бутстреп доверительный интервал разности перцентилей p(b) - p(a)
+[[nodiscard]] ConfidenceInterval bootstrapPercentileDiff(const std::vector<float>& a, const std::vector<float>& b,
+                                                         double p, double confidence,
+                                                         int iterations = 1000, uint64_t seed = 1);
+
+// Равномерная выборка времени кадра постоянного размера (алгоритм R): после
+// заполнения новый кадр заменяет случайный с вероятностью capacity / seen.
+// Память не растет на суточных прогонах, а критерии сравнения считаются по
+// выборке. Сумма и максимум - по всем кадрам
+class FrameTimeReservoir {
+public:
+    // 400 KB, до этого числа кадров выборка - все кадры
+    static constexpr size_t DEFAULT_CAPACITY = 100000;
+
+    explicit FrameTimeReservoir(size_t capacity = DEFAULT_CAPACITY, uint64_t seed = 1)
+        : capacity_(capacity), rng_(seed) {}
+
+    void add(float ms);
+
+    [[nodiscard]] uint64_t seen() const { return seen_; }
+    [[nodiscard]] double totalMs() const { return totalMs_; }
+    [[nodiscard]] float maxMs() const { return maxMs_; }
+    [[nodiscard]] const std::vector<float>& samples() const { return samples_; }
+    // Забирает выборку, счетчики остаются
+    [[nodiscard]] std::vector<float> release() { return std::move(samples_); }
+
+private:
+    size_t capacity_;
+    uint64_t seen_ = 0;
+    double totalMs_ = 0.0;
+    float maxMs_ = 0.0f;
+    std::vector<float> samples_;
+    std::mt19937_64 rng_;
+};
+
+// Гистограмма времени кадра с логарифмическими корзинами от 0.01 мс до 10 с.
+// Точность перцентиля - ширина корзины (около 6%), зато размер постоянный
+class FrameTimeHistogram {
+public:
+    static constexpr int BUCKETS_PER_DECADE = 40;
+    static constexpr int DECADES = 6;
+    static constexpr double MIN_MS = 0.01;
+    // Последняя корзина собирает все, что больше 10 с
+    static constexpr int BUCKET_COUNT = BUCKETS_PER_DECADE * DECADES + 1;
+
+    FrameTimeHistogram() : counts_(BUCKET_COUNT, 0) {}
+
+    void add(double ms) { ++counts_[bucketIndex(ms)]; ++total_; }
+    void merge(const FrameTimeHistogram& other);
+
+    [[nodiscard]] uint64_t total() const { return total_; }
+    [[nodiscard]] const std::vector<uint64_t>& counts() const { return counts_; }
+    [[nodiscard]] double percentile(double p) const;
+
+    // Верхняя граница корзины в миллисекундах
+    [[nodiscard]] static double upperBoundMs(int bucket);
+    [[nodiscard]] static int bucketIndex(double ms);
+
+    // Восстановление из сохраненных счетчиков
+    [[nodiscard]] static FrameTimeHistogram fromCounts(const std::vector<uint64_t>& counts);
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+};
+
+// Гистограмма в базе результатов: номер первой непустой корзины (uint16)
+// и счетчики uint64 до последней непустой, little-endian
+[[nodiscard]] std::vector<unsigned char> encodeHistogram(const FrameTimeHistogram& histogram);
+[[nodiscard]] FrameTimeHistogram decodeHistogram(const std::vector<unsigned char>& data);
@@ -0,0 +1,176 @@
+#include "stream_buffer.h"
+
+#include <GL/glew.h>
+
+#include "gl_dsa.h"
+#include "gl_intercept.h"
+#include "gl_state.h"
+#include "gles_context.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1000000000;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+} // namespace
+
+void StreamBuffer::init(size_t frameSize) {
+    destroy();
+    frameSize_ = alignUp(frameSize, 256);
+    // При записи потока команд записи в постоянное отображение не видны,
+    // пустому бэкенду отображать нечего. На ES то же дает GL_EXT_buffer_storage
+    persistent_ = (GLEW_ARB_buffer_storage || glesContext.bufferStorage()) && !glCapture.recording() && !nullBackend.active();
+    dsa_ = glDsa.enabled();
+    glDsa.createBuffers(1, &buffer_);
+    if (dsa_) {
+        // Те же шаги по имени буфера, привязка GL_ARRAY_BUFFER не меняется
+        if (persistent_) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glNamedBufferStorage(buffer_, frameSize_ * FRAMES_IN_FLIGHT, nullptr, flags);
+            mapped_ = static_cast<uint8_t*>(glMapNamedBufferRange(buffer_, 0, frameSize_ * FRAMES_IN_FLIGHT, flags));
+            if (!mapped_) {
+                glDeleteBuffers(1, &buffer_);
+                glDsa.createBuffers(1, &buffer_);
+                persistent_ = false;
+            }
+        }
+        if (!persistent_) {
+            glNamedBufferData(buffer_, frameSize_, nullptr, GL_STREAM_DRAW);
+        }
+        region_ = 0;
+        cursor_ = 0;
+        return;
+    }
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, buffer_);
+    if (persistent_) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, frameSize_ * FRAMES_IN_FLIGHT, nullptr, flags);
+        mapped_ = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, frameSize_ * FRAMES_IN_FLIGHT, flags));
+        if (!mapped_) {
+            // Драйвер объявил расширение, но отобразить не смог - пересоздаем буфер
+            glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &buffer_);
+            glGenBuffers(1, &buffer_);
+            glState.bindBuffer(GL_ARRAY_BUFFER, buffer_);
+            persistent_ = false;
+        }
+    }
+    if (!persistent_) {
+        glBufferData(GL_ARRAY_BUFFER, frameSize_, nullptr, GL_STREAM_DRAW);
+    }
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+    region_ = 0;
+    cursor_ = 0;
+}
+
+void StreamBuffer::destroy() {
+    if (buffer_ == 0) {
+        return;
+    }
+    for (void*& fence : fences_) {
+        if (fence) {
+            glDeleteSync(static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+    }
+    if (mapped_ && dsa_) {
+        glUnmapNamedBuffer(buffer_);
+        mapped_ = nullptr;
+    } else if (mapped_) {
+        glState.bindBuffer(GL_ARRAY_BUFFER, buffer_);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        mapped_ = nullptr;
+    }
+    // Удаление привязанного буфера сбрасывает привязку в обход кэша
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+}
+
+void StreamBuffer::beginFrame() {
+    if (buffer_ == 0) {
+        return;
+    }
+    cursor_ = 0;
+    if (!persistent_ && dsa_) {
+        glNamedBufferData(buffer_, frameSize_, nullptr, GL_STREAM_DRAW);
+        return;
+    }
+    if (!persistent_) {
+        // Сиротим хранилище: драйвер выдаст новое, не дожидаясь GPU
+        // Буфер остается привязанным: кэш состояния пропустит повторные привязки
+        glState.bindBuffer(GL_ARRAY_BUFFER, buffer_);
+        glBufferData(GL_ARRAY_BUFFER, frameSize_, nullptr, GL_STREAM_DRAW);
+        return;
+    }
+
+    region_ = (region_ + 1) % FRAMES_IN_FLIGHT;
+    if (void* fence = fences_[region_]) {
+        GLsync sync = static_cast<GLsync>(fence);
+        if (glClientWaitSync(sync, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++fenceWaits_;
+            while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS) == GL_TIMEOUT_EXPIRED) {
+            }
+        }
+        glDeleteSync(sync);
+        fences_[region_] = nullptr;
+    }
+}
+
+void StreamBuffer::endFrame() {
+    if (buffer_ == 0 || !persistent_) {
+        return;
+    }
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* StreamBuffer::map(size_t size, size_t alignment, size_t& offset) {
+    size_t start = alignUp(cursor_, alignment);
+    if (buffer_ == 0 || start + size > frameSize_) {
+        return nullptr;
+    }
+    cursor_ = start + size;
+
+    if (persistent_) {
+        offset = static_cast<size_t>(region_) * frameSize_ + start;
+        glCalls.countMappedWrite(size);
+        return mapped_ + offset;
+    }
+    offset = start;
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (dsa_) {
+        return glMapNamedBufferRange(buffer_, offset, size, access);
+    }
+    glState.bindBuffer(GL_ARRAY_BUFFER, buffer_);
+    void* pointer = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, access);
+    return pointer;
+}
+
+void StreamBuffer::unmap() {
+    if (persistent_ || buffer_ == 0) {
+        return;
+    }
+    if (dsa_) {
+        glUnmapNamedBuffer(buffer_);
+        return;
+    }
+    glState.bindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+size_t StreamBuffer::upload(const void* data, size_t size, size_t alignment) {
+    size_t offset = 0;
+    void* pointer = map(size, alignment, offset);
+    if (!pointer) {
+        return SIZE_MAX;
+    }
+    std::memcpy(pointer, data, size);
+    unmap();
+    return offset;
+}
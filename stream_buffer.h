@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Кольцевой буфер для данных, которые меняются каждый кадр (текст, график,
+// матрицы кубиков). С ARB_buffer_storage буфер отображен постоянно
+// (persistent + coherent) и поделен на регионы по кадрам: перед записью в
+// регион CPU ждет fence кадра, который его использовал. Без расширения
+// (чистый GL 3.3) буфер в начале кадра сиротится через glBufferData, а куски
+// внутри кадра отображаются без синхронизации - они не пересекаются. С DSA
+// (gl_dsa.h) буфер создается, сиротится и отображается по имени, без привязки
+class StreamBuffer {
+public:
+    static constexpr int FRAMES_IN_FLIGHT = 3;
+
+    // frameSize - байт на кадр
+    void init(size_t frameSize);
+    void destroy();
+
+    void beginFrame();
+    void endFrame();
+
+    // Место под size байт в регионе текущего кадра, смещение в буфере кратно
+    // alignment. nullptr - место в кадре кончилось. После записи нужен unmap()
+    void* map(size_t size, size_t alignment, size_t& offset);
+    void unmap();
+
+    // map, копирование и unmap. SIZE_MAX - место в кадре кончилось
+    size_t upload(const void* data, size_t size, size_t alignment);
+
+    [[nodiscard]] unsigned int buffer() const { return buffer_; }
+    [[nodiscard]] bool persistent() const { return persistent_; }
+    [[nodiscard]] size_t frameSize() const { return frameSize_; }
+    // Сколько раз CPU ждал, пока GPU освободит регион
+    [[nodiscard]] uint64_t fenceWaits() const { return fenceWaits_; }
+
+private:
+    unsigned int buffer_ = 0;
+    bool persistent_ = false;
+    bool dsa_ = false;
+    uint8_t* mapped_ = nullptr;
+    size_t frameSize_ = 0;
+    int region_ = 0;
+    size_t cursor_ = 0;
+    std::array<void*, FRAMES_IN_FLIGHT> fences_ {};
+    uint64_t fenceWaits_ = 0;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "gpu_timer.h"
+
+// Границы корзин гистограммы времени кадра для внешнего мониторинга, секунды
+constexpr double TELEMETRY_FRAME_BUCKETS[] = {
+    0.00025, 0.0005, 0.001, 0.002, 0.004, 0.008, 0.0166, 0.0333, 0.05, 0.1, 0.25, 0.5, 1.0
+};
+constexpr int TELEMETRY_FRAME_BUCKET_COUNT = sizeof(TELEMETRY_FRAME_BUCKETS) / sizeof(double);
+
+// Снимок метрик, который поток рендеринга публикует раз в секунду
+struct TelemetrySnapshot {
+    double uptimeSec = 0.0;
+    double fps = 0.0;
+    double fpsEstimate = 0.0;          // Оценка фильтра Калмана
+    double fpsErrorEstimate = 0.0;     // Дисперсия оценки
+    uint64_t frames = 0;               // Всего кадров с начала теста
+
+    // Некумулятивные счетчики, последняя корзина - больше TELEMETRY_FRAME_BUCKETS
+    uint64_t frameTimeBuckets[TELEMETRY_FRAME_BUCKET_COUNT + 1] = {};
+    double frameTimeSumSec = 0.0;
+
+    double gpuPassMs[GPU_PASS_COUNT] = {}; // Среднее за последнюю секунду, 0 - нет данных
+
+    int64_t vramTotalMB = -1;
+    int64_t vramUsedMB = -1;
+    double gpuTemperatureC = -1.0;
+    double gpuPowerW = -1.0;
+
+    void addFrameTime(double seconds) {
+        int bucket = 0;
+        while (bucket < TELEMETRY_FRAME_BUCKET_COUNT && seconds > TELEMETRY_FRAME_BUCKETS[bucket]) {
+            ++bucket;
+        }
+        ++frameTimeBuckets[bucket];
+        frameTimeSumSec += seconds;
+        ++frames;
+    }
+};
+
+// Seqlock с одним писателем: писатель никогда не ждет, читатель повторяет
+// чтение, если попал на запись. T копируется целиком, поэтому должен быть тривиальным.
+// Структура стандартной раскладки, её можно размещать в разделяемой памяти
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock payload must be trivially copyable");
+
+public:
+    void store(const T& value) {
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data_, &value, sizeof(T));
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // false - не удалось получить согласованную копию за maxAttempts попыток
+    bool load(T& out, int maxAttempts = 1000) const {
+        for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            std::memcpy(&out, &data_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] uint64_t sequence() const { return sequence_.load(std::memory_order_acquire); }
+
+private:
+    alignas(64) std::atomic<uint64_t> sequence_ {0};
+    alignas(64) T data_ {};
+};
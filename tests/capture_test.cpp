@@ -0,0 +1,166 @@
+// Разбор записи команд GL для replay: перевод имен в ячейки таблиц и отказ от
+// команд, данные которых не сходятся с аргументами
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "gl_capture_parser.h"
+
+namespace {
+
+// Поток в формате GlCapture: байт операции, zigzag varint аргументы, данные
+class StreamBuilder {
+public:
+    StreamBuilder& op(GlOp op, std::initializer_list<int64_t> args) {
+        stream_.push_back(static_cast<uint8_t>(op));
+        for (int64_t arg : args) {
+            varint((static_cast<uint64_t>(arg) << 1) ^ static_cast<uint64_t>(arg >> 63));
+        }
+        return *this;
+    }
+    StreamBuilder& data(GlOp code, std::initializer_list<int64_t> args, const void* bytes, size_t size) {
+        op(code, args);
+        varint(size);
+        auto* begin = static_cast<const uint8_t*>(bytes);
+        stream_.insert(stream_.end(), begin, begin + size);
+        return *this;
+    }
+    StreamBuilder& frame() { return op(GlOp::EndPrologue, {}).op(GlOp::Clear, {GL_COLOR_BUFFER_BIT}).op(GlOp::EndFrame, {}); }
+
+    bool parse(CaptureParser& parser, std::string& error) const {
+        CaptureReader reader(stream_.data(), stream_.size());
+        return parser.parse(reader, error);
+    }
+    bool parses() const {
+        CaptureParser parser;
+        std::string error;
+        return parse(parser, error);
+    }
+    std::vector<uint8_t>& bytes() { return stream_; }
+
+private:
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            stream_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        stream_.push_back(static_cast<uint8_t>(value));
+    }
+
+    std::vector<uint8_t> stream_;
+};
+
+void testValidStream() {
+    float matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    int32_t ranges[4] = {0, 36, 36, 36}; // first[], count[]
+    uint8_t vertices[16] = {};
+    const char uniform[] = "mvp";
+
+    StreamBuilder stream;
+    stream.op(GlOp::GenBuffer, {5})
+          .op(GlOp::BindBuffer, {GL_ARRAY_BUFFER, 5})
+          .data(GlOp::BufferData, {GL_ARRAY_BUFFER, 16, GL_STATIC_DRAW, 1}, vertices, sizeof(vertices))
+          .op(GlOp::CreateProgram, {7})
+          .data(GlOp::GetUniformLocation, {7, 3}, uniform, 3)
+          .op(GlOp::UseProgram, {7})
+          .op(GlOp::EndPrologue, {})
+          .data(GlOp::UniformMatrix4fv, {3, 1, 0}, matrix, sizeof(matrix))
+          .data(GlOp::MultiDrawArrays, {GL_TRIANGLES, 2}, ranges, sizeof(ranges))
+          .op(GlOp::EndFrame, {});
+    CaptureParser parser;
+    std::string error;
+    check(stream.parse(parser, error), "valid stream parses");
+    if (parser.commands.size() != 9) {
+        check(false, "valid stream command count");
+        return;
+    }
+    check(parser.prologueEnd == 6, "prologue ends at EndPrologue");
+    // Имена заменены ячейками: буфер - 1, программа - 2, uniform - 1
+    check(parser.commands[1].args[1] == 1 && parser.commands[5].args[0] == 2, "object names become slots");
+    check(parser.nameSlots == 3, "one slot per created object");
+    check(parser.commands[4].args[1] == 1 && parser.commands[6].args[0] == 1, "uniform location becomes a slot");
+    check(parser.locationDefaults.size() == 2 && parser.locationDefaults[1] == 3, "recorded location is the default");
+    const ReplayCommand& draw = parser.commands[7];
+    check(draw.size == sizeof(ranges) && std::memcmp(draw.data, ranges, sizeof(ranges)) == 0, "draw ranges are kept");
+    check(reinterpret_cast<uintptr_t>(parser.commands[6].data) % 8 == 0, "payload is 8-byte aligned");
+}
+
+void testTruncated() {
+    StreamBuilder noFrame;
+    noFrame.op(GlOp::GenBuffer, {1}).op(GlOp::EndPrologue, {});
+    check(!noFrame.parses(), "stream without a frame is rejected");
+
+    StreamBuilder cut;
+    cut.frame();
+    cut.op(GlOp::Viewport, {0, 0, 800, 800}).op(GlOp::EndFrame, {});
+    cut.bytes().resize(cut.bytes().size() - 3);
+    check(!cut.parses(), "truncated arguments are rejected");
+
+    StreamBuilder shortData;
+    uint8_t bytes[8] = {};
+    shortData.frame();
+    shortData.data(GlOp::BufferSubData, {GL_ARRAY_BUFFER, 0}, bytes, sizeof(bytes)).op(GlOp::EndFrame, {});
+    shortData.bytes().erase(shortData.bytes().end() - 5, shortData.bytes().end());
+    check(!shortData.parses(), "data past the end is rejected");
+
+    StreamBuilder unknown;
+    unknown.frame();
+    unknown.bytes().push_back(static_cast<uint8_t>(GlOp::Count));
+    check(!unknown.parses(), "unknown operation is rejected");
+}
+
+// Поток с одной командой с данными в кадре
+bool parsesWith(GlOp op, std::initializer_list<int64_t> args, size_t size, bool packedRows = false) {
+    std::vector<uint8_t> bytes(size);
+    StreamBuilder stream;
+    if (packedRows) {
+        stream.op(GlOp::PixelStorei, {GL_UNPACK_ALIGNMENT, 1});
+    }
+    stream.op(GlOp::EndPrologue, {}).data(op, args, bytes.data(), bytes.size()).op(GlOp::EndFrame, {});
+    return stream.parses();
+}
+
+void testPayloadSizes() {
+    check(parsesWith(GlOp::MultiDrawArrays, {GL_TRIANGLES, 3}, 3 * 2 * 4), "multi-draw arrays with matching ranges");
+    check(!parsesWith(GlOp::MultiDrawArrays, {GL_TRIANGLES, 4}, 3 * 2 * 4), "multi-draw arrays count past the data");
+    check(!parsesWith(GlOp::MultiDrawArrays, {GL_TRIANGLES, -1}, 0), "negative draw count");
+    check(parsesWith(GlOp::MultiDrawElements, {GL_TRIANGLES, GL_UNSIGNED_INT, 3}, 3 * 12), "multi-draw elements");
+    check(!parsesWith(GlOp::MultiDrawElements, {GL_TRIANGLES, GL_UNSIGNED_INT, 3}, 3 * 4), "multi-draw elements without offsets");
+
+    check(parsesWith(GlOp::Uniform3fv, {0, 2}, 2 * 12), "uniform vector array");
+    check(!parsesWith(GlOp::Uniform3fv, {0, 2}, 12), "uniform count past the data");
+    check(!parsesWith(GlOp::UniformMatrix4fv, {0, 1, 0}, 48), "short matrix");
+
+    check(parsesWith(GlOp::BufferData, {GL_ARRAY_BUFFER, 64, GL_STATIC_DRAW, 1}, 64), "buffer data");
+    check(parsesWith(GlOp::BufferData, {GL_ARRAY_BUFFER, 64, GL_STREAM_DRAW, 0}, 0), "buffer allocation without data");
+    check(!parsesWith(GlOp::BufferData, {GL_ARRAY_BUFFER, 64, GL_STATIC_DRAW, 1}, 32), "buffer size past the data");
+    check(!parsesWith(GlOp::BufferData, {GL_ARRAY_BUFFER, 64, GL_STREAM_DRAW, 0}, 64), "data for an allocation");
+    check(!parsesWith(GlOp::BufferSubData, {GL_ARRAY_BUFFER, -4}, 16), "negative buffer offset");
+
+    // 3x2 RGB: строки по 9 байт, при выравнивании 4 драйвер прочитает 12 + 9
+    check(parsesWith(GlOp::TexImage2D, {GL_TEXTURE_2D, 0, GL_RGBA, 4, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE}, 32),
+          "rgba texture");
+    check(parsesWith(GlOp::TexImage2D, {GL_TEXTURE_2D, 0, GL_RGBA, 4, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE}, 0),
+          "texture allocation without data");
+    check(!parsesWith(GlOp::TexImage2D, {GL_TEXTURE_2D, 0, GL_RGBA, 4, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE}, 16),
+          "texture size past the data");
+    check(!parsesWith(GlOp::TexImage2D, {GL_TEXTURE_2D, 0, GL_RGB, 3, 2, 0, GL_RGB, GL_UNSIGNED_BYTE}, 18),
+          "padded rows past the data");
+    check(parsesWith(GlOp::TexImage2D, {GL_TEXTURE_2D, 0, GL_RGB, 3, 2, 0, GL_RGB, GL_UNSIGNED_BYTE}, 18, true),
+          "packed rows with unpack alignment 1");
+    check(!parsesWith(GlOp::TexImage2D, {GL_TEXTURE_2D, 0, GL_RED, 1LL << 40, 1, 0, GL_RED, GL_UNSIGNED_BYTE}, 1),
+          "texture width out of range");
+}
+
+} // namespace
+
+void runCaptureTests() {
+    testValidStream();
+    testTruncated();
+    testPayloadSizes();
+}
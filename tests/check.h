@@ -0,0 +1,24 @@
+#pragma once
+
+// Общие для наборов проверок: провал печатается и считается, итог - в main
+#include <cmath>
+#include <iostream>
+
+inline int failures = 0;
+
+inline void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+inline bool near(double value, double expected, double tolerance) {
+    return std::fabs(value - expected) <= tolerance;
+}
+
+// Наборы, по одному на файл
+void runStatsTests();
+void runTraceTests();
+void runJsonTests();
+void runCaptureTests();
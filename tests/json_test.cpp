@@ -0,0 +1,75 @@
+// JSON управляющих протоколов: разбор по грамматике RFC 8259 и запись обратно
+#include <string>
+
+#include "check.h"
+#include "json.h"
+
+namespace {
+
+bool parses(const std::string& text) {
+    JsonValue value;
+    std::string error;
+    return parseJson(text, value, error);
+}
+
+JsonValue parsed(const std::string& text) {
+    JsonValue value;
+    std::string error;
+    parseJson(text, value, error);
+    return value;
+}
+
+void testRoundTrip() {
+    const char* text = R"({"method":"set_workload","params":{"name":"cube","cube_size":8,"cull":true},)"
+                       R"("list":[1,-2.5,1e+20,null,false,"x"],"id":1})";
+    JsonValue value = parsed(text);
+    check(value.isObject() && value.size() == 4, "object members");
+    check(value["params"]["cube_size"].asNumber() == 8 && value["params"]["cull"].asBool(), "nested values");
+    check(value["list"].size() == 6 && value["list"].items()[1].asNumber() == -2.5, "array values");
+    check(value["missing"].isNull() && !value.has("missing"), "missing member is null");
+    // Порядок полей сохраняется, поэтому запись совпадает с исходной строкой
+    check(parsed(value.dump()).dump() == value.dump(), "dump parses back to the same value");
+    check(JsonValue(0.1).dump() == "0.1" && JsonValue(1.0 / 3).dump() == "0.33333333333333331", "shortest exact number");
+    check(parsed(JsonValue(1.0 / 3).dump()).asNumber() == 1.0 / 3, "number round-trip");
+}
+
+void testNumbers() {
+    check(parses("0") && parses("-0") && parses("10") && parses("1.5e-3") && parses("2E+2"), "valid numbers");
+    check(!parses("0x1F") && !parses("-0x10"), "hex is rejected");
+    check(!parses("01") && !parses("-01"), "leading zeros are rejected");
+    check(!parses("-") && !parses("1.") && !parses(".5") && !parses("1e") && !parses("+1"), "incomplete numbers");
+    check(!parses("1e999") && !parses("inf") && !parses("nan"), "non-finite numbers");
+}
+
+void testStrings() {
+    check(parsed(R"("a\"b\\c\/d\n")").asString() == "a\"b\\c/d\n", "simple escapes");
+    check(parsed(R"("\u00e9\u20ac")").asString() == "\xC3\xA9\xE2\x82\xAC", "BMP escapes to UTF-8");
+    check(parsed(R"("\ud83d\ude00")").asString() == "\xF0\x9F\x98\x80", "surrogate pair");
+    check(!parses(R"("\ud83d")") && !parses(R"("\ud83dx")"), "lone high surrogate");
+    check(!parses(R"("\ud83d\u0041")"), "high surrogate followed by a non-surrogate");
+    check(!parses(R"("\ude00")"), "lone low surrogate");
+    check(!parses("\"a\tb\"") && !parses(std::string("\"a\0b\"", 5)), "unescaped control characters");
+    check(!parses(R"("\x")") && !parses(R"("\u12")") && !parses("\"abc"), "bad escapes and unterminated strings");
+
+    JsonValue text("line\n\ttab \x01 \"quoted\"");
+    check(parsed(text.dump()).asString() == text.asString(), "control characters are escaped on dump");
+}
+
+void testStructure() {
+    check(!parses("") && !parses("[1,]") && !parses("{\"a\":1,}") && !parses("{\"a\" 1}"), "malformed structure");
+    check(!parses("1 2") && !parses("{} x"), "trailing characters");
+    check(!parses("tru") && !parses("nul"), "truncated literals");
+    std::string deep(100, '[');
+    deep += std::string(100, ']');
+    check(!parses(deep), "nesting limit");
+    check(parses(" \t\r\n[ 1 , { } ]\n"), "whitespace between tokens");
+}
+
+} // namespace
+
+void runJsonTests() {
+    testRoundTrip();
+    testNumbers();
+    testStrings();
+    testStructure();
+}
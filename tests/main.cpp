@@ -0,0 +1,43 @@
+// Проверки без GL и окна. Без аргументов выполняются все наборы, иначе
+// только названный: так ctest показывает, какой набор упал
+#include <cstring>
+#include <iostream>
+
+#include "check.h"
+
+namespace {
+
+struct Suite {
+    const char* name;
+    void (*run)();
+};
+
+constexpr Suite SUITES[] = {
+    {"stats", runStatsTests},
+    {"trace", runTraceTests},
+    {"json", runJsonTests},
+    {"capture", runCaptureTests},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool found = false;
+    for (const Suite& suite : SUITES) {
+        if (argc < 2 || std::strcmp(argv[1], suite.name) == 0) {
+            int before = failures;
+            suite.run();
+            std::cout << suite.name << ": " << (failures == before ? "all checks passed" : "checks failed") << std::endl;
+            found = true;
+        }
+    }
+    if (!found) {
+        std::cerr << "unknown test suite: " << argv[1] << std::endl;
+        return 1;
+    }
+    if (failures > 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
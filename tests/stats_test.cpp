@@ -0,0 +1,167 @@
+// Проверки статистики сравнения прогонов по известным значениям. Эталоны
+// Манна-Уитни посчитаны вручную и совпадают с scipy.stats.mannwhitneyu
+// (method="asymptotic", use_continuity=True)
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "results.h"
+#include "stats.h"
+
+namespace {
+
+void testPercentile() {
+    std::vector<float> values = {4, 1, 3, 2};
+    check(near(percentile(values, 50.0), 2.5, 1e-9), "percentile p50 interpolates");
+    check(near(percentile(values, 99.0), 3.97, 1e-6), "percentile p99 interpolates");
+    check(near(percentile(values, 0.0), 1.0, 1e-9), "percentile p0 is min");
+    check(near(percentileSorted({1, 2, 3, 4}, 100.0), 4.0, 1e-9), "percentileSorted p100 is max");
+}
+
+void testMannWhitney() {
+    // Выборки не пересекаются: U = n1 * n2, дельта Клиффа 1
+    MannWhitneyResult separated = mannWhitneyU({1, 2, 3, 4, 5}, {6, 7, 8, 9, 10});
+    check(near(separated.u, 25.0, 1e-9), "mann-whitney U without ties");
+    check(near(separated.z, 2.506718, 1e-5), "mann-whitney z without ties");
+    check(near(separated.pValue, 0.0121858, 1e-6), "mann-whitney p without ties");
+    check(near(separated.cliffsDelta, 1.0, 1e-9), "cliff's delta without ties");
+
+    // Связи: средние ранги и поправка дисперсии
+    MannWhitneyResult ties = mannWhitneyU({1, 2, 2, 3}, {2, 3, 4, 4});
+    check(near(ties.u, 13.5, 1e-9), "mann-whitney U with ties");
+    check(near(ties.z, 1.497862, 1e-5), "mann-whitney z with ties");
+    check(near(ties.pValue, 0.1341692, 1e-6), "mann-whitney p with ties");
+    check(near(ties.cliffsDelta, 0.6875, 1e-9), "cliff's delta with ties");
+
+    MannWhitneyResult same = mannWhitneyU({5, 5, 5}, {5, 5});
+    check(same.pValue == 1.0 && same.z == 0.0, "mann-whitney on equal constants");
+}
+
+void testBootstrap() {
+    std::vector<float> a, b;
+    for (int i = 0; i < 1000; ++i) {
+        a.push_back(10.0f + i * 0.01f);
+        b.push_back(11.0f + i * 0.01f);
+    }
+    ConfidenceInterval shift = bootstrapPercentileDiff(a, b, 50.0, 0.99);
+    check(near(shift.estimate, 1.0, 1e-4), "bootstrap estimate of a shift");
+    check(shift.low > 0.0 && shift.low <= 1.0 && shift.high >= 1.0, "bootstrap interval covers the shift");
+
+    ConfidenceInterval constant = bootstrapPercentileDiff({2, 2, 2}, {3, 3, 3}, 99.0, 0.95);
+    check(near(constant.low, 1.0, 1e-9) && near(constant.high, 1.0, 1e-9), "bootstrap of constants is exact");
+}
+
+void testReservoir() {
+    FrameTimeReservoir small(1000);
+    for (int i = 1; i <= 100; ++i) {
+        small.add(static_cast<float>(i));
+    }
+    check(small.samples().size() == 100 && small.samples()[99] == 100.0f, "reservoir keeps all frames below capacity");
+
+    FrameTimeReservoir bounded(1000);
+    for (int i = 0; i < 100000; ++i) {
+        bounded.add(static_cast<float>(i));
+    }
+    check(bounded.samples().size() == 1000, "reservoir size is bounded");
+    check(bounded.seen() == 100000, "reservoir counts all frames");
+    check(near(bounded.totalMs(), 4999950000.0, 1.0), "reservoir sums all frames");
+    check(bounded.maxMs() == 99999.0f, "reservoir max over all frames");
+    // Среднее равномерной выборки: 50000 +- 5 стандартных ошибок
+    double sum = 0.0;
+    for (float v : bounded.samples()) {
+        sum += v;
+    }
+    check(near(sum / bounded.samples().size(), 50000.0, 5000.0), "reservoir sample is uniform");
+}
+
+void testHistogram() {
+    FrameTimeHistogram histogram;
+    for (int i = 0; i < 1000; ++i) {
+        histogram.add(5.0);
+    }
+    check(histogram.total() == 1000, "histogram total");
+    check(near(histogram.percentile(50.0), 5.0, 5.0 * 0.06), "histogram percentile within a bucket");
+}
+
+void testHistogramEncoding() {
+    FrameTimeHistogram histogram;
+    histogram.add(0.5);
+    histogram.add(16.6);
+    histogram.add(16.6);
+    histogram.add(1e6); // Последняя корзина
+    std::vector<unsigned char> data = encodeHistogram(histogram);
+    // Номер первой корзины и счетчики до последней непустой
+    int first = FrameTimeHistogram::bucketIndex(0.5);
+    check(data.size() == 2 + 8 * static_cast<size_t>(FrameTimeHistogram::BUCKET_COUNT - first),
+          "encoded histogram spans first to last non-empty bucket");
+    FrameTimeHistogram decoded = decodeHistogram(data);
+    check(decoded.counts() == histogram.counts(), "histogram round-trip keeps counts");
+    check(decoded.total() == 4, "histogram round-trip keeps total");
+
+    check(encodeHistogram(FrameTimeHistogram()).empty(), "empty histogram encodes to nothing");
+    check(decodeHistogram({}).total() == 0, "empty blob decodes to empty histogram");
+    // Оборванная запись: полные счетчики читаются, хвост отбрасывается
+    data.resize(2 + 8 + 3);
+    check(decodeHistogram(data).total() == 1, "truncated blob keeps complete counters");
+    // Первая корзина за пределами не читается за концом гистограммы
+    check(decodeHistogram({0xFF, 0xFF, 1, 0, 0, 0, 0, 0, 0, 0}).total() == 0, "out of range first bucket is ignored");
+}
+
+BenchmarkResults sampleRun(uint64_t seed, double medianShiftMs, double tailShiftMs) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<float> frame(10.0f, 0.5f);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    BenchmarkResults results;
+    for (int i = 0; i < 4000; ++i) {
+        float ms = frame(rng) + static_cast<float>(medianShiftMs);
+        // 5% кадров со спайками сдвигает P99, но не медиану
+        if (unit(rng) < 0.05) {
+            ms += 3.0f + static_cast<float>(tailShiftMs);
+        }
+        results.frameTimesMs.push_back(ms);
+    }
+    results.frames = results.frameTimesMs.size();
+    return results;
+}
+
+void testVerdict() {
+    BenchmarkResults baseline = sampleRun(1, 0.0, 0.0);
+    check(compareResults(baseline, sampleRun(2, 0.0, 0.0), 0.01, 2.0).verdict == Verdict::Unchanged,
+          "same distribution is unchanged");
+    check(compareResults(baseline, sampleRun(3, 0.0, 4.0), 0.01, 2.0).verdict == Verdict::Regressed,
+          "slower tail is a regression");
+    check(compareResults(sampleRun(4, 0.0, 4.0), sampleRun(5, 0.0, 0.0), 0.01, 2.0).verdict == Verdict::Improved,
+          "faster tail is an improvement");
+    check(compareResults(baseline, sampleRun(6, -1.0, 0.0), 0.01, 2.0).verdict == Verdict::Improved,
+          "faster median is an improvement");
+}
+
+void testConfiguration() {
+    BenchmarkResults baseline;
+    baseline.workload = "cube";
+    baseline.cubeSize = 3;
+    baseline.vertexFormat = "float";
+    baseline.backend = "gl";
+    baseline.resolution = "800x800";
+    BenchmarkResults current = baseline;
+    check(configurationDifferences(baseline, current).empty(), "same configuration is comparable");
+    check(runConfiguration(current) == "cube 3, float, gl, 800x800", "configuration string");
+
+    current.workload = "baked";
+    current.backend = "vulkan";
+    check(configurationDifferences(baseline, current).size() == 2, "workload and backend differences");
+    check(configurationDifferences(BenchmarkResults(), baseline).size() == 1, "old baseline without configuration");
+}
+
+} // namespace
+
+void runStatsTests() {
+    testPercentile();
+    testMannWhitney();
+    testBootstrap();
+    testReservoir();
+    testHistogram();
+    testHistogramEncoding();
+    testVerdict();
+    testConfiguration();
+}
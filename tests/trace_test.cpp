@@ -0,0 +1,184 @@
+// Формат трассы: varint, чанки и индекс после записи TraceWriter, поиск
+// чанков по оборванному или испорченному файлу
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "trace.h"
+#include "trace_format.h"
+
+namespace {
+
+constexpr uint64_t FRAME_COUNT = 2 * TRACE_FRAMES_PER_CHUNK + 100;
+const std::string DESCRIPTION = "trace test";
+
+void testVarint() {
+    const uint64_t values[] = {0, 1, 127, 128, 300, 1ull << 35, std::numeric_limits<uint64_t>::max()};
+    std::vector<unsigned char> encoded;
+    for (uint64_t value : values) {
+        appendVarint(encoded, value);
+    }
+    check(encoded.size() == 1 + 1 + 1 + 2 + 2 + 6 + 10, "varint sizes");
+    const unsigned char* p = encoded.data();
+    const unsigned char* end = encoded.data() + encoded.size();
+    bool same = true;
+    for (uint64_t value : values) {
+        same = same && readVarint(p, end) == value;
+    }
+    check(same && p == end, "varint round-trip");
+
+    // Оборванный varint не читается за концом буфера
+    std::vector<unsigned char> truncated = {0x80, 0x80};
+    p = truncated.data();
+    readVarint(p, truncated.data() + truncated.size());
+    check(p == truncated.data() + truncated.size(), "truncated varint stops at the end");
+}
+
+FrameRecord frameAt(uint64_t i) {
+    FrameRecord frame;
+    frame.frameIndex = i;
+    // 60 FPS с разбросом, каждый 1000-й кадр - спайк на секунды
+    frame.cpuStartNs = i * 16'600'000 + (i % 7) * 100'000 + (i / 1000) * 3'000'000'000ull;
+    frame.submitNs = frame.cpuStartNs + 2'000'000 + (i % 5) * 1000;
+    frame.swapEndNs = frame.submitNs + 500'000;
+    for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+        frame.gpuNs[pass] = (pass + 1) * 1'000'000 + i * 100;
+    }
+    frame.gpuResolved = true;
+    return frame;
+}
+
+std::vector<unsigned char> writeTrace() {
+    char path[] = "/tmp/rgbench_trace_testXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return {};
+    }
+    ::close(fd);
+    TraceWriter writer;
+    if (!writer.open(path, DESCRIPTION)) {
+        std::remove(path);
+        return {};
+    }
+    for (uint64_t i = 0; i < FRAME_COUNT; ++i) {
+        FrameRecord frame = frameAt(i);
+        writer.addFrame(frame);
+        writer.resolveGpu(i, frame.gpuNs);
+    }
+    writer.close();
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path);
+    return data;
+}
+
+// Все кадры чанков совпадают с записанными с точностью до тика
+bool framesMatch(const std::vector<ChunkRef>& chunks) {
+    uint64_t expected = 0;
+    for (const ChunkRef& chunk : chunks) {
+        if (chunk.firstFrame != expected) {
+            return false;
+        }
+        const unsigned char* p = chunk.payload;
+        const unsigned char* end = chunk.payload + chunk.byteSize;
+        uint64_t startTicks = chunk.baseTicks;
+        for (uint32_t i = 0; i < chunk.frameCount; ++i, ++expected) {
+            FrameRecord frame = frameAt(expected);
+            uint64_t start = frame.cpuStartNs / TRACE_TICK_NS;
+            uint64_t submit = frame.submitNs / TRACE_TICK_NS;
+            startTicks += readVarint(p, end);
+            if (startTicks != start || readVarint(p, end) != submit - start ||
+                readVarint(p, end) != frame.swapEndNs / TRACE_TICK_NS - submit) {
+                return false;
+            }
+            for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+                if (readVarint(p, end) != frame.gpuNs[pass] / TRACE_TICK_NS) {
+                    return false;
+                }
+            }
+        }
+        if (p != end) {
+            return false;
+        }
+    }
+    return expected == FRAME_COUNT;
+}
+
+void store(std::vector<unsigned char>& data, size_t offset, uint64_t value) {
+    std::memcpy(data.data() + offset, &value, sizeof(value));
+}
+
+uint64_t loadU64(const std::vector<unsigned char>& data, size_t offset) {
+    uint64_t value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+void testRoundTrip(const std::vector<unsigned char>& data, size_t firstChunk) {
+    std::vector<ChunkRef> indexed = readIndex(data.data(), data.size(), firstChunk);
+    check(indexed.size() == 3, "index lists every chunk");
+    check(!indexed.empty() && indexed.back().frameCount == 100, "last chunk holds the remainder");
+    check(framesMatch(indexed), "frames round-trip through the index");
+
+    std::vector<ChunkRef> scanned = scanChunks(data.data(), data.size(), firstChunk);
+    check(scanned.size() == 3 && framesMatch(scanned), "scan finds the same chunks as the index");
+}
+
+void testRecovery(const std::vector<unsigned char>& data, size_t firstChunk) {
+    // Запись оборвалась до индекса
+    std::vector<unsigned char> noIndex(data.begin(), data.end() - static_cast<std::ptrdiff_t>(TRAILER_SIZE));
+    check(readIndex(noIndex.data(), noIndex.size(), firstChunk).empty(), "missing trailer drops the index");
+    check(framesMatch(scanChunks(noIndex.data(), noIndex.size(), firstChunk)), "scan recovers all chunks");
+
+    // Оборван последний чанк: находятся только целые
+    std::vector<ChunkRef> chunks = readIndex(data.data(), data.size(), firstChunk);
+    size_t cut = static_cast<size_t>(chunks.back().payload - data.data()) + chunks.back().byteSize / 2;
+    std::vector<unsigned char> partial(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(cut));
+    check(scanChunks(partial.data(), partial.size(), firstChunk).size() == 2, "scan skips a truncated chunk");
+
+    size_t indexOffset = static_cast<size_t>(loadU64(data, data.size() - TRAILER_SIZE));
+
+    // Смещение чанка в индексе указывает не на чанк
+    std::vector<unsigned char> badOffset = data;
+    store(badOffset, indexOffset, loadU64(data, indexOffset) + 1);
+    check(readIndex(badOffset.data(), badOffset.size(), firstChunk).empty(), "bad chunk offset drops the index");
+
+    // Размер чанка выходит за индекс
+    std::vector<unsigned char> badSize = data;
+    uint32_t hugeSize = std::numeric_limits<uint32_t>::max();
+    std::memcpy(badSize.data() + indexOffset + 28, &hugeSize, sizeof(hugeSize));
+    check(readIndex(badSize.data(), badSize.size(), firstChunk).empty(), "oversized chunk drops the index");
+
+    // Число записей не сходится с размером индекса, в том числе с переполнением
+    std::vector<unsigned char> badCount = data;
+    store(badCount, data.size() - TRAILER_SIZE + 8, std::numeric_limits<uint64_t>::max() / INDEX_ENTRY_SIZE + 2);
+    check(readIndex(badCount.data(), badCount.size(), firstChunk).empty(), "bad entry count drops the index");
+
+    std::vector<unsigned char> badIndexOffset = data;
+    store(badIndexOffset, data.size() - TRAILER_SIZE, data.size());
+    check(readIndex(badIndexOffset.data(), badIndexOffset.size(), firstChunk).empty(), "index past the end is ignored");
+    check(scanChunks(badIndexOffset.data(), badIndexOffset.size(), firstChunk).size() == 3,
+          "scan stops at the index after the last chunk");
+}
+
+} // namespace
+
+void runTraceTests() {
+    testVarint();
+    std::vector<unsigned char> data = writeTrace();
+    size_t firstChunk = HEADER_FIXED_SIZE + DESCRIPTION.size();
+    check(data.size() > firstChunk + TRAILER_SIZE && std::memcmp(data.data(), TRACE_MAGIC, 8) == 0, "trace written");
+    if (data.size() <= firstChunk + TRAILER_SIZE) {
+        return;
+    }
+    testRoundTrip(data, firstChunk);
+    testRecovery(data, firstChunk);
+}
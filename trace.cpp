@@ -0,0 +1,496 @@
+#include "trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "stats.h"
+#include "trace_format.h"
+
+namespace {
+
+template <typename T>
+void append(std::vector<unsigned char>& out, T value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T load(const unsigned char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+inline uint64_t toTicks(uint64_t ns) {
+    return ns / TRACE_TICK_NS;
+}
+
+inline double ticksToMs(uint64_t ticks) {
+    return ticks * (TRACE_TICK_NS / 1e6);
+}
+
+// Накопитель статистики одной величины
+struct MetricStats {
+    FrameTimeHistogram histogram;
+    double sumMs = 0.0;
+    double maxMs = 0.0;
+
+    void add(double ms) {
+        histogram.add(ms);
+        sumMs += ms;
+        maxMs = std::max(maxMs, ms);
+    }
+
+    void merge(const MetricStats& other) {
+        histogram.merge(other.histogram);
+        sumMs += other.sumMs;
+        maxMs = std::max(maxMs, other.maxMs);
+    }
+};
+
+struct WindowStats {
+    FrameTimeHistogram histogram;
+    double sumMs = 0.0;
+    double maxMs = 0.0;
+};
+
+enum TraceMetric { METRIC_FRAME, METRIC_CPU, METRIC_SWAP, METRIC_GPU_FIRST, METRIC_COUNT = METRIC_GPU_FIRST + GPU_PASS_COUNT };
+
+struct TraceStats {
+    std::array<MetricStats, METRIC_COUNT> metrics;
+    std::vector<WindowStats> windows;
+    uint64_t frames = 0;
+    uint64_t lastTicks = 0;
+
+    void merge(TraceStats& other) {
+        for (int i = 0; i < METRIC_COUNT; ++i) {
+            metrics[i].merge(other.metrics[i]);
+        }
+        if (windows.size() < other.windows.size()) {
+            windows.resize(other.windows.size());
+        }
+        for (size_t i = 0; i < other.windows.size(); ++i) {
+            windows[i].histogram.merge(other.windows[i].histogram);
+            windows[i].sumMs += other.windows[i].sumMs;
+            windows[i].maxMs = std::max(windows[i].maxMs, other.windows[i].maxMs);
+        }
+        frames += other.frames;
+        lastTicks = std::max(lastTicks, other.lastTicks);
+    }
+};
+
+void decodeChunk(const ChunkRef& chunk, uint64_t windowTicks, TraceStats& stats) {
+    const unsigned char* p = chunk.payload;
+    const unsigned char* end = chunk.payload + chunk.byteSize;
+    uint64_t startTicks = chunk.baseTicks;
+
+    for (uint32_t i = 0; i < chunk.frameCount && p < end; ++i) {
+        uint64_t frameTicks = readVarint(p, end);
+        uint64_t submitTicks = readVarint(p, end);
+        uint64_t swapTicks = readVarint(p, end);
+        startTicks += frameTicks;
+
+        // У самого первого кадра трассы нет предыдущего, его длительность не считаем
+        if (chunk.firstFrame + i > 0) {
+            double frameMs = ticksToMs(frameTicks);
+            stats.metrics[METRIC_FRAME].add(frameMs);
+
+            size_t window = static_cast<size_t>(startTicks / windowTicks);
+            if (window >= stats.windows.size()) {
+                stats.windows.resize(window + 1);
+            }
+            WindowStats& w = stats.windows[window];
+            w.histogram.add(frameMs);
+            w.sumMs += frameMs;
+            w.maxMs = std::max(w.maxMs, frameMs);
+        }
+        stats.metrics[METRIC_CPU].add(ticksToMs(submitTicks));
+        stats.metrics[METRIC_SWAP].add(ticksToMs(swapTicks));
+        for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+            uint64_t gpuTicks = readVarint(p, end);
+            if (gpuTicks > 0) {
+                stats.metrics[METRIC_GPU_FIRST + pass].add(ticksToMs(gpuTicks));
+            }
+        }
+        ++stats.frames;
+    }
+    stats.lastTicks = std::max(stats.lastTicks, startTicks);
+}
+
+std::string formatDuration(double seconds) {
+    int total = static_cast<int>(seconds);
+    std::stringstream ss;
+    ss << std::setfill('0') << std::setw(2) << total / 3600 << ":" << std::setw(2) << (total / 60) % 60
+       << ":" << std::setw(2) << total % 60;
+    return ss.str();
+}
+
+void printMetricRow(const char* name, const MetricStats& m) {
+    uint64_t count = m.histogram.total();
+    if (count == 0) {
+        return;
+    }
+    // Интерполяция внутри корзины может выйти за максимум
+    auto p = [&m](double percent) { return std::min(m.histogram.percentile(percent), m.maxMs); };
+    std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << m.sumMs / count
+              << std::setw(10) << p(50.0)
+              << std::setw(10) << p(90.0)
+              << std::setw(10) << p(99.0)
+              << std::setw(10) << p(99.9)
+              << std::setw(10) << m.maxMs << std::endl;
+}
+
+} // namespace
+
+std::vector<ChunkRef> scanChunks(const unsigned char* data, size_t size, size_t offset) {
+    std::vector<ChunkRef> chunks;
+    while (offset + CHUNK_HEADER_SIZE <= size && load<uint32_t>(data + offset) == CHUNK_MAGIC) {
+        ChunkRef chunk {};
+        chunk.frameCount = load<uint32_t>(data + offset + 4);
+        chunk.byteSize = load<uint32_t>(data + offset + 8);
+        chunk.firstFrame = load<uint64_t>(data + offset + 16);
+        chunk.baseTicks = load<uint64_t>(data + offset + 24);
+        chunk.payload = data + offset + CHUNK_HEADER_SIZE;
+        if (offset + CHUNK_HEADER_SIZE + chunk.byteSize > size) {
+            break;
+        }
+        chunks.push_back(chunk);
+        offset += CHUNK_HEADER_SIZE + chunk.byteSize;
+    }
+    return chunks;
+}
+
+// Индекс в конце файла. Смещения и размеры проверяются по файлу до
+// использования: чанк лежит между заголовком и индексом и начинается с
+// CHUNK_MAGIC. Испорченный индекс отбрасывается целиком, тогда чанки ищет scanChunks
+std::vector<ChunkRef> readIndex(const unsigned char* data, size_t size, size_t firstChunk) {
+    std::vector<ChunkRef> chunks;
+    if (size < firstChunk + TRAILER_SIZE || std::memcmp(data + size - 8, INDEX_MAGIC, 8) != 0) {
+        return chunks;
+    }
+    uint64_t indexOffset = load<uint64_t>(data + size - TRAILER_SIZE);
+    uint64_t entries = load<uint64_t>(data + size - TRAILER_SIZE + 8);
+    // Без умножения: entries из файла может переполнить произведение
+    if (indexOffset < firstChunk || indexOffset > size - TRAILER_SIZE ||
+        (size - TRAILER_SIZE - indexOffset) % INDEX_ENTRY_SIZE != 0 ||
+        (size - TRAILER_SIZE - indexOffset) / INDEX_ENTRY_SIZE != entries) {
+        return chunks;
+    }
+    chunks.reserve(entries);
+    for (uint64_t i = 0; i < entries; ++i) {
+        const unsigned char* entry = data + indexOffset + i * INDEX_ENTRY_SIZE;
+        ChunkRef chunk {};
+        uint64_t offset = load<uint64_t>(entry);
+        chunk.firstFrame = load<uint64_t>(entry + 8);
+        chunk.baseTicks = load<uint64_t>(entry + 16);
+        chunk.frameCount = load<uint32_t>(entry + 24);
+        chunk.byteSize = load<uint32_t>(entry + 28);
+        if (offset < firstChunk || offset > indexOffset || indexOffset - offset < CHUNK_HEADER_SIZE ||
+            chunk.byteSize > indexOffset - offset - CHUNK_HEADER_SIZE ||
+            load<uint32_t>(data + offset) != CHUNK_MAGIC) {
+            return {};
+        }
+        chunk.payload = data + offset + CHUNK_HEADER_SIZE;
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string& path, const std::string& description) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+
+    std::vector<unsigned char> header(TRACE_MAGIC, TRACE_MAGIC + 8);
+    append<uint32_t>(header, TRACE_VERSION);
+    append<uint32_t>(header, static_cast<uint32_t>(TRACE_TICK_NS));
+    append<uint32_t>(header, TRACE_FRAMES_PER_CHUNK);
+    append<uint32_t>(header, GPU_PASS_COUNT);
+    append<uint64_t>(header, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+    append<uint32_t>(header, static_cast<uint32_t>(description.size()));
+    header.insert(header.end(), description.begin(), description.end());
+    std::fwrite(header.data(), 1, header.size(), file_);
+    offset_ = header.size();
+
+    chunk_.reserve(TRACE_FRAMES_PER_CHUNK);
+    stop_ = false;
+    thread_ = std::thread(&TraceWriter::writerLoop, this);
+    return true;
+}
+
+void TraceWriter::addFrame(const FrameRecord& record) {
+    if (!file_) {
+        return;
+    }
+    pending_.push_back(record);
+    flushReady(false);
+}
+
+void TraceWriter::resolveGpu(uint64_t frameIndex, const GpuPassTimes& times) {
+    if (pending_.empty() || frameIndex < pending_.front().frameIndex) {
+        return;
+    }
+    size_t position = frameIndex - pending_.front().frameIndex;
+    if (position < pending_.size()) {
+        pending_[position].gpuNs = times;
+        pending_[position].gpuResolved = true;
+    }
+    flushReady(false);
+}
+
+void TraceWriter::flushReady(bool all) {
+    // Кадры без результата GPU дольше, чем живут запросы таймера, пишем с нулевым временем GPU
+    while (!pending_.empty() &&
+           (all || pending_.front().gpuResolved || pending_.size() > GpuTimer::FRAMES_IN_FLIGHT + 2)) {
+        chunk_.push_back(pending_.front());
+        pending_.pop_front();
+        if (chunk_.size() == TRACE_FRAMES_PER_CHUNK) {
+            submitChunk();
+        }
+    }
+}
+
+void TraceWriter::submitChunk() {
+    if (chunk_.empty()) {
+        return;
+    }
+    std::vector<FrameRecord> full;
+    full.reserve(TRACE_FRAMES_PER_CHUNK);
+    full.swap(chunk_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(full));
+    }
+    cv_.notify_one();
+}
+
+void TraceWriter::close() {
+    if (!file_) {
+        return;
+    }
+    flushReady(true);
+    submitChunk();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+
+    std::vector<unsigned char> footer;
+    uint64_t indexOffset = offset_;
+    for (const ChunkIndexEntry& entry : index_) {
+        append<uint64_t>(footer, entry.offset);
+        append<uint64_t>(footer, entry.firstFrame);
+        append<uint64_t>(footer, entry.baseTicks);
+        append<uint32_t>(footer, entry.frameCount);
+        append<uint32_t>(footer, entry.byteSize);
+    }
+    append<uint64_t>(footer, indexOffset);
+    append<uint64_t>(footer, index_.size());
+    footer.insert(footer.end(), INDEX_MAGIC, INDEX_MAGIC + 8);
+    std::fwrite(footer.data(), 1, footer.size(), file_);
+
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void TraceWriter::writerLoop() {
+    for (;;) {
+        std::vector<FrameRecord> frames;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            frames = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        writeChunk(frames);
+    }
+}
+
+void TraceWriter::writeChunk(const std::vector<FrameRecord>& frames) {
+    encoded_.clear();
+    uint64_t baseTicks = lastStartTicks_;
+    uint64_t previous = lastStartTicks_;
+    for (const FrameRecord& frame : frames) {
+        uint64_t start = toTicks(frame.cpuStartNs);
+        uint64_t submit = toTicks(frame.submitNs);
+        uint64_t swapEnd = toTicks(frame.swapEndNs);
+        appendVarint(encoded_, start - previous);
+        appendVarint(encoded_, submit - start);
+        appendVarint(encoded_, swapEnd - submit);
+        for (uint64_t gpu : frame.gpuNs) {
+            appendVarint(encoded_, toTicks(gpu));
+        }
+        previous = start;
+    }
+    lastStartTicks_ = previous;
+
+    std::vector<unsigned char> header;
+    append<uint32_t>(header, CHUNK_MAGIC);
+    append<uint32_t>(header, static_cast<uint32_t>(frames.size()));
+    append<uint32_t>(header, static_cast<uint32_t>(encoded_.size()));
+    append<uint32_t>(header, 0);
+    append<uint64_t>(header, frames.front().frameIndex);
+    append<uint64_t>(header, baseTicks);
+
+    index_.push_back({offset_, frames.front().frameIndex, baseTicks,
+                      static_cast<uint32_t>(frames.size()), static_cast<uint32_t>(encoded_.size())});
+
+    std::fwrite(header.data(), 1, header.size(), file_);
+    std::fwrite(encoded_.data(), 1, encoded_.size(), file_);
+    offset_ += header.size() + encoded_.size();
+}
+
+int analyzeTrace(const std::string& path, const TraceAnalysisOptions& options) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Не удалось открыть трассу: " << path << std::endl;
+        return -1;
+    }
+    struct stat st {};
+    fstat(fd, &st);
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size < HEADER_FIXED_SIZE) {
+        ::close(fd);
+        std::cerr << path << ": файл слишком мал" << std::endl;
+        return -1;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "mmap не удался: " << path << std::endl;
+        return -1;
+    }
+    madvise(mapping, size, MADV_WILLNEED);
+    const auto* data = static_cast<const unsigned char*>(mapping);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (std::memcmp(data, TRACE_MAGIC, 8) != 0 || load<uint32_t>(data + 8) != TRACE_VERSION ||
+        load<uint32_t>(data + 12) != TRACE_TICK_NS || load<uint32_t>(data + 20) != GPU_PASS_COUNT) {
+        munmap(mapping, size);
+        std::cerr << path << ": неизвестный формат трассы" << std::endl;
+        return -1;
+    }
+    uint32_t descriptionLength = load<uint32_t>(data + 32);
+    std::string description(reinterpret_cast<const char*>(data + HEADER_FIXED_SIZE),
+                            std::min<size_t>(descriptionLength, size - HEADER_FIXED_SIZE));
+    size_t firstChunk = HEADER_FIXED_SIZE + descriptionLength;
+
+    std::vector<ChunkRef> chunks = firstChunk <= size ? readIndex(data, size, firstChunk) : std::vector<ChunkRef>();
+    bool indexed = !chunks.empty();
+    if (!indexed) {
+        chunks = scanChunks(data, size, firstChunk);
+    }
+    if (chunks.empty()) {
+        munmap(mapping, size);
+        std::cerr << path << ": в трассе нет кадров" << std::endl;
+        return -1;
+    }
+
+    // Не больше 2000 окон, иначе сводка не читается
+    const ChunkRef& lastChunk = chunks.back();
+    double approxDurationSec = ticksToMs(lastChunk.baseTicks) / 1000.0;
+    double windowSec = std::max(options.windowSec, std::ceil(approxDurationSec / 2000.0));
+    uint64_t windowTicks = static_cast<uint64_t>(windowSec * 1e9 / TRACE_TICK_NS);
+
+    // Чанки независимы, разбираем их параллельно
+    unsigned threadCount = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), chunks.size()));
+    std::vector<TraceStats> partial(threadCount);
+    std::atomic<size_t> nextChunk {0};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+                decodeChunk(chunks[i], windowTicks, partial[t]);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    TraceStats stats = std::move(partial[0]);
+    for (unsigned t = 1; t < threadCount; ++t) {
+        stats.merge(partial[t]);
+    }
+    munmap(mapping, size);
+
+    double analysisSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    double durationSec = ticksToMs(stats.lastTicks) / 1000.0;
+    const MetricStats& frame = stats.metrics[METRIC_FRAME];
+
+    std::cout << "Трасса: " << path << (indexed ? "" : " (без индекса, восстановлена по чанкам)") << "\n"
+              << "Описание: " << description << "\n"
+              << "Кадров: " << stats.frames << ", чанков: " << chunks.size()
+              << ", размер: " << std::fixed << std::setprecision(1) << size / (1024.0 * 1024.0) << " MB ("
+              << std::setprecision(2) << (stats.frames ? static_cast<double>(size) / stats.frames : 0.0)
+              << " байт/кадр)\n"
+              << "Длительность: " << formatDuration(durationSec) << ", средний FPS: "
+              << (frame.sumMs > 0 ? frame.histogram.total() / (frame.sumMs / 1000.0) : 0.0) << "\n"
+              << "Анализ: " << std::setprecision(3) << analysisSec << " с, потоков: " << threadCount << "\n"
+              << std::endl;
+
+    std::cout << std::left << std::setw(14) << "мс" << std::right << std::setw(10) << "mean" << std::setw(10) << "P50"
+              << std::setw(10) << "P90" << std::setw(10) << "P99" << std::setw(10) << "P99.9"
+              << std::setw(10) << "max" << std::endl;
+    printMetricRow("frame", frame);
+    printMetricRow("cpu submit", stats.metrics[METRIC_CPU]);
+    printMetricRow("swap", stats.metrics[METRIC_SWAP]);
+    for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+        std::string name = std::string("gpu ") + gpuPassName(pass);
+        printMetricRow(name.c_str(), stats.metrics[METRIC_GPU_FIRST + pass]);
+    }
+
+    if (options.showHistogram && frame.histogram.total() > 0) {
+        const auto& counts = frame.histogram.counts();
+        uint64_t peak = *std::max_element(counts.begin(), counts.end());
+        std::cout << "\nГистограмма времени кадра:" << std::endl;
+        for (int i = 0; i < FrameTimeHistogram::BUCKET_COUNT; ++i) {
+            if (counts[i] == 0) {
+                continue;
+            }
+            int bar = static_cast<int>(std::ceil(50.0 * counts[i] / peak));
+            std::cout << "  <=" << std::setw(10) << std::setprecision(3) << FrameTimeHistogram::upperBoundMs(i)
+                      << " мс " << std::setw(12) << counts[i] << " " << std::string(bar, '#') << std::endl;
+        }
+    }
+
+    std::cout << "\nОкна по " << std::setprecision(0) << windowSec << " с:" << std::endl;
+    std::cout << std::setw(10) << "время" << std::setw(12) << "кадров" << std::setw(12) << "avg fps"
+              << std::setw(10) << "p99 мс" << std::setw(10) << "max мс" << std::endl;
+    for (size_t i = 0; i < stats.windows.size(); ++i) {
+        const WindowStats& w = stats.windows[i];
+        uint64_t count = w.histogram.total();
+        if (count == 0) {
+            continue;
+        }
+        std::cout << std::setw(10) << formatDuration(i * windowSec) << std::setw(12) << count
+                  << std::setprecision(2) << std::setw(12) << count / (w.sumMs / 1000.0)
+                  << std::setprecision(3) << std::setw(10) << std::min(w.histogram.percentile(99.0), w.maxMs)
+                  << std::setw(10) << w.maxMs << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gpu_timer.h"
+
+// Бинарная трасса кадров.
+//
+// Файл: заголовок, чанки по TRACE_FRAMES_PER_CHUNK кадров, индекс чанков и
+// завершающая запись с его смещением. Время хранится в тиках по 100 нс,
+// поля кадра - varint дельты:
+//   начало кадра - начало предыдущего кадра
+//   отправка команд - начало кадра
+//   возврат из SwapBuffers - отправка команд
+//   время GPU каждого прохода
+// Типичный кадр занимает около 12 байт. Если запись оборвалась, индекс
+// восстанавливается последовательным чтением заголовков чанков.
+
+constexpr uint32_t TRACE_FRAMES_PER_CHUNK = 4096;
+constexpr uint64_t TRACE_TICK_NS = 100;
+
+// Кадр с временем в наносекундах от начала трассы
+struct FrameRecord {
+    uint64_t frameIndex = 0;
+    uint64_t cpuStartNs = 0;
+    uint64_t submitNs = 0;
+    uint64_t swapEndNs = 0;
+    GpuPassTimes gpuNs {};
+    bool gpuResolved = false;
+};
+
+// Запись трассы. Кодирование и запись на диск - в фоновом потоке,
+// поток рендеринга только складывает кадры в буфер
+class TraceWriter {
+public:
+    ~TraceWriter();
+
+    bool open(const std::string& path, const std::string& description);
+
+    // Кадр ждет результатов GPU таймера, пока их не передадут в resolveGpu
+    void addFrame(const FrameRecord& record);
+    void resolveGpu(uint64_t frameIndex, const GpuPassTimes& times);
+
+    // Дописывает оставшиеся кадры и индекс
+    void close();
+
+    [[nodiscard]] bool isOpen() const { return file_ != nullptr; }
+
+private:
+    struct ChunkIndexEntry {
+        uint64_t offset;
+        uint64_t firstFrame;
+        uint64_t baseTicks;
+        uint32_t frameCount;
+        uint32_t byteSize;
+    };
+
+    void flushReady(bool all);
+    void submitChunk();
+    void writerLoop();
+    void writeChunk(const std::vector<FrameRecord>& frames);
+
+    FILE* file_ = nullptr;
+    std::deque<FrameRecord> pending_;          // Ждут времени GPU
+    std::vector<FrameRecord> chunk_;           // Собираемый чанк
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::vector<FrameRecord>> queue_;
+    bool stop_ = false;
+
+    // Состояние фонового потока
+    std::vector<ChunkIndexEntry> index_;
+    std::vector<unsigned char> encoded_;
+    uint64_t lastStartTicks_ = 0;
+    uint64_t offset_ = 0;
+};
+
+struct TraceAnalysisOptions {
+    double windowSec = 60.0;
+    bool showHistogram = true;
+};
+
+// Анализ трассы через mmap, возвращает код завершения программы
+int analyzeTrace(const std::string& path, const TraceAnalysisOptions& options);
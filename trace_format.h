@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Разметка файла трассы из trace.h: заголовок, чанки, индекс и завершающая
+// запись. Отдельно от записи и анализа, чтобы формат проверялся тестами.
+// Все целые в файле little-endian, как на x86 и ARM, поэтому пишем memcpy
+constexpr char TRACE_MAGIC[8] = {'R', 'G', 'B', 'T', 'R', 'A', 'C', 'E'};
+constexpr char INDEX_MAGIC[8] = {'R', 'G', 'B', 'I', 'N', 'D', 'E', 'X'};
+constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+constexpr uint32_t TRACE_VERSION = 1;
+
+// Заголовок: магия, версия, тик, кадров в чанке, проходов GPU, время начала, длина описания
+constexpr size_t HEADER_FIXED_SIZE = 8 + 4 * 4 + 8 + 4;
+constexpr size_t CHUNK_HEADER_SIZE = 4 * 4 + 8 * 2;
+constexpr size_t INDEX_ENTRY_SIZE = 8 * 3 + 4 * 2;
+constexpr size_t TRAILER_SIZE = 8 * 2 + 8;
+
+inline void appendVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+inline uint64_t readVarint(const unsigned char*& p, const unsigned char* end) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (p < end && shift < 64) {
+        unsigned char byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+        shift += 7;
+    }
+    return value;
+}
+
+// Чанк в отображенном файле
+struct ChunkRef {
+    const unsigned char* payload;
+    uint32_t byteSize;
+    uint32_t frameCount;
+    uint64_t firstFrame;
+    uint64_t baseTicks;
+};
+
+// Последовательный обход чанков с offset, если индекса нет (запись была прервана)
+[[nodiscard]] std::vector<ChunkRef> scanChunks(const unsigned char* data, size_t size, size_t offset);
+
+// Индекс в конце файла; пустой, если его нет или он испорчен
+[[nodiscard]] std::vector<ChunkRef> readIndex(const unsigned char* data, size_t size, size_t firstChunk);
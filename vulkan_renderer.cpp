@@ -0,0 +1,1355 @@
+#include "vulkan_renderer.h"
+
+VulkanRenderer vulkanRenderer;
+
+#if defined(RGBENCH_VULKAN)
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "cube_mesh.h"
+#include "job_system.h"
+
+namespace {
+
+// SPIR-V шейдеров из shaders/, собирается glslc при сборке
+const uint32_t CUBE_VERT_SPV[] = {
+#include "vk_cube.vert.inc"
+};
+const uint32_t CUBE_FRAG_SPV[] = {
+#include "vk_cube.frag.inc"
+};
+const uint32_t HUD_VERT_SPV[] = {
+#include "vk_hud.vert.inc"
+};
+const uint32_t HUD_FRAG_SPV[] = {
+#include "vk_hud.frag.inc"
+};
+
+constexpr uint32_t ATLAS_WIDTH = 1024;
+constexpr uint32_t ATLAS_HEIGHT = 512;
+constexpr int ATLAS_PADDING = 1;           // Между глифами: линейная фильтрация не цепляет соседей
+constexpr size_t MIN_CUBES_PER_BUFFER = 1024;
+// Метки времени кадра: начало, конец кубика, конец графика, конец текста
+constexpr uint32_t TIMESTAMPS_PER_FRAME = GPU_PASS_COUNT + 1;
+
+struct HudVertex {
+    float x, y;      // Координаты отсечения
+    float u, v;
+    float r, g, b;
+};
+
+struct Buffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    void* mapped = nullptr;
+    VkDeviceSize size = 0;
+};
+
+struct Image {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+};
+
+bool check(VkResult result, const char* what, std::string& error) {
+    if (result != VK_SUCCESS) {
+        error = std::string(what) + " failed (VkResult " + std::to_string(result) + ")";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+struct VulkanRenderer::State {
+    GLFWwindow* window = nullptr;
+    JobSystem* jobs = nullptr;
+    bool vsync = false;
+    bool recreateSwapchain = false;
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t queueFamily = 0;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties {};
+    float timestampPeriod = 1.0f;
+    bool timestamps = false;
+    std::string deviceName;
+    std::string driverInfo;
+
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent {};
+    std::vector<VkImage> images;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkFramebuffer> framebuffers;
+    std::vector<VkSemaphore> renderFinished;  // По изображению swapchain
+    Image depth;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkDescriptorSetLayout instanceSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout atlasSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout cubePipelineLayout = VK_NULL_HANDLE;
+    VkPipelineLayout hudLayout = VK_NULL_HANDLE;
+    VkPipeline cubePipeline = VK_NULL_HANDLE;
+    VkPipeline cubeCulledPipeline = VK_NULL_HANDLE;
+    VkPipeline hudPipeline = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    Buffer cubeVertices;
+
+    // Атлас глифов: полки слева направо, в углу белый блок для сплошных прямоугольников
+    Image atlas;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorSet atlasSet = VK_NULL_HANDLE;
+    Buffer atlasStaging;
+    std::vector<uint8_t> atlasPixels;
+    std::map<const uint8_t*, glm::vec4> glyphs;  // Маска -> u0, v0, u1, v1
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    bool atlasDirty = true;
+    bool atlasUploaded = false;
+
+    struct Frame {
+        VkFence fence = VK_NULL_HANDLE;
+        VkSemaphore imageAvailable = VK_NULL_HANDLE;
+        VkCommandPool pool = VK_NULL_HANDLE;     // Первичный буфер, график и текст
+        VkCommandBuffer primary = VK_NULL_HANDLE;
+        VkCommandBuffer graph = VK_NULL_HANDLE;
+        VkCommandBuffer text = VK_NULL_HANDLE;
+        // По пулу на кусок кубика: кусок записывает один поток
+        std::vector<VkCommandPool> cubePools;
+        std::vector<VkCommandBuffer> cubeBuffers;
+        int cubeChunks = 0;
+        Buffer instances;
+        VkDescriptorSet instanceSet = VK_NULL_HANDLE;
+        Buffer hud;
+        uint64_t frameIndex = 0;
+        bool pending = false;                    // Ждет чтения меток времени
+    };
+    std::array<Frame, FRAMES_IN_FLIGHT> frames;
+    int current = 0;
+    uint32_t imageIndex = 0;
+    bool frameActive = false;
+    glm::vec3 clearColor {};
+    int lastCubeChunks = 0;
+
+    std::vector<HudVertex> graphVertices;
+    std::vector<HudVertex> textVertices;
+
+    std::vector<glm::vec3> offsets;
+    int offsetsSize = 0;
+    bool offsetsCull = false;
+
+    std::deque<std::pair<uint64_t, GpuPassTimes>> results;
+
+    bool createDevice(std::string& error);
+    bool createSwapchain(std::string& error);
+    void destroySwapchain();
+    bool createPipelines(std::string& error);
+    bool createResources(std::string& error);
+    bool createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, Buffer& buffer, std::string& error);
+    void destroyBuffer(Buffer& buffer);
+    bool ensureBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage);
+    bool createImage(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage,
+                     VkImageAspectFlags aspect, Image& image, std::string& error);
+    void destroyImage(Image& image);
+    int findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+    VkShaderModule createShader(const uint32_t* code, size_t size);
+    VkPipeline createPipeline(VkPipelineLayout layout, VkShaderModule vertex, VkShaderModule fragment,
+                              const VkPipelineVertexInputStateCreateInfo& vertexInput,
+                              VkCullModeFlags cull, bool depthTest, bool blend);
+    bool addGlyph(const uint8_t* mask, int width, int height, glm::vec4& uv);
+    void addQuad(std::vector<HudVertex>& vertices, const glm::mat4& transform, glm::vec2 min, glm::vec2 max,
+                 glm::vec4 uv, glm::vec3 color);
+    void beginSecondary(VkCommandBuffer buffer);
+    void recordHud(VkCommandBuffer buffer, const std::vector<HudVertex>& vertices, VkDeviceSize offset, uint32_t timestamp);
+    void uploadAtlas(VkCommandBuffer buffer);
+    void readTimestamps(Frame& frame);
+};
+
+VulkanRenderer::VulkanRenderer() = default;
+
+VulkanRenderer::~VulkanRenderer() = default;
+
+bool VulkanRenderer::init(GLFWwindow* window, JobSystem* jobs, std::string& error) {
+    if (!glfwVulkanSupported()) {
+        error = "Vulkan loader or driver not found";
+        return false;
+    }
+    state_ = std::make_unique<State>();
+    state_->window = window;
+    state_->jobs = jobs;
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    state_->extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+    if (!state_->createDevice(error) || !state_->createSwapchain(error)
+        || !state_->createPipelines(error) || !state_->createResources(error)) {
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::enabled() const {
+    return state_ != nullptr;
+}
+
+std::string VulkanRenderer::deviceName() const {
+    return state_ ? state_->deviceName : "";
+}
+
+std::string VulkanRenderer::driverInfo() const {
+    return state_ ? state_->driverInfo : "";
+}
+
+void VulkanRenderer::setVsync(bool vsync) {
+    if (state_ && state_->vsync != vsync) {
+        state_->vsync = vsync;
+        state_->recreateSwapchain = true;
+    }
+}
+
+int VulkanRenderer::cubeCommandBuffers() const {
+    return state_ ? state_->lastCubeChunks : 0;
+}
+
+bool VulkanRenderer::State::createDevice(std::string& error) {
+    uint32_t extensionCount = 0;
+    const char** extensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+    if (!extensions) {
+        error = "no Vulkan surface extensions for this window system";
+        return false;
+    }
+    VkApplicationInfo application {VK_STRUCTURE_TYPE_APPLICATION_INFO};
+    application.pApplicationName = "rgbench";
+    application.apiVersion = VK_API_VERSION_1_1;
+    VkInstanceCreateInfo instanceInfo {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+    instanceInfo.pApplicationInfo = &application;
+    instanceInfo.enabledExtensionCount = extensionCount;
+    instanceInfo.ppEnabledExtensionNames = extensions;
+    if (!check(vkCreateInstance(&instanceInfo, nullptr, &instance), "vkCreateInstance", error)
+        || !check(glfwCreateWindowSurface(instance, window, nullptr, &surface), "glfwCreateWindowSurface", error)) {
+        return false;
+    }
+
+    // Дискретная видеокарта, затем встроенная, виртуальная и CPU (lavapipe)
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+    int bestScore = -1;
+    for (VkPhysicalDevice candidate : devices) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(candidate, &properties);
+        if (properties.apiVersion < VK_API_VERSION_1_1) {
+            continue;
+        }
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+        for (uint32_t family = 0; family < familyCount; ++family) {
+            VkBool32 present = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(candidate, family, surface, &present);
+            if (!(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT) || !present) {
+                continue;
+            }
+            int score = 0;
+            switch (properties.deviceType) {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score = 4; break;
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score = 3; break;
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score = 2; break;
+                case VK_PHYSICAL_DEVICE_TYPE_CPU: score = 1; break;
+                default: break;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                physicalDevice = candidate;
+                queueFamily = family;
+                timestamps = families[family].timestampValidBits > 0;
+            }
+            break;
+        }
+    }
+    if (physicalDevice == VK_NULL_HANDLE) {
+        error = "no Vulkan 1.1 device can present to the window";
+        return false;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    deviceName = properties.deviceName;
+    timestampPeriod = properties.limits.timestampPeriod;
+    driverInfo = "Vulkan " + std::to_string(VK_VERSION_MAJOR(properties.apiVersion)) + "."
+               + std::to_string(VK_VERSION_MINOR(properties.apiVersion)) + "."
+               + std::to_string(VK_VERSION_PATCH(properties.apiVersion));
+    if (properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceDriverProperties driver {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DRIVER_PROPERTIES};
+        VkPhysicalDeviceProperties2 properties2 {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+        properties2.pNext = &driver;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+        driverInfo += ", " + std::string(driver.driverName) + " " + driver.driverInfo;
+    }
+
+    for (VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM}) {
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+        if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            depthFormat = format;
+            break;
+        }
+    }
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+    queueInfo.queueFamilyIndex = queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+    const char* deviceExtensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    VkDeviceCreateInfo deviceInfo {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.enabledExtensionCount = 1;
+    deviceInfo.ppEnabledExtensionNames = deviceExtensions;
+    if (!check(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device), "vkCreateDevice", error)) {
+        return false;
+    }
+    vkGetDeviceQueue(device, queueFamily, 0, &queue);
+    return true;
+}
+
+bool VulkanRenderer::State::createSwapchain(std::string& error) {
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
+
+    if (colorFormat == VK_FORMAT_UNDEFINED) {
+        uint32_t formatCount = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
+        std::vector<VkSurfaceFormatKHR> formats(formatCount);
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, formats.data());
+        if (formats.empty()) {
+            error = "surface reports no formats";
+            return false;
+        }
+        // Без sRGB, как кадр GL по умолчанию
+        colorFormat = formats[0].format;
+        for (const VkSurfaceFormatKHR& format : formats) {
+            if (format.format == VK_FORMAT_B8G8R8A8_UNORM || format.format == VK_FORMAT_R8G8B8A8_UNORM) {
+                colorFormat = format.format;
+                break;
+            }
+        }
+    }
+    VkColorSpaceKHR colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+
+    uint32_t modeCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, nullptr);
+    std::vector<VkPresentModeKHR> modes(modeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, modes.data());
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    if (!vsync) {
+        for (VkPresentModeKHR preferred : {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR}) {
+            if (std::find(modes.begin(), modes.end(), preferred) != modes.end()) {
+                presentMode = preferred;
+                break;
+            }
+        }
+    }
+
+    if (capabilities.currentExtent.width != UINT32_MAX) {
+        extent = capabilities.currentExtent;
+    } else {
+        extent.width = std::clamp(extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        extent.height = std::clamp(extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    }
+    uint32_t imageCount = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0) {
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
+    }
+    VkCompositeAlphaFlagBitsKHR compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    for (VkCompositeAlphaFlagBitsKHR candidate : {VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR, VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR}) {
+        if (capabilities.supportedCompositeAlpha & candidate) {
+            compositeAlpha = candidate;
+            break;
+        }
+    }
+
+    VkSwapchainKHR oldSwapchain = swapchain;
+    VkSwapchainCreateInfoKHR swapchainInfo {VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
+    swapchainInfo.surface = surface;
+    swapchainInfo.minImageCount = imageCount;
+    swapchainInfo.imageFormat = colorFormat;
+    swapchainInfo.imageColorSpace = colorSpace;
+    swapchainInfo.imageExtent = extent;
+    swapchainInfo.imageArrayLayers = 1;
+    swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    swapchainInfo.preTransform = capabilities.currentTransform;
+    swapchainInfo.compositeAlpha = compositeAlpha;
+    swapchainInfo.presentMode = presentMode;
+    swapchainInfo.clipped = VK_TRUE;
+    swapchainInfo.oldSwapchain = oldSwapchain;
+    if (!check(vkCreateSwapchainKHR(device, &swapchainInfo, nullptr, &swapchain), "vkCreateSwapchainKHR", error)) {
+        return false;
+    }
+    if (oldSwapchain != VK_NULL_HANDLE) {
+        vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
+    }
+
+    if (renderPass == VK_NULL_HANDLE) {
+        std::array<VkAttachmentDescription, 2> attachments {};
+        attachments[0].format = colorFormat;
+        attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        attachments[1].format = depthFormat;
+        attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        VkAttachmentReference colorReference {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        VkAttachmentReference depthReference {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+        VkSubpassDescription subpass {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorReference;
+        subpass.pDepthStencilAttachment = &depthReference;
+        VkSubpassDependency dependency {};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        VkRenderPassCreateInfo renderPassInfo {VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.pDependencies = &dependency;
+        if (!check(vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass), "vkCreateRenderPass", error)) {
+            return false;
+        }
+    }
+
+    uint32_t swapchainImageCount = 0;
+    vkGetSwapchainImagesKHR(device, swapchain, &swapchainImageCount, nullptr);
+    images.resize(swapchainImageCount);
+    vkGetSwapchainImagesKHR(device, swapchain, &swapchainImageCount, images.data());
+    if (!createImage(extent.width, extent.height, depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                     VK_IMAGE_ASPECT_DEPTH_BIT, depth, error)) {
+        return false;
+    }
+    for (VkImage image : images) {
+        VkImageViewCreateInfo viewInfo {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = colorFormat;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        VkImageView view = VK_NULL_HANDLE;
+        if (!check(vkCreateImageView(device, &viewInfo, nullptr, &view), "vkCreateImageView", error)) {
+            return false;
+        }
+        imageViews.push_back(view);
+
+        std::array<VkImageView, 2> views = {view, depth.view};
+        VkFramebufferCreateInfo framebufferInfo {VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments = views.data();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        if (!check(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer), "vkCreateFramebuffer", error)) {
+            return false;
+        }
+        framebuffers.push_back(framebuffer);
+
+        VkSemaphoreCreateInfo semaphoreInfo {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        if (!check(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore), "vkCreateSemaphore", error)) {
+            return false;
+        }
+        renderFinished.push_back(semaphore);
+    }
+    recreateSwapchain = false;
+    return true;
+}
+
+// Сам swapchain переиспользуется как oldSwapchain при пересоздании
+void VulkanRenderer::State::destroySwapchain() {
+    for (VkFramebuffer framebuffer : framebuffers) {
+        vkDestroyFramebuffer(device, framebuffer, nullptr);
+    }
+    for (VkImageView view : imageViews) {
+        vkDestroyImageView(device, view, nullptr);
+    }
+    for (VkSemaphore semaphore : renderFinished) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    framebuffers.clear();
+    imageViews.clear();
+    renderFinished.clear();
+    images.clear();
+    destroyImage(depth);
+}
+
+VkShaderModule VulkanRenderer::State::createShader(const uint32_t* code, size_t size) {
+    VkShaderModuleCreateInfo shaderInfo {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    shaderInfo.codeSize = size;
+    shaderInfo.pCode = code;
+    VkShaderModule module = VK_NULL_HANDLE;
+    vkCreateShaderModule(device, &shaderInfo, nullptr, &module);
+    return module;
+}
+
+VkPipeline VulkanRenderer::State::createPipeline(VkPipelineLayout layout, VkShaderModule vertex, VkShaderModule fragment,
+                                                 const VkPipelineVertexInputStateCreateInfo& vertexInput,
+                                                 VkCullModeFlags cull, bool depthTest, bool blend) {
+    std::array<VkPipelineShaderStageCreateInfo, 2> stages {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertex;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragment;
+    stages[1].pName = "main";
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPipelineViewportStateCreateInfo viewport {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+    // Вьюпорт с отрицательной высотой (Vulkan 1.1) переворачивает y: обход
+    // граней и ориентация кадра те же, что в GL
+    VkPipelineRasterizationStateCreateInfo rasterization {VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = cull;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+    VkPipelineMultisampleStateCreateInfo multisample {VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    VkPipelineDepthStencilStateCreateInfo depthStencil {VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+    depthStencil.depthTestEnable = depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+    VkPipelineColorBlendAttachmentState blendAttachment {};
+    blendAttachment.blendEnable = blend ? VK_TRUE : VK_FALSE;
+    blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
+                                   | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo colorBlend {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+    std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+    dynamic.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamic.pDynamicStates = dynamicStates.data();
+
+    VkGraphicsPipelineCreateInfo pipelineInfo {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+    pipelineInfo.pStages = stages.data();
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewport;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlend;
+    pipelineInfo.pDynamicState = &dynamic;
+    pipelineInfo.layout = layout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+    return pipeline;
+}
+
+bool VulkanRenderer::State::createPipelines(std::string& error) {
+    VkDescriptorSetLayoutBinding instanceBinding {};
+    instanceBinding.binding = 0;
+    instanceBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    instanceBinding.descriptorCount = 1;
+    instanceBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    VkDescriptorSetLayoutCreateInfo setInfo {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    setInfo.bindingCount = 1;
+    setInfo.pBindings = &instanceBinding;
+    if (!check(vkCreateDescriptorSetLayout(device, &setInfo, nullptr, &instanceSetLayout), "vkCreateDescriptorSetLayout", error)) {
+        return false;
+    }
+    VkDescriptorSetLayoutBinding atlasBinding {};
+    atlasBinding.binding = 0;
+    atlasBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    atlasBinding.descriptorCount = 1;
+    atlasBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setInfo.pBindings = &atlasBinding;
+    if (!check(vkCreateDescriptorSetLayout(device, &setInfo, nullptr, &atlasSetLayout), "vkCreateDescriptorSetLayout", error)) {
+        return false;
+    }
+
+    VkPushConstantRange pushConstants {VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4)};
+    VkPipelineLayoutCreateInfo layoutInfo {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &instanceSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstants;
+    if (!check(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &cubePipelineLayout), "vkCreatePipelineLayout", error)) {
+        return false;
+    }
+    layoutInfo.pSetLayouts = &atlasSetLayout;
+    layoutInfo.pushConstantRangeCount = 0;
+    if (!check(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &hudLayout), "vkCreatePipelineLayout", error)) {
+        return false;
+    }
+
+    VkShaderModule cubeVertex = createShader(CUBE_VERT_SPV, sizeof(CUBE_VERT_SPV));
+    VkShaderModule cubeFragment = createShader(CUBE_FRAG_SPV, sizeof(CUBE_FRAG_SPV));
+    VkShaderModule hudVertex = createShader(HUD_VERT_SPV, sizeof(HUD_VERT_SPV));
+    VkShaderModule hudFragment = createShader(HUD_FRAG_SPV, sizeof(HUD_FRAG_SPV));
+
+    // Вершины кубика - CUBE_VERTICES: позиция и цвет
+    VkVertexInputBindingDescription cubeBinding {0, CUBE_VERTEX_FLOATS * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX};
+    std::array<VkVertexInputAttributeDescription, 2> cubeAttributes = {{
+        {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+        {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 3 * sizeof(float)},
+    }};
+    VkPipelineVertexInputStateCreateInfo cubeInput {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    cubeInput.vertexBindingDescriptionCount = 1;
+    cubeInput.pVertexBindingDescriptions = &cubeBinding;
+    cubeInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(cubeAttributes.size());
+    cubeInput.pVertexAttributeDescriptions = cubeAttributes.data();
+
+    VkVertexInputBindingDescription hudBinding {0, sizeof(HudVertex), VK_VERTEX_INPUT_RATE_VERTEX};
+    std::array<VkVertexInputAttributeDescription, 3> hudAttributes = {{
+        {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(HudVertex, x)},
+        {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(HudVertex, u)},
+        {2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(HudVertex, r)},
+    }};
+    VkPipelineVertexInputStateCreateInfo hudInput {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    hudInput.vertexBindingDescriptionCount = 1;
+    hudInput.pVertexBindingDescriptions = &hudBinding;
+    hudInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(hudAttributes.size());
+    hudInput.pVertexAttributeDescriptions = hudAttributes.data();
+
+    cubePipeline = createPipeline(cubePipelineLayout, cubeVertex, cubeFragment, cubeInput, VK_CULL_MODE_NONE, true, false);
+    cubeCulledPipeline = createPipeline(cubePipelineLayout, cubeVertex, cubeFragment, cubeInput, VK_CULL_MODE_BACK_BIT, true, false);
+    hudPipeline = createPipeline(hudLayout, hudVertex, hudFragment, hudInput, VK_CULL_MODE_NONE, false, true);
+    for (VkShaderModule module : {cubeVertex, cubeFragment, hudVertex, hudFragment}) {
+        vkDestroyShaderModule(device, module, nullptr);
+    }
+    if (!cubePipeline || !cubeCulledPipeline || !hudPipeline) {
+        error = "vkCreateGraphicsPipelines failed";
+        return false;
+    }
+    return true;
+}
+
+int VulkanRenderer::State::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Все буферы в памяти, видимой CPU: данные кадра пишутся напрямую
+bool VulkanRenderer::State::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, Buffer& buffer, std::string& error) {
+    VkBufferCreateInfo bufferInfo {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (!check(vkCreateBuffer(device, &bufferInfo, nullptr, &buffer.buffer), "vkCreateBuffer", error)) {
+        return false;
+    }
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, buffer.buffer, &requirements);
+    int memoryType = findMemoryType(requirements.memoryTypeBits,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (memoryType < 0) {
+        error = "no host-visible memory for buffer";
+        return false;
+    }
+    VkMemoryAllocateInfo allocateInfo {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = static_cast<uint32_t>(memoryType);
+    if (!check(vkAllocateMemory(device, &allocateInfo, nullptr, &buffer.memory), "vkAllocateMemory", error)
+        || !check(vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0), "vkBindBufferMemory", error)
+        || !check(vkMapMemory(device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped), "vkMapMemory", error)) {
+        return false;
+    }
+    buffer.size = size;
+    return true;
+}
+
+void VulkanRenderer::State::destroyBuffer(Buffer& buffer) {
+    if (buffer.buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, buffer.buffer, nullptr);
+    }
+    if (buffer.memory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, buffer.memory, nullptr);
+    }
+    buffer = {};
+}
+
+// Буфер кадра растет по мере надобности. Вызывается после ожидания fence кадра
+bool VulkanRenderer::State::ensureBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage) {
+    if (buffer.size >= size) {
+        return true;
+    }
+    destroyBuffer(buffer);
+    std::string error;
+    return createBuffer(std::max<VkDeviceSize>(size, buffer.size * 2), usage, buffer, error);
+}
+
+bool VulkanRenderer::State::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage,
+                                        VkImageAspectFlags aspect, Image& image, std::string& error) {
+    VkImageCreateInfo imageInfo {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {width, height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (!check(vkCreateImage(device, &imageInfo, nullptr, &image.image), "vkCreateImage", error)) {
+        return false;
+    }
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image.image, &requirements);
+    int memoryType = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (memoryType < 0) {
+        memoryType = findMemoryType(requirements.memoryTypeBits, 0);
+    }
+    VkMemoryAllocateInfo allocateInfo {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = static_cast<uint32_t>(memoryType);
+    if (!check(vkAllocateMemory(device, &allocateInfo, nullptr, &image.memory), "vkAllocateMemory", error)
+        || !check(vkBindImageMemory(device, image.image, image.memory, 0), "vkBindImageMemory", error)) {
+        return false;
+    }
+    VkImageViewCreateInfo viewInfo {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    viewInfo.image = image.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange = {aspect, 0, 1, 0, 1};
+    return check(vkCreateImageView(device, &viewInfo, nullptr, &image.view), "vkCreateImageView", error);
+}
+
+void VulkanRenderer::State::destroyImage(Image& image) {
+    if (image.view != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, image.view, nullptr);
+    }
+    if (image.image != VK_NULL_HANDLE) {
+        vkDestroyImage(device, image.image, nullptr);
+    }
+    if (image.memory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, image.memory, nullptr);
+    }
+    image = {};
+}
+
+bool VulkanRenderer::State::createResources(std::string& error) {
+    if (!createBuffer(sizeof(CUBE_VERTICES), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, cubeVertices, error)) {
+        return false;
+    }
+    std::memcpy(cubeVertices.mapped, CUBE_VERTICES.data(), sizeof(CUBE_VERTICES));
+
+    atlasPixels.assign(static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT, 0);
+    for (int y = 0; y < 2; ++y) {
+        atlasPixels[y * ATLAS_WIDTH] = 255;
+        atlasPixels[y * ATLAS_WIDTH + 1] = 255;
+    }
+    shelfX = 2 + ATLAS_PADDING;
+    shelfHeight = 2;
+    if (!createImage(ATLAS_WIDTH, ATLAS_HEIGHT, VK_FORMAT_R8_UNORM, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                     VK_IMAGE_ASPECT_COLOR_BIT, atlas, error)
+        || !createBuffer(atlasPixels.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, atlasStaging, error)) {
+        return false;
+    }
+    VkSamplerCreateInfo samplerInfo {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (!check(vkCreateSampler(device, &samplerInfo, nullptr, &sampler), "vkCreateSampler", error)) {
+        return false;
+    }
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {{
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, FRAMES_IN_FLIGHT},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1},
+    }};
+    VkDescriptorPoolCreateInfo poolInfo {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.maxSets = FRAMES_IN_FLIGHT + 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    if (!check(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool), "vkCreateDescriptorPool", error)) {
+        return false;
+    }
+    VkDescriptorSetAllocateInfo setAllocate {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    setAllocate.descriptorPool = descriptorPool;
+    setAllocate.descriptorSetCount = 1;
+    setAllocate.pSetLayouts = &atlasSetLayout;
+    if (!check(vkAllocateDescriptorSets(device, &setAllocate, &atlasSet), "vkAllocateDescriptorSets", error)) {
+        return false;
+    }
+    VkDescriptorImageInfo atlasInfo {sampler, atlas.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet atlasWrite {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    atlasWrite.dstSet = atlasSet;
+    atlasWrite.descriptorCount = 1;
+    atlasWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    atlasWrite.pImageInfo = &atlasInfo;
+    vkUpdateDescriptorSets(device, 1, &atlasWrite, 0, nullptr);
+
+    if (timestamps) {
+        VkQueryPoolCreateInfo queryInfo {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = FRAMES_IN_FLIGHT * TIMESTAMPS_PER_FRAME;
+        if (!check(vkCreateQueryPool(device, &queryInfo, nullptr, &queryPool), "vkCreateQueryPool", error)) {
+            return false;
+        }
+    }
+
+    int chunks = jobs ? jobs->threadCount() : 1;
+    for (Frame& frame : frames) {
+        VkFenceCreateInfo fenceInfo {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        VkSemaphoreCreateInfo semaphoreInfo {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        VkCommandPoolCreateInfo commandPoolInfo {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolInfo.queueFamilyIndex = queueFamily;
+        if (!check(vkCreateFence(device, &fenceInfo, nullptr, &frame.fence), "vkCreateFence", error)
+            || !check(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.imageAvailable), "vkCreateSemaphore", error)
+            || !check(vkCreateCommandPool(device, &commandPoolInfo, nullptr, &frame.pool), "vkCreateCommandPool", error)) {
+            return false;
+        }
+        VkCommandBufferAllocateInfo bufferAllocate {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        bufferAllocate.commandPool = frame.pool;
+        bufferAllocate.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        bufferAllocate.commandBufferCount = 1;
+        std::array<VkCommandBuffer, 2> secondaries {};
+        if (!check(vkAllocateCommandBuffers(device, &bufferAllocate, &frame.primary), "vkAllocateCommandBuffers", error)) {
+            return false;
+        }
+        bufferAllocate.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        bufferAllocate.commandBufferCount = 2;
+        if (!check(vkAllocateCommandBuffers(device, &bufferAllocate, secondaries.data()), "vkAllocateCommandBuffers", error)) {
+            return false;
+        }
+        frame.graph = secondaries[0];
+        frame.text = secondaries[1];
+
+        frame.cubePools.resize(chunks);
+        frame.cubeBuffers.resize(chunks);
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            if (!check(vkCreateCommandPool(device, &commandPoolInfo, nullptr, &frame.cubePools[chunk]), "vkCreateCommandPool", error)) {
+                return false;
+            }
+            bufferAllocate.commandPool = frame.cubePools[chunk];
+            bufferAllocate.commandBufferCount = 1;
+            if (!check(vkAllocateCommandBuffers(device, &bufferAllocate, &frame.cubeBuffers[chunk]), "vkAllocateCommandBuffers", error)) {
+                return false;
+            }
+        }
+
+        setAllocate.pSetLayouts = &instanceSetLayout;
+        if (!check(vkAllocateDescriptorSets(device, &setAllocate, &frame.instanceSet), "vkAllocateDescriptorSets", error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void VulkanRenderer::destroy() {
+    if (!state_) {
+        return;
+    }
+    State& s = *state_;
+    if (s.device != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(s.device);
+        for (State::Frame& frame : s.frames) {
+            for (VkCommandPool pool : frame.cubePools) {
+                vkDestroyCommandPool(s.device, pool, nullptr);
+            }
+            if (frame.pool != VK_NULL_HANDLE) {
+                vkDestroyCommandPool(s.device, frame.pool, nullptr);
+            }
+            if (frame.fence != VK_NULL_HANDLE) {
+                vkDestroyFence(s.device, frame.fence, nullptr);
+            }
+            if (frame.imageAvailable != VK_NULL_HANDLE) {
+                vkDestroySemaphore(s.device, frame.imageAvailable, nullptr);
+            }
+            s.destroyBuffer(frame.instances);
+            s.destroyBuffer(frame.hud);
+        }
+        if (s.queryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(s.device, s.queryPool, nullptr);
+        }
+        if (s.descriptorPool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(s.device, s.descriptorPool, nullptr);
+        }
+        if (s.sampler != VK_NULL_HANDLE) {
+            vkDestroySampler(s.device, s.sampler, nullptr);
+        }
+        s.destroyImage(s.atlas);
+        s.destroyBuffer(s.atlasStaging);
+        s.destroyBuffer(s.cubeVertices);
+        for (VkPipeline pipeline : {s.cubePipeline, s.cubeCulledPipeline, s.hudPipeline}) {
+            if (pipeline != VK_NULL_HANDLE) {
+                vkDestroyPipeline(s.device, pipeline, nullptr);
+            }
+        }
+        for (VkPipelineLayout layout : {s.cubePipelineLayout, s.hudLayout}) {
+            if (layout != VK_NULL_HANDLE) {
+                vkDestroyPipelineLayout(s.device, layout, nullptr);
+            }
+        }
+        for (VkDescriptorSetLayout layout : {s.instanceSetLayout, s.atlasSetLayout}) {
+            if (layout != VK_NULL_HANDLE) {
+                vkDestroyDescriptorSetLayout(s.device, layout, nullptr);
+            }
+        }
+        s.destroySwapchain();
+        if (s.swapchain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(s.device, s.swapchain, nullptr);
+        }
+        if (s.renderPass != VK_NULL_HANDLE) {
+            vkDestroyRenderPass(s.device, s.renderPass, nullptr);
+        }
+        vkDestroyDevice(s.device, nullptr);
+    }
+    if (s.surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(s.instance, s.surface, nullptr);
+    }
+    if (s.instance != VK_NULL_HANDLE) {
+        vkDestroyInstance(s.instance, nullptr);
+    }
+    state_.reset();
+}
+
+void VulkanRenderer::State::readTimestamps(Frame& frame) {
+    if (!frame.pending) {
+        return;
+    }
+    frame.pending = false;
+    if (queryPool == VK_NULL_HANDLE) {
+        return;
+    }
+    std::array<uint64_t, TIMESTAMPS_PER_FRAME> ticks {};
+    uint32_t first = static_cast<uint32_t>(&frame - frames.data()) * TIMESTAMPS_PER_FRAME;
+    if (vkGetQueryPoolResults(device, queryPool, first, TIMESTAMPS_PER_FRAME, sizeof(ticks), ticks.data(),
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+        return;
+    }
+    GpuPassTimes times {};
+    for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+        times[pass] = static_cast<uint64_t>((ticks[pass + 1] - ticks[pass]) * static_cast<double>(timestampPeriod));
+    }
+    results.emplace_back(frame.frameIndex, times);
+}
+
+void VulkanRenderer::beginFrame(uint64_t frameIndex, int width, int height, glm::vec3 clearColor) {
+    State& s = *state_;
+    s.frameActive = false;
+    State::Frame& frame = s.frames[s.current];
+    vkWaitForFences(s.device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+    s.readTimestamps(frame);
+
+    // Свернутое окно: кадр пропускается
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    if (s.recreateSwapchain || static_cast<uint32_t>(width) != s.extent.width || static_cast<uint32_t>(height) != s.extent.height) {
+        vkDeviceWaitIdle(s.device);
+        s.destroySwapchain();
+        s.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        std::string error;
+        if (!s.createSwapchain(error)) {
+            return;
+        }
+    }
+    VkResult acquired = vkAcquireNextImageKHR(s.device, s.swapchain, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &s.imageIndex);
+    if (acquired == VK_ERROR_OUT_OF_DATE_KHR) {
+        s.recreateSwapchain = true;
+        return;
+    }
+    if (acquired != VK_SUCCESS && acquired != VK_SUBOPTIMAL_KHR) {
+        return;
+    }
+
+    vkResetCommandPool(s.device, frame.pool, 0);
+    for (VkCommandPool pool : frame.cubePools) {
+        vkResetCommandPool(s.device, pool, 0);
+    }
+    frame.frameIndex = frameIndex;
+    frame.cubeChunks = 0;
+    s.clearColor = clearColor;
+    s.graphVertices.clear();
+    s.textVertices.clear();
+    s.frameActive = true;
+}
+
+void VulkanRenderer::State::beginSecondary(VkCommandBuffer buffer) {
+    VkCommandBufferInheritanceInfo inheritance {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+    inheritance.renderPass = renderPass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = framebuffers[imageIndex];
+    VkCommandBufferBeginInfo beginInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+    vkBeginCommandBuffer(buffer, &beginInfo);
+    VkViewport viewport {0.0f, static_cast<float>(extent.height), static_cast<float>(extent.width),
+                         -static_cast<float>(extent.height), 0.0f, 1.0f};
+    VkRect2D scissor {{0, 0}, extent};
+    vkCmdSetViewport(buffer, 0, 1, &viewport);
+    vkCmdSetScissor(buffer, 0, 1, &scissor);
+}
+
+void VulkanRenderer::drawCube(const glm::mat4& viewProjection, const glm::mat4& rotation, int cubeSize, bool cull) {
+    State& s = *state_;
+    if (!s.frameActive) {
+        return;
+    }
+    State::Frame& frame = s.frames[s.current];
+    CubeLayout layout = cubeLayout(cubeSize);
+    if (s.offsetsSize != cubeSize || s.offsetsCull != cull) {
+        s.offsets = cubieOffsets(layout, cull);
+        s.offsetsSize = cubeSize;
+        s.offsetsCull = cull;
+    }
+    size_t instances = s.offsets.size();
+    VkDeviceSize instanceBytes = instances * CUBIE_TRANSFORM_FLOATS * sizeof(float);
+    if (instances == 0 || !s.ensureBuffer(frame.instances, instanceBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) {
+        return;
+    }
+    // Буфер мог пересоздаться: набор кадра не используется GPU после ожидания fence
+    VkDescriptorBufferInfo bufferInfo {frame.instances.buffer, 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = frame.instanceSet;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(s.device, 1, &write, 0, nullptr);
+
+    // Кусок на участника пула, но не мельче MIN_CUBES_PER_BUFFER
+    size_t chunks = std::min(frame.cubeBuffers.size(), std::max<size_t>(1, instances / MIN_CUBES_PER_BUFFER));
+    size_t chunkSize = (instances + chunks - 1) / chunks;
+    chunks = (instances + chunkSize - 1) / chunkSize;
+    auto* transforms = static_cast<float*>(frame.instances.mapped);
+    VkPipeline pipeline = cull ? s.cubeCulledPipeline : s.cubePipeline;
+
+    auto recordChunk = [&](size_t chunk) {
+        size_t first = chunk * chunkSize;
+        size_t count = std::min(chunkSize, instances - first);
+        writeCubieTransforms(rotation, layout.cubieSize, s.offsets.data() + first, count,
+                             transforms + first * CUBIE_TRANSFORM_FLOATS);
+
+        VkCommandBuffer buffer = frame.cubeBuffers[chunk];
+        s.beginSecondary(buffer);
+        vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        VkDeviceSize vertexOffset = 0;
+        vkCmdBindVertexBuffers(buffer, 0, 1, &s.cubeVertices.buffer, &vertexOffset);
+        vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, s.cubePipelineLayout, 0, 1, &frame.instanceSet, 0, nullptr);
+        vkCmdPushConstants(buffer, s.cubePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &viewProjection[0][0]);
+        vkCmdDraw(buffer, CUBE_VERTEX_COUNT, static_cast<uint32_t>(count), 0, static_cast<uint32_t>(first));
+        vkEndCommandBuffer(buffer);
+    };
+    if (s.jobs && chunks > 1) {
+        s.jobs->parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                recordChunk(chunk);
+            }
+        });
+    } else {
+        recordChunk(0);
+    }
+    frame.cubeChunks = static_cast<int>(chunks);
+}
+
+bool VulkanRenderer::State::addGlyph(const uint8_t* mask, int width, int height, glm::vec4& uv) {
+    auto found = glyphs.find(mask);
+    if (found != glyphs.end()) {
+        uv = found->second;
+        return true;
+    }
+    if (shelfX + width > static_cast<int>(ATLAS_WIDTH)) {
+        shelfX = 0;
+        shelfY += shelfHeight + ATLAS_PADDING;
+        shelfHeight = 0;
+    }
+    if (width > static_cast<int>(ATLAS_WIDTH) || shelfY + height > static_cast<int>(ATLAS_HEIGHT)) {
+        return false;
+    }
+    for (int row = 0; row < height; ++row) {
+        std::memcpy(atlasPixels.data() + static_cast<size_t>(shelfY + row) * ATLAS_WIDTH + shelfX,
+                    mask + static_cast<size_t>(row) * width, width);
+    }
+    uv = glm::vec4(static_cast<float>(shelfX) / ATLAS_WIDTH, static_cast<float>(shelfY) / ATLAS_HEIGHT,
+                   static_cast<float>(shelfX + width) / ATLAS_WIDTH, static_cast<float>(shelfY + height) / ATLAS_HEIGHT);
+    glyphs.emplace(mask, uv);
+    shelfX += width + ATLAS_PADDING;
+    shelfHeight = std::max(shelfHeight, height);
+    atlasDirty = true;
+    return true;
+}
+
+void VulkanRenderer::State::addQuad(std::vector<HudVertex>& vertices, const glm::mat4& transform, glm::vec2 min, glm::vec2 max,
+                                    glm::vec4 uv, glm::vec3 color) {
+    glm::vec4 a = transform * glm::vec4(min, 0.0f, 1.0f);
+    glm::vec4 b = transform * glm::vec4(max, 0.0f, 1.0f);
+    // Линии графика нулевой толщины растягиваются до пикселя, как в GL
+    float pixelX = 1.0f / extent.width;
+    float pixelY = 1.0f / extent.height;
+    if (b.x - a.x < 2.0f * pixelX) {
+        a.x -= pixelX;
+        b.x += pixelX;
+    }
+    if (b.y - a.y < 2.0f * pixelY) {
+        a.y -= pixelY;
+        b.y += pixelY;
+    }
+    // Строка 0 маски - верх глифа, то есть max.y
+    HudVertex topLeft {a.x, b.y, uv.x, uv.y, color.x, color.y, color.z};
+    HudVertex bottomLeft {a.x, a.y, uv.x, uv.w, color.x, color.y, color.z};
+    HudVertex bottomRight {b.x, a.y, uv.z, uv.w, color.x, color.y, color.z};
+    HudVertex topRight {b.x, b.y, uv.z, uv.y, color.x, color.y, color.z};
+    vertices.insert(vertices.end(), {topLeft, bottomLeft, bottomRight, topLeft, bottomRight, topRight});
+}
+
+void VulkanRenderer::drawRect(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, glm::vec3 color) {
+    State& s = *state_;
+    if (!s.frameActive) {
+        return;
+    }
+    // Середина белого блока 2 x 2: линейная фильтрация дает ровно 1
+    float whiteU = 1.0f / ATLAS_WIDTH;
+    float whiteV = 1.0f / ATLAS_HEIGHT;
+    s.addQuad(s.graphVertices, transform, min, max, glm::vec4(whiteU, whiteV, whiteU, whiteV), color);
+}
+
+void VulkanRenderer::drawGlyph(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, glm::vec3 color,
+                               const uint8_t* mask, int maskWidth, int maskHeight) {
+    State& s = *state_;
+    glm::vec4 uv;
+    if (!s.frameActive || !mask || maskWidth <= 0 || maskHeight <= 0 || !s.addGlyph(mask, maskWidth, maskHeight, uv)) {
+        return;
+    }
+    s.addQuad(s.textVertices, transform, min, max, uv, color);
+}
+
+void VulkanRenderer::State::recordHud(VkCommandBuffer buffer, const std::vector<HudVertex>& vertices, VkDeviceSize offset,
+                                      uint32_t timestamp) {
+    beginSecondary(buffer);
+    // Метка в начале прохода закрывает предыдущий: BOTTOM_OF_PIPE ждет прежние команды
+    if (queryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, timestamp);
+    }
+    if (!vertices.empty()) {
+        Frame& frame = frames[current];
+        vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, hudPipeline);
+        vkCmdBindVertexBuffers(buffer, 0, 1, &frame.hud.buffer, &offset);
+        vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, hudLayout, 0, 1, &atlasSet, 0, nullptr);
+        vkCmdDraw(buffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0);
+    }
+    vkEndCommandBuffer(buffer);
+}
+
+void VulkanRenderer::State::uploadAtlas(VkCommandBuffer buffer) {
+    // Новые глифы появляются в первых кадрах: проще дождаться GPU, чем держать
+    // промежуточный буфер на каждый кадр
+    vkQueueWaitIdle(queue);
+    std::memcpy(atlasStaging.mapped, atlasPixels.data(), atlasPixels.size());
+
+    VkImageMemoryBarrier barrier {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.srcAccessMask = atlasUploaded ? VK_ACCESS_SHADER_READ_BIT : 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = atlas.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    VkBufferImageCopy copy {};
+    copy.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    copy.imageExtent = {ATLAS_WIDTH, ATLAS_HEIGHT, 1};
+    vkCmdCopyBufferToImage(buffer, atlasStaging.buffer, atlas.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+    atlasDirty = false;
+    atlasUploaded = true;
+}
+
+void VulkanRenderer::endFrame() {
+    State& s = *state_;
+    if (!s.frameActive) {
+        return;
+    }
+    State::Frame& frame = s.frames[s.current];
+
+    // Вершины графика и текста одним буфером кадра
+    size_t graphBytes = s.graphVertices.size() * sizeof(HudVertex);
+    size_t textBytes = s.textVertices.size() * sizeof(HudVertex);
+    if (graphBytes + textBytes > 0 && s.ensureBuffer(frame.hud, graphBytes + textBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)) {
+        std::memcpy(frame.hud.mapped, s.graphVertices.data(), graphBytes);
+        std::memcpy(static_cast<uint8_t*>(frame.hud.mapped) + graphBytes, s.textVertices.data(), textBytes);
+    } else {
+        s.graphVertices.clear();
+        s.textVertices.clear();
+        textBytes = 0;
+    }
+    uint32_t firstQuery = static_cast<uint32_t>(s.current) * TIMESTAMPS_PER_FRAME;
+    s.recordHud(frame.graph, s.graphVertices, 0, firstQuery + GPU_PASS_GRAPH);
+    s.recordHud(frame.text, s.textVertices, graphBytes, firstQuery + GPU_PASS_TEXT);
+
+    VkCommandBufferBeginInfo beginInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(frame.primary, &beginInfo);
+    if (s.atlasDirty) {
+        s.uploadAtlas(frame.primary);
+    }
+    if (s.queryPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(frame.primary, s.queryPool, firstQuery, TIMESTAMPS_PER_FRAME);
+        vkCmdWriteTimestamp(frame.primary, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s.queryPool, firstQuery);
+    }
+    std::array<VkClearValue, 2> clearValues {};
+    clearValues[0].color = {{s.clearColor.x, s.clearColor.y, s.clearColor.z, 1.0f}};
+    clearValues[1].depthStencil = {1.0f, 0};
+    VkRenderPassBeginInfo renderPassBegin {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+    renderPassBegin.renderPass = s.renderPass;
+    renderPassBegin.framebuffer = s.framebuffers[s.imageIndex];
+    renderPassBegin.renderArea = {{0, 0}, s.extent};
+    renderPassBegin.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassBegin.pClearValues = clearValues.data();
+    vkCmdBeginRenderPass(frame.primary, &renderPassBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    std::vector<VkCommandBuffer> secondaries(frame.cubeBuffers.begin(), frame.cubeBuffers.begin() + frame.cubeChunks);
+    secondaries.push_back(frame.graph);
+    secondaries.push_back(frame.text);
+    vkCmdExecuteCommands(frame.primary, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+    vkCmdEndRenderPass(frame.primary);
+    if (s.queryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(frame.primary, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s.queryPool, firstQuery + GPU_PASS_COUNT);
+    }
+    vkEndCommandBuffer(frame.primary);
+
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    VkSubmitInfo submit {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submit.waitSemaphoreCount = 1;
+    submit.pWaitSemaphores = &frame.imageAvailable;
+    submit.pWaitDstStageMask = &waitStage;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &frame.primary;
+    submit.signalSemaphoreCount = 1;
+    submit.pSignalSemaphores = &s.renderFinished[s.imageIndex];
+    vkResetFences(s.device, 1, &frame.fence);
+    if (vkQueueSubmit(s.queue, 1, &submit, frame.fence) != VK_SUCCESS) {
+        return;
+    }
+    frame.pending = true;
+    s.lastCubeChunks = frame.cubeChunks;
+
+    VkPresentInfoKHR present {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+    present.waitSemaphoreCount = 1;
+    present.pWaitSemaphores = &s.renderFinished[s.imageIndex];
+    present.swapchainCount = 1;
+    present.pSwapchains = &s.swapchain;
+    present.pImageIndices = &s.imageIndex;
+    VkResult presented = vkQueuePresentKHR(s.queue, &present);
+    if (presented == VK_ERROR_OUT_OF_DATE_KHR || presented == VK_SUBOPTIMAL_KHR) {
+        s.recreateSwapchain = true;
+    }
+    s.current = (s.current + 1) % FRAMES_IN_FLIGHT;
+    s.frameActive = false;
+}
+
+bool VulkanRenderer::collect(uint64_t& frameIndex, GpuPassTimes& times) {
+    if (!state_ || state_->results.empty()) {
+        return false;
+    }
+    frameIndex = state_->results.front().first;
+    times = state_->results.front().second;
+    state_->results.pop_front();
+    return true;
+}
+
+#else
+
+// Сборка без Vulkan: бэкенд недоступен
+struct VulkanRenderer::State {};
+
+VulkanRenderer::VulkanRenderer() = default;
+
+VulkanRenderer::~VulkanRenderer() = default;
+
+bool VulkanRenderer::init(GLFWwindow*, JobSystem*, std::string& error) {
+    error = "rgbench was built without Vulkan (Vulkan SDK and glslc not found by CMake)";
+    return false;
+}
+
+void VulkanRenderer::destroy() {}
+
+bool VulkanRenderer::enabled() const { return false; }
+
+std::string VulkanRenderer::deviceName() const { return ""; }
+
+std::string VulkanRenderer::driverInfo() const { return ""; }
+
+void VulkanRenderer::setVsync(bool) {}
+
+void VulkanRenderer::beginFrame(uint64_t, int, int, glm::vec3) {}
+
+void VulkanRenderer::drawCube(const glm::mat4&, const glm::mat4&, int, bool) {}
+
+void VulkanRenderer::drawRect(const glm::mat4&, glm::vec2, glm::vec2, glm::vec3) {}
+
+void VulkanRenderer::drawGlyph(const glm::mat4&, glm::vec2, glm::vec2, glm::vec3, const uint8_t*, int, int) {}
+
+void VulkanRenderer::endFrame() {}
+
+bool VulkanRenderer::collect(uint64_t&, GpuPassTimes&) { return false; }
+
+int VulkanRenderer::cubeCommandBuffers() const { return 0; }
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "gpu_timer.h"
+
+struct GLFWwindow;
+class JobSystem;
+
+// Бэкенд Vulkan (--backend vulkan): та же сцена, что у GL, в окне GLFW без
+// контекста GL. Матрицы кубиков пишутся в storage buffer кадра и читаются
+// шейдером по gl_InstanceIndex; куски кубиков записываются во вторичные буферы
+// команд параллельно в пуле потоков. Оверлей - прямоугольники и глифы из
+// атласа одним конвейером. Время проходов меряется timestamp-запросами
+//
+// Собирается с RGBENCH_VULKAN (CMake нашел Vulkan и glslc), иначе init()
+// возвращает ошибку
+class VulkanRenderer {
+public:
+    static constexpr int FRAMES_IN_FLIGHT = 2;
+
+    VulkanRenderer();
+    ~VulkanRenderer();
+
+    // Окно создано с GLFW_NO_API. jobs - пул для записи вторичных буферов
+    bool init(GLFWwindow* window, JobSystem* jobs, std::string& error);
+    void destroy();
+    [[nodiscard]] bool enabled() const;
+
+    [[nodiscard]] std::string deviceName() const;
+    [[nodiscard]] std::string driverInfo() const;
+    // Режим показа меняется при следующем кадре пересозданием swapchain
+    void setVsync(bool vsync);
+
+    void beginFrame(uint64_t frameIndex, int width, int height, glm::vec3 clearColor);
+    // Кубик Рубика: матрицы кубиков и запись вторичных буферов кусками в потоках
+    void drawCube(const glm::mat4& viewProjection, const glm::mat4& rotation, int cubeSize, bool cull);
+    // Прямоугольник графика и глиф текста, как у программного растеризатора
+    void drawRect(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, glm::vec3 color);
+    void drawGlyph(const glm::mat4& transform, glm::vec2 min, glm::vec2 max, glm::vec3 color,
+                   const uint8_t* mask, int maskWidth, int maskHeight);
+    // Первичный буфер команд, отправка и показ
+    void endFrame();
+
+    // Время проходов самого старого готового кадра, false - готовых нет
+    bool collect(uint64_t& frameIndex, GpuPassTimes& times);
+    // Вторичных буферов кубика в прошлом кадре
+    [[nodiscard]] int cubeCommandBuffers() const;
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+extern VulkanRenderer vulkanRenderer;